@@ -2,23 +2,53 @@
 
 #include <algorithm>
 
-#include "numgeom/loadfromvtk.h"
+#include "numgeom/loadtrimesh.h"
 #ifdef USE_NUMGEOM_MODULE_OCC
 #  include "numgeom/loadusingocc.h"
 #endif
 
-TriMesh::Ptr LoadToTriMesh(const std::filesystem::path& filename) {
-  if (!std::filesystem::exists(filename)) return TriMesh::Ptr();
-
+namespace {
+std::string LowerExtension(const std::filesystem::path& filename) {
   std::string ext = filename.extension().string();
   std::transform(ext.begin(), ext.end(), ext.begin(),
                  [](unsigned char c) { return std::tolower(c); });
+  return ext;
+}
+
+#ifdef USE_NUMGEOM_MODULE_OCC
+bool IsDocumentFile(const std::string& ext) {
+#  ifdef NUMGEOM_OCC_LOAD_VRML
+  if (ext == ".wrl") return true;
+#  endif
+  return ext == ".step" || ext == ".stp" || ext == ".iges" || ext == ".igs" ||
+         ext == ".glb";
+}
+#endif
+}  // namespace
+
+TriMesh::Ptr LoadToTriMesh(const std::filesystem::path& filename,
+                           LoadProgress* progress) {
+  if (!std::filesystem::exists(filename)) return TriMesh::Ptr();
+
+  std::string ext = LowerExtension(filename);
 
 #ifdef USE_NUMGEOM_MODULE_OCC
   if (ext == ".step" || ext == ".stp") return LoadUsingOCC(filename);
 #endif
 
-  if (ext == ".vtk") return LoadTriMeshFromVtk(filename);
+  return LoadTriMesh(filename, progress);
+}
 
-  return TriMesh::Ptr();
+AsyncLoad<LoadedModel> LoadModelAsync(const std::filesystem::path& filename) {
+  return LoadAsync<LoadedModel>([filename](LoadProgress& progress) {
+    LoadedModel model;
+#ifdef USE_NUMGEOM_MODULE_OCC
+    if (IsDocumentFile(LowerExtension(filename))) {
+      model.document = LoadDocument(filename, progress);
+      return model;
+    }
+#endif
+    model.mesh = LoadToTriMesh(filename, &progress);
+    return model;
+  });
 }
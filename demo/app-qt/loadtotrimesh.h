@@ -1,8 +1,25 @@
 #ifndef examples_appqt_loadtotrimesh_h
 #define examples_appqt_loadtotrimesh_h
 
+#include "numgeom/loadasync.h"
 #include "numgeom/trimesh.h"
+#ifdef USE_NUMGEOM_MODULE_OCC
+#  include "TDocStd_Document.hxx"
+#endif
 
-TriMesh::Ptr LoadToTriMesh(const std::filesystem::path& filename);
+TriMesh::Ptr LoadToTriMesh(const std::filesystem::path& filename,
+                           LoadProgress* progress = nullptr);
+
+//! Загруженная модель: сетка или документ OCC.
+struct LoadedModel {
+  TriMesh::Ptr mesh;
+#ifdef USE_NUMGEOM_MODULE_OCC
+  Handle(TDocStd_Document) document;
+#endif
+};
+
+//! Загружает модель в отдельном потоке; документы OCC загружаются вместе
+//! с триангуляциями граней.
+AsyncLoad<LoadedModel> LoadModelAsync(const std::filesystem::path& filename);
 
 #endif  // !numgeom_io_loadtotrimesh_h
@@ -1,7 +1,11 @@
 #include "QApplication"
 #include "QLoggingCategory"
+#include "QStandardPaths"
 
 #include "numgeom/application.h"
+#ifdef USE_NUMGEOM_MODULE_OCC
+#  include "numgeom/tessellationcache.h"
+#endif
 
 #include "mainwindow.h"
 
@@ -16,6 +20,17 @@ int main(int argc, char* argv[]) {
   QCoreApplication::setOrganizationName("NumGeom");
   QCoreApplication::setApplicationName("app-qt");
 
+#ifdef USE_NUMGEOM_MODULE_OCC
+  // Триангуляции граней моделей сохраняются между запусками.
+  QString cache_dir =
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (!cache_dir.isEmpty()) {
+    std::filesystem::path cache_path = cache_dir.toStdWString();
+    TessellationCache::SetDefault(
+        TessellationCache::Create(cache_path / "tessellation"));
+  }
+#endif
+
 #ifndef NDEBUG
   QLoggingCategory::setFilterRules(QStringLiteral("qt.vulkan=true"));
 #endif
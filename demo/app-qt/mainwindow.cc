@@ -13,9 +13,13 @@
 #include "qmenu.h"
 #include "qmenubar.h"
 #include "qmessagebox.h"
+#include "qprogressbar.h"
+#include "qpushbutton.h"
 #include "qresource.h"
 #include "qscreen.h"
 #include "qstandardpaths.h"
+#include "qstatusbar.h"
+#include "qtimer.h"
 
 #include "numgeom/application.h"
 #include "numgeom/fgtext.h"
@@ -25,8 +29,6 @@
 #include "numgeom/scenewidget_axisindicator.h"
 #include "numgeom/vkscenerenderer.h"
 #ifdef USE_NUMGEOM_MODULE_OCC
-#  include "numgeom/loadusingocc.h"
-#  include "numgeom/sceneobject_polytriangulation.h"
 #  include "numgeom/sceneobject_tdocstd_document.h"
 #endif
 
@@ -45,6 +47,7 @@ MainWindow::MainWindow(Application* app) : settings_("NumGeom", "QtDemo"), updat
   mdi_area_ = new QMdiArea(this);
   this->setCentralWidget(mdi_area_);
   this->createActions();
+  this->createLoadingWidgets();
   QIcon window_icon(QString(":/resources/icons/app.ico"));
   this->setWindowIcon(window_icon);
 }
@@ -166,6 +169,25 @@ void MainWindow::createActions() {
   this->createHelpMenu();
 }
 
+void MainWindow::createLoadingWidgets() {
+  load_progress_ = new QProgressBar(this);
+  load_progress_->setRange(0, 100);
+  load_progress_->setMaximumWidth(200);
+  load_progress_->hide();
+  statusBar()->addPermanentWidget(load_progress_);
+
+  load_cancel_ = new QPushButton(tr("Cancel"), this);
+  load_cancel_->hide();
+  connect(load_cancel_, SIGNAL(clicked()), this, SLOT(onCancelLoading()));
+  statusBar()->addPermanentWidget(load_cancel_);
+
+  // Ход загрузки опрашивается в потоке интерфейса, поэтому загрузчику не
+  // нужно обращаться к виджетам.
+  load_timer_ = new QTimer(this);
+  load_timer_->setInterval(100);
+  connect(load_timer_, SIGNAL(timeout()), this, SLOT(onLoadingProgress()));
+}
+
 void MainWindow::createFileMenu() {
   QMenu* menu = menuBar()->addMenu(tr("&File"));
 
@@ -597,133 +619,73 @@ void MainWindow::onQuit() {
     this->close();
 }
 
-namespace {
-bool IsStepFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "step" || suffix == "stp";
-}
-
-bool IsStlFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "stl";
-}
-
-bool IsIgesFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "iges" || suffix == "igs";
-}
-
-bool IsObjFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "obj";
-}
-
-bool IsVrmlFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "wrl";
-}
-
-bool IsGltfFile(const QString& filename) {
-  QFileInfo fileInfo(filename);
-  QString suffix = fileInfo.suffix();
-  suffix = suffix.toLower();
-  return suffix == "glb";
-}
-}
-
 void MainWindow::openFile(const QString& filename) {
   SceneMdiSubWindow* active_sub = GetActiveMdiSubWindow();
   if (!active_sub) return;
-  Scene* scene = active_sub->GetScene();
-  if (!scene) return;
+  if (!active_sub->GetScene()) return;
+
+  // Незавершенная загрузка предыдущего файла отменяется. Сцена очищается
+  // только после загрузки, чтобы при отмене осталась прежняя модель.
+  loading_ = LoadModelAsync(filename.toStdWString());
+  loading_window_ = active_sub;
+  loading_filename_ = filename;
+  load_progress_->setValue(0);
+  load_progress_->show();
+  load_cancel_->show();
+  statusBar()->showMessage(
+      tr("Loading %1").arg(QFileInfo(filename).fileName()));
+  load_timer_->start();
+}
+
+void MainWindow::onLoadingProgress() {
+  if (!loading_.IsValid()) {
+    load_timer_->stop();
+    return;
+  }
+  load_progress_->setValue(
+      static_cast<int>(100.0 * loading_.Progress().Fraction()));
+  if (!loading_.IsReady()) return;
 
-  // Update window title with filename
-  QFileInfo fileInfo(filename);
-  active_sub->setWindowTitle(fileInfo.fileName());
+  load_timer_->stop();
+  load_progress_->hide();
+  load_cancel_->hide();
+  statusBar()->clearMessage();
 
-  scene->Clear();
-  app_->Update(scene);
+  bool cancelled = loading_.Progress().IsCancelled();
+  LoadedModel model = loading_.Get();
+  bool loaded = model.mesh != TriMesh::Ptr();
 #ifdef USE_NUMGEOM_MODULE_OCC
-  if (IsStepFile(filename)) {
-    auto document = LoadStepDocument(filename.toStdWString());
-    if (!document) {
-      qDebug() << "Ошибка при загрузке файла '" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_TDocStd_Document>(document);
-    scene->FitScene();
-    app_->Update(scene);
-    return;
-  } else if (IsStlFile(filename)) {
-    auto triangulation = LoadStl(filename.toStdWString());
-    if (!triangulation) {
-      qDebug() << "Ошибка при загрузке файла `" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_PolyTriangulation>(triangulation);
-    scene->FitScene();
-    app_->Update(scene);
-    return;
-  } else if (IsIgesFile(filename)) {
-    auto document = LoadIges(filename.toStdWString());
-    if (!document) {
-      qDebug() << "Ошибка при загрузке файла `" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_TDocStd_Document>(document);
-    scene->FitScene();
-    app_->Update(scene);
-    return;
-  } else if (IsObjFile(filename)) {
-    auto triangulation = LoadObj(filename.toStdWString());
-    if (!triangulation) {
-      qDebug() << "Ошибка при загрузке файла `" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_PolyTriangulation>(triangulation);
-    scene->FitScene();
-    app_->Update(scene);
-    return;
-#ifdef NUMGEOM_OCC_LOAD_VRML
-  } else if (IsVrmlFile(filename)) {
-    auto document = LoadVrml(filename.toStdWString());
-    if (!document) {
-      qDebug() << "Ошибка при загрузке файла `" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_TDocStd_Document>(document);
-    scene->FitScene();
-    app_->Update(scene);
-    return;
+  loaded = loaded || !model.document.IsNull();
 #endif
-  } else if (IsGltfFile(filename)) {
-    auto document = LoadGltf(filename.toStdWString());
-    if (!document) {
-      qDebug() << "Ошибка при загрузке файла `" << filename << "'";
-      return;
-    }
-    scene->AddObject<SceneObject_TDocStd_Document>(document);
-    scene->FitScene();
-    app_->Update(scene);
+  if (!loaded) {
+    if (cancelled)
+      statusBar()->showMessage(tr("Loading cancelled"), 3000);
+    else
+      qDebug() << "Ошибка при загрузке файла `" << loading_filename_ << "'";
     return;
   }
+
+  SceneMdiSubWindow* sub = loading_window_;
+  Scene* scene = sub ? sub->GetScene() : nullptr;
+  if (!scene) return;
+
+  // Update window title with filename
+  QFileInfo fileInfo(loading_filename_);
+  sub->setWindowTitle(fileInfo.fileName());
+
+  scene->Clear();
+#ifdef USE_NUMGEOM_MODULE_OCC
+  if (!model.document.IsNull())
+    scene->AddObject<SceneObject_TDocStd_Document>(model.document);
+  else
 #endif
-  auto mesh = LoadToTriMesh(filename.toStdWString());
-  if(mesh) {
-    scene->AddObject<SceneObject_Mesh>(mesh);
-    scene->FitScene();
-    app_->Update(scene);
-  }
+    scene->AddObject<SceneObject_Mesh>(model.mesh);
+  scene->FitScene();
+  app_->Update(scene);
+}
+
+void MainWindow::onCancelLoading() {
+  loading_.Cancel();
 }
 
 void MainWindow::onOpenFile() {
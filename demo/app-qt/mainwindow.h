@@ -3,10 +3,16 @@
 
 #include "qmainwindow.h"
 #include "qmdiarea.h"
+#include "qpointer.h"
 #include "qsettings.h"
 #include "qvulkaninstance.h"
 
+#include "loadtotrimesh.h"
+
 class Application;
+class QProgressBar;
+class QPushButton;
+class QTimer;
 class Scene;
 class SceneWindow;
 class SceneMdiSubWindow;
@@ -28,6 +34,7 @@ class MainWindow : public QMainWindow {
   void createActions();
   void createFileMenu();
   void createHelpMenu();
+  void createLoadingWidgets();
   void createPickingMenu();
   void createSceneMenu();
   void createViewMenu();
@@ -47,10 +54,12 @@ class MainWindow : public QMainWindow {
   void onAddAxisIndicator();
   void onAddFgImage();
   void onAddFgText();
+  void onCancelLoading();
   void onClearScene();
   void onDownloadData();
   void onFitScene();
   void onGoToTestData();
+  void onLoadingProgress();
   void onMsaa(QAction* action);
   void onOpenFile();
   void onOpenRecentFile();
@@ -80,5 +89,13 @@ class MainWindow : public QMainWindow {
   QMenu* recent_files_menu_;
   QMenu* window_list_menu_;
   bool updating_window_menu_;
+
+  // Фоновая загрузка файла и подокно, в сцену которого попадет результат.
+  AsyncLoad<LoadedModel> loading_;
+  QPointer<SceneMdiSubWindow> loading_window_;
+  QString loading_filename_;
+  QProgressBar* load_progress_;
+  QPushButton* load_cancel_;
+  QTimer* load_timer_;
 };
 #endif  // NUMGEOM_EXAMPLE_APPQT_MAINWINDOW_H_
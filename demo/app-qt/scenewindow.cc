@@ -3,12 +3,16 @@
 #include <iostream>
 
 #include "qevent.h"
+#include "qtimer.h"
 #include "qvulkaninstance.h"
 
 #include "numgeom/application.h"
 #include "numgeom/scene.h"
 #include "numgeom/userinputcontroller.h"
 #include "numgeom/vkscenerenderer.h"
+#ifdef USE_NUMGEOM_MODULE_OCC
+#  include "numgeom/drawable_occshape.h"
+#endif
 
 SceneWindow::SceneWindow(Application* app) {
   this->setSurfaceType(QSurface::VulkanSurface);
@@ -59,9 +63,10 @@ void SceneWindow::keyReleaseEvent(QKeyEvent* event) {
 
 void SceneWindow::mousePressEvent(QMouseEvent* event) {
   QPoint pt = event->pos();
-  if (event->button() == Qt::LeftButton)
+  if (event->button() == Qt::LeftButton) {
+    left_button_down_pos_ = pt;
     user_input_controller_->MouseLeftButtonDown(pt.x(), pt.y());
-  else if (event->button() == Qt::RightButton)
+  } else if (event->button() == Qt::RightButton)
     user_input_controller_->MouseRightButtonDown(pt.x(), pt.y());
   else if (event->button() == Qt::MiddleButton)
     user_input_controller_->MouseMiddleButtonDown(pt.x(), pt.y());
@@ -75,9 +80,15 @@ void SceneWindow::mousePressEvent(QMouseEvent* event) {
 
 void SceneWindow::mouseReleaseEvent(QMouseEvent* event) {
   QPoint pt = event->pos();
-  if (event->button() == Qt::LeftButton)
+  if (event->button() == Qt::LeftButton) {
     user_input_controller_->MouseLeftButtonUp(pt.x(), pt.y());
-  else if (event->button() == Qt::RightButton)
+#ifdef USE_NUMGEOM_MODULE_OCC
+    // Щелчок выбирает грань B-rep фигуры под курсором.
+    if (pt == left_button_down_pos_ &&
+        SelectPickedFace(scene_, PickFace(*app_, scene_, pt.x(), pt.y())))
+      app_->Update(scene_);
+#endif
+  } else if (event->button() == Qt::RightButton)
     user_input_controller_->MouseRightButtonUp(pt.x(), pt.y());
   else if (event->button() == Qt::MiddleButton)
     user_input_controller_->MouseMiddleButtonUp(pt.x(), pt.y());
@@ -117,6 +128,9 @@ bool SceneWindow::event(QEvent* e) {
     case QEvent::Paint:
     case QEvent::UpdateRequest:
       app_->GetRenderer()->Update(scene_);
+      // Пока сетки уточняются в фоне, периодически перерисовываем сцену.
+      if (scene_ && scene_->IsViewUpdatePending())
+        QTimer::singleShot(100, this, &QWindow::requestUpdate);
       break;
     case QEvent::PlatformSurface: {
       auto* pse = static_cast<QPlatformSurfaceEvent*>(e);
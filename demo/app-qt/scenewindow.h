@@ -1,6 +1,7 @@
 #ifndef NUMGEOM_EXAMPLES_APPQT_SCENEWINDOW_H_
 #define NUMGEOM_EXAMPLES_APPQT_SCENEWINDOW_H_
 
+#include "qpoint.h"
 #include "qwindow.h"
 
 #include "numgeom/trimesh.h"
@@ -34,5 +35,6 @@ class SceneWindow : public QWindow {
   Application* app_ = nullptr;
   Scene* scene_ = nullptr;
   UserInputController* user_input_controller_ = nullptr;
+  QPoint left_button_down_pos_;   //!< Точка нажатия левой кнопки мыши.
 };
 #endif  // NUMGEOM_EXAMPLES_APPQT_SCENEWINDOW_H_
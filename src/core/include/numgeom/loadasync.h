@@ -0,0 +1,186 @@
+#ifndef numgeom_numgeom_loadasync_h
+#define numgeom_numgeom_loadasync_h
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "numgeom/core_export.h"
+
+/**\class LoadProgress
+\brief Ход загрузки, разделяемый загрузчиком и вызывающим потоком.
+
+Загрузчик сообщает число разобранных байтов файла и число построенных
+триангуляций граней, а также периодически проверяет `IsCancelled()` и при
+отмене прекращает работу, возвращая пустой результат. Счетчики атомарные,
+их можно опрашивать из любого потока. Функция обратного вызова, если задана,
+вызывается после каждого изменения счетчиков в том потоке, который их
+изменил: загрузчики, разбирающие файл параллельно, сообщают ход из рабочих
+потоков. Вызовы при этом упорядочены и никогда не выполняются одновременно,
+поэтому функция не должна изменять ход загрузки.
+*/
+class CORE_EXPORT LoadProgress {
+ public:
+  typedef std::function<void(const LoadProgress&)> Callback;
+
+ public:
+  explicit LoadProgress(Callback callback = Callback());
+
+  LoadProgress(const LoadProgress&) = delete;
+  LoadProgress& operator=(const LoadProgress&) = delete;
+
+  void SetTotalBytes(size_t nbBytes);
+  void SetParsedBytes(size_t nbBytes);
+  void AddParsedBytes(size_t nbBytes);
+  size_t TotalBytes() const { return myTotalBytes; }
+  size_t ParsedBytes() const { return myParsedBytes; }
+
+  void SetTotalFaces(size_t nbFaces);
+  void AddMeshedFaces(size_t nbFaces);
+  size_t TotalFaces() const { return myTotalFaces; }
+  size_t MeshedFaces() const { return myMeshedFaces; }
+
+  //! Доля выполненной работы в диапазоне [0, 1]. Если число граней известно,
+  //! разбор файла и построение триангуляций считаются равными по весу.
+  double Fraction() const;
+
+  //! Запрашивает отмену; загрузчик прервется при ближайшей проверке.
+  void Cancel() { myCancelled = true; }
+  bool IsCancelled() const { return myCancelled; }
+
+ private:
+  void Notify() const;
+
+ private:
+  std::atomic<size_t> myTotalBytes;
+  std::atomic<size_t> myParsedBytes;
+  std::atomic<size_t> myTotalFaces;
+  std::atomic<size_t> myMeshedFaces;
+  std::atomic<bool> myCancelled;
+  Callback myCallback;
+  mutable std::mutex myCallbackMutex;
+};
+
+/**\class AbandonedLoads
+\brief Загрузки, результат которых больше не нужен, но которые еще работают.
+
+Объект `std::future`, полученный от `std::async`, в деструкторе дожидается
+завершения потока. Чтобы отказ от загрузки не останавливал вызывающий поток,
+отмененная загрузка хранится в общем списке, пока загрузчик не заметит
+отмену, и освобождается при следующем опросе списка.
+*/
+class CORE_EXPORT AbandonedLoads {
+ public:
+  class CORE_EXPORT Load {
+   public:
+    virtual ~Load();
+    virtual bool IsReady() const = 0;
+  };
+
+ public:
+  //! Добавляет загрузку в список и освобождает завершившиеся.
+  static void Add(std::unique_ptr<Load> load);
+
+  //! Освобождает завершившиеся загрузки.
+  static void Release();
+};
+
+/**\class AsyncLoad
+\brief Результат загрузки, выполняемой в отдельном потоке.
+
+Объект только перемещается. Деструктор и присваивание незавершенной
+загрузки запрашивают отмену и не ждут загрузчик: загрузка передается в
+`AbandonedLoads` и освобождается после завершения.
+*/
+template <typename T>
+class AsyncLoad {
+ public:
+  AsyncLoad() = default;
+
+  AsyncLoad(std::future<T>&& future, std::shared_ptr<LoadProgress> progress)
+      : myFuture(std::move(future)), myProgress(std::move(progress)) {}
+
+  AsyncLoad(AsyncLoad&&) = default;
+
+  AsyncLoad& operator=(AsyncLoad&& other) {
+    if (this != &other) {
+      Reset();
+      myFuture = std::move(other.myFuture);
+      myProgress = std::move(other.myProgress);
+    }
+    return *this;
+  }
+
+  ~AsyncLoad() { Reset(); }
+
+  //! Связан ли объект с загрузкой, результат которой еще не получен.
+  bool IsValid() const { return myFuture.valid(); }
+
+  bool IsReady() const {
+    return myFuture.valid() && myFuture.wait_for(std::chrono::seconds(0)) ==
+                                   std::future_status::ready;
+  }
+
+  void Wait() const {
+    if (myFuture.valid()) myFuture.wait();
+  }
+
+  //! Дожидается завершения и возвращает результат; повторный вызов
+  //! недопустим. Исключение загрузчика пробрасывается вызывающему.
+  T Get() { return myFuture.get(); }
+
+  void Cancel() {
+    if (myProgress) myProgress->Cancel();
+  }
+
+  //! Ход загрузки; у объекта без загрузки он пустой.
+  const LoadProgress& Progress() const {
+    static const LoadProgress s_noProgress;
+    return myProgress ? *myProgress : s_noProgress;
+  }
+
+ private:
+  class Abandoned : public AbandonedLoads::Load {
+   public:
+    explicit Abandoned(std::future<T>&& future) : myFuture(std::move(future)) {}
+
+    bool IsReady() const override {
+      return myFuture.wait_for(std::chrono::seconds(0)) ==
+             std::future_status::ready;
+    }
+
+   private:
+    std::future<T> myFuture;
+  };
+
+  void Reset() {
+    if (!myFuture.valid()) return;
+    Cancel();
+    AbandonedLoads::Add(std::make_unique<Abandoned>(std::move(myFuture)));
+    myProgress.reset();
+  }
+
+ private:
+  std::future<T> myFuture;
+  std::shared_ptr<LoadProgress> myProgress;
+};
+
+//! Запускает `loader` в отдельном потоке и сразу возвращает управление.
+template <typename T>
+AsyncLoad<T> LoadAsync(std::function<T(LoadProgress&)> loader,
+                       LoadProgress::Callback callback = {}) {
+  AbandonedLoads::Release();
+  auto progress = std::make_shared<LoadProgress>(std::move(callback));
+  std::future<T> future =
+      std::async(std::launch::async, [loader = std::move(loader), progress]() {
+        return loader(*progress);
+      });
+  return AsyncLoad<T>(std::move(future), std::move(progress));
+}
+
+#endif  // !numgeom_numgeom_loadasync_h
@@ -0,0 +1,105 @@
+#ifndef numgeom_numgeom_meshfield_h
+#define numgeom_numgeom_meshfield_h
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "numgeom/core_export.h"
+
+/**\class MeshField
+\brief Именованный типизированный массив атрибутов сетки.
+
+Значения хранятся непрерывным блоком кортежей по `NbComponents()` компонент
+(от 1 до 4) в одном из поддерживаемых типов. Указатель `Data()` можно
+напрямую передавать в буфер вершин рендерера.
+*/
+class CORE_EXPORT MeshField {
+ public:
+  typedef std::shared_ptr<MeshField> Ptr;
+
+  enum class ValueType { Float, Double, Int };
+
+ public:
+  //! Создает массив из `nbTuples` кортежей, заполненный нулями.
+  //! Возвращает пустой указатель при недопустимом числе компонент.
+  static Ptr Create(const std::string& name, ValueType type,
+                    size_t nbComponents, size_t nbTuples);
+
+  static size_t SizeOf(ValueType);
+
+ public:
+  const std::string& Name() const { return myName; }
+
+  ValueType Type() const { return myType; }
+
+  size_t NbComponents() const { return myNbComponents; }
+
+  size_t NbTuples() const { return myNbTuples; }
+
+  const void* Data() const { return myData.data(); }
+
+  void* Data() { return myData.data(); }
+
+  //! Типизированный доступ к непрерывному массиву значений.
+  template <typename T>
+  const T* Values() const {
+    assert(sizeof(T) == SizeOf(myType));
+    return reinterpret_cast<const T*>(myData.data());
+  }
+
+  template <typename T>
+  T* Values() {
+    assert(sizeof(T) == SizeOf(myType));
+    return reinterpret_cast<T*>(myData.data());
+  }
+
+  double GetValue(size_t tuple, size_t comp) const {
+    size_t i = tuple * myNbComponents + comp;
+    switch (myType) {
+      case ValueType::Float:
+        return Values<float>()[i];
+      case ValueType::Double:
+        return Values<double>()[i];
+      case ValueType::Int:
+        return Values<int32_t>()[i];
+    }
+    return 0.0;
+  }
+
+  void SetValue(size_t tuple, size_t comp, double value) {
+    size_t i = tuple * myNbComponents + comp;
+    switch (myType) {
+      case ValueType::Float:
+        Values<float>()[i] = static_cast<float>(value);
+        break;
+      case ValueType::Double:
+        Values<double>()[i] = value;
+        break;
+      case ValueType::Int:
+        Values<int32_t>()[i] = static_cast<int32_t>(value);
+        break;
+    }
+  }
+
+  //! Создает копию массива, оставляя только кортежи с номерами `tuples`.
+  Ptr Extract(const std::vector<size_t>& tuples) const;
+
+ private:
+  MeshField(const std::string& name, ValueType type, size_t nbComponents,
+            size_t nbTuples);
+
+  MeshField(const MeshField&) = delete;
+  void operator=(const MeshField&) = delete;
+
+ private:
+  std::string myName;
+  ValueType myType;
+  size_t myNbComponents;
+  size_t myNbTuples;
+  std::vector<std::byte> myData;
+};
+#endif  // !numgeom_numgeom_meshfield_h
@@ -0,0 +1,79 @@
+#ifndef numgeom_numgeom_mortoncode_h
+#define numgeom_numgeom_mortoncode_h
+
+#include <cstdint>
+
+/**
+\file
+\brief Коды Мортона: перемежение битов целочисленных координат ячейки.
+
+Бит координаты `i` занимает младшую позицию в каждой группе, за ним идут биты
+`j` и `k`. Двумерный код вмещает по 32 бита на координату, трехмерный -- по
+21 биту.
+*/
+
+//! Раздвигает биты числа, вставляя между ними по одному нулевому биту.
+constexpr uint64_t MortonSpread2d(uint32_t v) {
+  uint64_t x = v;
+  x = (x | x << 16) & 0x0000FFFF0000FFFFull;
+  x = (x | x << 8) & 0x00FF00FF00FF00FFull;
+  x = (x | x << 4) & 0x0F0F0F0F0F0F0F0Full;
+  x = (x | x << 2) & 0x3333333333333333ull;
+  x = (x | x << 1) & 0x5555555555555555ull;
+  return x;
+}
+
+//! Обратная к `MortonSpread2d` операция: собирает четные биты числа.
+constexpr uint32_t MortonCompact2d(uint64_t x) {
+  x &= 0x5555555555555555ull;
+  x = (x | x >> 1) & 0x3333333333333333ull;
+  x = (x | x >> 2) & 0x0F0F0F0F0F0F0F0Full;
+  x = (x | x >> 4) & 0x00FF00FF00FF00FFull;
+  x = (x | x >> 8) & 0x0000FFFF0000FFFFull;
+  x = (x | x >> 16) & 0x00000000FFFFFFFFull;
+  return static_cast<uint32_t>(x);
+}
+
+//! Раздвигает 21 младший бит числа, вставляя между ними по два нулевых бита.
+constexpr uint64_t MortonSpread3d(uint32_t v) {
+  uint64_t x = v & 0x1FFFFFu;
+  x = (x | x << 32) & 0x001F00000000FFFFull;
+  x = (x | x << 16) & 0x001F0000FF0000FFull;
+  x = (x | x << 8) & 0x100F00F00F00F00Full;
+  x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+
+//! Обратная к `MortonSpread3d` операция: собирает каждый третий бит числа.
+constexpr uint32_t MortonCompact3d(uint64_t x) {
+  x &= 0x1249249249249249ull;
+  x = (x | x >> 2) & 0x10C30C30C30C30C3ull;
+  x = (x | x >> 4) & 0x100F00F00F00F00Full;
+  x = (x | x >> 8) & 0x001F0000FF0000FFull;
+  x = (x | x >> 16) & 0x001F00000000FFFFull;
+  x = (x | x >> 32) & 0x00000000001FFFFFull;
+  return static_cast<uint32_t>(x);
+}
+
+constexpr uint64_t MortonEncode2d(uint32_t i, uint32_t j) {
+  return MortonSpread2d(i) | MortonSpread2d(j) << 1;
+}
+
+constexpr void MortonDecode2d(uint64_t code, uint32_t& i, uint32_t& j) {
+  i = MortonCompact2d(code);
+  j = MortonCompact2d(code >> 1);
+}
+
+constexpr uint64_t MortonEncode3d(uint32_t i, uint32_t j, uint32_t k) {
+  return MortonSpread3d(i) | MortonSpread3d(j) << 1 | MortonSpread3d(k) << 2;
+}
+
+constexpr void MortonDecode3d(uint64_t code, uint32_t& i, uint32_t& j,
+                              uint32_t& k) {
+  i = MortonCompact3d(code);
+  j = MortonCompact3d(code >> 1);
+  k = MortonCompact3d(code >> 2);
+}
+
+#endif  // !numgeom_numgeom_mortoncode_h
@@ -0,0 +1,25 @@
+#ifndef numgeom_numgeom_parallelfor_h
+#define numgeom_numgeom_parallelfor_h
+
+#include <cstddef>
+#include <functional>
+
+#include "numgeom/core_export.h"
+
+//! Число потоков, используемых `ParallelFor`.
+CORE_EXPORT size_t NbParallelThreads();
+
+/**
+\brief Обрабатывает диапазон [0, n) непрерывными блоками в нескольких потоках.
+
+Функция `body(begin, end)` вызывается для непересекающихся блоков, длина
+которых не меньше `minBlockSize`, если только весь диапазон не короче. Блоки
+назначаются потокам в порядке возрастания, так что результат, собранный по
+индексам, не зависит от числа потоков. Первое исключение, выброшенное в
+каком-либо потоке, пробрасывается вызывающему после завершения всех потоков.
+*/
+CORE_EXPORT void ParallelFor(
+    size_t n, const std::function<void(size_t begin, size_t end)>& body,
+    size_t minBlockSize = 1);
+
+#endif  // !numgeom_numgeom_parallelfor_h
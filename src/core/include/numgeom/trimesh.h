@@ -7,6 +7,7 @@
 
 #include "glm/glm.hpp"
 #include "numgeom/core_export.h"
+#include "numgeom/meshfield.h"
 
 #define NONE_INDEX -1
 
@@ -95,6 +96,16 @@ class CORE_EXPORT CTriMesh {
 
   TriMeshConnectivity* Connectivity() const;
 
+  //! Массивы атрибутов, заданных в узлах сетки (POINT_DATA).
+  const std::vector<MeshField::Ptr>& PointFields() const;
+
+  //! Массивы атрибутов, заданных в треугольниках сетки (CELL_DATA).
+  const std::vector<MeshField::Ptr>& CellFields() const;
+
+  MeshField::Ptr FindPointField(const std::string& name) const;
+
+  MeshField::Ptr FindCellField(const std::string& name) const;
+
  protected:
   CTriMesh(size_t nbNodes, size_t nbCells);
 
@@ -106,6 +117,8 @@ class CORE_EXPORT CTriMesh {
   std::vector<NodeType> myNodes;
   std::vector<Cell> myCells;
   mutable TriMeshConnectivity* myConnectivity;
+  std::vector<MeshField::Ptr> myPointFields;
+  std::vector<MeshField::Ptr> myCellFields;
 };
 
 class TriMesh : public CTriMesh {
@@ -115,9 +128,13 @@ class TriMesh : public CTriMesh {
  public:
   static Ptr Create(size_t nbNodes, size_t nbCells);
 
+  //! Создает сетку, копируя узлы и треугольники.
   static Ptr Create(const std::vector<NodeType>& nodes,
                     const std::vector<Cell>& cells);
 
+  //! Создает сетку, забирая массивы во владение без копирования.
+  static Ptr Create(std::vector<NodeType>&& nodes, std::vector<Cell>&& cells);
+
  public:
   virtual ~TriMesh();
 
@@ -127,6 +144,14 @@ class TriMesh : public CTriMesh {
 
   void Transform(const glm::dmat4&);
 
+  //! Добавляет массив узловых атрибутов. Число кортежей должно совпадать
+  //! с числом узлов, имя - быть уникальным.
+  bool AddPointField(MeshField::Ptr);
+
+  //! Добавляет массив атрибутов треугольников. Число кортежей должно
+  //! совпадать с числом треугольников, имя - быть уникальным.
+  bool AddCellField(MeshField::Ptr);
+
  private:
   TriMesh(size_t nbNodes, size_t nbCells);
 };
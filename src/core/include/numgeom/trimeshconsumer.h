@@ -0,0 +1,58 @@
+#ifndef numgeom_numgeom_trimeshconsumer_h
+#define numgeom_numgeom_trimeshconsumer_h
+
+#include <cstddef>
+#include <vector>
+
+#include "numgeom/core_export.h"
+#include "numgeom/trimesh.h"
+
+/**\class TriMeshConsumer
+\brief Приемник узлов и треугольников, которые загрузчик выдает порциями.
+
+Загрузчик не хранит сетку целиком: узлы и треугольники передаются в том
+порядке, в котором они идут в файле, порциями ограниченного размера. Индексы
+узлов в треугольниках - глобальные, отсчитываются от начала файла.
+Если метод вернул `false`, загрузка прерывается.
+*/
+class CORE_EXPORT TriMeshConsumer {
+ public:
+  virtual ~TriMeshConsumer();
+
+  //! Оценка сверху числа узлов, вызывается до передачи первой порции узлов.
+  virtual void ReserveNodes(size_t nbNodes);
+
+  //! Оценка сверху числа треугольников, вызывается до первой их порции.
+  virtual void ReserveCells(size_t nbCells);
+
+  virtual bool AddNodes(const CTriMesh::NodeType* nodes, size_t count) = 0;
+
+  virtual bool AddCells(const CTriMesh::Cell* cells, size_t count) = 0;
+};
+
+/**\class TriMeshBuilder
+\brief Собирает порции в сетку без промежуточных копий.
+
+Узлы и треугольники накапливаются сразу в итоговых массивах, которые затем
+передаются во владение сетке через `TriMesh::Create(std::vector&&, ...)`.
+*/
+class CORE_EXPORT TriMeshBuilder : public TriMeshConsumer {
+ public:
+  TriMeshBuilder();
+
+  void ReserveNodes(size_t nbNodes) override;
+
+  void ReserveCells(size_t nbCells) override;
+
+  bool AddNodes(const CTriMesh::NodeType* nodes, size_t count) override;
+
+  bool AddCells(const CTriMesh::Cell* cells, size_t count) override;
+
+  //! Создает сетку из накопленных данных, опустошая построитель.
+  TriMesh::Ptr Release();
+
+ private:
+  std::vector<CTriMesh::NodeType> myNodes;
+  std::vector<CTriMesh::Cell> myCells;
+};
+#endif  // !numgeom_numgeom_trimeshconsumer_h
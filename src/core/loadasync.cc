@@ -0,0 +1,88 @@
+#include "numgeom/loadasync.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace {
+;
+
+std::mutex s_abandonedMutex;
+
+std::vector<std::unique_ptr<AbandonedLoads::Load>>& AbandonedList() {
+  // Список создается при первом отказе от загрузки, позже статических
+  // объектов загрузчиков. При выходе из программы он разрушается раньше них
+  // и дожидается загрузчиков, пока те еще могут работать.
+  static std::vector<std::unique_ptr<AbandonedLoads::Load>> s_loads;
+  return s_loads;
+}
+
+void ReleaseReady(std::vector<std::unique_ptr<AbandonedLoads::Load>>& loads) {
+  std::erase_if(loads, [](const std::unique_ptr<AbandonedLoads::Load>& load) {
+    return load->IsReady();
+  });
+}
+}  // namespace
+
+LoadProgress::LoadProgress(Callback callback)
+    : myTotalBytes(0),
+      myParsedBytes(0),
+      myTotalFaces(0),
+      myMeshedFaces(0),
+      myCancelled(false),
+      myCallback(std::move(callback)) {}
+
+void LoadProgress::SetTotalBytes(size_t nbBytes) {
+  myTotalBytes = nbBytes;
+  this->Notify();
+}
+
+void LoadProgress::SetParsedBytes(size_t nbBytes) {
+  myParsedBytes = nbBytes;
+  this->Notify();
+}
+
+void LoadProgress::AddParsedBytes(size_t nbBytes) {
+  myParsedBytes += nbBytes;
+  this->Notify();
+}
+
+void LoadProgress::SetTotalFaces(size_t nbFaces) {
+  myTotalFaces = nbFaces;
+  this->Notify();
+}
+
+void LoadProgress::AddMeshedFaces(size_t nbFaces) {
+  myMeshedFaces += nbFaces;
+  this->Notify();
+}
+
+double LoadProgress::Fraction() const {
+  auto ratio = [](size_t done, size_t total) {
+    return total == 0 ? 0.0
+                      : std::min(1.0, static_cast<double>(done) / total);
+  };
+  double parsed = ratio(myParsedBytes, myTotalBytes);
+  if (myTotalFaces == 0) return parsed;
+  return 0.5 * parsed + 0.5 * ratio(myMeshedFaces, myTotalFaces);
+}
+
+void LoadProgress::Notify() const {
+  if (!myCallback) return;
+  std::lock_guard<std::mutex> lock(myCallbackMutex);
+  myCallback(*this);
+}
+
+AbandonedLoads::Load::~Load() {}
+
+void AbandonedLoads::Add(std::unique_ptr<Load> load) {
+  std::lock_guard<std::mutex> lock(s_abandonedMutex);
+  auto& loads = AbandonedList();
+  ReleaseReady(loads);
+  loads.push_back(std::move(load));
+}
+
+void AbandonedLoads::Release() {
+  std::lock_guard<std::mutex> lock(s_abandonedMutex);
+  ReleaseReady(AbandonedList());
+}
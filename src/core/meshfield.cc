@@ -0,0 +1,42 @@
+#include "numgeom/meshfield.h"
+
+#include <cstring>
+
+MeshField::MeshField(const std::string& name, ValueType type,
+                     size_t nbComponents, size_t nbTuples)
+    : myName(name),
+      myType(type),
+      myNbComponents(nbComponents),
+      myNbTuples(nbTuples),
+      myData(nbComponents * nbTuples * SizeOf(type)) {}
+
+MeshField::Ptr MeshField::Create(const std::string& name, ValueType type,
+                                 size_t nbComponents, size_t nbTuples) {
+  if (nbComponents < 1 || nbComponents > 4) return Ptr();
+
+  return Ptr(new MeshField(name, type, nbComponents, nbTuples));
+}
+
+size_t MeshField::SizeOf(ValueType type) {
+  switch (type) {
+    case ValueType::Float:
+      return sizeof(float);
+    case ValueType::Double:
+      return sizeof(double);
+    case ValueType::Int:
+      return sizeof(int32_t);
+  }
+  return 0;
+}
+
+MeshField::Ptr MeshField::Extract(const std::vector<size_t>& tuples) const {
+  Ptr field = Create(myName, myType, myNbComponents, tuples.size());
+  size_t tupleSize = myNbComponents * SizeOf(myType);
+  const std::byte* src = myData.data();
+  std::byte* dst = field->myData.data();
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    assert(tuples[i] < myNbTuples);
+    std::memcpy(dst + i * tupleSize, src + tuples[i] * tupleSize, tupleSize);
+  }
+  return field;
+}
@@ -0,0 +1,47 @@
+#include "numgeom/parallelfor.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+size_t NbParallelThreads() {
+  static const size_t s_nbThreads =
+      std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  return s_nbThreads;
+}
+
+void ParallelFor(size_t n,
+                 const std::function<void(size_t begin, size_t end)>& body,
+                 size_t minBlockSize) {
+  if (n == 0) return;
+
+  minBlockSize = std::max<size_t>(minBlockSize, 1);
+  size_t nbBlocks = std::min(NbParallelThreads(), n / minBlockSize);
+  if (nbBlocks <= 1) {
+    body(0, n);
+    return;
+  }
+
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto run = [&](size_t iBlock) {
+    size_t begin = n * iBlock / nbBlocks;
+    size_t end = n * (iBlock + 1) / nbBlocks;
+    try {
+      body(begin, end);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error) error = std::current_exception();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nbBlocks - 1);
+  for (size_t i = 1; i < nbBlocks; ++i) threads.emplace_back(run, i);
+  run(0);
+  for (std::thread& t : threads) t.join();
+
+  if (error) std::rethrow_exception(error);
+}
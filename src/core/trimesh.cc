@@ -41,6 +41,34 @@ TriMeshConnectivity* CTriMesh::Connectivity() const {
   return myConnectivity;
 }
 
+const std::vector<MeshField::Ptr>& CTriMesh::PointFields() const {
+  return myPointFields;
+}
+
+const std::vector<MeshField::Ptr>& CTriMesh::CellFields() const {
+  return myCellFields;
+}
+
+namespace {
+;
+
+MeshField::Ptr FindField(const std::vector<MeshField::Ptr>& fields,
+                         const std::string& name) {
+  for (const MeshField::Ptr& field : fields) {
+    if (field->Name() == name) return field;
+  }
+  return MeshField::Ptr();
+}
+}  // namespace
+
+MeshField::Ptr CTriMesh::FindPointField(const std::string& name) const {
+  return FindField(myPointFields, name);
+}
+
+MeshField::Ptr CTriMesh::FindCellField(const std::string& name) const {
+  return FindField(myCellFields, name);
+}
+
 TriMesh::TriMesh(size_t nbNodes, size_t nbCells) : CTriMesh(nbNodes, nbCells) {}
 
 TriMesh::~TriMesh() {}
@@ -80,11 +108,33 @@ bool CTriMesh::Dump(const std::filesystem::path& fileName) const {
 TriMesh::Ptr TriMesh::Create(const std::vector<NodeType>& nodes,
                              const std::vector<Cell>& cells) {
   auto mesh = Ptr(new TriMesh(0, 0));
+  mesh->myNodes = nodes;
+  mesh->myCells = cells;
+  return mesh;
+}
+
+TriMesh::Ptr TriMesh::Create(std::vector<NodeType>&& nodes,
+                             std::vector<Cell>&& cells) {
+  auto mesh = Ptr(new TriMesh(0, 0));
   mesh->myNodes = std::move(nodes);
   mesh->myCells = std::move(cells);
   return mesh;
 }
 
+bool TriMesh::AddPointField(MeshField::Ptr field) {
+  if (!field || field->NbTuples() != this->NbNodes()) return false;
+  if (this->FindPointField(field->Name())) return false;
+  myPointFields.push_back(field);
+  return true;
+}
+
+bool TriMesh::AddCellField(MeshField::Ptr field) {
+  if (!field || field->NbTuples() != this->NbCells()) return false;
+  if (this->FindCellField(field->Name())) return false;
+  myCellFields.push_back(field);
+  return true;
+}
+
 void TriMesh::Transform(const glm::dmat4& tr) {
   std::transform(myNodes.begin(), myNodes.end(), myNodes.begin(),
                  [&](const NodeType& pt) { return tr * glm::dvec4(pt, 0.0); });
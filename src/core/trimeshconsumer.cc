@@ -0,0 +1,34 @@
+#include "numgeom/trimeshconsumer.h"
+
+TriMeshConsumer::~TriMeshConsumer() {}
+
+void TriMeshConsumer::ReserveNodes(size_t) {}
+
+void TriMeshConsumer::ReserveCells(size_t) {}
+
+TriMeshBuilder::TriMeshBuilder() {}
+
+void TriMeshBuilder::ReserveNodes(size_t nbNodes) {
+  myNodes.reserve(myNodes.size() + nbNodes);
+}
+
+void TriMeshBuilder::ReserveCells(size_t nbCells) {
+  myCells.reserve(myCells.size() + nbCells);
+}
+
+bool TriMeshBuilder::AddNodes(const CTriMesh::NodeType* nodes, size_t count) {
+  myNodes.insert(myNodes.end(), nodes, nodes + count);
+  return true;
+}
+
+bool TriMeshBuilder::AddCells(const CTriMesh::Cell* cells, size_t count) {
+  myCells.insert(myCells.end(), cells, cells + count);
+  return true;
+}
+
+TriMesh::Ptr TriMeshBuilder::Release() {
+  TriMesh::Ptr mesh = TriMesh::Create(std::move(myNodes), std::move(myCells));
+  myNodes.clear();
+  myCells.clear();
+  return mesh;
+}
@@ -294,7 +294,8 @@ Ray ScreenPosToRay(const Scene* scene, const glm::ivec2& screen_pos) {
 }
 
 Drawable* Application::Pick(Scene* scene, int x, int y,
-                            glm::vec3* picked_point) const {
+                            glm::vec3* picked_point,
+                            size_t* picked_triangle) const {
   auto id = impl_->renderer_->GetObjectId(scene, x, y);
   if (id == 0) return nullptr;
   Drawable* picked_item = nullptr;
@@ -307,9 +308,13 @@ Drawable* Application::Pick(Scene* scene, int x, int y,
     }
     if (picked_item) break;
   }
-  if (picked_item && picked_point) {
+  auto picked_surface = dynamic_cast<Drawable2*>(picked_item);
+  if (picked_surface && (picked_point || picked_triangle)) {
     Ray ray = ScreenPosToRay(scene, glm::ivec2(x, y));
-    *picked_point = IntersectRayWithDrawable(ray, dynamic_cast<Drawable2*>(picked_item));
+    glm::vec3 point =
+        IntersectRayWithDrawable(ray, picked_surface, picked_triangle);
+    if (picked_point)
+      *picked_point = point;
   }
   return picked_item;
 }
@@ -77,6 +77,14 @@ glm::uvec2 Camera::GetScreenSize() const {
   return sz;
 }
 
+float Camera::GetPixelScale() const {
+  if (!get_viewport_size_function_)
+    return 0.0f;
+  uint32_t width, height;
+  std::tie(width, height) = get_viewport_size_function_();
+  return height / (2.0f * std::tan(fov_y_ * 0.5f));
+}
+
 glm::vec3 Camera::GetPosition() const { return eye_; }
 
 glm::vec3 Camera::GetPivotPoint() const {
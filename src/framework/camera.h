@@ -25,6 +25,10 @@ class Camera {
 
   glm::uvec2 GetScreenSize() const;
 
+  //! Number of pixels covered by a unit segment perpendicular to the view
+  //! direction at unit distance from the camera; 0 if the viewport is unknown.
+  float GetPixelScale() const;
+
   glm::vec3 GetPosition() const;
   glm::vec3 GetPivotPoint() const;
   void SetPivotPoint(const glm::vec3&);
@@ -1,6 +1,9 @@
 #include "numgeom/drawable.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <vector>
 
 Drawable::Drawable(SceneObject* parent) {
   assert(parent != nullptr);
@@ -42,6 +45,16 @@ glm::vec3 Drawable::GetColor() const {
   return color_;
 }
 
+float* Drawable::CopyVertexColors(float* data) const {
+  for (size_t i = 0; i < this->GetVertsCount(); ++i) {
+    glm::vec3 c = this->GetVertexColor(i);
+    *data++ = c.x;
+    *data++ = c.y;
+    *data++ = c.z;
+  }
+  return data;
+}
+
 Drawable0::Drawable0(SceneObject* parent) : Drawable(parent) {
 }
 
@@ -76,6 +89,46 @@ Drawable2::Drawable2(SceneObject* parent) : Drawable(parent) {
 Drawable2::~Drawable2() {
 }
 
+void Drawable2::SetColorField(const std::string& name) {
+  if (name == color_field_)
+    return;
+  color_field_ = name;
+  this->SetColorsDirty();
+}
+
+float* Drawable2::CopyVertexColors(float* data) const {
+  MeshField::Ptr field;
+  if (!color_field_.empty())
+    field = this->GetPointField(color_field_);
+  if (!field || field->NbTuples() != this->GetVertsCount())
+    return Drawable::CopyVertexColors(data);
+
+  const size_t nbTuples = field->NbTuples();
+  const size_t nbComponents = field->NbComponents();
+  std::vector<float> values(nbTuples);
+  for (size_t i = 0; i < nbTuples; ++i) {
+    double value = field->GetValue(i, 0);
+    if (nbComponents > 1) {
+      double sum = 0.0;
+      for (size_t k = 0; k < nbComponents; ++k)
+        sum += field->GetValue(i, k) * field->GetValue(i, k);
+      value = std::sqrt(sum);
+    }
+    values[i] = static_cast<float>(value);
+  }
+  auto [itMin, itMax] = std::minmax_element(values.begin(), values.end());
+  const float vMin = nbTuples ? *itMin : 0.0f;
+  const float range = nbTuples ? *itMax - vMin : 0.0f;
+  const glm::vec3 low(0.0f, 0.0f, 1.0f), high(1.0f, 0.0f, 0.0f);
+  for (float v : values) {
+    glm::vec3 c = glm::mix(low, high, range > 0.0f ? (v - vMin) / range : 0.0f);
+    *data++ = c.x;
+    *data++ = c.y;
+    *data++ = c.z;
+  }
+  return data;
+}
+
 Drawable2* Drawable2::Cast(Drawable* d) {
   return dynamic_cast<Drawable2*>(d);
 }
@@ -73,7 +73,10 @@ class FRAMEWORK_EXPORT Application {
 
   void Sync();
 
-  Drawable* Pick(Scene*, int x, int y, glm::vec3* picked_point = nullptr) const;
+  //! Возвращает объект в точке экрана. В `picked_triangle`, если он задан,
+  //! пишется номер треугольника объекта в порядке `GetTriangles()`.
+  Drawable* Pick(Scene*, int x, int y, glm::vec3* picked_point = nullptr,
+                 size_t* picked_triangle = nullptr) const;
 
   const WorkplaneAttributes* GetWorkplaneAttributes() const;
 
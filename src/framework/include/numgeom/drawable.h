@@ -2,12 +2,17 @@
 #define NUMGEOM_FRAMEWORK_DRAWABLE_H
 
 #include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
 
 #include "numgeom/alignedboundbox.h"
 #include "numgeom/framework_export.h"
 #include "numgeom/iterator.h"
+#include "numgeom/meshfield.h"
 #include "numgeom/trackedobject.h"
 
+class Scene;
 class SceneObject;
 
 class FRAMEWORK_EXPORT Drawable : public TrackedObject {
@@ -55,11 +60,39 @@ class FRAMEWORK_EXPORT Drawable : public TrackedObject {
   */
   virtual AlignedBoundBox GetBoundBox() const;
 
+  /**
+  \brief Согласует объект с текущим видом сцены.
+
+  Вызывается перед синхронизацией сцены с рендерером. Объект, представление
+  которого зависит от положения камеры (например, детализация сетки), может
+  здесь измениться и отметить себя измененным. Возвращает `true`, если объект
+  продолжает подготовку в фоне и вызов следует повторить позже.
+  */
+  virtual bool UpdateView(const Scene&) { return false; }
+
   void SetColor(const glm::vec3& color);
   void SetColor(float r, float g, float b);
   void SetColor(int r, int g, int b);
   glm::vec3 GetColor() const;
 
+  /**
+  \brief Возвращает цвет вершины с номером `vertex` в порядке `GetVertices()`.
+
+  По умолчанию все вершины имеют цвет объекта. Объект, части которого
+  подсвечиваются по отдельности, переопределяет метод, так что подсветка
+  меняет только цвета вершин, а не сетку.
+  */
+  virtual glm::vec3 GetVertexColor(size_t vertex) const { return GetColor(); }
+
+  /**
+  \brief Копирует цвета всех вершин в порядке `GetVertices()`.
+
+  Возвращает указатель за последним записанным числом. По умолчанию
+  вызывает `GetVertexColor()` для каждой вершины; объект, цвета которого
+  заданы по частям, заполняет сразу диапазоны вершин.
+  */
+  virtual float* CopyVertexColors(float* data) const;
+
  private:
   SceneObject* parent_;
   uint32_t id_;
@@ -109,5 +142,53 @@ class FRAMEWORK_EXPORT Drawable2 : public Drawable {
   }
   virtual Iterator<glm::u32vec3> GetTriangles() const = 0;
   virtual Iterator<glm::vec3> GetNormals() const = 0;
+
+  /**
+  \brief Возвращает номера групп треугольников в порядке `GetTriangles()`.
+
+  Группа -- часть объекта, которую можно выбрать отдельно, например грань
+  B-rep фигуры. Пустой диапазон, если треугольники не разбиты на группы.
+  */
+  virtual std::span<const uint32_t> GetTriangleGroups() const { return {}; }
+
+  /**
+  \brief Возвращает непрерывные массивы вершин, нормалей и треугольников.
+
+  Порядок элементов совпадает с `GetVertices()`, `GetNormals()` и
+  `GetTriangles()`. Объект, хранящий такие массивы, позволяет копировать их
+  в буферы рендерера целиком, без обхода через итераторы. Пустой диапазон,
+  если массивов нет.
+  */
+  virtual std::span<const glm::vec3> GetVertexArray() const { return {}; }
+  virtual std::span<const glm::vec3> GetNormalArray() const { return {}; }
+  virtual std::span<const glm::u32vec3> GetTriangleArray() const {
+    return {};
+  }
+
+  /**
+  \brief Возвращает массив атрибутов вершин с именем `name` или пустой
+  указатель, если такого массива нет.
+
+  Значения лежат непрерывно в порядке вершин `GetVertices()` и используются
+  для цветовой раскраски без обхода вершин через итератор.
+  */
+  virtual MeshField::Ptr GetPointField(const std::string& name) const {
+    return MeshField::Ptr();
+  }
+
+  /**
+  \brief Раскрашивает вершины по массиву атрибутов `name`.
+
+  Значения (для векторов -- их длины) переводятся в цвета от синего к
+  красному в пределах диапазона массива. Пустое имя, а также отсутствующий
+  массив возвращают раскраску цветом объекта.
+  */
+  void SetColorField(const std::string& name);
+  const std::string& GetColorField() const { return color_field_; }
+
+  float* CopyVertexColors(float* data) const override;
+
+ private:
+  std::string color_field_;
 };
 #endif // !NUMGEOM_FRAMEWORK_DRAWABLE_H
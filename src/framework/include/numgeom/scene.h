@@ -59,8 +59,20 @@ class FRAMEWORK_EXPORT Scene : public TrackedObject {
   void RotateCamera(int x, int y, int dx, int dy);
 
   void OrientCamera(const OrthoBasis<float>&);
+
+  //! Число пикселей в отрезке единичной длины, перпендикулярном лучу зрения
+  //! и удаленном от камеры на единицу; 0, если размер окна неизвестен.
+  float GetPixelScale() const;
   //!@}
 
+  //! Согласует рисуемые объекты с текущим положением камеры (см.
+  //! `Drawable::UpdateView`). Возвращает `true`, если какие-то объекты
+  //! продолжают работу в фоне и сцену следует обновить позже.
+  bool UpdateView();
+
+  //! Результат последнего вызова `UpdateView`.
+  bool IsViewUpdatePending() const;
+
   //! Очищаем сцену от всех рисуемых объектов.
   void Clear();
 
@@ -24,10 +24,15 @@ class TrackedObject {
   bool IsDirty() const { return GetState() == State::Dirty; }
   bool IsRemoved() const { return GetState() == State::Removed; }
   bool IsDeleted() const { return GetState() == State::Delete; }
+
+  //! Изменились только цвета объекта или его подобъектов, а геометрия
+  //! осталась прежней, так что достаточно обновить буфер цветов.
+  bool IsColorsDirty() const;
   void Sync();
 
  protected:
   void SetDirty();
+  void SetColorsDirty();
   void AddSubObjects(const TrackedObjectList*);
 
  private:
@@ -37,6 +42,7 @@ class TrackedObject {
 
  private:
   State object_state_ = State::New;
+  bool colors_dirty_ = false;
   const TrackedObjectList* sub_objects_ = nullptr;
 };
 #endif // !NUMGEOM_FRAMEWORK_TRACKEDOBJECT_H
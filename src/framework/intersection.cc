@@ -39,7 +39,8 @@ struct RayProximity
 };
 }
 
-glm::vec3 IntersectRayWithDrawable(const Ray& ray1, const Drawable2* drawable) {
+glm::vec3 IntersectRayWithDrawable(const Ray& ray1, const Drawable2* drawable,
+                                   size_t* triangle) {
   // Подготавливаем массивы вершин и треугольников.
   std::vector<glm::vec3> verts(drawable->GetVertsCount());
   auto it_v = verts.begin();
@@ -57,7 +58,9 @@ glm::vec3 IntersectRayWithDrawable(const Ray& ray1, const Drawable2* drawable) {
   );
   RTQuery rtQuery{};
   RayProximity result;
-  for (glm::u32vec3 t : cells) {
+  size_t nearest = cells.size();
+  for (size_t i = 0; i < cells.size(); ++i) {
+    glm::u32vec3 t = cells[i];
     glm::vec3 p1 = verts[t.x];
     glm::vec3 p2 = verts[t.y];
     glm::vec3 p3 = verts[t.z];
@@ -74,7 +77,10 @@ glm::vec3 IntersectRayWithDrawable(const Ray& ray1, const Drawable2* drawable) {
         || rtResult.sqrDistance == result.dist2 && rtResult.parameter < result.tRay) {
       result.dist2 = rtResult.sqrDistance;
       result.tRay = rtResult.parameter;
+      nearest = i;
     }
   }
+  if (triangle)
+    *triangle = nearest;
   return ray1.origin + ray1.direction * result.tRay;
 }
@@ -1,11 +1,16 @@
 #ifndef NUMGEOM_FRAMEWORK_INTERSECTION_H
 #define NUMGEOM_FRAMEWORK_INTERSECTION_H
 
+#include <cstddef>
+
 #include "glm/glm.hpp"
 
 class Drawable2;
 class Ray;
 
-glm::vec3 IntersectRayWithDrawable(const Ray& ray, const Drawable2* drawable);
+//! Точка объекта, ближайшая к лучу. В `triangle`, если он задан, пишется
+//! номер треугольника с этой точкой в порядке `GetTriangles()`.
+glm::vec3 IntersectRayWithDrawable(const Ray& ray, const Drawable2* drawable,
+                                   size_t* triangle = nullptr);
 
 #endif // !NUMGEOM_FRAMEWORK_INTERSECTION_H
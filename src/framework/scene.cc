@@ -1,5 +1,6 @@
 #include "numgeom/scene.h"
 
+#include "numgeom/drawable.h"
 #include "numgeom/fgtext.h"
 #include "numgeom/iteratorimpl.hpp"
 #include "numgeom/sceneobject.h"
@@ -17,6 +18,7 @@ class SceneImpl {
   uint64_t vulkan_surface_ = 0;
   SelectionMode selection_mode_ = SelectionMode::Disable;
   bool workplane_enabled_;
+  bool view_update_pending_ = false;
 };
 
 Scene::Scene(const std::string& name) {
@@ -122,6 +124,24 @@ void Scene::OrientCamera(const OrthoBasis<float>& ortho_basis) {
   this->FitScene();
 }
 
+float Scene::GetPixelScale() const {
+  return impl_->camera_.GetPixelScale();
+}
+
+bool Scene::UpdateView() {
+  bool pending = false;
+  for (SceneObject* o : this->Objects()) {
+    for (Drawable* d : o->Drawables())
+      pending = d->UpdateView(*this) || pending;
+  }
+  impl_->view_update_pending_ = pending;
+  return pending;
+}
+
+bool Scene::IsViewUpdatePending() const {
+  return impl_->view_update_pending_;
+}
+
 void Scene::SetViewportSizeFunction(std::function<std::tuple<uint32_t,uint32_t>()> func) {
   impl_->camera_.SetViewportSizeFunction(func);
 }
@@ -1,5 +1,7 @@
 #include "sceneiterators.h"
 
+#include <cstring>
+
 #include "numgeom/drawable.h"
 #include "numgeom/trimeshconnectivity.h"
 #include "numgeom/scene.h"
@@ -341,7 +343,9 @@ class SceneColorIterator : public IteratorImpl<glm::vec3> {
     }
   }
 
-  glm::vec3 current() const override { return (*it_drawable_)->GetColor(); }
+  glm::vec3 current() const override {
+    return (*it_drawable_)->GetVertexColor(vertex_index_);
+  }
 
   IteratorImpl<glm::vec3>* clone() const override {
     return new SceneColorIterator(it_sceneobject_, it_drawable_, vertex_index_);
@@ -375,3 +379,76 @@ Iterator<glm::vec3> GetColorIterator(const Scene* scene) {
   auto impl = new SceneColorIterator(scene);
   return Iterator<glm::vec3>(impl);
 }
+
+namespace {
+float* CopyArray(std::span<const glm::vec3> values, float* data) {
+  std::memcpy(data, values.data(), values.size_bytes());
+  return data + 3 * values.size();
+}
+
+float* CopyIterator(Iterator<glm::vec3> values, float* data) {
+  for (glm::vec3 v : values) {
+    *data++ = v.x;
+    *data++ = v.y;
+    *data++ = v.z;
+  }
+  return data;
+}
+}
+
+float* CopyVertices(const Scene* scene, float* data) {
+  for (const SceneObject* o : scene->Objects()) {
+    for (Drawable* d : o->Drawables()) {
+      const Drawable2* d2 = Drawable2::Cast(d);
+      if (d2 && d2->GetVertexArray().size() == d->GetVertsCount())
+        data = CopyArray(d2->GetVertexArray(), data);
+      else
+        data = CopyIterator(d->GetVertices(), data);
+    }
+  }
+  return data;
+}
+
+float* CopyNormals(const Scene* scene, float* data) {
+  for (const SceneObject* o : scene->Objects()) {
+    for (Drawable2* d : GetTriaDrawables(o->Drawables())) {
+      if (d->GetNormalArray().size() == d->GetVertsCount())
+        data = CopyArray(d->GetNormalArray(), data);
+      else
+        data = CopyIterator(d->GetNormals(), data);
+    }
+  }
+  return data;
+}
+
+float* CopyColors(const Scene* scene, float* data) {
+  for (const SceneObject* o : scene->Objects()) {
+    for (Drawable* d : o->Drawables())
+      data = d->CopyVertexColors(data);
+  }
+  return data;
+}
+
+uint32_t* CopyTriangles(const Scene* scene, uint32_t* data) {
+  uint32_t vertex_offset = 0;
+  for (const SceneObject* o : scene->Objects()) {
+    for (Drawable2* d : GetTriaDrawables(o->Drawables())) {
+      std::span<const glm::u32vec3> triangles = d->GetTriangleArray();
+      if (triangles.size() == d->GetCellsCount()) {
+        for (glm::u32vec3 t : triangles) {
+          *data++ = t.x + vertex_offset;
+          *data++ = t.y + vertex_offset;
+          *data++ = t.z + vertex_offset;
+        }
+      } else {
+        for (glm::u32vec3 t : d->GetTriangles()) {
+          *data++ = t.x + vertex_offset;
+          *data++ = t.y + vertex_offset;
+          *data++ = t.z + vertex_offset;
+        }
+      }
+      vertex_offset += d->GetVertsCount();
+    }
+  }
+  return data;
+}
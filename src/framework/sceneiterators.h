@@ -1,6 +1,8 @@
 #ifndef NUMGEOM_FRAMEWORK_SCENEITERATORS_H
 #define NUMGEOM_FRAMEWORK_SCENEITERATORS_H
 
+#include <cstdint>
+
 #include "glm/glm.hpp"
 
 #include "numgeom/iterator.h"
@@ -25,4 +27,18 @@ Iterator<glm::u32vec3> GetTriaIterator(const Scene*);
 
 Iterator<Drawable2*> GetTriaDrawables(const Iterator<Drawable*>&);
 
+//! Копирует координаты вершин сцены в порядке `GetVertexIterator()`.
+//! Непрерывные массивы объектов копируются целиком. Возвращает указатель
+//! за последним записанным числом.
+float* CopyVertices(const Scene*, float* data);
+
+//! Копирует нормали сцены в порядке `GetNormalIterator()`.
+float* CopyNormals(const Scene*, float* data);
+
+//! Копирует цвета вершин сцены в порядке `GetColorIterator()`.
+float* CopyColors(const Scene*, float* data);
+
+//! Копирует индексы треугольников сцены в порядке `GetTriaIterator()`.
+uint32_t* CopyTriangles(const Scene*, uint32_t* data);
+
 #endif // !NUMGEOM_FRAMEWORK_SCENEITERATORS_H
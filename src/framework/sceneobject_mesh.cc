@@ -131,6 +131,10 @@ class Drawable2_TriMesh : public Drawable2 {
     return Iterator<glm::vec3>(impl);
   }
 
+  MeshField::Ptr GetPointField(const std::string& name) const override {
+    return mesh_->FindPointField(name);
+  }
+
  private:
   CTriMesh::Ptr mesh_;
 };
@@ -151,6 +155,10 @@ SceneObject_Mesh::SceneObject_Mesh(Scene* scene, CTriMesh::Ptr mesh)
     auto d = this->AddDrawable<Drawable2_TriMesh>(mesh);
     d->SetColor(s_colors[s_color_index]);
     s_color_index = (s_color_index + 1) % s_colors.size();
+    // Результаты расчета видны сразу: сетка раскрашивается по первому
+    // массиву атрибутов вершин.
+    if (!mesh->PointFields().empty())
+      d->SetColorField(mesh->PointFields().front()->Name());
   }
 }
 
@@ -24,12 +24,29 @@ TrackedObject::State TrackedObject::GetState() const {
   return State::Clean;
 }
 
+bool TrackedObject::IsColorsDirty() const {
+  if (colors_dirty_)
+    return true;
+  if (!sub_objects_)
+    return false;
+  for (TrackedObject* sub_object : sub_objects_->GetObjects()) {
+    if (sub_object->IsColorsDirty())
+      return true;
+  }
+  return false;
+}
+
 void TrackedObject::SetDirty() {
   assert(object_state_ != State::Removed);
   if (object_state_ != State::New)
     object_state_ = State::Dirty;
 }
 
+void TrackedObject::SetColorsDirty() {
+  assert(object_state_ != State::Removed);
+  colors_dirty_ = true;
+}
+
 void TrackedObject::Sync() {
   assert(object_state_ != State::Delete);
   switch (object_state_) {
@@ -44,6 +61,7 @@ void TrackedObject::Sync() {
   case State::Delete:
     std::abort();
   }
+  colors_dirty_ = false;
   if (sub_objects_) {
     for (TrackedObject* sub_object : sub_objects_->GetObjects())
       sub_object->Sync();
@@ -3278,12 +3278,7 @@ void UpdateScene(const Scene* scene, SceneRes* scene_res) {
     // Копируем вершины.
     void* mapped_data = nullptr;
     vmaMapMemory(allocator, scene_res->alloc_vertex, &mapped_data);
-    float* data = reinterpret_cast<float*>(mapped_data);
-    for (glm::vec3 pt : GetVertexIterator(scene)) {
-      *data++ = pt.x;
-      *data++ = pt.y;
-      *data++ = pt.z;
-    }
+    CopyVertices(scene, reinterpret_cast<float*>(mapped_data));
     vmaUnmapMemory(allocator, scene_res->alloc_vertex);
   }
 
@@ -3303,12 +3298,7 @@ void UpdateScene(const Scene* scene, SceneRes* scene_res) {
     // Копируем нормали.
     void* mapped_data = nullptr;
     vmaMapMemory(allocator, scene_res->alloc_normal, &mapped_data);
-    float* data = reinterpret_cast<float*>(mapped_data);
-    for (glm::vec3 n : GetNormalIterator(scene)) {
-      *data++ = n.x;
-      *data++ = n.y;
-      *data++ = n.z;
-    }
+    CopyNormals(scene, reinterpret_cast<float*>(mapped_data));
     vmaUnmapMemory(allocator, scene_res->alloc_normal);
   }
 
@@ -3328,12 +3318,7 @@ void UpdateScene(const Scene* scene, SceneRes* scene_res) {
     // Копируем цвета.
     void* mapped_data = nullptr;
     vmaMapMemory(allocator, scene_res->alloc_color, &mapped_data);
-    float* data = reinterpret_cast<float*>(mapped_data);
-    for (glm::vec3 c : GetColorIterator(scene)) {
-      *data++ = c.x;
-      *data++ = c.y;
-      *data++ = c.z;
-    }
+    CopyColors(scene, reinterpret_cast<float*>(mapped_data));
     vmaUnmapMemory(allocator, scene_res->alloc_color);
   }
 
@@ -3382,18 +3367,26 @@ void UpdateScene(const Scene* scene, SceneRes* scene_res) {
     // Копируем индексный буфер.
     void* mapped_data = nullptr;
     vmaMapMemory(allocator, scene_res->alloc_index, &mapped_data);
-    uint32_t* data = reinterpret_cast<uint32_t*>(mapped_data);
-    for (glm::u32vec3 tr : GetTriaIterator(scene)) {
-      *data++ = tr.x;
-      *data++ = tr.y;
-      *data++ = tr.z;
-    }
+    CopyTriangles(scene, reinterpret_cast<uint32_t*>(mapped_data));
     vmaUnmapMemory(allocator, scene_res->alloc_index);
   }
 
   scene_res->index_count = 3 * n_cells;
 }
 
+//! Перезаписывает только буфер цветов, когда геометрия сцены не изменилась
+//! (например, при выделении граней). Число вершин прежнее, так что буфер
+//! переиспользуется.
+void UpdateColors(const Scene* scene, SceneRes* scene_res) {
+  if (scene_res->buffer_color == VK_NULL_HANDLE)
+    return;
+  auto allocator = scene_res->vk_state->allocator;
+  void* mapped_data = nullptr;
+  vmaMapMemory(allocator, scene_res->alloc_color, &mapped_data);
+  CopyColors(scene, reinterpret_cast<float*>(mapped_data));
+  vmaUnmapMemory(allocator, scene_res->alloc_color);
+}
+
 void UpdateDescriptorSets(
     Scene* scene, SceneRes* scene_res,
     const std::map<const FgObject*,TextureRes*>& fg_res_array) {
@@ -3566,9 +3559,14 @@ bool Synchronize(Application* app, VulkanObjects* vk_objects, Scene* scene) {
     auto it = vk_objects->scene_res_array.find(scene);
     auto scene_res =
         (it != vk_objects->scene_res_array.end() ? it->second : nullptr);
+    // Объекты, зависящие от вида, могут измениться до выгрузки сцены.
+    if (!scene->IsRemoved())
+      scene->UpdateView();
     switch (scene->GetState()) {
     case TrackedObject::State::Clean:
       scene_res->RestoreInvalidated();
+      if (scene->IsColorsDirty())
+        UpdateColors(scene, scene_res);
       break;
     case TrackedObject::State::New:
       assert(scene_res == nullptr);
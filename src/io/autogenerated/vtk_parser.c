@@ -79,6 +79,8 @@
 /* First part of user prologue.  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vtk_parser.h"
 
 int vtklex();
@@ -88,7 +90,10 @@ int vtkwrap() { return 1; }
 void InsertNextValue(double);
 void PreparePointArray(int);
 void PrepareVtkLoading();
-void PreparePolygonArray(int, int);
+void PreparePolygonArray(int);
+void PrepareCellTypeArray();
+void PrepareFieldSection(int, int);
+void PrepareFieldArray(char*, int, int);
 
 
 # ifndef YY_CAST
@@ -137,21 +142,41 @@ enum yysymbol_kind_t
   YYSYMBOL_UNSTRUCTURED_GRID = 17,         /* UNSTRUCTURED_GRID  */
   YYSYMBOL_real = 18,                      /* real  */
   YYSYMBOL_integer = 19,                   /* integer  */
-  YYSYMBOL_YYACCEPT = 20,                  /* $accept  */
-  YYSYMBOL_Input = 21,                     /* Input  */
-  YYSYMBOL_22_1 = 22,                      /* $@1  */
-  YYSYMBOL_FileFormat = 23,                /* FileFormat  */
-  YYSYMBOL_DataSet = 24,                   /* DataSet  */
-  YYSYMBOL_StructuredGrid = 25,            /* StructuredGrid  */
-  YYSYMBOL_UnstructuredGrid = 26,          /* UnstructuredGrid  */
-  YYSYMBOL_27_2 = 27,                      /* $@2  */
-  YYSYMBOL_Polydata = 28,                  /* Polydata  */
-  YYSYMBOL_29_3 = 29,                      /* $@3  */
-  YYSYMBOL_30_4 = 30,                      /* $@4  */
-  YYSYMBOL_ValueType = 31,                 /* ValueType  */
-  YYSYMBOL_NumericValues = 32,             /* NumericValues  */
-  YYSYMBOL_IntValues = 33,                 /* IntValues  */
-  YYSYMBOL_Fields = 34                     /* Fields  */
+  YYSYMBOL_POINT_DATA = 20,                /* POINT_DATA  */
+  YYSYMBOL_CELL_DATA = 21,                 /* CELL_DATA  */
+  YYSYMBOL_SCALARS = 22,                   /* SCALARS  */
+  YYSYMBOL_VECTORS = 23,                   /* VECTORS  */
+  YYSYMBOL_NORMALS = 24,                   /* NORMALS  */
+  YYSYMBOL_LOOKUP_TABLE = 25,              /* LOOKUP_TABLE  */
+  YYSYMBOL_identifier = 26,                /* identifier  */
+  YYSYMBOL_YYACCEPT = 27,                  /* $accept  */
+  YYSYMBOL_Input = 28,                     /* Input  */
+  YYSYMBOL_29_1 = 29,                      /* $@1  */
+  YYSYMBOL_FileFormat = 30,                /* FileFormat  */
+  YYSYMBOL_DataSet = 31,                   /* DataSet  */
+  YYSYMBOL_StructuredGrid = 32,            /* StructuredGrid  */
+  YYSYMBOL_UnstructuredGrid = 33,          /* UnstructuredGrid  */
+  YYSYMBOL_34_2 = 34,                      /* $@2  */
+  YYSYMBOL_35_3 = 35,                      /* $@3  */
+  YYSYMBOL_36_4 = 36,                      /* $@4  */
+  YYSYMBOL_Polydata = 37,                  /* Polydata  */
+  YYSYMBOL_38_5 = 38,                      /* $@5  */
+  YYSYMBOL_39_6 = 39,                      /* $@6  */
+  YYSYMBOL_ValueType = 40,                 /* ValueType  */
+  YYSYMBOL_NumericValues = 41,             /* NumericValues  */
+  YYSYMBOL_IntValues = 42,                 /* IntValues  */
+  YYSYMBOL_Fields = 43,                    /* Fields  */
+  YYSYMBOL_FieldSection = 44,              /* FieldSection  */
+  YYSYMBOL_45_7 = 45,                      /* $@7  */
+  YYSYMBOL_46_8 = 46,                      /* $@8  */
+  YYSYMBOL_Attributes = 47,                /* Attributes  */
+  YYSYMBOL_Attribute = 48,                 /* Attribute  */
+  YYSYMBOL_49_9 = 49,                      /* $@9  */
+  YYSYMBOL_50_10 = 50,                     /* $@10  */
+  YYSYMBOL_51_11 = 51,                     /* $@11  */
+  YYSYMBOL_52_12 = 52,                     /* $@12  */
+  YYSYMBOL_LookupTable = 53,               /* LookupTable  */
+  YYSYMBOL_FieldValueType = 54             /* FieldValueType  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -482,19 +507,19 @@ union yyalloc
 /* YYFINAL -- State number of the termination state.  */
 #define YYFINAL  4
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   49
+#define YYLAST   88
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  20
+#define YYNTOKENS  27
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  15
+#define YYNNTS  28
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  23
+#define YYNRULES  44
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  56
+#define YYNSTATES  94
 
 /* YYMAXUTOK -- Last valid token kind.  */
-#define YYMAXUTOK   274
+#define YYMAXUTOK   281
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
@@ -535,16 +560,19 @@ static const yytype_int8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-      15,    16,    17,    18,    19
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26
 };
 
 #if VTKDEBUG
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
-static const yytype_int8 yyrline[] =
+static const yytype_uint8 yyrline[] =
 {
-       0,    47,    47,    47,    54,    54,    56,    56,    56,    59,
-      67,    66,    77,    79,    76,    83,    83,    86,    87,    88,
-      89,    92,    93,    96
+       0,    60,    60,    60,    67,    67,    69,    69,    69,    72,
+      80,    82,    84,    79,    90,    92,    89,    96,    96,    99,
+     100,   101,   102,   105,   106,   110,   111,   115,   115,   116,
+     116,   120,   121,   125,   125,   127,   127,   129,   129,   131,
+     131,   135,   138,   139,   140
 };
 #endif
 
@@ -564,9 +592,12 @@ static const char *const yytname[] =
   "VTK_DATAFILE_VERSION_3_0", "ASCII", "BINARY", "CELL_TYPES", "CELLS",
   "DATASET", "DIMENSIONS", "DOUBLE", "FLOAT", "POINTS", "POLYDATA",
   "POLYGONS", "STRUCTURED_GRID", "TITLE", "UNSTRUCTURED_GRID", "real",
-  "integer", "$accept", "Input", "$@1", "FileFormat", "DataSet",
-  "StructuredGrid", "UnstructuredGrid", "$@2", "Polydata", "$@3", "$@4",
-  "ValueType", "NumericValues", "IntValues", "Fields", YY_NULLPTR
+  "integer", "POINT_DATA", "CELL_DATA", "SCALARS", "VECTORS", "NORMALS",
+  "LOOKUP_TABLE", "identifier", "$accept", "Input", "$@1", "FileFormat",
+  "DataSet", "StructuredGrid", "UnstructuredGrid", "$@2", "$@3", "$@4",
+  "Polydata", "$@5", "$@6", "ValueType", "NumericValues", "IntValues",
+  "Fields", "FieldSection", "$@7", "$@8", "Attributes", "Attribute", "$@9",
+  "$@10", "$@11", "$@12", "LookupTable", "FieldValueType", YY_NULLPTR
 };
 
 static const char *
@@ -576,7 +607,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#define YYPACT_NINF (-47)
+#define YYPACT_NINF (-74)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -590,12 +621,16 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-       0,   -47,    13,     4,   -47,     7,   -47,   -47,    -1,     6,
-     -47,   -47,   -47,   -47,    18,    22,    20,   -47,     3,    15,
-      16,    14,    17,    14,   -47,   -47,   -47,    19,   -47,     8,
-      21,     8,   -47,   -47,    -9,    23,    -3,    24,   -47,   -47,
-      14,    25,    26,     8,    27,   -47,    10,    28,    28,   -47,
-      -5,    29,    30,   -47,    28,    29
+      18,   -74,    23,    11,   -74,    21,   -74,   -74,    34,     7,
+     -74,   -74,   -74,   -74,    31,    38,    36,     9,    12,    30,
+      32,    33,    35,   -74,    25,    37,    25,   -74,   -74,   -74,
+     -74,   -74,    39,   -74,   -10,   -10,    19,    41,    19,    24,
+      29,    40,   -10,   -74,   -10,   -74,   -74,    -8,    42,    -3,
+      -9,    -9,    -9,   -74,    43,   -74,   -74,    25,    44,   -74,
+     -74,   -74,    45,   -74,   -74,    46,    19,    48,   -74,    47,
+      19,    19,   -74,    22,   -74,    47,    49,    19,    22,    22,
+      50,    50,    19,   -74,    22,   -74,    51,    -1,    22,   -74,
+      52,   -74,    50,    51
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -604,25 +639,31 @@ static const yytype_int8 yypact[] =
 static const yytype_int8 yydefact[] =
 {
        0,     2,     0,     0,     1,     0,     4,     5,     0,     0,
-      23,     6,     7,     8,     0,     0,     0,     3,     0,     0,
-       0,     0,     0,     0,    16,    15,    12,     0,    10,     0,
-       0,     0,    17,    18,     0,     0,     0,     0,    19,    20,
-       0,     0,     0,     0,     0,    13,     9,     0,     0,    21,
-       0,    14,     0,    22,     0,    11
+      25,     6,     7,     8,     0,     0,     0,     3,     0,     0,
+       0,     0,     0,    26,     0,     0,     0,    27,    29,    18,
+      17,    14,     0,    10,     0,     0,     0,     0,     0,     0,
+       0,     0,    28,    31,    30,    19,    20,     0,     0,     0,
+       0,     0,     0,    32,     0,    21,    22,     0,     0,    43,
+      42,    44,    33,    37,    39,     0,     0,     0,    35,     0,
+       0,     0,    15,     9,    11,     0,     0,     0,    38,    40,
+       0,     0,     0,    41,    34,    23,    16,     0,    36,    24,
+       0,    12,     0,    13
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -47,   -47,   -47,   -47,   -47,   -47,   -47,   -47,   -47,   -47,
-     -47,   -23,   -25,   -46,   -47
+     -74,   -74,   -74,   -74,   -74,   -74,   -74,   -74,   -74,   -74,
+     -74,   -74,   -74,   -23,   -38,   -73,   -74,   -74,   -74,   -74,
+      53,   -35,   -74,   -74,   -74,   -74,   -18,    -6
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-       0,     2,     3,     8,    10,    11,    12,    31,    13,    29,
-      48,    26,    34,    50,    17
+       0,     2,     3,     8,    10,    11,    12,    38,    81,    92,
+      13,    36,    80,    31,    47,    86,    17,    23,    34,    35,
+      42,    43,    69,    75,    70,    71,    77,    62
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -630,48 +671,64 @@ static const yytype_int8 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-      28,    52,    51,     1,    41,    37,    36,     9,    55,    38,
-      39,     6,     7,     4,    53,    38,    39,    43,    46,    14,
-       5,    15,    21,    16,    24,    25,    32,    33,    38,    39,
-      18,    19,    20,    35,    22,    23,    27,     0,    30,     0,
-       0,     0,    40,    42,    44,    45,    47,    49,    53,    54
+      49,    59,    60,    33,    58,    90,    54,    53,    87,    53,
+      55,    56,    39,    40,    41,    55,    56,    61,    89,    93,
+      14,     1,    15,     4,    16,     6,     7,     5,    73,    21,
+      22,    24,    78,    79,    66,    29,    30,    45,    46,    84,
+      55,    56,     9,    18,    88,    63,    64,    19,    20,    25,
+      50,    26,    27,    48,    28,    51,    32,    82,    37,     0,
+       0,    57,    65,    67,    68,    72,    52,    74,     0,    85,
+      89,    91,    76,     0,     0,    83,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,    44
 };
 
 static const yytype_int8 yycheck[] =
 {
-      23,     6,    48,     3,     7,    14,    31,     8,    54,    18,
-      19,     4,     5,     0,    19,    18,    19,    40,    43,    13,
-      16,    15,    19,    17,    10,    11,    18,    19,    18,    19,
-      12,     9,    12,    12,    19,    19,    19,    -1,    19,    -1,
-      -1,    -1,    19,    19,    19,    19,    19,    19,    19,    19
+      38,    10,    11,    26,     7,     6,    14,    42,    81,    44,
+      18,    19,    22,    23,    24,    18,    19,    26,    19,    92,
+      13,     3,    15,     0,    17,     4,     5,    16,    66,    20,
+      21,    19,    70,    71,    57,    10,    11,    18,    19,    77,
+      18,    19,     8,    12,    82,    51,    52,     9,    12,    19,
+      26,    19,    19,    12,    19,    26,    19,    75,    19,    -1,
+      -1,    19,    19,    19,    19,    19,    26,    19,    -1,    19,
+      19,    19,    25,    -1,    -1,    26,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    35
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     3,    21,    22,     0,    16,     4,     5,    23,     8,
-      24,    25,    26,    28,    13,    15,    17,    34,    12,     9,
-      12,    19,    19,    19,    10,    11,    31,    19,    31,    29,
-      19,    27,    18,    19,    32,    12,    32,    14,    18,    19,
-      19,     7,    19,    31,    19,    19,    32,    19,    30,    19,
-      33,    33,     6,    19,    19,    33
+       0,     3,    28,    29,     0,    16,     4,     5,    30,     8,
+      31,    32,    33,    37,    13,    15,    17,    43,    12,     9,
+      12,    20,    21,    44,    19,    19,    19,    19,    19,    10,
+      11,    40,    19,    40,    45,    46,    38,    19,    34,    22,
+      23,    24,    47,    48,    47,    18,    19,    41,    12,    41,
+      26,    26,    26,    48,    14,    18,    19,    19,     7,    10,
+      11,    26,    54,    54,    54,    19,    40,    19,    19,    49,
+      51,    52,    19,    41,    19,    50,    25,    53,    41,    41,
+      39,    35,    53,    26,    41,    19,    42,    42,    41,    19,
+       6,    19,    36,    42
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    20,    22,    21,    23,    23,    24,    24,    24,    25,
-      27,    26,    29,    30,    28,    31,    31,    32,    32,    32,
-      32,    33,    33,    34
+       0,    27,    29,    28,    30,    30,    31,    31,    31,    32,
+      34,    35,    36,    33,    38,    39,    37,    40,    40,    41,
+      41,    41,    41,    42,    42,    43,    43,    45,    44,    46,
+      44,    47,    47,    49,    48,    50,    48,    51,    48,    52,
+      48,    53,    54,    54,    54
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     0,     6,     1,     1,     1,     1,     1,    10,
-       0,    14,     0,     0,    12,     1,     1,     1,     1,     2,
-       2,     1,     2,     0
+       0,     0,     0,    16,     0,     0,    12,     1,     1,     1,
+       1,     2,     2,     1,     2,     0,     2,     0,     4,     0,
+       4,     1,     2,     0,     6,     0,     7,     0,     5,     0,
+       5,     2,     1,     1,     1
 };
 
 
@@ -1526,38 +1583,94 @@ yyreduce:
                              { PreparePointArray((yyvsp[-1].integer)); }
     break;
 
-  case 12: /* $@3: %empty  */
+  case 11: /* $@3: %empty  */
+                          { PreparePolygonArray((yyvsp[-1].integer)); }
+    break;
+
+  case 12: /* $@4: %empty  */
+                       { PrepareCellTypeArray(); }
+    break;
+
+  case 14: /* $@5: %empty  */
                              { PreparePointArray((yyvsp[-1].integer)); }
     break;
 
-  case 13: /* $@4: %empty  */
-                             { PreparePolygonArray((yyvsp[-1].integer), (yyvsp[0].integer)); }
+  case 15: /* $@6: %empty  */
+                             { PreparePolygonArray((yyvsp[-1].integer)); }
     break;
 
-  case 17: /* NumericValues: real  */
+  case 19: /* NumericValues: real  */
                           { InsertNextValue((yyvsp[0].real)); }
     break;
 
-  case 18: /* NumericValues: integer  */
+  case 20: /* NumericValues: integer  */
                           { InsertNextValue((yyvsp[0].integer)); }
     break;
 
-  case 19: /* NumericValues: NumericValues real  */
+  case 21: /* NumericValues: NumericValues real  */
                           { InsertNextValue((yyvsp[0].real)); }
     break;
 
-  case 20: /* NumericValues: NumericValues integer  */
+  case 22: /* NumericValues: NumericValues integer  */
                           { InsertNextValue((yyvsp[0].integer)); }
     break;
 
-  case 21: /* IntValues: integer  */
+  case 23: /* IntValues: integer  */
                           { InsertNextValue((yyvsp[0].integer)); }
     break;
 
-  case 22: /* IntValues: IntValues integer  */
+  case 24: /* IntValues: IntValues integer  */
                           { InsertNextValue((yyvsp[0].integer)); }
     break;
 
+  case 27: /* $@7: %empty  */
+                       { PrepareFieldSection(0, (yyvsp[0].integer)); }
+    break;
+
+  case 29: /* $@8: %empty  */
+                       { PrepareFieldSection(1, (yyvsp[0].integer)); }
+    break;
+
+  case 33: /* $@9: %empty  */
+                                      { PrepareFieldArray((yyvsp[-1].string), (yyvsp[0].integer), 1); }
+    break;
+
+  case 35: /* $@10: %empty  */
+                                              { PrepareFieldArray((yyvsp[-2].string), (yyvsp[-1].integer), (yyvsp[0].integer)); }
+    break;
+
+  case 37: /* $@11: %empty  */
+                                      { PrepareFieldArray((yyvsp[-1].string), (yyvsp[0].integer), 3); }
+    break;
+
+  case 39: /* $@12: %empty  */
+                                      { PrepareFieldArray((yyvsp[-1].string), (yyvsp[0].integer), 3); }
+    break;
+
+  case 41: /* LookupTable: LOOKUP_TABLE identifier  */
+                                     { free((yyvsp[0].string)); }
+    break;
+
+  case 42: /* FieldValueType: FLOAT  */
+           { (yyval.integer) = 0; }
+    break;
+
+  case 43: /* FieldValueType: DOUBLE  */
+           { (yyval.integer) = 1; }
+    break;
+
+  case 44: /* FieldValueType: identifier  */
+               {
+      /* int не является ключевым словом, чтобы не менять разбор имен. */
+      (yyval.integer) = strcmp((yyvsp[0].string), "int") == 0 ? 2 : -1;
+      free((yyvsp[0].string));
+      if ((yyval.integer) < 0) {
+        vtkerror("unknown field value type");
+        YYABORT;
+      }
+    }
+    break;
+
 
 
       default: break;
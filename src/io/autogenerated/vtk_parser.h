@@ -78,7 +78,14 @@ extern int vtkdebug;
     TITLE = 271,                   /* TITLE  */
     UNSTRUCTURED_GRID = 272,       /* UNSTRUCTURED_GRID  */
     real = 273,                    /* real  */
-    integer = 274                  /* integer  */
+    integer = 274,                 /* integer  */
+    POINT_DATA = 275,              /* POINT_DATA  */
+    CELL_DATA = 276,               /* CELL_DATA  */
+    SCALARS = 277,                 /* SCALARS  */
+    VECTORS = 278,                 /* VECTORS  */
+    NORMALS = 279,                 /* NORMALS  */
+    LOOKUP_TABLE = 280,            /* LOOKUP_TABLE  */
+    identifier = 281               /* identifier  */
   };
   typedef enum vtktokentype vtktoken_kind_t;
 #endif
@@ -627,8 +627,8 @@ static void yynoreturn yy_fatal_error ( const char* msg  );
 	(yy_hold_char) = *yy_cp; \
 	*yy_cp = '\0'; \
 	(yy_c_buf_p) = yy_cp;
-#define YY_NUM_RULES 20
-#define YY_END_OF_BUFFER 21
+#define YY_NUM_RULES 27
+#define YY_END_OF_BUFFER 28
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -636,24 +636,29 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static const flex_int16_t yy_accept[145] =
+static const flex_int16_t yy_accept[193] =
     {   0,
-        0,    0,    3,    3,   21,   20,    1,   20,    5,   20,
-       20,   20,   20,   20,   20,   20,   20,   20,   20,    3,
-        4,    1,    5,    6,    0,    0,    0,    0,    0,    0,
-        0,    0,    0,    0,    0,    0,    0,    3,    6,    0,
-        6,    0,    0,    0,    0,    0,    0,    0,    0,    0,
-        0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
-        0,    0,    0,    0,    0,    7,    0,   10,    0,    0,
-        0,    0,    0,    0,    0,    0,    0,   14,    0,    0,
-        8,    0,    0,    0,   15,    0,    0,    0,    0,   13,
-        0,    0,   11,    0,    0,    0,    0,    0,    0,    0,
-
-        0,   16,   17,    0,    0,    0,    0,    0,    0,    0,
-        0,    9,   12,    0,    0,    0,    0,    0,    0,    0,
-        0,    0,    0,    0,    0,    0,    0,    0,    0,   18,
-        0,    0,    0,    0,   19,    0,    0,    0,    0,    0,
-        0,    0,    2,    0
+        0,    0,    3,    3,   28,   27,    1,   27,    5,   26,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+       26,   26,   26,   27,    3,    4,    1,    5,    6,    0,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,    0,
+        0,    3,    6,    0,    6,   26,   26,   26,   26,   26,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+        0,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+       26,   26,   26,   26,   26,   26,    0,    7,   26,   11,
+       26,   26,   26,   26,   26,   26,   26,   26,   26,   26,
+
+       26,   26,   26,   15,    0,    0,    8,   26,   26,   26,
+       26,   26,   26,   19,   26,   26,   26,   26,   26,   26,
+       26,   14,    0,   26,   26,   12,   26,   26,   17,   26,
+       26,   26,   23,   26,   26,   25,    0,   26,   26,   26,
+       26,   26,   20,   21,   26,   26,    0,    9,   26,   26,
+       26,   26,   26,   26,    0,   10,   13,   26,   18,   26,
+       26,    0,   26,   26,   26,    0,   16,   26,   26,    0,
+       26,   26,    0,    0,   26,   26,    0,   22,   26,    0,
+       26,    0,   24,    0,    0,    0,    0,    0,    0,    0,
+        2,    0
     } ;
 
 static const YY_CHAR yy_ec[256] =
@@ -665,13 +670,13 @@ static const YY_CHAR yy_ec[256] =
         1,    1,    6,    1,    7,    8,    1,    9,   10,   10,
        10,   11,   11,   11,   11,   11,   11,    1,    1,    1,
         1,    1,    1,    1,   12,   13,   14,   15,   16,   17,
-       18,    1,   19,    1,    1,   20,   21,   22,   23,   24,
-        1,   25,   26,   27,   28,   29,    1,    1,   30,    1,
-        1,    1,    1,    1,   31,    1,   32,   33,    1,   34,
+       18,   19,   20,   19,   21,   22,   23,   24,   25,   26,
+       19,   27,   28,   29,   30,   31,   19,   19,   32,   19,
+        1,    1,    1,    1,   33,    1,   34,   35,   19,   36,
 
-       35,   36,    1,    1,   37,    1,   38,   39,    1,   40,
-       41,    1,    1,   42,   43,   44,   45,   46,    1,    1,
-        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+       37,   38,   19,   19,   39,   19,   40,   41,   19,   42,
+       43,   19,   19,   44,   45,   46,   47,   48,   19,   19,
+       19,   19,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
@@ -688,124 +693,170 @@ static const YY_CHAR yy_ec[256] =
         1,    1,    1,    1,    1
     } ;
 
-static const YY_CHAR yy_meta[47] =
+static const YY_CHAR yy_meta[49] =
     {   0,
-        1,    1,    2,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    1,    1,    1,    1
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1
     } ;
 
-static const flex_int16_t yy_base[148] =
+static const flex_int16_t yy_base[193] =
     {   0,
-        0,   35,  203,  202,  204,  207,   14,   10,   44,  177,
-      183,  185,   10,  177,  172,  176,  156,  157,   19,    0,
-      207,   28,   64,   67,   75,  181,  172,  173,  165,  170,
-       37,  165,  163,  143,  146,   21,  142,    0,   78,   81,
-       86,  166,  172,  163,  170,  165,  158,  149,  150,  150,
-      143,  143,  136,  154,  147,   67,  145,  148,  142,   85,
-      154,  142,  127,  121,   47,  207,  134,  207,  136,  146,
-      135,  134,  147,  135,  130,  128,  120,  207,   97,  122,
-      207,  123,  125,  132,  207,  123,  127,  120,  133,  207,
-      102,  121,  207,  121,  131,  116,  116,  113,  107,  122,
-
-      115,  207,  207,  120,  107,  117,  107,  106,  116,  105,
-       92,  207,  207,   97,  111,   87,  107,  109,   88,   97,
-       90,    4,  101,  101,   37,   83,   96,   84,   66,  207,
-       88,   63,   90,   33,  207,   27,    3,   54,  100,   27,
-       18,    2,  207,  207,  113,  115,    0
+        1,   45,   50,    1,    1,    1,   97,   93,   97,  128,
+       86,   91,   96,   81,   85,   86,   87,  101,   93,  102,
+        1,   77,   80,  129,  177,    1,    1,    1,  114,  220,
+        1,    1,    1,    1,  112,    1,  103,  106,  100,  108,
+      107,  153,  212,  216,  206,  207,  222,  190,  195,    1,
+      193,    1,    1,  234,    1,  222,  231,  222,  233,  230,
+      226,  225,  225,  218,  229,  222,  224,  225,  220,  222,
+      217,  238,  232,  232,  233,  238,  233,  252,  237,  252,
+      256,  255,  244,  247,  232,  228,  271,    1,  244,    1,
+      262,  262,  251,  254,  259,  254,  271,  259,  258,  259,
+
+      259,  263,  255,    1,    1,  259,    1,  282,  263,  267,
+      277,  265,  271,    1,  285,  272,  278,  275,  274,  291,
+      278,    1,  261,  279,  283,    1,  285,  282,    1,  300,
+      301,  286,    1,  288,  287,    1,  283,  306,  303,  296,
+      309,  293,    1,    1,  307,  294,  308,    1,  298,  299,
+      315,  317,  315,  304,  293,    1,    1,  311,    1,  301,
+      319,  295,  321,  320,  324,  303,    1,  314,  309,  339,
+      324,  327,    1,  309,  332,  321,  305,    1,  330,  306,
+      337,  314,    1,  311,  313,  352,    1,  349,  349,  356,
+        1,  371
     } ;
 
-static const flex_int16_t yy_def[148] =
+static const flex_int16_t yy_def[193] =
     {   0,
-      145,  145,  146,  146,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  147,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  147,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,    0,  144,  144,  144
+      192,    1,  192,    3,  192,  192,  192,  192,    8,  192,
+       10,   10,   11,   10,   14,   14,   14,   14,   14,   12,
+       14,   14,   14,  192,  192,  192,    7,    9,    9,  192,
+       14,   14,   14,   14,   14,   14,   14,   14,   14,   14,
+       14,   14,   11,   14,   14,   10,   14,   14,   14,   24,
+      192,   25,   29,   30,   54,   11,   14,   14,   14,   12,
+       14,   14,   14,   14,   14,   14,   14,   14,   14,   14,
+      192,   11,   14,   10,   10,   14,   14,   14,   14,   14,
+       14,   14,   14,   14,   14,   14,  192,   14,   14,   14,
+       14,   12,   10,   14,   14,   10,   14,   14,   14,   14,
+
+       14,   14,   14,   14,   87,  192,   14,   14,   14,   14,
+       11,   14,   10,   14,   14,   14,   14,   10,   14,   14,
+       10,   14,  192,   14,   14,   14,   14,   14,   14,   14,
+       14,   10,   14,   14,   14,   14,  192,   14,   12,   14,
+       14,   14,   14,   14,   12,   14,  192,   14,   10,   10,
+       14,   14,   14,   14,  192,   14,   14,   14,   14,   14,
+       12,  192,   12,   14,   14,  192,   14,   14,   14,  192,
+       11,   14,  170,  192,   14,   14,  192,   14,   11,  192,
+       14,  192,   14,  192,  192,  192,  186,  192,  192,  192,
+      192,    0
     } ;
 
-static const flex_int16_t yy_nxt[254] =
+static const flex_int16_t yy_nxt[420] =
     {   0,
-       38,    7,    7,    7,  143,  144,    8,  125,    9,    9,
-        9,   10,   11,   12,   13,   22,   22,   22,   23,   23,
-       23,   29,   36,   14,   36,   15,  142,   16,   30,   22,
-       22,   22,  126,   17,  141,   18,    7,    7,    7,   19,
-      125,    8,  138,    9,    9,    9,   10,   11,   12,   13,
-       79,   24,   23,   23,   23,   47,   48,  139,   14,   25,
-       15,   80,   16,  140,   37,  126,   37,  137,   17,  136,
-       18,   24,   23,   23,   23,   39,   39,   39,   25,   25,
-       40,   40,   25,   41,   41,   41,   39,   39,   39,   41,
-       41,   41,   68,   25,   41,   41,   41,   69,   25,   73,
-
-       79,   25,   74,  139,  135,  134,  133,  132,  131,  140,
-      130,   80,   25,    6,    6,   20,   20,  129,  128,  127,
-      124,  123,  122,  121,  120,  119,  118,  117,  116,  115,
-      114,  113,  112,  111,  110,  109,  108,  107,  106,  105,
-      104,  103,  102,  101,  100,   99,   98,   97,   96,   95,
-       94,   93,   92,   91,   90,   89,   88,   87,   86,   85,
-       84,   83,   82,   81,   78,   77,   76,   75,   72,   71,
-       70,   67,   66,   65,   64,   63,   62,   61,   60,   59,
-       58,   57,   56,   55,   54,   53,   52,   51,   50,   49,
-       46,   45,   44,   43,   42,   35,   34,   33,   32,   31,
-
-       28,   27,   26,  144,   21,   21,    5,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144
+      192,    6,    7,    7,    7,    6,    6,    8,    6,    9,
+        9,    9,   10,   11,   12,   13,   14,   14,   14,   14,
+       14,   14,   15,   14,   16,   14,   17,   14,   18,   14,
+       19,   20,   14,   21,   14,   14,   22,   14,   23,   14,
+       14,   14,   14,   14,   14,   14,   14,   14,   14,   24,
+       25,   25,   26,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   27,   27,
+
+       27,   28,   28,   28,   29,   37,   38,   39,   34,   41,
+       42,   43,   30,   34,   44,   40,   46,   47,   34,   48,
+       49,  192,   53,   53,   53,   56,   57,   58,   59,   45,
+       60,   61,   50,   30,   31,   32,   33,   33,   33,   34,
+       34,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   34,   35,   34,   34,   34,   34,
+       36,   34,   34,   34,   34,   34,   34,   34,   34,   34,
+       34,   34,   34,   34,   34,   34,   51,   52,   52,   62,
+       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
+       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
+
+       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
+       52,   52,   52,   52,   52,   52,   52,   52,   52,   52,
+       52,   52,   52,   52,   52,   54,   54,   65,   55,   55,
+       55,   63,   66,   64,   67,   68,   69,   70,   71,  192,
+      192,   72,   73,   74,   75,   76,   77,   78,   79,   80,
+       81,   82,   83,   84,   85,   86,   87,   88,   89,   90,
+       92,   93,   94,   95,   91,   96,   97,   99,  100,   98,
+      101,  102,  103,  104,  105,  107,  108,  110,  111,  112,
+      113,  114,  116,  117,  118,  106,  115,  119,  120,  121,
+      109,  122,  123,  124,  125,  126,  127,  128,  129,  130,
+
+      131,  132,  133,  134,  135,  136,  137,  138,  139,  140,
+      141,  142,  143,  144,  145,  146,  147,  148,  149,  150,
+      151,  152,  153,  154,  155,  156,  157,  158,  159,  160,
+      161,  162,  163,  164,  165,  166,  167,  168,  169,  170,
+      171,  172,  173,  175,  176,  177,  178,  179,  180,  181,
+      182,  183,  184,  185,  186,  187,  189,  190,  191,    0,
+        0,  188,    0,    0,    0,    0,    0,    0,    0,  174,
+        5,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192
     } ;
 
-static const flex_int16_t yy_chk[254] =
+static const flex_int16_t yy_chk[420] =
     {   0,
-      147,    1,    1,    1,  142,    0,    1,  122,    1,    1,
-        1,    1,    1,    1,    1,    7,    7,    7,    8,    8,
-        8,   13,   19,    1,   36,    1,  141,    1,   13,   22,
-       22,   22,  122,    1,  140,    1,    2,    2,    2,    2,
-      125,    2,  137,    2,    2,    2,    2,    2,    2,    2,
-       65,    9,    9,    9,    9,   31,   31,  138,    2,    9,
-        2,   65,    2,  138,   19,  125,   36,  136,    2,  134,
-        2,   23,   23,   23,   23,   24,   24,   24,    9,   23,
-       25,   25,   24,   25,   25,   25,   39,   39,   39,   40,
-       40,   40,   56,   39,   41,   41,   41,   56,   23,   60,
-
-       79,   24,   60,  139,  133,  132,  131,  129,  128,  139,
-      127,   79,   39,  145,  145,  146,  146,  126,  124,  123,
-      121,  120,  119,  118,  117,  116,  115,  114,  111,  110,
-      109,  108,  107,  106,  105,  104,  101,  100,   99,   98,
-       97,   96,   95,   94,   92,   91,   89,   88,   87,   86,
-       84,   83,   82,   80,   77,   76,   75,   74,   73,   72,
-       71,   70,   69,   67,   64,   63,   62,   61,   59,   58,
-       57,   55,   54,   53,   52,   51,   50,   49,   48,   47,
-       46,   45,   44,   43,   42,   37,   35,   34,   33,   32,
-       30,   29,   28,   27,   26,   18,   17,   16,   15,   14,
-
-       12,   11,   10,    5,    4,    3,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144,  144,  144,  144,  144,  144,  144,  144,
-      144,  144,  144
+        5,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    2,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    7,    7,
+
+        7,    8,    8,    8,    9,   11,   12,   13,   14,   15,
+       16,   17,    9,   11,   18,   13,   19,   20,   12,   22,
+       23,   29,   29,   29,   29,   35,   37,   38,   39,   18,
+       40,   41,   24,    9,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   10,   10,   10,   10,
+       10,   10,   10,   10,   10,   10,   24,   25,   25,   42,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   25,   25,   25,   25,   25,
+       25,   25,   25,   25,   25,   30,   30,   44,   30,   30,
+       30,   43,   45,   43,   46,   47,   48,   49,   51,   54,
+       54,   56,   57,   58,   59,   60,   61,   62,   63,   64,
+       65,   66,   67,   68,   69,   70,   71,   72,   73,   74,
+       75,   76,   77,   78,   74,   79,   80,   81,   82,   80,
+       83,   84,   85,   86,   87,   89,   91,   92,   93,   94,
+       95,   96,   97,   98,   99,   87,   96,  100,  101,  102,
+       91,  103,  106,  108,  109,  110,  111,  112,  113,  115,
+
+      116,  117,  118,  119,  120,  121,  123,  124,  125,  127,
+      128,  130,  131,  132,  134,  135,  137,  138,  139,  140,
+      141,  142,  145,  146,  147,  149,  150,  151,  152,  153,
+      154,  155,  158,  160,  161,  162,  163,  164,  165,  166,
+      168,  169,  170,  171,  172,  174,  175,  176,  177,  179,
+      180,  181,  182,  184,  185,  186,  188,  189,  190,    0,
+        0,  186,    0,    0,    0,    0,    0,    0,    0,  170,
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+
+      192,  192,  192,  192,  192,  192,  192,  192,  192,  192,
+      192,  192,  192,  192,  192,  192,  192,  192,  192
     } ;
 
 /* Table of booleans, true if rule could match eol. */
-static const flex_int32_t yy_rule_can_match_eol[21] =
+static const flex_int32_t yy_rule_can_match_eol[28] =
     {   0,
 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-    0,     };
+    0, 0, 0, 0, 0, 0, 0, 0,     };
 
 static yy_state_type yy_last_accepting_state;
 static char *yy_last_accepting_cpos;
@@ -822,6 +873,8 @@ int yy_flex_debug = 0;
 #define YY_RESTORE_YY_MORE_OFFSET
 char *yytext;
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vtk_parser.h"
 #define YY_NO_UNISTD_H 1
 
@@ -1071,13 +1124,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 145 )
+				if ( yy_current_state >= 193 )
 					yy_c = yy_meta[yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
 			++yy_cp;
 			}
-		while ( yy_current_state != 144 );
+		while ( yy_current_state != 192 );
 		yy_cp = (yy_last_accepting_cpos);
 		yy_current_state = (yy_last_accepting_state);
 
@@ -1153,50 +1206,81 @@ YY_RULE_SETUP
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-{ return CELL_TYPES; }
+{ return CELL_DATA; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-{ return CELLS; }
+{ return CELL_TYPES; }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-{ return DATASET; }
+{ return CELLS; }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-{ return DIMENSIONS; }
+{ return DATASET; }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-{ return DOUBLE; }
+{ return DIMENSIONS; }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-{ return FLOAT; }
+{ return DOUBLE; }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-{ return POINTS; }
+{ return FLOAT; }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-{ return POLYDATA; }
+{ return LOOKUP_TABLE; }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-{ return POLYGONS; }
+{ return NORMALS; }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-{ return STRUCTURED_GRID; }
+{ return POINT_DATA; }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-{ return UNSTRUCTURED_GRID; }
+{ return POINTS; }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
+{ return POLYDATA; }
+	YY_BREAK
+case 21:
+YY_RULE_SETUP
+{ return POLYGONS; }
+	YY_BREAK
+case 22:
+YY_RULE_SETUP
+{ return STRUCTURED_GRID; }
+	YY_BREAK
+case 23:
+YY_RULE_SETUP
+{ return SCALARS; }
+	YY_BREAK
+case 24:
+YY_RULE_SETUP
+{ return UNSTRUCTURED_GRID; }
+	YY_BREAK
+case 25:
+YY_RULE_SETUP
+{ return VECTORS; }
+	YY_BREAK
+case 26:
+YY_RULE_SETUP
+{
+                  vtklval.string = strdup(yytext);
+                  return identifier;
+                }
+	YY_BREAK
+case 27:
+YY_RULE_SETUP
 ECHO;
 	YY_BREAK
 case YY_STATE_EOF(INITIAL):
@@ -1498,7 +1582,7 @@ static int yy_get_next_buffer (void)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 145 )
+			if ( yy_current_state >= 193 )
 				yy_c = yy_meta[yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
@@ -1526,11 +1610,11 @@ static int yy_get_next_buffer (void)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 145 )
+		if ( yy_current_state >= 193 )
 			yy_c = yy_meta[yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
-	yy_is_jam = (yy_current_state == 144);
+	yy_is_jam = (yy_current_state == 192);
 
 		return yy_is_jam ? 0 : yy_current_state;
 }
@@ -3,9 +3,20 @@
 
 #include <filesystem>
 
+#include "numgeom/loadasync.h"
 #include "numgeom/numgeomio_export.h"
 #include "numgeom/trimesh.h"
+#include "numgeom/trimeshconsumer.h"
 
-IO_EXPORT TriMesh::Ptr LoadTriMeshFromVtk(const std::filesystem::path&);
+IO_EXPORT TriMesh::Ptr LoadTriMeshFromVtk(const std::filesystem::path&,
+                                          LoadProgress* progress = nullptr);
+
+//! Потоковая загрузка: узлы и треугольники передаются приемнику порциями не
+//! больше `chunkSize` элементов, сетка целиком в памяти не собирается.
+//! Атрибуты POINT_DATA/CELL_DATA в этом режиме не загружаются.
+IO_EXPORT bool LoadTriMeshFromVtk(const std::filesystem::path&,
+                                  TriMeshConsumer& consumer,
+                                  size_t chunkSize = 1 << 16,
+                                  LoadProgress* progress = nullptr);
 
 #endif  // !numgeom_numgeom_loadfromvtk_h
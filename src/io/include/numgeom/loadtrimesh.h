@@ -0,0 +1,35 @@
+#ifndef numgeom_numgeom_loadtrimesh_h
+#define numgeom_numgeom_loadtrimesh_h
+
+#include <filesystem>
+
+#include "numgeom/loadasync.h"
+#include "numgeom/numgeomio_export.h"
+#include "numgeom/trimesh.h"
+
+//! Загружает STL-файл (текстовый или двоичный). Совпадающие вершины
+//! соседних треугольников сливаются в один узел.
+IO_EXPORT TriMesh::Ptr LoadTriMeshFromStl(const std::filesystem::path&,
+                                          LoadProgress* progress = nullptr);
+
+//! Загружает вершины и грани OBJ-файла. Многоугольные грани разбиваются
+//! веером на треугольники, текстурные координаты и нормали игнорируются.
+IO_EXPORT TriMesh::Ptr LoadTriMeshFromObj(const std::filesystem::path&,
+                                          LoadProgress* progress = nullptr);
+
+//! Загружает двоичный PLY-файл (binary_little_endian/binary_big_endian).
+IO_EXPORT TriMesh::Ptr LoadTriMeshFromPly(const std::filesystem::path&,
+                                          LoadProgress* progress = nullptr);
+
+//! Выбирает загрузчик по расширению файла: vtk, stl, obj или ply.
+//! Загрузчики сообщают в `progress` число разобранных байтов и прерываются,
+//! возвращая пустой указатель, если загрузка отменена.
+IO_EXPORT TriMesh::Ptr LoadTriMesh(const std::filesystem::path&,
+                                   LoadProgress* progress = nullptr);
+
+//! Выполняет `LoadTriMesh` в отдельном потоке.
+IO_EXPORT AsyncLoad<TriMesh::Ptr> LoadTriMeshAsync(
+    const std::filesystem::path&,
+    LoadProgress::Callback callback = LoadProgress::Callback());
+
+#endif  // !numgeom_numgeom_loadtrimesh_h
@@ -0,0 +1,187 @@
+#include "numgeom/loadtrimesh.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+#include "numgeom/parallelfor.h"
+
+#include "mappedfile.h"
+
+namespace {
+;
+
+//! Минимальный размер блока текста, разбираемого одним потоком.
+const size_t kTextBlockSize = 1 << 20;
+
+/**\struct ObjBlock
+\brief Результат разбора участка файла, состоящего из целых строк.
+
+Индексы вершин граней хранятся до перевода в глобальную нумерацию: четное
+значение `2 * i` - номер `i` вершины от начала файла, нечетное `2 * i + 1` -
+номер `i` вершины от начала блока (для относительных ссылок `i` может быть
+отрицательным, если вершина задана в одном из предыдущих блоков).
+*/
+struct ObjBlock {
+  std::vector<glm::dvec3> nodes;
+  std::vector<int64_t> cells;
+  bool failed = false;
+};
+
+bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char* SkipBlanks(const char* p, const char* end) {
+  while (p != end && IsBlank(*p)) ++p;
+  return p;
+}
+
+const char* SkipToken(const char* p, const char* end) {
+  while (p != end && !IsBlank(*p) && *p != '\n') ++p;
+  return p;
+}
+
+bool ParseVertex(const char* p, const char* end, ObjBlock& block) {
+  glm::dvec3 node;
+  for (int k = 0; k < 3; ++k) {
+    p = SkipBlanks(p, end);
+    if (p != end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, node[k]);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+  }
+  block.nodes.push_back(node);
+  return true;
+}
+
+bool ParseFace(const char* p, const char* end, ObjBlock& block) {
+  int64_t face[3];
+  size_t n = 0;
+  while (true) {
+    p = SkipBlanks(p, end);
+    if (p == end || *p == '\n') break;
+
+    // Из ссылки вида `v/vt/vn` используем только номер вершины.
+    int64_t index = 0;
+    auto result = std::from_chars(p, end, index);
+    if (result.ec != std::errc() || index == 0) return false;
+    p = SkipToken(result.ptr, end);
+
+    if (index > 0)
+      index = 2 * (index - 1);
+    else
+      index = 2 * (static_cast<int64_t>(block.nodes.size()) + index) + 1;
+
+    // Многоугольник разбиваем веером треугольников с вершиной в первом узле.
+    if (n < 2) {
+      face[n++] = index;
+      continue;
+    }
+    face[2] = index;
+    block.cells.insert(block.cells.end(), face, face + 3);
+    face[1] = face[2];
+  }
+  return true;
+}
+
+void ParseBlock(std::string_view text, ObjBlock& block) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  while (p != end) {
+    p = SkipBlanks(p, end);
+    const char* lineEnd = std::find(p, end, '\n');
+    if (lineEnd - p > 1 && p[0] == 'v' && IsBlank(p[1])) {
+      if (!ParseVertex(p + 2, lineEnd, block)) {
+        block.failed = true;
+        return;
+      }
+    } else if (lineEnd - p > 1 && p[0] == 'f' && IsBlank(p[1])) {
+      if (!ParseFace(p + 2, lineEnd, block)) {
+        block.failed = true;
+        return;
+      }
+    }
+    p = (lineEnd == end) ? end : lineEnd + 1;
+  }
+}
+}  // namespace
+
+TriMesh::Ptr LoadTriMeshFromObj(const std::filesystem::path& fileName,
+                                LoadProgress* progress) {
+  MappedFile file;
+  if (!file.Open(fileName) || file.Size() == 0) return TriMesh::Ptr();
+  if (progress) progress->SetTotalBytes(file.Size());
+
+  std::string_view text(file.Data(), file.Size());
+  size_t size = text.size();
+
+  // Границы блоков выравниваем на начало строки.
+  size_t nbBlocks = std::max<size_t>(1, size / kTextBlockSize);
+  std::vector<size_t> bounds(nbBlocks + 1, size);
+  bounds[0] = 0;
+  for (size_t i = 1; i < nbBlocks; ++i) {
+    size_t pos = std::max(bounds[i - 1], size * i / nbBlocks);
+    pos = text.find('\n', pos);
+    bounds[i] = (pos == std::string_view::npos) ? size : pos + 1;
+  }
+
+  std::vector<ObjBlock> blocks(nbBlocks);
+  ParallelFor(nbBlocks, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (progress && progress->IsCancelled()) {
+        blocks[i].failed = true;
+        continue;
+      }
+      ParseBlock(text.substr(bounds[i], bounds[i + 1] - bounds[i]), blocks[i]);
+      if (progress) progress->AddParsedBytes(bounds[i + 1] - bounds[i]);
+    }
+  });
+  file.Close();
+
+  // Номера первых вершин блоков для перевода относительных ссылок.
+  std::vector<size_t> nodeOffsets(nbBlocks + 1, 0);
+  std::vector<size_t> cellOffsets(nbBlocks + 1, 0);
+  for (size_t i = 0; i < nbBlocks; ++i) {
+    if (blocks[i].failed) return TriMesh::Ptr();
+    nodeOffsets[i + 1] = nodeOffsets[i] + blocks[i].nodes.size();
+    cellOffsets[i + 1] = cellOffsets[i] + blocks[i].cells.size() / 3;
+  }
+  size_t nbNodes = nodeOffsets[nbBlocks];
+  size_t nbCells = cellOffsets[nbBlocks];
+  if (nbNodes == 0 || nbCells == 0) return TriMesh::Ptr();
+
+  std::vector<TriMesh::NodeType> nodes(nbNodes);
+  std::vector<TriMesh::Cell> cells(nbCells);
+  std::vector<char> blockFailed(nbBlocks, 0);
+  ParallelFor(nbBlocks, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ObjBlock& block = blocks[i];
+      std::copy(block.nodes.begin(), block.nodes.end(),
+                nodes.begin() + nodeOffsets[i]);
+      block.nodes = std::vector<glm::dvec3>();
+
+      size_t nbBlockCells = block.cells.size() / 3;
+      for (size_t j = 0; j < nbBlockCells; ++j) {
+        size_t ids[3];
+        for (size_t k = 0; k < 3; ++k) {
+          int64_t code = block.cells[3 * j + k];
+          int64_t index = code / 2;
+          if (code % 2 != 0)
+            index = static_cast<int64_t>(nodeOffsets[i]) + (code - 1) / 2;
+          if (index < 0 || static_cast<size_t>(index) >= nbNodes) {
+            blockFailed[i] = 1;
+            index = 0;
+          }
+          ids[k] = static_cast<size_t>(index);
+        }
+        cells[cellOffsets[i] + j] = TriMesh::Cell(ids);
+      }
+      block.cells = std::vector<int64_t>();
+    }
+  });
+  if (std::find(blockFailed.begin(), blockFailed.end(), 1) !=
+      blockFailed.end())
+    return TriMesh::Ptr();
+
+  return TriMesh::Create(std::move(nodes), std::move(cells));
+}
@@ -0,0 +1,354 @@
+#include "numgeom/loadtrimesh.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "numgeom/parallelfor.h"
+
+#include "mappedfile.h"
+
+namespace {
+;
+
+enum class PlyType {
+  None,
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64
+};
+
+struct PlyProperty {
+  std::string name;
+  PlyType type = PlyType::None;
+  // Для списков: тип счетчика элементов списка.
+  PlyType countType = PlyType::None;
+};
+
+struct PlyElement {
+  std::string name;
+  size_t count = 0;
+  std::vector<PlyProperty> properties;
+};
+
+PlyType ParsePlyType(const std::string& name) {
+  if (name == "char" || name == "int8") return PlyType::Int8;
+  if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+  if (name == "short" || name == "int16") return PlyType::Int16;
+  if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+  if (name == "int" || name == "int32") return PlyType::Int32;
+  if (name == "uint" || name == "uint32") return PlyType::UInt32;
+  if (name == "float" || name == "float32") return PlyType::Float32;
+  if (name == "double" || name == "float64") return PlyType::Float64;
+  return PlyType::None;
+}
+
+size_t SizeOf(PlyType type) {
+  switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+      return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+      return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+      return 4;
+    case PlyType::Float64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+template <typename T>
+T ReadRaw(const char* p, bool swapBytes) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, p, sizeof(T));
+  if (swapBytes) std::reverse(bytes, bytes + sizeof(T));
+  T v;
+  std::memcpy(&v, bytes, sizeof(T));
+  return v;
+}
+
+double ReadValue(const char* p, PlyType type, bool swapBytes) {
+  switch (type) {
+    case PlyType::Int8:
+      return ReadRaw<int8_t>(p, swapBytes);
+    case PlyType::UInt8:
+      return ReadRaw<uint8_t>(p, swapBytes);
+    case PlyType::Int16:
+      return ReadRaw<int16_t>(p, swapBytes);
+    case PlyType::UInt16:
+      return ReadRaw<uint16_t>(p, swapBytes);
+    case PlyType::Int32:
+      return ReadRaw<int32_t>(p, swapBytes);
+    case PlyType::UInt32:
+      return ReadRaw<uint32_t>(p, swapBytes);
+    case PlyType::Float32:
+      return ReadRaw<float>(p, swapBytes);
+    case PlyType::Float64:
+      return ReadRaw<double>(p, swapBytes);
+    default:
+      return 0.0;
+  }
+}
+
+//! Разбирает текстовый заголовок. Возвращает смещение начала данных или 0.
+size_t ParseHeader(std::string_view text, bool& swapBytes,
+                   std::vector<PlyElement>& elements) {
+  if (text.substr(0, 4) != "ply\n" && text.substr(0, 5) != "ply\r\n") return 0;
+
+  size_t headerEnd = text.find("end_header");
+  if (headerEnd == std::string_view::npos) return 0;
+  size_t dataStart = text.find('\n', headerEnd);
+  if (dataStart == std::string_view::npos) return 0;
+
+  std::istringstream header(std::string(text.substr(0, headerEnd)));
+  std::string line;
+  bool hasFormat = false;
+  while (std::getline(header, line)) {
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+    if (keyword == "format") {
+      std::string format;
+      tokens >> format;
+      if (format == "binary_little_endian")
+        swapBytes = std::endian::native != std::endian::little;
+      else if (format == "binary_big_endian")
+        swapBytes = std::endian::native != std::endian::big;
+      else
+        return 0;
+      hasFormat = true;
+    } else if (keyword == "element") {
+      PlyElement element;
+      tokens >> element.name >> element.count;
+      if (!tokens) return 0;
+      elements.push_back(element);
+    } else if (keyword == "property") {
+      if (elements.empty()) return 0;
+      PlyProperty property;
+      std::string type;
+      tokens >> type;
+      if (type == "list") {
+        std::string countType;
+        tokens >> countType >> type;
+        property.countType = ParsePlyType(countType);
+        if (property.countType == PlyType::None) return 0;
+      }
+      property.type = ParsePlyType(type);
+      tokens >> property.name;
+      if (!tokens || property.type == PlyType::None) return 0;
+      elements.back().properties.push_back(property);
+    }
+  }
+  return hasFormat ? dataStart + 1 : 0;
+}
+
+//! Размер записи элемента без списков или 0, если в элементе есть списки.
+size_t FixedRecordSize(const PlyElement& element) {
+  size_t size = 0;
+  for (const PlyProperty& property : element.properties) {
+    if (property.countType != PlyType::None) return 0;
+    size += SizeOf(property.type);
+  }
+  return size;
+}
+
+//! Размер значения свойства, начинающегося с `p`, или 0 при выходе за `end`.
+size_t PropertySize(const PlyProperty& property, const char* p,
+                    const char* end, bool swapBytes) {
+  size_t size = SizeOf(property.type);
+  if (property.countType != PlyType::None) {
+    size_t countSize = SizeOf(property.countType);
+    if (static_cast<size_t>(end - p) < countSize) return 0;
+    double count = ReadValue(p, property.countType, swapBytes);
+    if (count < 0) return 0;
+    size = countSize + static_cast<size_t>(count) * size;
+  }
+  return (static_cast<size_t>(end - p) < size) ? 0 : size;
+}
+
+//! Пропускает `count` записей элемента. Возвращает nullptr при выходе за
+//! `end`.
+const char* SkipRecords(const PlyElement& element, size_t count,
+                        const char* p, const char* end, bool swapBytes) {
+  size_t recordSize = FixedRecordSize(element);
+  if (recordSize != 0) {
+    if (static_cast<size_t>(end - p) / recordSize < count) return nullptr;
+    return p + count * recordSize;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    for (const PlyProperty& property : element.properties) {
+      size_t size = PropertySize(property, p, end, swapBytes);
+      if (size == 0) return nullptr;
+      p += size;
+    }
+  }
+  return p;
+}
+
+bool LoadVertices(const PlyElement& element, const char* data,
+                  const char* end, bool swapBytes,
+                  std::vector<TriMesh::NodeType>& nodes) {
+  size_t recordSize = FixedRecordSize(element);
+  if (recordSize == 0) return false;
+  if (static_cast<size_t>(end - data) / recordSize < element.count)
+    return false;
+
+  size_t offsets[3];
+  PlyType types[3];
+  const char* names[3] = {"x", "y", "z"};
+  for (int k = 0; k < 3; ++k) {
+    size_t offset = 0;
+    types[k] = PlyType::None;
+    for (const PlyProperty& property : element.properties) {
+      if (property.name == names[k]) {
+        offsets[k] = offset;
+        types[k] = property.type;
+        break;
+      }
+      offset += SizeOf(property.type);
+    }
+    if (types[k] == PlyType::None) return false;
+  }
+
+  nodes.resize(element.count);
+  ParallelFor(
+      element.count,
+      [&](size_t iBegin, size_t iEnd) {
+        for (size_t i = iBegin; i < iEnd; ++i) {
+          const char* p = data + i * recordSize;
+          for (int k = 0; k < 3; ++k)
+            nodes[i][k] = ReadValue(p + offsets[k], types[k], swapBytes);
+        }
+      },
+      1 << 14);
+  return true;
+}
+
+//! Загружает грани и возвращает указатель на конец их записей или nullptr.
+const char* LoadFaces(const PlyElement& element, const char* data,
+                      const char* end, bool swapBytes,
+                      std::vector<TriMesh::Cell>& cells) {
+  auto itIndices = std::find_if(
+      element.properties.begin(), element.properties.end(),
+      [](const PlyProperty& property) {
+        return property.countType != PlyType::None &&
+               (property.name == "vertex_indices" ||
+                property.name == "vertex_index");
+      });
+  if (itIndices == element.properties.end()) return nullptr;
+
+  // Число граней из заголовка проверяем до выделения памяти: запись грани
+  // не короче скалярных свойств, счетчиков списков и трех индексов.
+  size_t minRecordSize = 3 * SizeOf(itIndices->type);
+  for (const PlyProperty& property : element.properties) {
+    minRecordSize += property.countType != PlyType::None
+                         ? SizeOf(property.countType)
+                         : SizeOf(property.type);
+  }
+  if (static_cast<size_t>(end - data) / minRecordSize < element.count)
+    return nullptr;
+
+  // Последовательно вычисляем положения списков индексов и число
+  // треугольников, которые дадут многоугольники, разбитые веером.
+  std::vector<const char*> faces(element.count);
+  std::vector<size_t> cellOffsets(element.count + 1, 0);
+  const char* p = data;
+  for (size_t i = 0; i < element.count; ++i) {
+    size_t n = 0;
+    for (auto it = element.properties.begin(); it != element.properties.end();
+         ++it) {
+      size_t size = PropertySize(*it, p, end, swapBytes);
+      if (size == 0) return nullptr;
+      if (it == itIndices) {
+        faces[i] = p;
+        n = static_cast<size_t>(ReadValue(p, it->countType, swapBytes));
+      }
+      p += size;
+    }
+    cellOffsets[i + 1] = cellOffsets[i] + (n >= 3 ? n - 2 : 0);
+  }
+
+  cells.resize(cellOffsets.back());
+  size_t countSize = SizeOf(itIndices->countType);
+  size_t indexSize = SizeOf(itIndices->type);
+  ParallelFor(
+      element.count,
+      [&](size_t iBegin, size_t iEnd) {
+        for (size_t i = iBegin; i < iEnd; ++i) {
+          const char* q = faces[i] + countSize;
+          size_t nbCells = cellOffsets[i + 1] - cellOffsets[i];
+          // Отрицательные и слишком большие индексы заменяем недопустимым,
+          // чтобы сетку отвергла проверка индексов после загрузки.
+          auto index = [&](size_t k) {
+            double value =
+                ReadValue(q + k * indexSize, itIndices->type, swapBytes);
+            if (!(value >= 0.0 && value <= UINT32_MAX))
+              return static_cast<size_t>(NONE_INDEX);
+            return static_cast<size_t>(value);
+          };
+          for (size_t j = 0; j < nbCells; ++j)
+            cells[cellOffsets[i] + j] =
+                TriMesh::Cell(index(0), index(j + 1), index(j + 2));
+        }
+      },
+      1 << 14);
+  return p;
+}
+}  // namespace
+
+TriMesh::Ptr LoadTriMeshFromPly(const std::filesystem::path& fileName,
+                                LoadProgress* progress) {
+  MappedFile file;
+  if (!file.Open(fileName) || file.Size() == 0) return TriMesh::Ptr();
+  if (progress) progress->SetTotalBytes(file.Size());
+
+  std::string_view text(file.Data(), file.Size());
+  bool swapBytes = false;
+  std::vector<PlyElement> elements;
+  size_t dataStart = ParseHeader(text, swapBytes, elements);
+  if (dataStart == 0) return TriMesh::Ptr();
+
+  std::vector<TriMesh::NodeType> nodes;
+  std::vector<TriMesh::Cell> cells;
+  const char* p = file.Data() + dataStart;
+  const char* end = file.Data() + file.Size();
+  for (const PlyElement& element : elements) {
+    // Элементы загружаются целиком, поэтому отмену проверяем между ними.
+    if (progress && progress->IsCancelled()) return TriMesh::Ptr();
+    if (element.name == "vertex") {
+      if (!LoadVertices(element, p, end, swapBytes, nodes))
+        return TriMesh::Ptr();
+      p += element.count * FixedRecordSize(element);
+    } else if (element.name == "face") {
+      p = LoadFaces(element, p, end, swapBytes, cells);
+    } else {
+      p = SkipRecords(element, element.count, p, end, swapBytes);
+    }
+    if (!p) return TriMesh::Ptr();
+    if (progress) progress->SetParsedBytes(p - file.Data());
+  }
+  file.Close();
+
+  for (const TriMesh::Cell& cell : cells) {
+    if (cell.na >= nodes.size() || cell.nb >= nodes.size() ||
+        cell.nc >= nodes.size())
+      return TriMesh::Ptr();
+  }
+  if (nodes.empty() || cells.empty()) return TriMesh::Ptr();
+
+  return TriMesh::Create(std::move(nodes), std::move(cells));
+}
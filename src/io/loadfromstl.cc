@@ -0,0 +1,172 @@
+#include "numgeom/loadtrimesh.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "numgeom/parallelfor.h"
+
+#include "mappedfile.h"
+#include "trianglesoup.h"
+
+namespace {
+;
+
+const size_t kBinaryHeaderSize = 84;
+const size_t kBinaryFacetSize = 50;
+
+//! Минимальный размер блока текста, разбираемого одним потоком.
+const size_t kTextBlockSize = 1 << 20;
+
+//! Число фасет двоичного файла между проверками отмены загрузки.
+const size_t kProgressStep = 1 << 16;
+
+bool IsCancelled(const LoadProgress* progress) {
+  return progress && progress->IsCancelled();
+}
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+         c == '\f';
+}
+
+uint32_t ReadUInt32(const char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+float ReadFloat(const char* p) {
+  float v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+bool IsBinaryStl(const char* data, size_t size) {
+  if (size < kBinaryHeaderSize) return false;
+  uint64_t nbFacets = ReadUInt32(data + 80);
+  // Некоторые программы дописывают байты после фасет, поэтому файл может
+  // быть длиннее. В текстовом файле на месте числа фасет стоят символы,
+  // и требуемый размер оказывается больше гигабайта.
+  return size >= kBinaryHeaderSize + nbFacets * kBinaryFacetSize;
+}
+
+bool LoadBinaryStl(const char* data, std::vector<glm::dvec3>& soup,
+                   LoadProgress* progress) {
+  size_t nbFacets = ReadUInt32(data + 80);
+  soup.resize(3 * nbFacets);
+  if (progress) progress->AddParsedBytes(kBinaryHeaderSize);
+  ParallelFor(
+      nbFacets,
+      [&](size_t begin, size_t end) {
+        for (size_t step = begin; step < end; step += kProgressStep) {
+          if (IsCancelled(progress)) return;
+          size_t stepEnd = std::min(end, step + kProgressStep);
+          for (size_t i = step; i < stepEnd; ++i) {
+            // Пропускаем нормаль: 12 байт перед вершинами.
+            const char* p =
+                data + kBinaryHeaderSize + i * kBinaryFacetSize + 12;
+            for (size_t j = 0; j < 3; ++j, p += 12) {
+              soup[3 * i + j] = glm::dvec3(ReadFloat(p), ReadFloat(p + 4),
+                                           ReadFloat(p + 8));
+            }
+          }
+          if (progress)
+            progress->AddParsedBytes((stepEnd - step) * kBinaryFacetSize);
+        }
+      },
+      1 << 14);
+  return !IsCancelled(progress);
+}
+
+//! Разбирает участок текста, содержащий целое число фасет, и добавляет
+//! координаты вершин в `soup`.
+bool ParseTextBlock(std::string_view text, std::vector<glm::dvec3>& soup) {
+  const std::string_view keyword = "vertex";
+  const char* end = text.data() + text.size();
+  size_t pos = 0;
+  while ((pos = text.find(keyword, pos)) != std::string_view::npos) {
+    const char* p = text.data() + pos + keyword.size();
+    bool isToken = (pos == 0 || IsSpace(text[pos - 1])) && p != end &&
+                   IsSpace(*p);
+    pos += keyword.size();
+    if (!isToken) continue;
+
+    glm::dvec3 node;
+    for (int k = 0; k < 3; ++k) {
+      while (p != end && IsSpace(*p)) ++p;
+      if (p != end && *p == '+') ++p;
+      auto result = std::from_chars(p, end, node[k]);
+      if (result.ec != std::errc()) return false;
+      p = result.ptr;
+    }
+    soup.push_back(node);
+    pos = p - text.data();
+  }
+  return soup.size() % 3 == 0;
+}
+
+bool LoadTextStl(const char* data, size_t size, std::vector<glm::dvec3>& soup,
+                 LoadProgress* progress) {
+  std::string_view text(data, size);
+
+  // Границы блоков выравниваем на конец фасеты, чтобы каждый блок содержал
+  // только целые треугольники.
+  size_t nbBlocks = std::max<size_t>(1, size / kTextBlockSize);
+  std::vector<size_t> bounds(nbBlocks + 1, size);
+  bounds[0] = 0;
+  for (size_t i = 1; i < nbBlocks; ++i) {
+    size_t pos = std::max(bounds[i - 1], size * i / nbBlocks);
+    pos = text.find("endfacet", pos);
+    bounds[i] = (pos == std::string_view::npos) ? size : pos + 8;
+  }
+
+  std::vector<std::vector<glm::dvec3>> blocks(nbBlocks);
+  std::vector<char> blockFailed(nbBlocks, 0);
+  ParallelFor(nbBlocks, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      std::string_view block =
+          text.substr(bounds[i], bounds[i + 1] - bounds[i]);
+      if (IsCancelled(progress)) {
+        blockFailed[i] = 1;
+        continue;
+      }
+      blocks[i].reserve(block.size() / 80);
+      if (!ParseTextBlock(block, blocks[i])) blockFailed[i] = 1;
+      if (progress) progress->AddParsedBytes(block.size());
+    }
+  });
+
+  size_t nbSoupNodes = 0;
+  for (size_t i = 0; i < nbBlocks; ++i) {
+    if (blockFailed[i]) return false;
+    nbSoupNodes += blocks[i].size();
+  }
+  soup.reserve(nbSoupNodes);
+  for (std::vector<glm::dvec3>& block : blocks) {
+    soup.insert(soup.end(), block.begin(), block.end());
+    block = std::vector<glm::dvec3>();
+  }
+  return true;
+}
+}  // namespace
+
+TriMesh::Ptr LoadTriMeshFromStl(const std::filesystem::path& fileName,
+                                LoadProgress* progress) {
+  MappedFile file;
+  if (!file.Open(fileName) || file.Size() == 0) return TriMesh::Ptr();
+  if (progress) progress->SetTotalBytes(file.Size());
+
+  // Двоичный файл тоже может начинаться со слова "solid", поэтому сначала
+  // проверяем соответствие размера файла числу фасет в заголовке.
+  std::vector<glm::dvec3> soup;
+  bool ok = IsBinaryStl(file.Data(), file.Size())
+                ? LoadBinaryStl(file.Data(), soup, progress)
+                : LoadTextStl(file.Data(), file.Size(), soup, progress);
+  file.Close();
+  if (!ok || soup.empty() || IsCancelled(progress)) return TriMesh::Ptr();
+
+  return CreateFromTriangleSoup(soup);
+}
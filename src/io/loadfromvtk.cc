@@ -1,8 +1,10 @@
 #include "numgeom/loadfromvtk.h"
 
+#include <algorithm>
 #include <cassert>
-
-#include "numgeom/staticjaggedarray.h"
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
 
 static std::string s_vtkerror;
 
@@ -13,6 +15,8 @@ extern "C" {
 
 extern FILE* vtkin;
 extern int vtklineno;
+void vtkrestart(FILE* file);
+int vtklex_destroy();
 
 void vtkerror(const char* str) {
   std::stringstream ss;
@@ -21,64 +25,177 @@ void vtkerror(const char* str) {
 }
 
 struct VtkGridData {
-  std::vector<glm::dvec3> points;
-  StaticJaggedArray cells;
-  size_t index, index2;
+  // Узлы и треугольники передаются приемнику порциями по `chunkSize`.
+  TriMeshConsumer* consumer;
+  size_t chunkSize;
+  bool consumerFailed;
+  // Ход загрузки обновляется при передаче каждой порции.
+  LoadProgress* progress;
+  // Загружать ли атрибуты; при потоковой загрузке они пропускаются.
+  bool loadFields;
+  std::vector<glm::dvec3> nodeChunk;
+  std::vector<TriMesh::Cell> cellChunk;
+  // Узлы текущей ячейки и признаки того, что ячейка - треугольник.
+  std::vector<size_t> cellNodes;
+  std::vector<bool> isTriaCell;
+  std::vector<MeshField::Ptr> pointFields;
+  std::vector<MeshField::Ptr> cellFields;
+  size_t index;
   size_t num;
   bool loadPointArray;
   bool loadPolydataArray;
   bool loadCellArray;
   bool loadCellTypeArray;
+  bool loadFieldArray;
+  // Секция атрибутов, в которую загружаются массивы: 0 - POINT_DATA,
+  // 1 - CELL_DATA, и число кортежей в ней.
+  int fieldLocation;
+  size_t fieldTuples;
+  // Загружаемый массив атрибутов; пустой, если значения пропускаются.
+  MeshField* field;
 
   void ClearFlags() {
+    FlushChunks();
     loadPointArray = false;
     loadPolydataArray = false;
     loadCellArray = false;
     loadCellTypeArray = false;
+    loadFieldArray = false;
+  }
+
+  //! Прерывает разбор: файл переводится в конец, а буфер сканера
+  //! сбрасывается, поэтому следующей лексемой разборщик получит EOF и
+  //! завершится с ошибкой.
+  void Abort() {
+    consumerFailed = true;
+    fseek(vtkin, 0, SEEK_END);
+    vtkrestart(vtkin);
+  }
+
+  void FlushChunks() {
+    if (!nodeChunk.empty()) {
+      if (!consumerFailed &&
+          !consumer->AddNodes(nodeChunk.data(), nodeChunk.size()))
+        Abort();
+      nodeChunk.clear();
+    }
+    if (!cellChunk.empty()) {
+      if (!consumerFailed &&
+          !consumer->AddCells(cellChunk.data(), cellChunk.size()))
+        Abort();
+      cellChunk.clear();
+    }
+    if (progress) {
+      long pos = ftell(vtkin);
+      if (pos >= 0) progress->SetParsedBytes(static_cast<size_t>(pos));
+      if (progress->IsCancelled() && !consumerFailed) Abort();
+    }
   }
 };
 
 static VtkGridData s_fileData;
 
 void PrepareVtkLoading() {
+  s_fileData.nodeChunk.clear();
+  s_fileData.cellChunk.clear();
   s_fileData.ClearFlags();
-  s_fileData.points.clear();
-  s_fileData.cells.Clear();
+  s_fileData.isTriaCell.clear();
+  s_fileData.pointFields.clear();
+  s_fileData.cellFields.clear();
 }
 
 void PreparePointArray(int count) {
   s_fileData.ClearFlags();
   s_fileData.loadPointArray = true;
-  s_fileData.points.resize(count);
+  s_fileData.consumer->ReserveNodes(count);
+  s_fileData.nodeChunk.reserve(std::min<size_t>(count, s_fileData.chunkSize));
   s_fileData.index = 0;
 }
 
-void PreparePolygonArray(int rows, int n) {
+void PreparePolygonArray(int rows) {
   s_fileData.ClearFlags();
   s_fileData.loadPolydataArray = true;
-  s_fileData.cells.Initialize(rows, n - rows);
-  s_fileData.index = 0;
-  s_fileData.index2 = 0;
+  s_fileData.consumer->ReserveCells(rows);
+  s_fileData.cellChunk.reserve(std::min<size_t>(rows, s_fileData.chunkSize));
+  if (s_fileData.loadFields) s_fileData.isTriaCell.reserve(rows);
   s_fileData.num = 0;
 }
 
+void PrepareCellTypeArray() {
+  s_fileData.ClearFlags();
+  s_fileData.loadCellTypeArray = true;
+}
+
+void PrepareFieldSection(int location, int count) {
+  s_fileData.ClearFlags();
+  s_fileData.fieldLocation = location;
+  s_fileData.fieldTuples = count;
+}
+
+void PrepareFieldArray(char* name, int type, int nbComponents) {
+  s_fileData.ClearFlags();
+  MeshField::ValueType valueType = MeshField::ValueType::Float;
+  if (type == 1)
+    valueType = MeshField::ValueType::Double;
+  else if (type == 2)
+    valueType = MeshField::ValueType::Int;
+  MeshField::Ptr field;
+  if (s_fileData.loadFields)
+    field = MeshField::Create(name, valueType, nbComponents,
+                              s_fileData.fieldTuples);
+  free(name);
+  if (field) {
+    if (s_fileData.fieldLocation == 0)
+      s_fileData.pointFields.push_back(field);
+    else
+      s_fileData.cellFields.push_back(field);
+  }
+  s_fileData.loadFieldArray = true;
+  s_fileData.field = field.get();
+  s_fileData.index = 0;
+}
+
 void InsertNextValue(double val) {
   if (s_fileData.loadPointArray) {
-    size_t idx = s_fileData.index / 3;
     size_t comp = s_fileData.index % 3;
-    s_fileData.points[idx][comp] = val;
+    if (comp == 0) {
+      if (s_fileData.nodeChunk.size() == s_fileData.chunkSize)
+        s_fileData.FlushChunks();
+      s_fileData.nodeChunk.emplace_back();
+    }
+    s_fileData.nodeChunk.back()[comp] = val;
     ++s_fileData.index;
   } else if (s_fileData.loadPolydataArray) {
     if (s_fileData.num == 0) {
       s_fileData.num = static_cast<size_t>(val);
-      s_fileData.cells.Offsets()[s_fileData.index2 + 1] =
-          s_fileData.cells.Offsets()[s_fileData.index2] + s_fileData.num;
-      ++s_fileData.index2;
+      s_fileData.cellNodes.clear();
+      if (s_fileData.num == 0 && s_fileData.loadFields)
+        s_fileData.isTriaCell.push_back(false);
     } else {
-      s_fileData.cells.Data()[s_fileData.index] = static_cast<size_t>(val);
-      ++s_fileData.index;
-      --s_fileData.num;
+      s_fileData.cellNodes.push_back(static_cast<size_t>(val));
+      if (--s_fileData.num == 0) {
+        bool isTria = s_fileData.cellNodes.size() == 3;
+        if (s_fileData.loadFields) s_fileData.isTriaCell.push_back(isTria);
+        if (isTria) {
+          if (s_fileData.cellChunk.size() == s_fileData.chunkSize)
+            s_fileData.FlushChunks();
+          s_fileData.cellChunk.emplace_back(s_fileData.cellNodes.data());
+        }
+      }
     }
+  } else if (s_fileData.loadCellTypeArray) {
+    // Типы ячеек не сохраняем: из ячеек оставляем только треугольники,
+    // которые определяем по числу узлов.
+  } else if (s_fileData.loadFieldArray) {
+    // Пропускаем массивы с неподдерживаемым числом компонент, а также все
+    // массивы при потоковой загрузке.
+    MeshField* field = s_fileData.field;
+    if (!field) return;
+    size_t nbComponents = field->NbComponents();
+    size_t tuple = s_fileData.index / nbComponents;
+    if (tuple < field->NbTuples())
+      field->SetValue(tuple, s_fileData.index % nbComponents, val);
+    ++s_fileData.index;
   } else {
     assert(false);
     abort();
@@ -86,35 +203,93 @@ void InsertNextValue(double val) {
 }
 }
 
-TriMesh::Ptr LoadTriMeshFromVtk(const std::filesystem::path& fileName) {
+namespace {
+;
+
+//! Сканер и разборщик хранят состояние в глобальных переменных, поэтому
+//! файлы, загружаемые из разных потоков, разбираются по очереди.
+std::mutex s_parseMutex;
+
+bool ParseVtk(const std::filesystem::path& fileName, TriMeshConsumer& consumer,
+              size_t chunkSize, bool loadFields, LoadProgress* progress) {
   FILE* file = fopen(fileName.string().c_str(), "r");
   if (!file) {
-    return TriMesh::Ptr();
+    return false;
+  }
+
+  if (progress) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(fileName, ec);
+    if (!ec) progress->SetTotalBytes(static_cast<size_t>(size));
   }
 
+  s_fileData.consumer = &consumer;
+  s_fileData.chunkSize = std::max<size_t>(chunkSize, 1);
+  s_fileData.consumerFailed = false;
+  s_fileData.loadFields = loadFields;
+  s_fileData.progress = progress;
+
+  // Сканер мог остаться в состоянии прерванного разбора предыдущего файла:
+  // с непрочитанным буфером и в условии заголовка. Перед разбором начинаем
+  // сканирование нового файла, а после разбора сбрасываем все состояние.
   vtkin = file;
+  vtkrestart(file);
   int parseRC = vtkparse();
+  if (parseRC == 0) s_fileData.FlushChunks();
+  vtklex_destroy();
   fclose(file);
-  if (parseRC != 0) {
+  s_fileData.nodeChunk.clear();
+  s_fileData.nodeChunk.shrink_to_fit();
+  s_fileData.cellChunk.clear();
+  s_fileData.cellChunk.shrink_to_fit();
+  s_fileData.consumer = nullptr;
+  s_fileData.progress = nullptr;
+  if (parseRC == 0 && progress && progress->TotalBytes() != 0)
+    progress->SetParsedBytes(progress->TotalBytes());
+  return parseRC == 0 && !s_fileData.consumerFailed;
+}
+}  // namespace
+
+bool LoadTriMeshFromVtk(const std::filesystem::path& fileName,
+                        TriMeshConsumer& consumer, size_t chunkSize,
+                        LoadProgress* progress) {
+  std::lock_guard<std::mutex> lock(s_parseMutex);
+  return ParseVtk(fileName, consumer, chunkSize, false, progress);
+}
+
+TriMesh::Ptr LoadTriMeshFromVtk(const std::filesystem::path& fileName,
+                                LoadProgress* progress) {
+  std::lock_guard<std::mutex> lock(s_parseMutex);
+  TriMeshBuilder builder;
+  if (!ParseVtk(fileName, builder, 1 << 16, true, progress)) {
+    s_fileData.isTriaCell.clear();
+    s_fileData.pointFields.clear();
+    s_fileData.cellFields.clear();
     return TriMesh::Ptr();
   }
 
-  size_t nbCells = s_fileData.cells.Size();
-  size_t nbTrias = 0;
-  for (size_t i = 0; i < nbCells; ++i) {
-    size_t n = s_fileData.cells.Size(i);
-    if (n == 3) ++nbTrias;
-  }
+  TriMesh::Ptr mesh = builder.Release();
+  for (const MeshField::Ptr& field : s_fileData.pointFields)
+    mesh->AddPointField(field);
 
-  std::vector<TriMesh::Cell> trias;
-  trias.reserve(nbTrias);
-  for (size_t i = 0; i < nbCells; ++i) {
-    size_t n = s_fileData.cells.Size(i);
-    if (n == 3) {
-      const size_t* nodes = s_fileData.cells[i];
-      trias.push_back(TriMesh::Cell(nodes[0], nodes[1], nodes[2]));
+  // Атрибуты ячеек других типов отбрасываем вместе с самими ячейками.
+  size_t nbCells = s_fileData.isTriaCell.size();
+  if (!s_fileData.cellFields.empty() && mesh->NbCells() != nbCells) {
+    std::vector<size_t> triaCells;
+    triaCells.reserve(mesh->NbCells());
+    for (size_t i = 0; i < nbCells; ++i) {
+      if (s_fileData.isTriaCell[i]) triaCells.push_back(i);
+    }
+    for (MeshField::Ptr& field : s_fileData.cellFields) {
+      if (field->NbTuples() == nbCells) field = field->Extract(triaCells);
     }
   }
+  for (const MeshField::Ptr& field : s_fileData.cellFields)
+    mesh->AddCellField(field);
+
+  s_fileData.isTriaCell.clear();
+  s_fileData.pointFields.clear();
+  s_fileData.cellFields.clear();
 
-  return TriMesh::Create(s_fileData.points, trias);
+  return mesh;
 }
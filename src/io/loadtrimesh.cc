@@ -0,0 +1,28 @@
+#include "numgeom/loadtrimesh.h"
+
+#include <algorithm>
+
+#include "numgeom/loadfromvtk.h"
+
+TriMesh::Ptr LoadTriMesh(const std::filesystem::path& fileName,
+                         LoadProgress* progress) {
+  std::string ext = fileName.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  if (ext == ".vtk") return LoadTriMeshFromVtk(fileName, progress);
+  if (ext == ".stl") return LoadTriMeshFromStl(fileName, progress);
+  if (ext == ".obj") return LoadTriMeshFromObj(fileName, progress);
+  if (ext == ".ply") return LoadTriMeshFromPly(fileName, progress);
+
+  return TriMesh::Ptr();
+}
+
+AsyncLoad<TriMesh::Ptr> LoadTriMeshAsync(const std::filesystem::path& fileName,
+                                         LoadProgress::Callback callback) {
+  return LoadAsync<TriMesh::Ptr>(
+      [fileName](LoadProgress& progress) {
+        return LoadTriMesh(fileName, &progress);
+      },
+      std::move(callback));
+}
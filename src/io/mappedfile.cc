@@ -0,0 +1,105 @@
+#include "mappedfile.h"
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : myData(nullptr), mySize(0), myIsEmpty(false) {
+#if defined(_WIN32)
+  myFile = INVALID_HANDLE_VALUE;
+  myMapping = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() { this->Close(); }
+
+#if defined(_WIN32)
+bool MappedFile::Open(const std::filesystem::path& fileName) {
+  this->Close();
+
+  HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  myFile = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    this->Close();
+    return false;
+  }
+  mySize = static_cast<size_t>(size.QuadPart);
+  if (mySize == 0) {
+    myIsEmpty = true;
+    return true;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    this->Close();
+    return false;
+  }
+  myMapping = mapping;
+
+  myData = static_cast<const char*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!myData) {
+    this->Close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (myData) UnmapViewOfFile(myData);
+  if (myMapping) CloseHandle(myMapping);
+  if (myFile != INVALID_HANDLE_VALUE) CloseHandle(myFile);
+  myData = nullptr;
+  myMapping = nullptr;
+  myFile = INVALID_HANDLE_VALUE;
+  mySize = 0;
+  myIsEmpty = false;
+}
+#else
+bool MappedFile::Open(const std::filesystem::path& fileName) {
+  this->Close();
+
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  mySize = static_cast<size_t>(st.st_size);
+  if (mySize == 0) {
+    close(fd);
+    myIsEmpty = true;
+    return true;
+  }
+
+  void* data = mmap(nullptr, mySize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    mySize = 0;
+    return false;
+  }
+  madvise(data, mySize, MADV_SEQUENTIAL);
+  myData = static_cast<const char*>(data);
+  return true;
+}
+
+void MappedFile::Close() {
+  if (myData) munmap(const_cast<char*>(myData), mySize);
+  myData = nullptr;
+  mySize = 0;
+  myIsEmpty = false;
+}
+#endif
@@ -0,0 +1,42 @@
+#ifndef numgeom_io_mappedfile_h
+#define numgeom_io_mappedfile_h
+
+#include <cstddef>
+#include <filesystem>
+
+/**\class MappedFile
+\brief Файл, отображенный в память только для чтения.
+
+Страницы подгружаются операционной системой по мере обращения, поэтому
+разбор больших файлов не требует промежуточного буфера.
+*/
+class MappedFile {
+ public:
+  MappedFile();
+
+  ~MappedFile();
+
+  bool Open(const std::filesystem::path&);
+
+  void Close();
+
+  bool IsOpen() const { return myData != nullptr || myIsEmpty; }
+
+  const char* Data() const { return myData; }
+
+  size_t Size() const { return mySize; }
+
+ private:
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+ private:
+  const char* myData;
+  size_t mySize;
+  bool myIsEmpty;
+#if defined(_WIN32)
+  void* myFile;
+  void* myMapping;
+#endif
+};
+#endif  // !numgeom_io_mappedfile_h
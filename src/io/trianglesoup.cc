@@ -0,0 +1,77 @@
+#include "trianglesoup.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "numgeom/parallelfor.h"
+
+namespace {
+;
+
+const size_t kEmptySlot = static_cast<size_t>(-1);
+
+uint64_t HashNode(const glm::dvec3& node) {
+  // Прибавление нуля превращает -0.0 в 0.0, чтобы они не различались.
+  double coords[3] = {node.x + 0.0, node.y + 0.0, node.z + 0.0};
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (double c : coords) {
+    uint64_t bits;
+    std::memcpy(&bits, &c, sizeof(bits));
+    h ^= bits;
+    h *= 0x100000001b3ull;
+    h ^= h >> 29;
+  }
+  return h;
+}
+}  // namespace
+
+TriMesh::Ptr CreateFromTriangleSoup(const std::vector<glm::dvec3>& soup) {
+  size_t nbSoupNodes = soup.size();
+  size_t nbTrias = nbSoupNodes / 3;
+
+  std::vector<uint64_t> hashes(nbSoupNodes);
+  ParallelFor(
+      nbSoupNodes,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) hashes[i] = HashNode(soup[i]);
+      },
+      1 << 14);
+
+  // Открытая адресация: в ячейке хранится номер первого вхождения узла.
+  size_t capacity = 16;
+  while (capacity < 2 * nbSoupNodes) capacity *= 2;
+  std::vector<size_t> slots(capacity, kEmptySlot);
+
+  std::vector<TriMesh::NodeType> nodes;
+  std::vector<size_t> soup2node(nbSoupNodes);
+  for (size_t i = 0; i < nbSoupNodes; ++i) {
+    size_t slot = hashes[i] & (capacity - 1);
+    while (true) {
+      size_t first = slots[slot];
+      if (first == kEmptySlot) {
+        slots[slot] = i;
+        soup2node[i] = nodes.size();
+        nodes.push_back(soup[i]);
+        break;
+      }
+      if (hashes[first] == hashes[i] && soup[first] == soup[i]) {
+        soup2node[i] = soup2node[first];
+        break;
+      }
+      slot = (slot + 1) & (capacity - 1);
+    }
+  }
+  slots = std::vector<size_t>();
+  hashes = std::vector<uint64_t>();
+
+  std::vector<TriMesh::Cell> cells(nbTrias);
+  ParallelFor(
+      nbTrias,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          cells[i] = TriMesh::Cell(&soup2node[3 * i]);
+      },
+      1 << 14);
+
+  return TriMesh::Create(std::move(nodes), std::move(cells));
+}
@@ -0,0 +1,13 @@
+#ifndef numgeom_io_trianglesoup_h
+#define numgeom_io_trianglesoup_h
+
+#include <vector>
+
+#include "numgeom/trimesh.h"
+
+//! Создает сетку из треугольников, заданных тройками узлов подряд.
+//! Узлы с побитово совпадающими координатами сливаются; узлы нумеруются
+//! в порядке первого появления.
+TriMesh::Ptr CreateFromTriangleSoup(const std::vector<glm::dvec3>& soup);
+
+#endif  // !numgeom_io_trianglesoup_h
@@ -1,5 +1,7 @@
 %{
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "vtk_parser.h"
 
 int vtklex();
@@ -9,7 +11,10 @@ int vtkwrap() { return 1; }
 void InsertNextValue(double);
 void PreparePointArray(int);
 void PrepareVtkLoading();
-void PreparePolygonArray(int, int);
+void PreparePolygonArray(int);
+void PrepareCellTypeArray();
+void PrepareFieldSection(int, int);
+void PrepareFieldArray(char*, int, int);
 %}
 
 
@@ -41,6 +46,14 @@ void PreparePolygonArray(int, int);
        UNSTRUCTURED_GRID
 %token<real> real
 %token<integer> integer
+%token POINT_DATA
+       CELL_DATA
+       SCALARS
+       VECTORS
+       NORMALS
+       LOOKUP_TABLE
+%token<string> identifier
+%type<integer> FieldValueType
 %%
 
 Input:
@@ -66,9 +79,9 @@ UnstructuredGrid:
     DATASET UNSTRUCTURED_GRID
     POINTS integer ValueType { PreparePointArray($4); }
     NumericValues
-    CELLS integer integer
+    CELLS integer integer { PreparePolygonArray($9); }
     IntValues
-    CELL_TYPES integer
+    CELL_TYPES integer { PrepareCellTypeArray(); }
     IntValues
 ;
 
@@ -76,7 +89,7 @@ Polydata:
     DATASET POLYDATA
     POINTS integer ValueType { PreparePointArray($4); }
     NumericValues
-    POLYGONS integer integer { PreparePolygonArray($9, $10); }
+    POLYGONS integer integer { PreparePolygonArray($9); }
     IntValues
 ;
 
@@ -93,6 +106,46 @@ IntValues:
   | IntValues integer     { InsertNextValue($2); }
 ;
 
-Fields: ;
+Fields:
+    %empty
+  | Fields FieldSection
+;
+
+FieldSection:
+    POINT_DATA integer { PrepareFieldSection(0, $2); } Attributes
+  | CELL_DATA integer  { PrepareFieldSection(1, $2); } Attributes
+;
+
+Attributes:
+    Attribute
+  | Attributes Attribute
+;
+
+Attribute:
+    SCALARS identifier FieldValueType { PrepareFieldArray($2, $3, 1); }
+    LookupTable NumericValues
+  | SCALARS identifier FieldValueType integer { PrepareFieldArray($2, $3, $4); }
+    LookupTable NumericValues
+  | VECTORS identifier FieldValueType { PrepareFieldArray($2, $3, 3); }
+    NumericValues
+  | NORMALS identifier FieldValueType { PrepareFieldArray($2, $3, 3); }
+    NumericValues
+;
+
+LookupTable: LOOKUP_TABLE identifier { free($2); };
+
+FieldValueType:
+    FLOAT  { $$ = 0; }
+  | DOUBLE { $$ = 1; }
+  | identifier {
+      /* int не является ключевым словом, чтобы не менять разбор имен. */
+      $$ = strcmp($1, "int") == 0 ? 2 : -1;
+      free($1);
+      if ($$ < 0) {
+        vtkerror("unknown field value type");
+        YYABORT;
+      }
+    }
+;
 
 %%
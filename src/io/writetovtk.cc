@@ -1,6 +1,59 @@
 #include "numgeom/writetovtk.h"
 
 #include <fstream>
+#include <limits>
+
+namespace {
+;
+
+const char* VtkTypeName(MeshField::ValueType type) {
+  switch (type) {
+    case MeshField::ValueType::Float:
+      return "float";
+    case MeshField::ValueType::Double:
+      return "double";
+    case MeshField::ValueType::Int:
+      return "int";
+  }
+  return "double";
+}
+
+// Трехкомпонентные массивы записываются как VECTORS (или NORMALS для массива
+// нормалей), остальные -- как SCALARS с таблицей цветов по умолчанию.
+void WriteFieldArray(std::ostream& file, const MeshField& field) {
+  const char* typeName = VtkTypeName(field.Type());
+  if (field.NbComponents() == 3) {
+    bool normals = field.Name() == "Normals" || field.Name() == "normals";
+    file << (normals ? "NORMALS " : "VECTORS ") << field.Name() << ' '
+         << typeName << std::endl;
+  } else {
+    file << "SCALARS " << field.Name() << ' ' << typeName << ' '
+         << field.NbComponents() << std::endl;
+    file << "LOOKUP_TABLE default" << std::endl;
+  }
+  size_t nbTuples = field.NbTuples();
+  size_t nbComponents = field.NbComponents();
+  for (size_t i = 0; i < nbTuples; ++i) {
+    for (size_t j = 0; j < nbComponents; ++j)
+      file << field.GetValue(i, j) << ' ';
+  }
+  file << std::endl;
+}
+
+void WriteFields(std::ostream& file, CTriMesh::Ptr mesh) {
+  file.precision(std::numeric_limits<double>::max_digits10);
+  if (!mesh->PointFields().empty()) {
+    file << "POINT_DATA " << mesh->NbNodes() << std::endl;
+    for (const MeshField::Ptr& field : mesh->PointFields())
+      WriteFieldArray(file, *field);
+  }
+  if (!mesh->CellFields().empty()) {
+    file << "CELL_DATA " << mesh->NbCells() << std::endl;
+    for (const MeshField::Ptr& field : mesh->CellFields())
+      WriteFieldArray(file, *field);
+  }
+}
+}  // namespace
 
 bool WriteToUnstructuredVtk(CTriMesh::Ptr mesh,
                             const std::filesystem::path& filename) {
@@ -32,6 +85,8 @@ bool WriteToUnstructuredVtk(CTriMesh::Ptr mesh,
   for (size_t i = 0; i < nbCells; ++i) file << "5 ";  //< VTK_TRIANGLE
   file << std::endl;
 
+  WriteFields(file, mesh);
+
   return true;
 }
 
@@ -61,5 +116,7 @@ bool WriteToPolydataVtk(CTriMesh::Ptr mesh,
   }
   file << std::endl;
 
+  WriteFields(file, mesh);
+
   return true;
 }
@@ -0,0 +1,110 @@
+#ifndef numgeom_occ_binarystream_h
+#define numgeom_occ_binarystream_h
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <vector>
+
+/**
+\file
+\brief Двоичный ввод-вывод значений фиксированного размера через потоки.
+
+Значения пишутся в порядке байтов машины без выравнивания. Функции чтения
+возвращают ложь, если поток закончился раньше, чем были прочитаны все байты.
+*/
+
+template <typename T>
+void WriteValue(std::ostream& stream, const T& value) {
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void WriteValues(std::ostream& stream, std::span<const T> values) {
+  stream.write(reinterpret_cast<const char*>(values.data()),
+               static_cast<std::streamsize>(values.size_bytes()));
+}
+
+//! Пишет значения `values[order[0]]`, `values[order[1]]`, ... Значения
+//! собираются блоками, так что копия всего массива не создается.
+template <typename T>
+void WriteValuesInOrder(std::ostream& stream, std::span<const T> values,
+                        std::span<const size_t> order) {
+  const size_t blockSize = 4096;
+  std::vector<T> block;
+  block.reserve(std::min(blockSize, order.size()));
+  for (size_t first = 0; first < order.size(); first += blockSize) {
+    size_t last = std::min(first + blockSize, order.size());
+    block.clear();
+    for (size_t k = first; k < last; ++k) block.push_back(values[order[k]]);
+    WriteValues(stream, std::span<const T>(block));
+  }
+}
+
+template <typename T>
+bool ReadValue(std::istream& stream, T& value) {
+  stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return stream.gcount() == static_cast<std::streamsize>(sizeof(T));
+}
+
+template <typename T>
+bool ReadValues(std::istream& stream, std::span<T> values) {
+  auto size = static_cast<std::streamsize>(values.size_bytes());
+  stream.read(reinterpret_cast<char*>(values.data()), size);
+  return stream.gcount() == size;
+}
+
+//! Значение `BytesLeft` для потока, размер которого неизвестен.
+constexpr uint64_t UnknownBytesLeft = std::numeric_limits<uint64_t>::max();
+
+//! Число байтов до конца потока или `UnknownBytesLeft`, если поток не
+//! поддерживает позиционирование.
+inline uint64_t BytesLeft(std::istream& stream) {
+  const uint64_t unknown = UnknownBytesLeft;
+  std::istream::pos_type pos = stream.tellg();
+  if (pos == std::istream::pos_type(-1)) return unknown;
+  stream.seekg(0, std::ios::end);
+  std::istream::pos_type end = stream.tellg();
+  stream.seekg(pos);
+  if (end == std::istream::pos_type(-1) || end < pos) return unknown;
+  return static_cast<uint64_t>(end - pos);
+}
+
+//! Хватит ли оставшихся байтов потока на `count` значений типа `T`. Число
+//! значений, прочитанное из файла, проверяют до выделения памяти под них.
+//! Для потока без позиционирования, например канала, проверка всегда
+//! успешна; такие значения читают функцией `ReadValues` с их числом.
+template <typename T>
+bool HasValues(std::istream& stream, uint64_t count) {
+  return count <= BytesLeft(stream) / sizeof(T);
+}
+
+//! Читает `count` значений в `values`. Если размер потока известен, память
+//! выделяется после проверки, что значений в потоке хватит. Иначе значения
+//! читаются блоками, так что память растет лишь по мере поступления данных
+//! и ошибочное число значений не приводит к огромному выделению.
+template <typename T>
+bool ReadValues(std::istream& stream, uint64_t count, std::vector<T>& values) {
+  values.clear();
+  if (BytesLeft(stream) != UnknownBytesLeft) {
+    if (!HasValues<T>(stream, count)) return false;
+    values.resize(count);
+    return ReadValues(stream, std::span<T>(values));
+  }
+
+  const uint64_t blockSize = std::max<uint64_t>(1, (1 << 20) / sizeof(T));
+  while (values.size() < count) {
+    size_t first = values.size();
+    size_t size = static_cast<size_t>(std::min(blockSize, count - first));
+    values.resize(first + size);
+    if (!ReadValues(stream, std::span<T>(values).subspan(first, size)))
+      return false;
+  }
+  return true;
+}
+
+#endif  // !numgeom_occ_binarystream_h
@@ -1,18 +1,31 @@
 ﻿#include "numgeom/classificate.h"
 
+#include <BRepClass3d_SolidClassifier.hxx>
 #include <BRepTools.hxx>
+#include <BRep_Tool.hxx>
 #include <Bnd_Box2d.hxx>
 #include <Geom2d_Curve.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp_Explorer.hxx>
 #include <TopoDS.hxx>
 #include <TopoDS_Face.hxx>
 #include <TopoDS_Iterator.hxx>
 #include <TopoDS_Wire.hxx>
-#include <map>
+#include <gp_Pnt.hxx>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <span>
 
 #include "numgeom/circularlist.h"
+#include "numgeom/parallelfor.h"
 #include "numgeom/quadtree.h"
 #include "numgeom/tesselate.h"
 #include "numgeom/utilities.h"
+#include "trianglebvh.h"
 #include "writevtk.h"
 
 namespace {
@@ -47,18 +60,54 @@ class MeshLinesAndContoursIntersections {
     const CircularList<ContourPoint>::Node* seg;
   };
 
-  mutable std::map<size_t, std::vector<Cross>> vInts, hInts;
-
  public:
   MeshLinesAndContoursIntersections(const QuadTree&, const FaceContours&,
                                     Standard_Integer maxLevelsNumber);
 
   Standard_Integer levelIndex() const { return myLevelIndex; }
 
-  const std::vector<Cross>& GetVInts(size_t) const;
-  const std::vector<Cross>& GetHInts(size_t) const;
+  //! Вычисляет в нескольких потоках пересечения контуров с вертикальными
+  //! `vLines` и горизонтальными `hLines` сеточными линиями, которых еще нет
+  //! в кэше. Списки номеров линий упорядочены и не содержат повторов.
+  void Prepare(const std::vector<size_t>& vLines,
+               const std::vector<size_t>& hLines);
+
+  //! Пересечения с линией, подготовленной вызовом `Prepare`.
+  std::span<const Cross> GetVInts(size_t) const;
+  std::span<const Cross> GetHInts(size_t) const;
 
  private:
+  //! Пересечения сеточных линий с контурами в непрерывных массивах:
+  //! упорядоченные номера линий и смещения их пересечений в `crosses`.
+  struct LineCache {
+    std::vector<size_t> lines;
+    std::vector<size_t> offsets = {0};
+    std::vector<Cross> crosses;
+
+    std::span<const Cross> Get(size_t line) const;
+
+    void Add(const std::vector<size_t>& wanted,
+             const std::function<void(size_t, std::vector<Cross>&)>& compute);
+  };
+
+  //! Отрезки контуров, распределенные по полосам, на которые разбита
+  //! габаритная коробка дерева вдоль одной из осей. Линия, параллельная
+  //! другой оси, проверяется только с отрезками своей полосы.
+  struct SegmentStrips {
+    Standard_Real origin = 0.0;
+    Standard_Real step = 1.0;
+    std::vector<size_t> offsets;
+    std::vector<const CircularList<ContourPoint>::Node*> segments;
+
+    void Build(const FaceContours&, Standard_Real minCoord,
+               Standard_Real maxCoord, Standard_Boolean byX);
+
+    std::span<const CircularList<ContourPoint>::Node* const> Get(
+        Standard_Real coord) const;
+
+    size_t Strip(Standard_Real coord) const;
+  };
+
   //! Intersect contours by vertical segment.
   //! Vertical segment ((xConst,yMin),(xConst,yMax)).
   void IntersectVertical(Standard_Real xConst, std::vector<Cross>&) const;
@@ -70,6 +119,8 @@ class MeshLinesAndContoursIntersections {
   Standard_Real xMin, yMin, xMax, yMax;
   Standard_Integer nbVLines, nbHLines;
   Standard_Integer myLevelIndex;
+  SegmentStrips myXStrips, myYStrips;
+  LineCache myVInts, myHInts;
 };
 
 void Enlarge(Bnd_Box2d&, Standard_Real);
@@ -200,40 +251,28 @@ Standard_Real NearestDistance2(const gp_Pnt2d& p,
   return minDistance;
 }
 
-TopAbs_State Classificate(const TopoDS_Face& F, const gp_Pnt2d& Q,
-                          const AuxClassificateData2d** pAux) {
-  if (F.IsNull()) return TopAbs_UNKNOWN;
-
-  if (pAux != nullptr && (*pAux) != nullptr && (*pAux)->face != F)
-    return TopAbs_UNKNOWN;
-
-  static const Standard_Real Tol = 1.e-7;
-  static const AuxClassificateData2d* s_aux = nullptr;
-  if (pAux) {
-    if (!(*pAux)) (*pAux) = new AuxClassificateData2d(F, Tol);
-  } else {
-    if (!s_aux || s_aux->face != F) s_aux = new AuxClassificateData2d(F, Tol);
-  }
-
-  const AuxClassificateData2d* aux = pAux ? *pAux : s_aux;
-  assert(aux && aux->face == F);
+namespace {
+;
 
+//! Классификация точки по готовым вспомогательным данным грани.
+TopAbs_State ClassifyPoint(const AuxClassificateData2d& aux,
+                           const gp_Pnt2d& Q) {
 #if 0
-    aux->qTree->Dump("quadtree.vtk");
-    aux->fContours.Dump("contours.vtk");
+    aux.qTree->Dump("quadtree.vtk");
+    aux.fContours.Dump("contours.vtk");
     Dumper dumper;
     dumper.AddPoints({Q});
     dumper.Save("point.vtk");
 #endif
 
-  QuadTree::Cell cell = aux->qTree->GetCell(Q);
+  QuadTree::Cell cell = aux.qTree->GetCell(Q);
   if (!cell) return TopAbs_OUT;
 
-  size_t attr = aux->qTree->GetAttr(cell);
+  size_t attr = aux.qTree->GetAttr(cell);
   std::list<QuadTree::Cell> boundaryCells;
   TopAbs_State qPointState = TopAbs_UNKNOWN;
   if (attr == 0 || attr == 1) {
-    SearchNearestCells(aux->qTree, Q, IsBoundaryCell, aux->tolerance,
+    SearchNearestCells(aux.qTree, Q, IsBoundaryCell, aux.tolerance,
                        boundaryCells);
     qPointState = (attr == 0 ? TopAbs_IN : TopAbs_OUT);
     if (boundaryCells.empty()) return qPointState;
@@ -241,14 +280,14 @@ TopAbs_State Classificate(const TopoDS_Face& F, const gp_Pnt2d& Q,
     boundaryCells.push_back(cell);
 
   for (const QuadTree::Cell& cell : boundaryCells) {
-    size_t attr = aux->qTree->GetAttr(cell);
+    size_t attr = aux.qTree->GetAttr(cell);
     assert(attr != 0 && attr != 1);
     // Превращаем атрибут в указатель на участок контура.
     auto cptr = reinterpret_cast<const CircularList<ContourPoint>::Node*>(attr);
     // Вычисляем расстояние от точки до контура,
     // используя `cptr` как начальное приближение.
     Standard_Real qcDistance = NearestDistance2(Q, cptr);
-    if (std::abs(qcDistance) <= aux->tolerance) return TopAbs_ON;
+    if (std::abs(qcDistance) <= aux.tolerance) return TopAbs_ON;
 
     if (qcDistance < 0.0) {
       assert(qPointState == TopAbs_UNKNOWN || qPointState == TopAbs_IN);
@@ -261,6 +300,193 @@ TopAbs_State Classificate(const TopoDS_Face& F, const gp_Pnt2d& Q,
 
   return qPointState;
 }
+}  // namespace
+
+FaceClassifier::FaceClassifier(const TopoDS_Face& face,
+                               Standard_Real tolerance)
+    : myData(std::make_unique<AuxClassificateData2d>(face, tolerance)) {}
+
+FaceClassifier::~FaceClassifier() {}
+
+const TopoDS_Face& FaceClassifier::Face() const { return myData->face; }
+
+TopAbs_State FaceClassifier::Classify(const gp_Pnt2d& point) const {
+  return ClassifyPoint(*myData, point);
+}
+
+std::vector<TopAbs_State> FaceClassifier::Classify(
+    std::span<const gp_Pnt2d> points) const {
+  const AuxClassificateData2d& aux = *myData;
+  const size_t nbPoints = points.size();
+  std::vector<TopAbs_State> states(nbPoints, TopAbs_OUT);
+
+  // Упорядочиваем точки по ячейкам, в которые они попадают; точки вне
+  // дерева (пустая ячейка) оказываются в начале и остаются внешними.
+  std::vector<std::pair<QuadTree::Cell, size_t>> order(nbPoints);
+  ParallelFor(
+      nbPoints,
+      [&](size_t iBegin, size_t iEnd) {
+        for (size_t i = iBegin; i < iEnd; ++i)
+          order[i] = std::make_pair(aux.qTree->GetCell(points[i]), i);
+      },
+      1 << 12);
+  std::sort(order.begin(), order.end());
+
+  std::vector<size_t> groups;
+  for (size_t i = 0; i < nbPoints; ++i) {
+    if (i == 0 || order[i].first != order[i - 1].first) groups.push_back(i);
+  }
+  groups.push_back(nbPoints);
+
+  ParallelFor(groups.size() - 1, [&](size_t gBegin, size_t gEnd) {
+    std::vector<QuadTree::Cell> boundaryCells;
+    for (size_t g = gBegin; g < gEnd; ++g) {
+      const QuadTree::Cell cell = order[groups[g]].first;
+      if (!cell) continue;
+
+      // Внутренняя или внешняя ячейка, вблизи которой нет граничных ячеек,
+      // определяет состояние всех своих точек.
+      size_t attr = aux.qTree->GetAttr(cell);
+      if (attr == 0 || attr == 1) {
+        Standard_Real xMin, yMin, xMax, yMax;
+        aux.qTree->GetCellBox(cell, xMin, yMin, xMax, yMax);
+        Standard_Real halfDiagonal = 0.5 * std::hypot(xMax - xMin, yMax - yMin);
+        SearchKNearestCells(aux.qTree, aux.qTree->GetCenter(cell),
+                            IsBoundaryCell, 1, aux.tolerance + halfDiagonal,
+                            boundaryCells);
+        if (boundaryCells.empty()) {
+          TopAbs_State state = (attr == 0 ? TopAbs_IN : TopAbs_OUT);
+          for (size_t k = groups[g]; k < groups[g + 1]; ++k)
+            states[order[k].second] = state;
+          continue;
+        }
+      }
+
+      for (size_t k = groups[g]; k < groups[g + 1]; ++k) {
+        size_t i = order[k].second;
+        states[i] = ClassifyPoint(aux, points[i]);
+      }
+    }
+  });
+  return states;
+}
+
+TopAbs_State Classificate(const TopoDS_Face& F, const gp_Pnt2d& Q,
+                          const AuxClassificateData2d** pAux) {
+  if (F.IsNull()) return TopAbs_UNKNOWN;
+
+  if (pAux != nullptr && (*pAux) != nullptr && (*pAux)->face != F)
+    return TopAbs_UNKNOWN;
+
+  static const Standard_Real Tol = 1.e-7;
+  if (pAux) {
+    if (!(*pAux)) (*pAux) = new AuxClassificateData2d(F, Tol);
+    return ClassifyPoint(**pAux, Q);
+  }
+
+  // Классификатор последней грани у каждого потока свой и освобождается
+  // при завершении потока.
+  thread_local std::unique_ptr<FaceClassifier> s_classifier;
+  if (!s_classifier || s_classifier->Face() != F)
+    s_classifier = std::make_unique<FaceClassifier>(F, Tol);
+  return s_classifier->Classify(Q);
+}
+
+struct SolidClassifier::Internal {
+  TopoDS_Shape shape;
+  Standard_Real tolerance;
+  //! Точки ближе этого расстояния к триангуляции классифицируются точно.
+  Standard_Real nearDistance;
+  //! Пустой указатель, если у какой-либо грани нет триангуляции.
+  std::unique_ptr<TriangleBVH> bvh;
+  glm::dvec3 boxMin, boxMax;
+
+  //! Строит иерархию коробок по сетке граней фигуры `shape`.
+  void Init(const CTriMesh& mesh);
+
+  TopAbs_State Classify(
+      const gp_Pnt& P,
+      std::unique_ptr<BRepClass3d_SolidClassifier>& exact) const;
+};
+
+void SolidClassifier::Internal::Init(const CTriMesh& mesh) {
+  // Поверхность отстоит от треугольников не дальше прогиба сетки.
+  Standard_Real deflection = 0.0;
+  for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next()) {
+    TopLoc_Location loc;
+    const Handle(Poly_Triangulation)& triangulation =
+        BRep_Tool::Triangulation(TopoDS::Face(it.Current()), loc);
+    if (triangulation.IsNull()) return;
+    deflection = std::max(deflection, triangulation->Deflection());
+  }
+  nearDistance = 2.0 * deflection + tolerance;
+  bvh = std::make_unique<TriangleBVH>(mesh);
+  bvh->GetBox(boxMin, boxMax);
+}
+
+TopAbs_State SolidClassifier::Internal::Classify(
+    const gp_Pnt& P,
+    std::unique_ptr<BRepClass3d_SolidClassifier>& exact) const {
+  if (bvh) {
+    glm::dvec3 p(P.X(), P.Y(), P.Z());
+    for (int i = 0; i < 3; ++i) {
+      if (p[i] < boxMin[i] - nearDistance || p[i] > boxMax[i] + nearDistance)
+        return TopAbs_OUT;
+    }
+    bool isInside;
+    if (!bvh->IsCloser(p, nearDistance) && bvh->ClassifyByParity(p, isInside))
+      return isInside ? TopAbs_IN : TopAbs_OUT;
+  }
+
+  if (!exact) exact = std::make_unique<BRepClass3d_SolidClassifier>(shape);
+  exact->Perform(P, tolerance);
+  return exact->State();
+}
+
+SolidClassifier::SolidClassifier(const TopoDS_Shape& solid,
+                                 Standard_Real tolerance,
+                                 const MeshParameters& params)
+    : myData(std::make_unique<Internal>()) {
+  myData->shape = solid;
+  myData->tolerance = tolerance;
+  myData->nearDistance = tolerance;
+  if (solid.IsNull()) return;
+
+  TriMesh::Ptr mesh = ConvertToTriMesh(solid, params);
+  if (mesh) myData->Init(*mesh);
+}
+
+SolidClassifier::SolidClassifier(const TopoDS_Shape& solid,
+                                 const CTriMesh& mesh, Standard_Real tolerance)
+    : myData(std::make_unique<Internal>()) {
+  myData->shape = solid;
+  myData->tolerance = tolerance;
+  myData->nearDistance = tolerance;
+  if (!solid.IsNull()) myData->Init(mesh);
+}
+
+SolidClassifier::~SolidClassifier() {}
+
+const TopoDS_Shape& SolidClassifier::Shape() const { return myData->shape; }
+
+TopAbs_State SolidClassifier::Classify(const gp_Pnt& point) const {
+  std::unique_ptr<BRepClass3d_SolidClassifier> exact;
+  return myData->Classify(point, exact);
+}
+
+std::vector<TopAbs_State> SolidClassifier::Classify(
+    std::span<const gp_Pnt> points) const {
+  std::vector<TopAbs_State> states(points.size(), TopAbs_UNKNOWN);
+  ParallelFor(
+      points.size(),
+      [&](size_t begin, size_t end) {
+        std::unique_ptr<BRepClass3d_SolidClassifier> exact;
+        for (size_t i = begin; i < end; ++i)
+          states[i] = myData->Classify(points[i], exact);
+      },
+      1 << 10);
+  return states;
+}
 
 namespace {
 ;
@@ -378,49 +604,151 @@ Standard_Boolean IntersectSegmentSegment(const gp_Pnt2d& seg1p1,
   return t1 >= 0.0 && t1 <= 1.0;
 }
 
-const std::vector<MeshLinesAndContoursIntersections::Cross>&
-MeshLinesAndContoursIntersections::GetVInts(size_t i) const {
-  auto it = vInts.find(i);
-  if (it == vInts.end()) {
-    auto itb = vInts.insert(std::make_pair(i, std::vector<Cross>()));
-    it = itb.first;
-    Standard_Real xConst = xMin + (xMax - xMin) / (nbVLines - 1) * i;
-    this->IntersectVertical(xConst, it->second);
+std::span<const MeshLinesAndContoursIntersections::Cross>
+MeshLinesAndContoursIntersections::LineCache::Get(size_t line) const {
+  auto it = std::lower_bound(lines.begin(), lines.end(), line);
+  assert(it != lines.end() && *it == line);
+  size_t k = it - lines.begin();
+  return std::span<const Cross>(crosses.data() + offsets[k],
+                                offsets[k + 1] - offsets[k]);
+}
+
+void MeshLinesAndContoursIntersections::LineCache::Add(
+    const std::vector<size_t>& wanted,
+    const std::function<void(size_t, std::vector<Cross>&)>& compute) {
+  std::vector<size_t> missing;
+  std::set_difference(wanted.begin(), wanted.end(), lines.begin(),
+                      lines.end(), std::back_inserter(missing));
+  if (missing.empty()) return;
+
+  std::vector<std::vector<Cross>> computed(missing.size());
+  ParallelFor(missing.size(), [&](size_t iBegin, size_t iEnd) {
+    for (size_t i = iBegin; i < iEnd; ++i) compute(missing[i], computed[i]);
+  });
+
+  // Сливаем новые линии с имеющимися, сохраняя порядок номеров.
+  LineCache merged;
+  merged.lines.reserve(lines.size() + missing.size());
+  merged.offsets.reserve(lines.size() + missing.size() + 1);
+  size_t nbCrosses = crosses.size();
+  for (const auto& c : computed) nbCrosses += c.size();
+  merged.crosses.reserve(nbCrosses);
+  size_t iOld = 0, iNew = 0;
+  while (iOld < lines.size() || iNew < missing.size()) {
+    if (iNew == missing.size() ||
+        (iOld < lines.size() && lines[iOld] < missing[iNew])) {
+      merged.lines.push_back(lines[iOld]);
+      merged.crosses.insert(merged.crosses.end(),
+                            crosses.begin() + offsets[iOld],
+                            crosses.begin() + offsets[iOld + 1]);
+      ++iOld;
+    } else {
+      merged.lines.push_back(missing[iNew]);
+      merged.crosses.insert(merged.crosses.end(), computed[iNew].begin(),
+                            computed[iNew].end());
+      ++iNew;
+    }
+    merged.offsets.push_back(merged.crosses.size());
   }
-  return it->second;
+  std::swap(*this, merged);
 }
 
-const std::vector<MeshLinesAndContoursIntersections::Cross>&
-MeshLinesAndContoursIntersections::GetHInts(size_t j) const {
-  auto it = hInts.find(j);
-  if (it == hInts.end()) {
-    auto itb = hInts.insert(std::make_pair(j, std::vector<Cross>()));
-    it = itb.first;
-    Standard_Real yConst = yMin + (yMax - yMin) / (nbHLines - 1) * j;
-    this->IntersectHorizontal(yConst, it->second);
+void MeshLinesAndContoursIntersections::SegmentStrips::Build(
+    const FaceContours& fContours, Standard_Real minCoord,
+    Standard_Real maxCoord, Standard_Boolean byX) {
+  size_t nbSegments = 0;
+  for (const auto& contour : fContours.myWires) {
+    for (auto it = contour.begin(); it != contour.end(); ++it) ++nbSegments;
   }
-  return it->second;
+  const size_t nbStrips = std::clamp<size_t>(nbSegments, 1, 4096);
+  origin = minCoord;
+  step = (maxCoord - minCoord) / nbStrips;
+  if (step <= 0.0) step = 1.0;
+
+  // Отрезок попадает во все полосы, которые пересекает его проекция.
+  // Полоса точки вычисляется одинаково для концов отрезков и для линий,
+  // поэтому линия, проходящая через конец отрезка, его не пропустит.
+  auto range = [&](const CircularList<ContourPoint>::Node* node) {
+    const gp_Pnt2d& p0 = node->data.p;
+    const gp_Pnt2d& p1 = node->next->data.p;
+    Standard_Real c0 = byX ? p0.X() : p0.Y();
+    Standard_Real c1 = byX ? p1.X() : p1.Y();
+    return std::make_pair(Strip(std::min(c0, c1)), Strip(std::max(c0, c1)));
+  };
+  offsets.assign(nbStrips + 1, 0);
+  for (const auto& contour : fContours.myWires) {
+    for (auto it = contour.begin(); it != contour.end(); ++it) {
+      auto [k0, k1] = range(it.current_node());
+      for (size_t k = k0; k <= k1; ++k) ++offsets[k + 1];
+    }
+  }
+  for (size_t k = 0; k < nbStrips; ++k) offsets[k + 1] += offsets[k];
+  segments.resize(offsets.back());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (const auto& contour : fContours.myWires) {
+    for (auto it = contour.begin(); it != contour.end(); ++it) {
+      auto [k0, k1] = range(it.current_node());
+      for (size_t k = k0; k <= k1; ++k)
+        segments[fill[k]++] = it.current_node();
+    }
+  }
+}
+
+size_t MeshLinesAndContoursIntersections::SegmentStrips::Strip(
+    Standard_Real coord) const {
+  Standard_Real k = std::floor((coord - origin) / step);
+  if (k <= 0.0) return 0;
+  return std::min(static_cast<size_t>(k), offsets.size() - 2);
+}
+
+std::span<const CircularList<ContourPoint>::Node* const>
+MeshLinesAndContoursIntersections::SegmentStrips::Get(
+    Standard_Real coord) const {
+  size_t k = Strip(coord);
+  return std::span<const CircularList<ContourPoint>::Node* const>(
+      segments.data() + offsets[k], offsets[k + 1] - offsets[k]);
+}
+
+void MeshLinesAndContoursIntersections::Prepare(
+    const std::vector<size_t>& vLines, const std::vector<size_t>& hLines) {
+  myVInts.Add(vLines, [this](size_t i, std::vector<Cross>& inter) {
+    Standard_Real xConst = xMin + (xMax - xMin) / (nbVLines - 1) * i;
+    this->IntersectVertical(xConst, inter);
+  });
+  myHInts.Add(hLines, [this](size_t j, std::vector<Cross>& inter) {
+    Standard_Real yConst = yMin + (yMax - yMin) / (nbHLines - 1) * j;
+    this->IntersectHorizontal(yConst, inter);
+  });
+}
+
+std::span<const MeshLinesAndContoursIntersections::Cross>
+MeshLinesAndContoursIntersections::GetVInts(size_t i) const {
+  return myVInts.Get(i);
+}
+
+std::span<const MeshLinesAndContoursIntersections::Cross>
+MeshLinesAndContoursIntersections::GetHInts(size_t j) const {
+  return myHInts.Get(j);
 }
 
 void MeshLinesAndContoursIntersections::IntersectVertical(
     Standard_Real xConst, std::vector<Cross>& inter) const {
-  gp_Pnt2d vSegP1(xConst, yMin), vSegP2(xConst, yMax);
-  for (const CircularList<ContourPoint>& contour : myContours.myWires) {
-    for (auto it = contour.begin(); it != contour.end(); ++it) {
-      gp_Pnt2d p0 = (*it).p;
-      gp_Pnt2d p1 = (*std::next(it)).p;
-      // Пересекается ли отрезок (p0,p1) с вертикальной прямой?
-      Standard_Real x0 = p0.X(), x1 = p1.X();
-      Standard_Real y0 = p0.Y(), y1 = p1.Y();
-      Standard_Boolean b1 =
-          (xConst >= x0 || xConst >= x1) && (xConst <= x0 || xConst <= x1);
-      Standard_Boolean b2 =
-          (y0 >= yMin && y0 <= yMax || y1 >= yMin && y1 <= yMax);
-      if (b1 && b2) {
-        Standard_Real u = (xConst - x0) / (x1 - x0);
-        Standard_Real y = y0 + u * (y1 - y0);
-        inter.push_back({y, it.current_node()});
-      }
+  // Отрезки полосы перечислены в том же порядке, что и в контурах, поэтому
+  // порядок равных пересечений после сортировки не зависит от полос.
+  for (const CircularList<ContourPoint>::Node* node : myXStrips.Get(xConst)) {
+    gp_Pnt2d p0 = node->data.p;
+    gp_Pnt2d p1 = node->next->data.p;
+    // Пересекается ли отрезок (p0,p1) с вертикальной прямой?
+    Standard_Real x0 = p0.X(), x1 = p1.X();
+    Standard_Real y0 = p0.Y(), y1 = p1.Y();
+    Standard_Boolean b1 =
+        (xConst >= x0 || xConst >= x1) && (xConst <= x0 || xConst <= x1);
+    Standard_Boolean b2 =
+        (y0 >= yMin && y0 <= yMax || y1 >= yMin && y1 <= yMax);
+    if (b1 && b2) {
+      Standard_Real u = (xConst - x0) / (x1 - x0);
+      Standard_Real y = y0 + u * (y1 - y0);
+      inter.push_back({y, node});
     }
   }
 
@@ -432,23 +760,20 @@ void MeshLinesAndContoursIntersections::IntersectVertical(
 
 void MeshLinesAndContoursIntersections::IntersectHorizontal(
     Standard_Real yConst, std::vector<Cross>& inter) const {
-  gp_Pnt2d vSegP1(yConst, xMin), vSegP2(yConst, xMax);
-  for (const auto& polyline : myContours.myWires) {
-    for (auto it = polyline.begin(); it != polyline.end(); ++it) {
-      gp_Pnt2d p0 = (*it).p;
-      gp_Pnt2d p1 = (*std::next(it)).p;
-      // Пересекается ли отрезок (p0,p1) с горизонтальной прямой?
-      Standard_Real x0 = p0.X(), x1 = p1.X();
-      Standard_Real y0 = p0.Y(), y1 = p1.Y();
-      Standard_Boolean b1 =
-          (yConst >= y0 || yConst >= y1) && (yConst <= y0 || yConst <= y1);
-      Standard_Boolean b2 =
-          (x0 >= xMin && x0 <= xMax || x1 >= xMin && x1 <= xMax);
-      if (b1 && b2) {
-        Standard_Real u = (yConst - y0) / (y1 - y0);
-        Standard_Real x = x0 + u * (x1 - x0);
-        inter.push_back({x, it.current_node()});
-      }
+  for (const CircularList<ContourPoint>::Node* node : myYStrips.Get(yConst)) {
+    gp_Pnt2d p0 = node->data.p;
+    gp_Pnt2d p1 = node->next->data.p;
+    // Пересекается ли отрезок (p0,p1) с горизонтальной прямой?
+    Standard_Real x0 = p0.X(), x1 = p1.X();
+    Standard_Real y0 = p0.Y(), y1 = p1.Y();
+    Standard_Boolean b1 =
+        (yConst >= y0 || yConst >= y1) && (yConst <= y0 || yConst <= y1);
+    Standard_Boolean b2 =
+        (x0 >= xMin && x0 <= xMax || x1 >= xMin && x1 <= xMax);
+    if (b1 && b2) {
+      Standard_Real u = (yConst - y0) / (y1 - y0);
+      Standard_Real x = x0 + u * (x1 - x0);
+      inter.push_back({x, node});
     }
   }
 
@@ -465,7 +790,7 @@ PositionType Reverse(PositionType t) {
 }
 
 void GetEdgeInfo(
-    const std::vector<MeshLinesAndContoursIntersections::Cross>& lints,
+    std::span<const MeshLinesAndContoursIntersections::Cross> lints,
     Standard_Real uBeg, Standard_Real uEnd, PositionType& t1, PositionType& t2,
     const CircularList<ContourPoint>::Node** seg1,
     const CircularList<ContourPoint>::Node** seg2) {
@@ -666,6 +991,8 @@ MeshLinesAndContoursIntersections::MeshLinesAndContoursIntersections(
   myLevelIndex = levelIndex;
   qTree.CellsNumberOnLevel(levelIndex, nbVLines, nbHLines);
   nbVLines += 1, nbHLines += 1;
+  myXStrips.Build(fContours, xMin, xMax, Standard_True);
+  myYStrips.Build(fContours, yMin, yMax, Standard_False);
 }
 }  // namespace
 
@@ -682,32 +1009,73 @@ AuxClassificateData2d::AuxClassificateData2d(const TopoDS_Face& F,
   box.Get(xMinBox, yMinBox, xMaxBox, yMaxBox);
   MeshLinesAndContoursIntersections mlacInts(*qTree, fContours,
                                              maxLevelsNumber);
-  std::vector<Standard_Integer> splitCells;
+  // Дерево строится сверху вниз по уровням. Ячейки уровня классифицируются
+  // в нескольких потоках, затем атрибуты и деления применяются к дереву
+  // последовательно. Следующий уровень составляют дочерние ячейки
+  // разделенных: другие ячейки этого уровня не существуют.
+  std::vector<QuadTree::Cell> cells;
+  for (QuadTree::Cell cell : qTree->TerminalCellsOfLevel(0))
+    cells.push_back(cell);
+  std::vector<size_t> attrs;
+  std::vector<size_t> vLines, hLines;
   for (Standard_Integer level = 0; level < maxLevelsNumber; ++level) {
-    splitCells.clear();
-    for (QuadTree::Cell cell : qTree->TerminalCellsOfLevel(level)) {
-      const CircularList<ContourPoint>::Node* node = nullptr;
-      PositionType type =
-          ClassificateCell(*qTree, cell, fContours, mlacInts, &node);
-
-      if (type == BoundaryPosition && !node)
-        splitCells.push_back(cell.index);
-      else {
-        size_t attr;
+    vLines.clear();
+    hLines.clear();
+    for (const QuadTree::Cell& cell : cells) {
+      Standard_Integer i1Line, j1Line, i2Line, j2Line;
+      GetCellLineIndices(mlacInts, *qTree, cell, i1Line, j1Line, i2Line,
+                         j2Line);
+      vLines.push_back(i1Line);
+      vLines.push_back(i2Line);
+      hLines.push_back(j1Line);
+      hLines.push_back(j2Line);
+    }
+    for (std::vector<size_t>* lines : {&vLines, &hLines}) {
+      std::sort(lines->begin(), lines->end());
+      lines->erase(std::unique(lines->begin(), lines->end()), lines->end());
+    }
+    mlacInts.Prepare(vLines, hLines);
+
+    // Отметка граничной ячейки, которую нужно разделить.
+    static const size_t splitMark = std::numeric_limits<size_t>::max();
+    attrs.assign(cells.size(), 0);
+    ParallelFor(cells.size(), [&](size_t iBegin, size_t iEnd) {
+      for (size_t i = iBegin; i < iEnd; ++i) {
+        const CircularList<ContourPoint>::Node* node = nullptr;
+        PositionType type =
+            ClassificateCell(*qTree, cells[i], fContours, mlacInts, &node);
         if (type == OuterPosition)
-          attr = 1;
+          attrs[i] = 1;
         else if (type == InnerPosition)
-          attr = 0;
-        else  // type == BoundaryPosition
-          attr = reinterpret_cast<size_t>(node);
-        qTree->SetAttr(cell, attr);
+          attrs[i] = 0;
+        else if (!node)
+          attrs[i] = splitMark;
+        else
+          attrs[i] = reinterpret_cast<size_t>(node);
+      }
+    });
+
+    std::vector<QuadTree::Cell> children;
+    Standard_Integer ni, nj;
+    qTree->CellsNumberOnLevel(level + 1, ni, nj);
+    for (size_t i = 0; i < cells.size(); ++i) {
+      if (attrs[i] != splitMark) {
+        qTree->SetAttr(cells[i], attrs[i]);
+        continue;
+      }
+      qTree->Split(cells[i]);
+      Standard_Integer iCell, jCell;
+      qTree->GetCellCoords(cells[i], iCell, jCell);
+      for (Standard_Integer dj = 0; dj < 2; ++dj) {
+        for (Standard_Integer di = 0; di < 2; ++di)
+          children.emplace_back(level + 1,
+                                (2 * jCell + dj) * ni + 2 * iCell + di);
       }
     }
 
-    if (splitCells.empty()) break;
-
-    for (Standard_Integer cellIndex : splitCells)
-      qTree->Split(QuadTree::Cell(level, cellIndex));
+    if (children.empty()) break;
+    std::sort(children.begin(), children.end());
+    cells.swap(children);
   }
 }
 
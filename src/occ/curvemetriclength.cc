@@ -2,6 +2,7 @@
 
 #include <Geom2d_Curve.hxx>
 #include <Geom_Curve.hxx>
+#include <algorithm>
 #include <cassert>
 #include <gp_Lin2d.hxx>
 #include <gp_Pln.hxx>
@@ -137,6 +138,23 @@ Standard_Real MaximumGapParameter(const Handle(Geom2d_Curve) & C,
 Standard_Real pow2(double v) { return v * v; }
 
 Standard_Real pow3(double v) { return v * v * v; }
+
+//! Номер отрезка ломаной (от 1), на котором лежит точка, удаленная по кривой
+//! на `abscissa` от ее начала; `cumLength` -- длины от начала до узлов. Поиск
+//! начинается с отрезка `hint`, поэтому для возрастающих длин таблица
+//! просматривается один раз. Возвращает размер таблицы, если длина больше
+//! длины кривой.
+size_t FindSegment(const std::vector<Standard_Real>& cumLength,
+                   Standard_Real abscissa, size_t hint) {
+  const size_t n = cumLength.size();
+  if (hint == 0 || hint >= n || cumLength[hint - 1] > abscissa) {
+    auto it = std::lower_bound(cumLength.begin() + 1, cumLength.end(),
+                               abscissa);
+    return it - cumLength.begin();
+  }
+  while (hint < n && cumLength[hint] < abscissa) ++hint;
+  return hint;
+}
 }  // namespace
 
 CurveMetricLength::CurveMetricLength(const Handle(Geom_Curve) & C,
@@ -148,17 +166,16 @@ CurveMetricLength::CurveMetricLength(const Handle(Geom_Curve) & C,
   myRelAccuracy = relAccuracy;
 
   myL = 0.0;
-  myPolyline = {myU0, myU1};
-  auto it = myPolyline.begin();
-  Standard_Real u0 = *it;
-  Standard_Real m0 = MetricOnCurvePoint(u0);
-  while (Standard_True) {
-    auto itNext = it;
-    ++itNext;
-    if (itNext == myPolyline.end()) break;
-
-    Standard_Real tA = *it;
-    Standard_Real tB = *itNext;
+  myPolyline.push_back(myU0);
+  myMetric.push_back(MetricOnCurvePoint(myU0));
+  myAbscissa.push_back(0.0);
+  // Правые концы еще не принятых отрезков ломаной, ближайший -- последний.
+  // Отрезки делятся и принимаются слева направо, поэтому принятые узлы
+  // дописываются в конец массивов.
+  std::vector<Standard_Real> pending = {myU1};
+  while (!pending.empty()) {
+    Standard_Real tA = myPolyline.back();
+    Standard_Real tB = pending.back();
 
     Standard_Real tC = MaximumGapParameter(C, tA, tB);
     gp_Pnt ptA = C->Value(tA);
@@ -168,20 +185,21 @@ CurveMetricLength::CurveMetricLength(const Handle(Geom_Curve) & C,
     Standard_Real d1 = ptA.Distance(ptC);
     Standard_Real d2 = ptB.Distance(ptC);
     Standard_Real eps = std::abs(d / (d1 + d2) - 1.0);
-    if (eps > relAccuracy)
-      myPolyline.insert(itNext, tC);
-    else {
-      Standard_Real u1 = (*itNext);
-      Standard_Real m1 = MetricOnCurvePoint(u1);
-      Standard_Real subL = CalcCurveMetricLength(u0, u1, m0, m1);
-      if (subL > 0.1) {
-        myPolyline.insert(itNext, tC);
-      } else {
-        myL += subL;
-        u0 = u1, m0 = m1;
-        ++it;
-      }
+    if (eps > relAccuracy) {
+      pending.push_back(tC);
+      continue;
+    }
+    Standard_Real m1 = MetricOnCurvePoint(tB);
+    Standard_Real subL = CalcCurveMetricLength(tA, tB, myMetric.back(), m1);
+    if (subL > 0.1) {
+      pending.push_back(tC);
+      continue;
     }
+    myL += subL;
+    myPolyline.push_back(tB);
+    myMetric.push_back(m1);
+    myAbscissa.push_back(myL);
+    pending.pop_back();
   }
 }
 
@@ -190,43 +208,60 @@ Standard_Real CurveMetricLength::Length() const { return myL; }
 Standard_Real CurveMetricLength::ParameterByAbscissa(
     Standard_Real uStart, Standard_Real abscissa) const {
   assert(uStart >= myU0 && uStart <= myU1);
+  Standard_Real s = AbscissaOfParameter(uStart) + abscissa;
+  if (s - myL > 1.e-8) return HUGE_VAL;
+  size_t segment = FindSegment(myAbscissa, s, 0);
+  return segment < myAbscissa.size() ? ParameterInSegment(segment, s) : myU1;
+}
 
-  gp_Pnt ptStart = myCurve->Value(uStart);
-  auto it = myPolyline.begin();
-  while (it != myPolyline.end() && *it <= uStart) ++it;
-  Standard_Real u0 = uStart;
-  Standard_Real m0 = MetricOnCurvePoint(u0);
-  Standard_Real u1 = (*it);
-  Standard_Real m1 = MetricOnCurvePoint(u1);
-  Standard_Real allL = CalcCurveMetricLength(u0, u1, m0, m1);
-  while (allL < abscissa) {
-    ++it;
-    if (it == myPolyline.end()) return HUGE_VAL;
-    u0 = u1, m0 = m1;
-    u1 = (*it);
-    m1 = MetricOnCurvePoint(u1);
-    Standard_Real L = CalcCurveMetricLength(u0, u1, m0, m1);
-    allL += L;
+void CurveMetricLength::ParametersByAbscissae(
+    const std::vector<Standard_Real>& abscissae,
+    std::vector<Standard_Real>& params) const {
+  params.resize(abscissae.size());
+  size_t segment = 0;
+  for (size_t i = 0; i < abscissae.size(); ++i) {
+    Standard_Real s = abscissae[i];
+    if (s - myL > 1.e-8) {
+      params[i] = HUGE_VAL;
+      continue;
+    }
+    segment = FindSegment(myAbscissa, s, segment);
+    params[i] =
+        segment < myAbscissa.size() ? ParameterInSegment(segment, s) : myU1;
   }
+}
 
-  Standard_Real restL = allL - abscissa;
-  if (restL < 1.e-8) return u0;
+Standard_Real CurveMetricLength::AbscissaOfParameter(Standard_Real u) const {
+  auto it = std::upper_bound(myPolyline.begin(), myPolyline.end(), u);
+  if (it == myPolyline.begin()) return 0.0;
+  if (it == myPolyline.end()) return myL;
+  size_t i = (it - myPolyline.begin()) - 1;
+  return myAbscissa[i] +
+         CalcCurveMetricLength(myPolyline[i], u, myMetric[i],
+                               MetricOnCurvePoint(u));
+}
+
+Standard_Real CurveMetricLength::ParameterInSegment(
+    size_t segment, Standard_Real abscissa) const {
+  Standard_Real u0 = myPolyline[segment - 1];
+  Standard_Real u1 = myPolyline[segment];
+  if (abscissa <= myAbscissa[segment - 1]) return u0;
+  if (abscissa >= myAbscissa[segment]) return u1;
 
-  Standard_Real u, m;
-  Standard_Real us = u0, ms = m0;
+  // Длина отсчитывается от начала отрезка, метрика в котором известна.
+  Standard_Real us = u0, ms = myMetric[segment - 1];
+  Standard_Real restL = abscissa - myAbscissa[segment - 1];
   for (Standard_Integer iter = 0; iter < 10; ++iter) {
-    u = 0.5 * (u0 + u1);
-    m = MetricOnCurvePoint(u);
-    Standard_Real L = CalcCurveMetricLength(us, u, ms, m);
+    Standard_Real u = 0.5 * (u0 + u1);
+    Standard_Real L = CalcCurveMetricLength(us, u, ms, MetricOnCurvePoint(u));
     if (L < restL)
-      u0 = u, m0 = m;
+      u0 = u;
     else if (L > restL)
-      u1 = u, m1 = m;
+      u1 = u;
     else
-      break;
+      return u;
   }
-
-  return u;
+  return 0.5 * (u0 + u1);
 }
 
 Standard_Real CurveMetricLength::CalcCurveMetricLength(Standard_Real uA,
@@ -267,17 +302,16 @@ Curve2dMetricLength::Curve2dMetricLength(const Handle(Geom2d_Curve) & C,
   myRelAccuracy = relAccuracy;
 
   myL = 0.0;
-  myPolyline = {myU0, myU1};
-  auto it = myPolyline.begin();
-  Standard_Real u0 = *it;
-  Standard_Real m0 = MetricOnCurvePoint(u0);
-  while (Standard_True) {
-    auto itNext = it;
-    ++itNext;
-    if (itNext == myPolyline.end()) break;
-
-    Standard_Real tA = *it;
-    Standard_Real tB = *itNext;
+  myPolyline.push_back(myU0);
+  myMetric.push_back(MetricOnCurvePoint(myU0));
+  myAbscissa.push_back(0.0);
+  // Правые концы еще не принятых отрезков ломаной, ближайший -- последний.
+  // Отрезки делятся и принимаются слева направо, поэтому принятые узлы
+  // дописываются в конец массивов.
+  std::vector<Standard_Real> pending = {myU1};
+  while (!pending.empty()) {
+    Standard_Real tA = myPolyline.back();
+    Standard_Real tB = pending.back();
 
     Standard_Real tC = MaximumGapParameter(C, tA, tB);
     gp_Pnt2d ptA = C->Value(tA);
@@ -287,20 +321,21 @@ Curve2dMetricLength::Curve2dMetricLength(const Handle(Geom2d_Curve) & C,
     Standard_Real d1 = ptA.Distance(ptC);
     Standard_Real d2 = ptB.Distance(ptC);
     Standard_Real eps = std::abs(d / (d1 + d2) - 1.0);
-    if (eps > relAccuracy)
-      myPolyline.insert(itNext, tC);
-    else {
-      Standard_Real u1 = (*itNext);
-      Standard_Real m1 = MetricOnCurvePoint(u1);
-      Standard_Real subL = CalcCurveMetricLength(u0, u1, m0, m1);
-      if (subL > 0.1) {
-        myPolyline.insert(itNext, tC);
-      } else {
-        myL += subL;
-        u0 = u1, m0 = m1;
-        ++it;
-      }
+    if (eps > relAccuracy) {
+      pending.push_back(tC);
+      continue;
+    }
+    Standard_Real m1 = MetricOnCurvePoint(tB);
+    Standard_Real subL = CalcCurveMetricLength(tA, tB, myMetric.back(), m1);
+    if (subL > 0.1) {
+      pending.push_back(tC);
+      continue;
     }
+    myL += subL;
+    myPolyline.push_back(tB);
+    myMetric.push_back(m1);
+    myAbscissa.push_back(myL);
+    pending.pop_back();
   }
 }
 
@@ -309,43 +344,60 @@ Standard_Real Curve2dMetricLength::Length() const { return myL; }
 Standard_Real Curve2dMetricLength::ParameterByAbscissa(
     Standard_Real uStart, Standard_Real abscissa) const {
   assert(uStart >= myU0 && uStart <= myU1);
+  Standard_Real s = AbscissaOfParameter(uStart) + abscissa;
+  if (s - myL > 1.e-8) return HUGE_VAL;
+  size_t segment = FindSegment(myAbscissa, s, 0);
+  return segment < myAbscissa.size() ? ParameterInSegment(segment, s) : myU1;
+}
 
-  gp_Pnt2d ptStart = myCurve->Value(uStart);
-  auto it = myPolyline.begin();
-  while (it != myPolyline.end() && *it <= uStart) ++it;
-  Standard_Real u0 = uStart;
-  Standard_Real m0 = MetricOnCurvePoint(u0);
-  Standard_Real u1 = (*it);
-  Standard_Real m1 = MetricOnCurvePoint(u1);
-  Standard_Real allL = CalcCurveMetricLength(u0, u1, m0, m1);
-  while (allL < abscissa) {
-    ++it;
-    if (it == myPolyline.end()) return HUGE_VAL;
-    u0 = u1, m0 = m1;
-    u1 = (*it);
-    m1 = MetricOnCurvePoint(u1);
-    Standard_Real L = CalcCurveMetricLength(u0, u1, m0, m1);
-    allL += L;
+void Curve2dMetricLength::ParametersByAbscissae(
+    const std::vector<Standard_Real>& abscissae,
+    std::vector<Standard_Real>& params) const {
+  params.resize(abscissae.size());
+  size_t segment = 0;
+  for (size_t i = 0; i < abscissae.size(); ++i) {
+    Standard_Real s = abscissae[i];
+    if (s - myL > 1.e-8) {
+      params[i] = HUGE_VAL;
+      continue;
+    }
+    segment = FindSegment(myAbscissa, s, segment);
+    params[i] =
+        segment < myAbscissa.size() ? ParameterInSegment(segment, s) : myU1;
   }
+}
+
+Standard_Real Curve2dMetricLength::AbscissaOfParameter(Standard_Real u) const {
+  auto it = std::upper_bound(myPolyline.begin(), myPolyline.end(), u);
+  if (it == myPolyline.begin()) return 0.0;
+  if (it == myPolyline.end()) return myL;
+  size_t i = (it - myPolyline.begin()) - 1;
+  return myAbscissa[i] +
+         CalcCurveMetricLength(myPolyline[i], u, myMetric[i],
+                               MetricOnCurvePoint(u));
+}
 
-  Standard_Real restL = allL - abscissa;
-  if (restL < 1.e-8) return u0;
+Standard_Real Curve2dMetricLength::ParameterInSegment(
+    size_t segment, Standard_Real abscissa) const {
+  Standard_Real u0 = myPolyline[segment - 1];
+  Standard_Real u1 = myPolyline[segment];
+  if (abscissa <= myAbscissa[segment - 1]) return u0;
+  if (abscissa >= myAbscissa[segment]) return u1;
 
-  Standard_Real u, m;
-  Standard_Real us = u0, ms = m0;
+  // Длина отсчитывается от начала отрезка, метрика в котором известна.
+  Standard_Real us = u0, ms = myMetric[segment - 1];
+  Standard_Real restL = abscissa - myAbscissa[segment - 1];
   for (Standard_Integer iter = 0; iter < 10; ++iter) {
-    u = 0.5 * (u0 + u1);
-    m = MetricOnCurvePoint(u);
-    Standard_Real L = CalcCurveMetricLength(us, u, ms, m);
+    Standard_Real u = 0.5 * (u0 + u1);
+    Standard_Real L = CalcCurveMetricLength(us, u, ms, MetricOnCurvePoint(u));
     if (L < restL)
-      u0 = u, m0 = m;
+      u0 = u;
     else if (L > restL)
-      u1 = u, m1 = m;
+      u1 = u;
     else
-      break;
+      return u;
   }
-
-  return u;
+  return 0.5 * (u0 + u1);
 }
 
 Standard_Real Curve2dMetricLength::CalcCurveMetricLength(
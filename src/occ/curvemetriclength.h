@@ -1,7 +1,7 @@
 #ifndef NUMGEOM_NUMGEOM_CURVEMETRICLENGTH_H
 #define NUMGEOM_NUMGEOM_CURVEMETRICLENGTH_H
 
-#include <list>
+#include <vector>
 
 #include "Standard_Handle.hxx"
 
@@ -15,21 +15,39 @@ class CurveMetricLength {
 
   Standard_Real Length() const;
 
+  //! Параметр точки, удаленной по кривой на `abscissa` от точки `u0`,
+  //! или HUGE_VAL, если такой точки нет.
   Standard_Real ParameterByAbscissa(Standard_Real u0,
                                     Standard_Real abscissa) const;
 
+  //! Параметры точек, удаленных по кривой на `abscissae` от ее начала.
+  //! Для возрастающих длин таблица длин просматривается один раз.
+  void ParametersByAbscissae(const std::vector<Standard_Real>& abscissae,
+                             std::vector<Standard_Real>& params) const;
+
  private:
   Standard_Real MetricOnCurvePoint(Standard_Real u) const;
 
   Standard_Real CalcCurveMetricLength(Standard_Real uA, Standard_Real uB,
                                       Standard_Real hA, Standard_Real hB) const;
 
+  //! Длина части кривой от ее начала до точки `u`.
+  Standard_Real AbscissaOfParameter(Standard_Real u) const;
+
+  //! Параметр точки отрезка `segment` ломаной, удаленной по кривой на
+  //! `abscissa` от начала кривой.
+  Standard_Real ParameterInSegment(size_t segment,
+                                   Standard_Real abscissa) const;
+
  private:
   Handle(Geom_Curve) myCurve;
   Standard_Real myU0, myU1;
   Standard_Real myL;
   Standard_Real myRelAccuracy;
-  std::list<Standard_Real> myPolyline;
+  //! Узлы ломаной, метрика в них и длины частей кривой от начала до узлов.
+  std::vector<Standard_Real> myPolyline;
+  std::vector<Standard_Real> myMetric;
+  std::vector<Standard_Real> myAbscissa;
 };
 
 class Curve2dMetricLength {
@@ -39,20 +57,38 @@ class Curve2dMetricLength {
 
   Standard_Real Length() const;
 
+  //! Параметр точки, удаленной по кривой на `abscissa` от точки `u0`,
+  //! или HUGE_VAL, если такой точки нет.
   Standard_Real ParameterByAbscissa(Standard_Real u0,
                                     Standard_Real abscissa) const;
 
+  //! Параметры точек, удаленных по кривой на `abscissae` от ее начала.
+  //! Для возрастающих длин таблица длин просматривается один раз.
+  void ParametersByAbscissae(const std::vector<Standard_Real>& abscissae,
+                             std::vector<Standard_Real>& params) const;
+
  private:
   Standard_Real MetricOnCurvePoint(Standard_Real u) const;
 
   Standard_Real CalcCurveMetricLength(Standard_Real uA, Standard_Real uB,
                                       Standard_Real hA, Standard_Real hB) const;
 
+  //! Длина части кривой от ее начала до точки `u`.
+  Standard_Real AbscissaOfParameter(Standard_Real u) const;
+
+  //! Параметр точки отрезка `segment` ломаной, удаленной по кривой на
+  //! `abscissa` от начала кривой.
+  Standard_Real ParameterInSegment(size_t segment,
+                                   Standard_Real abscissa) const;
+
  private:
   Handle(Geom2d_Curve) myCurve;
   Standard_Real myU0, myU1;
   Standard_Real myL;
   Standard_Real myRelAccuracy;
-  std::list<Standard_Real> myPolyline;
+  //! Узлы ломаной, метрика в них и длины частей кривой от начала до узлов.
+  std::vector<Standard_Real> myPolyline;
+  std::vector<Standard_Real> myMetric;
+  std::vector<Standard_Real> myAbscissa;
 };
 #endif  // !NUMGEOM_NUMGEOM_CURVEMETRICLENGTH_H
@@ -1,12 +1,23 @@
 #include "numgeom/drawable_occshape.h"
 
-#include "BRep_Tool.hxx"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+
+#include "BRepBuilderAPI_Copy.hxx"
 #include "BRepMesh_IncrementalMesh.hxx"
+#include "BRepTools.hxx"
+#include "BRep_Tool.hxx"
+#include "Bnd_Box.hxx"
+#include "Standard_Failure.hxx"
 #include "gp_Trsf.hxx"
 #include "TopExp_Explorer.hxx"
 #include "TopoDS.hxx"
 #include "TopoDS_Face.hxx"
 #include "TopoDS_Shape.hxx"
+#include "TopoDS_TShape.hxx"
 #if OCC_VERSION_HEX >= 0x070700
 #  include "BRepLib_ToolTriangulatedShape.hxx"
 #else
@@ -15,313 +26,606 @@
 
 #include "glm/gtc/matrix_transform.hpp"
 
-namespace {
+#include "numgeom/application.h"
+#include "numgeom/iteratorimpl.h"
+#include "numgeom/loadasync.h"
+#include "numgeom/parallelfor.h"
+#include "numgeom/scene.h"
+#include "numgeom/sceneobject.h"
+#include "numgeom/utilities.h"
 
-class OccVertexIterator : public IteratorImpl<glm::vec3> {
- public:
-  typedef std::tuple<Handle(Poly_Triangulation),gp_Trsf,bool> TrngInfo;
-
- public:
-  OccVertexIterator(const std::list<TrngInfo>& triangulations)
-      : triangulations_(triangulations),
-        trng_it_(triangulations_.end()),
-        current_index_(0),
-        index_count_(0) {
-    if(!triangulations_.empty()) {
-      trng_it_ = triangulations_.begin();
-      index_count_ = std::get<0>(*trng_it_)->NbNodes();
-    }
-  }
+namespace {
 
-  OccVertexIterator(const std::list<TrngInfo>& triangulations,
-                    std::list<TrngInfo>::const_iterator trng_it,
-                    size_t current_index = 0,
-                    size_t index_count = 0)
-      : triangulations_(triangulations),
-        trng_it_(trng_it),
-        current_index_(current_index),
-        index_count_(index_count) {
-  }
+const glm::vec3 kHighlightColor(1.0f, 0.75f, 0.0f);
+const glm::vec3 kSelectionColor(0.1f, 0.45f, 1.0f);
 
-  virtual ~OccVertexIterator() {}
+//! Защищает кэш прототипов. Под этим же замком проверяется, что прототип
+//! больше никому не нужен, так что кэш не выдаст его во время очистки.
+std::mutex s_prototypeMutex;
 
-  void advance() override {
-    ++current_index_;
-    if (current_index_ == index_count_) {
-      ++trng_it_;
-      if(trng_it_ == triangulations_.end())
-        return;
-      current_index_ = 0;
-      index_count_ = std::get<0>(*trng_it_)->NbNodes();
-    }
-  }
+void ComputeNormals(const TopoDS_Face& f,
+                    const Handle(Poly_Triangulation)& tr) {
+  if (tr->HasNormals() || !tr->HasUVNodes())
+    return;
+#if OCC_VERSION_HEX >= 0x070700
+  BRepLib_ToolTriangulatedShape::ComputeNormals(f,tr);
+#else
+  StdPrs_ToolTriangulatedShape::ComputeNormals(f,tr);
+#endif
+}
 
-  glm::vec3 current() const override {
-    gp_Pnt pt = std::get<0>(*trng_it_)->Node(current_index_ + 1);
-    pt.Transform(std::get<1>(*trng_it_));
-    return glm::vec3(pt.X(), pt.Y(), pt.Z());
+//! Строит сетку грани с заданным прогибом. Сетка строится на копии грани:
+//! у копии свои ребра и поверхность, поэтому фоновое построение не
+//! затрагивает триангуляции исходной фигуры и соседних граней.
+Handle(Poly_Triangulation) MeshFaceCopy(const TopoDS_Face& face,
+                                        double deflection, double angle) {
+  try {
+    BRepBuilderAPI_Copy copier(face, Standard_True, Standard_False);
+    TopoDS_Face copy = TopoDS::Face(copier.Shape());
+    BRepMesh_IncrementalMesh(copy, deflection, Standard_False, angle,
+                             Standard_False);
+    TopLoc_Location l;
+    Handle(Poly_Triangulation) tr = BRep_Tool::Triangulation(copy,l);
+    if (tr)
+      ComputeNormals(copy,tr);
+    return tr;
+  } catch (const Standard_Failure&) {
+    return Handle(Poly_Triangulation)();
   }
+}
 
-  IteratorImpl<glm::vec3>* clone() const override {
-    return new OccVertexIterator(triangulations_, trng_it_, current_index_,
-                                 index_count_);
+//! Есть ли у граней сетки подробнее, чем требуют параметры. Такие сетки
+//! остаются от прототипа той же фигуры с меньшим прогибом.
+bool HasFinerTriangulation(const TopoDS_Shape& shape,
+                           const MeshParameters& params) {
+  if (params.relative)
+    return false;
+  for (TopExp_Explorer it(shape,TopAbs_FACE); it.More(); it.Next()) {
+    TopLoc_Location l;
+    const Handle(Poly_Triangulation)& tr =
+        BRep_Tool::Triangulation(TopoDS::Face(it.Value()),l);
+    if (tr && tr->Deflection() < params.linearDeflection * (1.0 - 1.0e-7))
+      return true;
   }
+  return false;
+}
 
-  IteratorImpl<glm::vec3>* last() const override {
-    return new OccVertexIterator(triangulations_, triangulations_.end());
-  }
+double Distance(const Bnd_Box& box, const glm::vec3& p) {
+  double xmin, ymin, zmin, xmax, ymax, zmax;
+  box.Get(xmin, ymin, zmin, xmax, ymax, zmax);
+  double dx = std::max({xmin - p.x, 0.0, p.x - xmax});
+  double dy = std::max({ymin - p.y, 0.0, p.y - ymax});
+  double dz = std::max({zmin - p.z, 0.0, p.z - zmax});
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
 
-  bool end() const override {
-    return trng_it_ == triangulations_.end();
-  }
+} // namespace
 
-  bool equals(const IteratorImpl<glm::vec3>& other) const override {
-    auto ptr = dynamic_cast<const OccVertexIterator*>(&other);
-    if (!ptr) return false;
-    if(trng_it_ == triangulations_.end() && trng_it_ == ptr->trng_it_)
-      return true;
-    return trng_it_ == ptr->trng_it_ &&
-           current_index_ == ptr->current_index_;
-  }
+/**
+\brief Общие для всех вхождений фигуры сетки граней.
+
+Прототип -- фигура, перенесенная в начало координат. Все вхождения фигуры
+(например, одинаковые болты сборки) ссылаются на один прототип и отличаются
+только положением, поэтому сетки граней и их уточнения строятся и хранятся
+один раз на уникальную деталь.
+*/
+struct Drawable2_OccShape::Prototype {
+  //! Уровни детализации сетки одной грани.
+  struct Face {
+    TopoDS_Face face;
+    gp_Trsf location;          //!< Положение грани в прототипе.
+    bool reversed;
+    Bnd_Box box;               //!< Коробка грани в системе прототипа.
+    double deflection;         //!< Прогиб уровня 0 в системе прототипа.
+    std::vector<Handle(Poly_Triangulation)> levels;
+    int limit;                 //!< Уровень, выше которого сетку не построить.
+  };
+
+  Prototype(const TopoDS_Shape& shape, const MeshParameters& params);
+
+  //! Увеличивает число хранимых уровней граней до `maxLevel + 1`.
+  void Reserve(int maxLevel);
+
+  //! Разбирает сетки, построенные в фоне, по уровням граней.
+  void Collect();
+
+  //! Просит построить уровень `level` грани `index`; `priority` -- ошибка
+  //! на экране, с которой грань отображается сейчас.
+  void Request(size_t index, int level, double priority);
+
+  //! Запускает построение запрошенных уровней, если оно еще не идет.
+  //! Возвращает `true`, если построение не закончено.
+  bool Refine();
+
+  TopoDS_Shape shape;
+  MeshParameters params;
+  std::vector<Face> faces;
+  std::map<size_t,std::pair<int,double>> requests;
+  std::shared_ptr<RefinedFaces> refined;
+  // Фоновое построение работает с копиями граней и с `refined`, поэтому
+  // деструктор только отменяет его, не дожидаясь завершения.
+  AsyncLoad<void> refining;
+};
 
- private:
-  const std::list<TrngInfo>& triangulations_;
-  std::list<TrngInfo>::const_iterator trng_it_;
-  size_t current_index_;
-  size_t index_count_;
+//! Сетки граней, построенные в фоне и еще не разобранные по уровням.
+struct Drawable2_OccShape::RefinedFaces {
+  std::mutex mutex;
+  std::vector<std::tuple<size_t,int,Handle(Poly_Triangulation)>> items;
 };
 
-class OccTriangleIterator : public IteratorImpl<glm::u32vec3> {
- public:
-   typedef std::tuple<Handle(Poly_Triangulation),gp_Trsf,bool> TrngInfo;
-
- public:
-   OccTriangleIterator(const std::list<TrngInfo>& triangulations)
-       : triangulations_(triangulations),
-         current_index_(0),
-         index_count_(0),
-         vertex_offset_(0),
-         reverse_normal_(false) {
-     if(!triangulations_.empty()) {
-       trng_it_ = triangulations_.begin();
-       index_count_ = std::get<0>(*trng_it_)->NbTriangles();
-       reverse_normal_ = std::get<2>(*trng_it_);
-     }
-   }
-
-  OccTriangleIterator(const std::list<TrngInfo>& triangulations,
-                     std::list<TrngInfo>::const_iterator trng_it,
-                     size_t current_index = 0,
-                     size_t index_count = 0,
-                     size_t vertex_offset = 0)
-      : triangulations_(triangulations),
-        trng_it_(trng_it),
-        current_index_(current_index),
-        index_count_(index_count),
-        vertex_offset_(vertex_offset),
-        reverse_normal_(false) {
-    if(trng_it_ != triangulations_.end())
-      reverse_normal_ = std::get<2>(*trng_it_);
+Drawable2_OccShape::Prototype::Prototype(const TopoDS_Shape& s,
+                                         const MeshParameters& p)
+    : shape(s), params(p), refined(std::make_shared<RefinedFaces>()) {
+  // Прототип с другими параметрами уже забрал сетки граней себе, поэтому
+  // слишком подробные сетки можно убрать с граней и построить заново.
+  if (HasFinerTriangulation(shape, params))
+    BRepTools::Clean(shape);
+  TriangulateShape(shape, params);
+  for (TopExp_Explorer it(shape,TopAbs_FACE); it.More(); it.Next()) {
+    const TopoDS_Face& f = TopoDS::Face(it.Value());
+    TopLoc_Location l;
+    Handle(Poly_Triangulation) tr = BRep_Tool::Triangulation(f,l);
+    if (!tr)
+      continue;
+    ComputeNormals(f,tr);
+    Face face;
+    face.face = f;
+    face.location = l.Transformation();
+    face.reversed = (f.Orientation() == TopAbs_REVERSED);
+    for (Standard_Integer i = 1; i <= tr->NbNodes(); ++i)
+      face.box.Add(tr->Node(i).Transformed(face.location));
+    double deflection =
+        tr->Deflection() > 0.0 ? tr->Deflection() : params.linearDeflection;
+    face.deflection = deflection * std::abs(face.location.ScaleFactor());
+    face.levels.push_back(tr);
+    face.limit = std::numeric_limits<int>::max();
+    faces.push_back(face);
   }
+}
 
-   virtual ~OccTriangleIterator() {}
-
-  void advance() override {
-    ++current_index_;
-    if (current_index_ == index_count_) {
-      vertex_offset_ += std::get<0>(*trng_it_)->NbNodes();
-      ++trng_it_;
-      current_index_ = 0;
-      if (trng_it_ != triangulations_.end()) {
-        index_count_ = std::get<0>(*trng_it_)->NbTriangles();
-        reverse_normal_ = std::get<2>(*trng_it_);
-      }
-    }
+void Drawable2_OccShape::Prototype::Reserve(int maxLevel) {
+  for (Face& face : faces) {
+    if (face.levels.size() < static_cast<size_t>(maxLevel) + 1)
+      face.levels.resize(maxLevel + 1);
   }
+}
 
-  glm::u32vec3 current() const override {
-    const Handle(Poly_Triangulation)& trng = std::get<0>(*trng_it_);
-    const Poly_Triangle& tri = trng->Triangle(current_index_ + 1); // 1-based index
-    Standard_Integer na, nb, nc;
-    tri.Get(na, nb, nc);
-    // Convert to 0-based and add vertex offset
-    glm::u32vec3 tr(
-        static_cast<uint32_t>(na - 1 + vertex_offset_),
-        static_cast<uint32_t>(nb - 1 + vertex_offset_),
-        static_cast<uint32_t>(nc - 1 + vertex_offset_));
-    if (reverse_normal_)
-      std::swap(tr.y, tr.z);
-    return tr;
+void Drawable2_OccShape::Prototype::Collect() {
+  // Неудача построения ограничивает уровень грани.
+  if (refining.IsReady())
+    refining.Get();
+  std::lock_guard<std::mutex> lock(refined->mutex);
+  for (auto& [index, level, tr] : refined->items) {
+    Face& face = faces[index];
+    if (tr)
+      face.levels[level] = tr;
+    else
+      face.limit = std::min(face.limit, level - 1);
   }
+  refined->items.clear();
+}
 
-  IteratorImpl<glm::u32vec3>* clone() const override {
-    return new OccTriangleIterator(triangulations_, trng_it_, current_index_,
-                                   index_count_, vertex_offset_);
+void Drawable2_OccShape::Prototype::Request(size_t index, int level,
+                                            double priority) {
+  // Из нескольких вхождений строим самый подробный из запрошенных уровней:
+  // вхождениям, которым хватает более грубого, он тоже подходит.
+  auto [it, inserted] = requests.try_emplace(index, level, priority);
+  if (!inserted) {
+    it->second.first = std::max(it->second.first, level);
+    it->second.second = std::max(it->second.second, priority);
   }
+}
 
-  IteratorImpl<glm::u32vec3>* last() const override {
-    return new OccTriangleIterator(triangulations_, triangulations_.end());
+bool Drawable2_OccShape::Prototype::Refine() {
+  // Одновременно строится не больше одной очереди: она обрабатывается
+  // последовательно, начиная с граней с наибольшей ошибкой на экране.
+  if (!refining.IsValid() && !requests.empty()) {
+    struct Task {
+      double priority;
+      size_t index;
+      int level;
+      TopoDS_Face face;
+      double deflection;
+      double angle;
+    };
+    std::vector<Task> tasks;
+    for (const auto& [index, request] : requests) {
+      const Face& face = faces[index];
+      int level = request.first;
+      // Уровень мог быть построен, пока запрос ждал своей очереди.
+      if (level > face.limit || face.levels[level])
+        continue;
+      // Ошибка на экране определяется линейным прогибом, поэтому уточняется
+      // только он; угловой прогиб остается прежним, иначе число
+      // треугольников на криволинейных гранях росло бы независимо от вида.
+      double scale = std::abs(face.location.ScaleFactor());
+      tasks.push_back(Task{request.second, index, level, face.face,
+                           std::ldexp(face.deflection / scale, -level),
+                           params.angularDeflection});
+    }
+    requests.clear();
+    if (tasks.empty())
+      return false;
+    std::sort(tasks.begin(), tasks.end(),
+              [](const Task& a, const Task& b) {
+                return a.priority > b.priority;
+              });
+    refining = LoadAsync<void>(
+        [tasks = std::move(tasks), results = refined](LoadProgress& progress) {
+          for (const Task& task : tasks) {
+            if (progress.IsCancelled())
+              return;
+            Handle(Poly_Triangulation) tr =
+                MeshFaceCopy(task.face, task.deflection, task.angle);
+            std::lock_guard<std::mutex> lock(results->mutex);
+            results->items.emplace_back(task.index, task.level, tr);
+          }
+        });
   }
+  return refining.IsValid();
+}
 
-  bool end() const override {
-    return trng_it_ == triangulations_.end();
-  }
+std::shared_ptr<Drawable2_OccShape::Prototype>
+Drawable2_OccShape::GetPrototype(const TopoDS_Shape& shape,
+                                 const MeshParameters& params) {
+  typedef std::tuple<const TopoDS_TShape*,double,double,bool> Key;
+  static std::map<Key,std::weak_ptr<Prototype>> s_prototypes;
+
+  const Key key(shape.TShape().get(), params.linearDeflection,
+                params.angularDeflection, params.relative);
+  std::lock_guard<std::mutex> lock(s_prototypeMutex);
+  std::shared_ptr<Prototype> prototype = s_prototypes[key].lock();
+  if (prototype)
+    return prototype;
+  std::erase_if(s_prototypes,
+                [](const auto& item) { return item.second.expired(); });
+  TopoDS_Shape located = shape.Located(TopLoc_Location());
+  prototype = std::make_shared<Prototype>(located.Oriented(TopAbs_FORWARD),
+                                          params);
+  s_prototypes[key] = prototype;
+  return prototype;
+}
 
-  bool equals(const IteratorImpl<glm::u32vec3>& other) const override {
-    auto ptr = dynamic_cast<const OccTriangleIterator*>(&other);
-    if (!ptr) return false;
-    return trng_it_ == ptr->trng_it_ &&
-           current_index_ == ptr->current_index_;
-  }
+Drawable2_OccShape::Drawable2_OccShape(SceneObject* parent,
+                                       const TopoDS_Shape& shape,
+                                       const gp_Trsf& trsf,
+                                       const MeshParameters& params)
+    : Drawable2(parent), shape_(shape), trsf_(trsf) {
+  // Положение грани вхождения -- положение грани в прототипе, затем
+  // положение фигуры и преобразование `trsf` вхождения.
+  location_ = trsf * shape.Location().Transformation();
+  inverse_location_ = location_.Inverted();
+  reversed_ = (shape.Orientation() == TopAbs_REVERSED);
+  pixel_error_ = 0.0;
+  max_level_ = 0;
+  prototype_ = GetPrototype(shape, params);
+  for (const Prototype::Face& face : prototype_->faces)
+    faces_.push_back(face.face);
+  levels_.assign(prototype_->faces.size(), 0);
+  face_states_.assign(prototype_->faces.size(), FaceState::Normal);
+  nb_marked_faces_ = 0;
+  this->CollectTriangulations();
+}
 
- private:
-  const std::list<TrngInfo>& triangulations_;
-  std::list<TrngInfo>::const_iterator trng_it_;
-  size_t current_index_;
-  size_t index_count_;
-  size_t vertex_offset_;
-  bool reverse_normal_;
-};
+Drawable2_OccShape::~Drawable2_OccShape() {
+}
 
-class OccNormalIterator : public IteratorImpl<glm::vec3> {
- public:
-   typedef std::tuple<Handle(Poly_Triangulation),gp_Trsf,bool> TrngInfo;
-
- public:
-  OccNormalIterator(const std::list<TrngInfo>& triangulations)
-      : triangulations_(triangulations),
-        trng_it_(triangulations_.end()),
-        current_index_(0),
-        index_count_(0),
-        reverse_normal_(false) {
-    if(!triangulations_.empty()) {
-      trng_it_ = triangulations_.begin();
-      index_count_ = std::get<0>(*trng_it_)->NbNodes();
-      reverse_normal_ = std::get<2>(*trng_it_);
-    }
-  }
+size_t Drawable2_OccShape::GetVertsCount() const {
+  return vertices_.size();
+}
 
-  OccNormalIterator(const std::list<TrngInfo>& triangulations,
-                    std::list<TrngInfo>::const_iterator trng_it,
-                    size_t current_index = 0,
-                    size_t index_count = 0)
-      : triangulations_(triangulations),
-        trng_it_(trng_it),
-        current_index_(current_index),
-        index_count_(index_count),
-        reverse_normal_(false) {
-    if(trng_it_ != triangulations_.end())
-      reverse_normal_ = std::get<2>(*trng_it_);
-  }
+size_t Drawable2_OccShape::GetCellsCount() const {
+  return triangles_.size();
+}
 
-  virtual ~OccNormalIterator() {}
-
-  void advance() override {
-    ++current_index_;
-    if (current_index_ == index_count_) {
-      ++trng_it_;
-      if(trng_it_ == triangulations_.end())
-        return;
-      current_index_ = 0;
-      index_count_ = std::get<0>(*trng_it_)->NbNodes();
-      reverse_normal_ = std::get<2>(*trng_it_);
-    }
-  }
+Iterator<glm::vec3> Drawable2_OccShape::GetVertices() const {
+  typedef std::vector<glm::vec3>::const_iterator StdIteratorType;
+  auto impl = new IteratorImpl_StdIterator<StdIteratorType>(vertices_.begin(),
+                                                            vertices_.end());
+  return Iterator<glm::vec3>(impl);
+}
 
-  glm::vec3 current() const override {
-    const Handle(Poly_Triangulation)& trng = std::get<0>(*trng_it_);
-    gp_Dir normal;
-    if (!trng->HasNormals())
-      return glm::vec3(0.0f, 0.0f, 1.0f);
-    normal = trng->Normal(current_index_ + 1);
-    if (reverse_normal_)
-      normal.Reverse();
-    normal.Transform(std::get<1>(*trng_it_));
-    return glm::vec3(normal.X(), normal.Y(), normal.Z());
-  }
+Iterator<glm::u32vec3> Drawable2_OccShape::GetTriangles() const {
+  typedef std::vector<glm::u32vec3>::const_iterator StdIteratorType;
+  auto impl = new IteratorImpl_StdIterator<StdIteratorType>(triangles_.begin(),
+                                                            triangles_.end());
+  return Iterator<glm::u32vec3>(impl);
+}
 
-  IteratorImpl<glm::vec3>* clone() const override {
-    return new OccNormalIterator(triangulations_, trng_it_, current_index_,
-                                 index_count_);
-  }
+Iterator<glm::vec3> Drawable2_OccShape::GetNormals() const {
+  typedef std::vector<glm::vec3>::const_iterator StdIteratorType;
+  auto impl = new IteratorImpl_StdIterator<StdIteratorType>(normals_.begin(),
+                                                            normals_.end());
+  return Iterator<glm::vec3>(impl);
+}
 
-  IteratorImpl<glm::vec3>* last() const override {
-    return new OccNormalIterator(triangulations_, triangulations_.end());
-  }
+std::span<const glm::vec3> Drawable2_OccShape::GetVertexArray() const {
+  return vertices_;
+}
+
+std::span<const glm::vec3> Drawable2_OccShape::GetNormalArray() const {
+  return normals_;
+}
+
+std::span<const glm::u32vec3> Drawable2_OccShape::GetTriangleArray() const {
+  return triangles_;
+}
+
+std::span<const size_t> Drawable2_OccShape::GetFaceVertexOffsets() const {
+  return face_vertex_offsets_;
+}
+
+std::span<const size_t> Drawable2_OccShape::GetFaceTriangleOffsets() const {
+  return face_triangle_offsets_;
+}
+
+std::span<const uint32_t> Drawable2_OccShape::GetTriangleGroups() const {
+  return triangle_faces_;
+}
 
-  bool end() const override {
-    return trng_it_ == triangulations_.end();
+glm::vec3 Drawable2_OccShape::GetFaceColor(size_t face) const {
+  glm::vec3 color = this->GetColor();
+  switch (face_states_[face]) {
+    case FaceState::Highlighted:
+      return glm::mix(color, kHighlightColor, 0.6f);
+    case FaceState::Selected:
+      return kSelectionColor;
+    default:
+      return color;
   }
+}
+
+glm::vec3 Drawable2_OccShape::GetVertexColor(size_t vertex) const {
+  if (nb_marked_faces_ == 0)
+    return this->GetColor();
+  auto it = std::upper_bound(face_vertex_offsets_.begin(),
+                             face_vertex_offsets_.end(), vertex);
+  return this->GetFaceColor(it - face_vertex_offsets_.begin() - 1);
+}
 
-  bool equals(const IteratorImpl<glm::vec3>& other) const override {
-    auto ptr = dynamic_cast<const OccNormalIterator*>(&other);
-    if (!ptr) return false;
-    return trng_it_ == ptr->trng_it_ &&
-           current_index_ == ptr->current_index_;
+float* Drawable2_OccShape::CopyVertexColors(float* data) const {
+  for (size_t f = 0; f + 1 < face_vertex_offsets_.size(); ++f) {
+    glm::vec3 c = this->GetFaceColor(f);
+    for (size_t v = face_vertex_offsets_[f]; v < face_vertex_offsets_[f + 1];
+         ++v) {
+      *data++ = c.x;
+      *data++ = c.y;
+      *data++ = c.z;
+    }
   }
+  return data;
+}
 
-  private:
-   const std::list<TrngInfo>& triangulations_;
-   std::list<TrngInfo>::const_iterator trng_it_;
-   size_t current_index_;
-   size_t index_count_;
-   bool reverse_normal_;
-};
+size_t Drawable2_OccShape::GetFacesCount() const {
+  return faces_.size();
+}
 
-} // namespace
+TopoDS_Face Drawable2_OccShape::GetFace(size_t index) const {
+  const TopoDS_Face& face = faces_[index];
+  return TopoDS::Face(
+      face.Moved(shape_.Location()).Composed(shape_.Orientation()));
+}
 
-Drawable2_OccShape::Drawable2_OccShape(SceneObject* parent,
-                                       const TopoDS_Shape& shape,
-                                       const gp_Trsf& trsf)
-    : Drawable2(parent), shape_(shape), trsf_(trsf) {
-  verts_num_ = 0;
-  cells_num_ = 0;
-  for (TopExp_Explorer it(shape,TopAbs_FACE); it.More(); it.Next()) {
-    const TopoDS_Face& f = TopoDS::Face(it.Value());
-    TopLoc_Location l;
-    Handle(Poly_Triangulation) tr = BRep_Tool::Triangulation(f,l);
-    if (!tr) {
-      BRepMesh_IncrementalMesh(f,0.6f);
-      tr = BRep_Tool::Triangulation(f,l);
-    }
-    if (!tr)
-      continue;
-    if (!tr->HasNormals() && tr->HasUVNodes()) {
-#if OCC_VERSION_HEX >= 0x070700
-      BRepLib_ToolTriangulatedShape::ComputeNormals(f,tr);
-#else
-      StdPrs_ToolTriangulatedShape::ComputeNormals(f,tr);
-#endif
+void Drawable2_OccShape::SetFaceState(size_t index, FaceState state) {
+  FaceState& current = face_states_[index];
+  if (current == state)
+    return;
+  if (current == FaceState::Normal)
+    ++nb_marked_faces_;
+  else if (state == FaceState::Normal)
+    --nb_marked_faces_;
+  current = state;
+  this->SetColorsDirty();
+}
+
+Drawable2_OccShape::FaceState Drawable2_OccShape::GetFaceState(
+    size_t index) const {
+  return face_states_[index];
+}
+
+std::span<const Drawable2_OccShape::FaceState>
+Drawable2_OccShape::GetFaceStates() const {
+  return face_states_;
+}
+
+void Drawable2_OccShape::EnableViewRefinement(double pixelError,
+                                              int maxLevel) {
+  if (!prototype_)
+    return;
+  pixel_error_ = pixelError;
+  max_level_ = std::max(maxLevel, 0);
+  prototype_->Reserve(max_level_);
+  bool changed = false;
+  for (int& level : levels_) {
+    if (level > max_level_) {
+      level = 0;
+      changed = true;
     }
-    verts_num_ += tr->NbNodes();
-    cells_num_ += tr->NbTriangles();
-    bool reverse_normals = (f.Orientation() == TopAbs_REVERSED);
-    triangulations_.push_back(std::make_tuple(tr,l*trsf,reverse_normals));
+  }
+  if (changed) {
+    this->CollectTriangulations();
+    this->SetDirty();
   }
 }
 
-Drawable2_OccShape::~Drawable2_OccShape() {
+bool Drawable2_OccShape::UpdateView(const Scene& scene) {
+  return this->UpdateView(scene.CameraPosition(), scene.GetPixelScale());
 }
 
-size_t Drawable2_OccShape::GetVertsCount() const {
-  return verts_num_;
+bool Drawable2_OccShape::UpdateView(const glm::vec3& eye, float pixelScale) {
+  if (!prototype_ || pixel_error_ <= 0.0 || pixelScale <= 0.0f)
+    return false;
+
+  prototype_->Collect();
+
+  // Расстояния считаем в системе прототипа: ошибка на экране не зависит от
+  // масштаба вхождения, так как прогиб и расстояние масштабируются вместе.
+  gp_Pnt localEye(eye.x, eye.y, eye.z);
+  localEye.Transform(inverse_location_);
+  glm::vec3 localPoint(localEye.X(), localEye.Y(), localEye.Z());
+
+  // Для каждой грани нужен грубейший уровень, ошибка которого на экране не
+  // больше допустимой. Если он не построен, показываем ближайший построенный
+  // и, если тот грубее нужного, запрашиваем построение у прототипа.
+  bool changed = false;
+  for (size_t i = 0; i < levels_.size(); ++i) {
+    const Prototype::Face& face = prototype_->faces[i];
+    int limit = std::min(max_level_, face.limit);
+    double distance = Distance(face.box, localPoint);
+    double error = face.deflection * pixelScale;
+    int wanted = limit;
+    if (distance * pixel_error_ >= error)
+      wanted = 0;
+    else if (distance > 0.0)
+      wanted = static_cast<int>(
+          std::ceil(std::log2(error / (distance * pixel_error_))));
+    wanted = std::min(wanted, limit);
+
+    int level = -1;
+    for (int l = wanted; l <= max_level_ && level < 0; ++l) {
+      if (face.levels[l])
+        level = l;
+    }
+    if (level < 0) {
+      for (int l = wanted - 1; l >= 0 && level < 0; --l) {
+        if (face.levels[l])
+          level = l;
+      }
+      double projected =
+          distance > 0.0 ? std::ldexp(error / distance, -level) : error;
+      prototype_->Request(i, wanted, projected);
+    }
+    if (level != levels_[i]) {
+      levels_[i] = level;
+      changed = true;
+    }
+  }
+
+  if (changed) {
+    this->CollectTriangulations();
+    this->SetDirty();
+  }
+  return prototype_->Refine();
 }
 
-size_t Drawable2_OccShape::GetCellsCount() const {
-  return cells_num_;
+void Drawable2_OccShape::CollectTriangulations() {
+  // Сначала размечаем диапазоны граней в массивах, затем заполняем диапазоны
+  // независимо друг от друга.
+  const size_t nbFaces = levels_.size();
+  face_vertex_offsets_.assign(1, 0);
+  face_triangle_offsets_.assign(1, 0);
+  for (size_t i = 0; i < nbFaces; ++i) {
+    const Handle(Poly_Triangulation)& tr =
+        prototype_->faces[i].levels[levels_[i]];
+    face_vertex_offsets_.push_back(face_vertex_offsets_.back() +
+                                   tr->NbNodes());
+    face_triangle_offsets_.push_back(face_triangle_offsets_.back() +
+                                     tr->NbTriangles());
+  }
+  vertices_.resize(face_vertex_offsets_.back());
+  normals_.resize(vertices_.size());
+  triangles_.resize(face_triangle_offsets_.back());
+  triangle_faces_.resize(triangles_.size());
+
+  ParallelFor(
+      nbFaces,
+      [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const Prototype::Face& face = prototype_->faces[i];
+          const Handle(Poly_Triangulation)& tr = face.levels[levels_[i]];
+          const gp_Trsf trsf = location_ * face.location;
+          const bool reversed = (face.reversed != reversed_);
+          size_t v = face_vertex_offsets_[i];
+          for (Standard_Integer k = 1; k <= tr->NbNodes(); ++k, ++v) {
+            gp_Pnt p = tr->Node(k).Transformed(trsf);
+            vertices_[v] = glm::vec3(p.X(), p.Y(), p.Z());
+            if (!tr->HasNormals()) {
+              normals_[v] = glm::vec3(0.0f, 0.0f, 1.0f);
+              continue;
+            }
+            gp_Dir n = tr->Normal(k);
+            if (reversed)
+              n.Reverse();
+            n.Transform(trsf);
+            normals_[v] = glm::vec3(n.X(), n.Y(), n.Z());
+          }
+          // Узлы триангуляции нумеруются с единицы.
+          const uint32_t offset =
+              static_cast<uint32_t>(face_vertex_offsets_[i]);
+          size_t t = face_triangle_offsets_[i];
+          for (Standard_Integer k = 1; k <= tr->NbTriangles(); ++k, ++t) {
+            Standard_Integer na, nb, nc;
+            tr->Triangle(k).Get(na, nb, nc);
+            glm::u32vec3 tri(offset + na - 1, offset + nb - 1,
+                             offset + nc - 1);
+            if (reversed)
+              std::swap(tri.y, tri.z);
+            triangles_[t] = tri;
+            triangle_faces_[t] = static_cast<uint32_t>(i);
+          }
+        }
+      },
+      16);
 }
 
-Iterator<glm::vec3> Drawable2_OccShape::GetVertices() const {
-  auto impl = new OccVertexIterator(triangulations_);
-  return Iterator<glm::vec3>(impl);
+void Drawable2_OccShape::ReleaseTriangulations() {
+  if (!prototype_)
+    return;
+  pixel_error_ = 0.0;
+  std::shared_ptr<Prototype> prototype = std::move(prototype_);
+  // Кэш прототипов хранит слабые ссылки, поэтому единственная оставшаяся
+  // ссылка -- наша, и под замком кэша прототип уже никто не получит. Фоновое
+  // построение читает те же грани, поэтому до очистки оно отменяется и
+  // завершается.
+  std::lock_guard<std::mutex> lock(s_prototypeMutex);
+  if (prototype.use_count() != 1)
+    return;
+  prototype->refining.Cancel();
+  prototype->refining.Wait();
+  BRepTools::Clean(prototype->shape);
 }
 
-Iterator<glm::u32vec3> Drawable2_OccShape::GetTriangles() const {
-  auto impl = new OccTriangleIterator(triangulations_);
-  return Iterator<glm::u32vec3>(impl);
+OccPickedFace PickFace(const Application& app, Scene* scene, int x, int y) {
+  OccPickedFace result;
+  size_t triangle = 0;
+  Drawable* picked = app.Pick(scene, x, y, nullptr, &triangle);
+  if (!picked)
+    return result;
+  result.drawable_id = picked->GetId();
+  auto shape = dynamic_cast<const Drawable2_OccShape*>(picked);
+  if (!shape)
+    return result;
+  std::span<const uint32_t> faces = shape->GetTriangleGroups();
+  if (triangle < faces.size()) {
+    result.face_index = faces[triangle];
+    result.face = shape->GetFace(result.face_index);
+  }
+  return result;
 }
 
-Iterator<glm::vec3> Drawable2_OccShape::GetNormals() const {
-  auto impl = new OccNormalIterator(triangulations_);
-  return Iterator<glm::vec3>(impl);
+bool SelectPickedFace(Scene* scene, const OccPickedFace& picked) {
+  using FaceState = Drawable2_OccShape::FaceState;
+  bool changed = false;
+  for (SceneObject* object : scene->Objects()) {
+    for (Drawable* drawable : object->Drawables()) {
+      auto shape = dynamic_cast<Drawable2_OccShape*>(drawable);
+      if (!shape)
+        continue;
+      const bool isPicked =
+          !picked.face.IsNull() && shape->GetId() == picked.drawable_id;
+      std::span<const FaceState> states = shape->GetFaceStates();
+      for (size_t i = 0; i < states.size(); ++i) {
+        FaceState state = states[i];
+        if (isPicked && i == picked.face_index)
+          state = FaceState::Selected;
+        else if (state == FaceState::Selected)
+          state = FaceState::Normal;
+        if (state == states[i])
+          continue;
+        shape->SetFaceState(i, state);
+        changed = true;
+      }
+    }
+  }
+  return changed;
 }
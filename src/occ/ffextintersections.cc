@@ -2,6 +2,7 @@
 
 #include <Adaptor2d_Line2d.hxx>
 #include <Adaptor3d_CurveOnSurface.hxx>
+#include <BRepBndLib.hxx>
 #include <BRep_Tool.hxx>
 #include <GCPnts_AbscissaPoint.hxx>
 #include <Geom2dAPI_InterCurveCurve.hxx>
@@ -9,17 +10,23 @@
 #include <GeomAPI_IntCS.hxx>
 #include <GeomAPI_IntSS.hxx>
 #include <GeomAdaptor_Curve.hxx>
+#include <GeomAdaptor_Surface.hxx>
 #include <GeomLib.hxx>
 #include <Geom_BoundedCurve.hxx>
 #include <Geom_BoundedSurface.hxx>
+#include <Precision.hxx>
 #include <TopExp_Explorer.hxx>
 #include <TopTools_ListOfShape.hxx>
 #include <TopoDS.hxx>
 #include <TopoDS_Edge.hxx>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <list>
 
+#include "numgeom/parallelfor.h"
 #include "numgeom/utilities.h"
+#include "shapetopology.h"
 
 namespace {
 ;
@@ -41,101 +48,202 @@ double GetIsolineCurveLength(Handle(Geom_BoundedSurface) surface,
   return GCPnts_AbscissaPoint::Length(curveOnSurface);
 }
 
-void ExtendSurfacesOfExternalFaces(
-    const TopTools_MapOfShape& externalFaces,
-    std::unordered_map<TopoDS_Face, Handle(Geom_Surface)>&
-        face2extendedSurface) {
+//! Расширяет ограниченную поверхность и возвращает в `extLength` наибольшую
+//! длину расширения. Неограниченная поверхность не меняется, а `extLength`
+//! обнуляется.
+Handle(Geom_Surface) ExtendSurface(const Handle(Geom_Surface) & surface,
+                                   Standard_Real& extLength) {
   // Функция BRepLib::ExtendFace(face, ...) расширяет грань. Пример
   // использования можно найти в BOPAlgo_RemoveFeatures.cxx:542.
 
-  // \warning Несущие поверхности у двух граней могут совпадать,
-  //          что позволяет ускорить этот код.
+  extLength = 0.0;
+  auto boundedSurface = Handle(Geom_BoundedSurface)::DownCast(surface);
+  if (!boundedSurface) return surface;
+
+  // Расширяем ограниченную поверхность
+  // на половину ее длины влево и вправо, вверх и вниз.
+  Standard_Real u1, u2, v1, v2;
+  boundedSurface->Bounds(u1, u2, v1, v2);
+  Standard_Real extULength =
+      0.25 * (GetIsolineCurveLength(boundedSurface, Standard_True, u1) +
+              GetIsolineCurveLength(boundedSurface, Standard_True, u2));
+  Standard_Real extVLength =
+      0.25 * (GetIsolineCurveLength(boundedSurface, Standard_False, v1) +
+              GetIsolineCurveLength(boundedSurface, Standard_False, v2));
+  extLength = std::max(extULength, extVLength);
+  Standard_Integer cont = 2;
+  for (int i = 0; i < 4; ++i) {
+    Standard_Boolean inU = (i == 0 || i == 1);
+    Standard_Boolean after = (i == 1 || i == 3);
+    if (inU && boundedSurface->IsUPeriodic()) continue;
+    if (!inU && boundedSurface->IsVPeriodic()) continue;
+    Standard_Real extLength = inU ? extULength : extVLength;
+    GeomLib::ExtendSurfByLength(boundedSurface, extLength, cont, inU, after);
+  }
+  return boundedSurface;
+}
 
-  for (auto it = externalFaces.cbegin(); it != externalFaces.cend(); ++it) {
-    const TopoDS_Face& face = TopoDS::Face(*it);
+//! Габаритная коробка грани, увеличенная на длину расширения ее поверхности.
+//! Коробка расширенной поверхности для плоскостей, цилиндров и конусов
+//! бесконечна, поэтому за их длину расширения, как и в `ExtendSurface`,
+//! принимается половина размера грани.
+Bnd_Box ExtendedFaceBox(const TopoDS_Face& face, Standard_Real extLength) {
+  Bnd_Box box;
+  BRepBndLib::Add(face, box);
+  if (box.IsVoid()) return box;
+  if (extLength <= 0.0) extLength = 0.5 * std::sqrt(box.SquareExtent());
+  box.Enlarge(extLength);
+  return box;
+}
+}  // namespace
+
+FaceFaceIntersections::FaceFaceIntersections(
+    const TopTools_MapOfShape& externalFaces, const ShapeTopology& topology,
+    bool inParallel)
+    : myTopology(topology), myInParallel(inParallel) {
+  // Несущие поверхности у нескольких граней могут совпадать, поэтому каждая
+  // поверхность расширяется один раз.
+  // Грани перечисляются в порядке фигуры, а не в порядке хеш-таблицы, который
+  // меняется от запуска к запуску.
+  std::vector<TopoDS_Face> faces;
+  for (auto it = externalFaces.cbegin(); it != externalFaces.cend(); ++it)
+    faces.push_back(TopoDS::Face(*it));
+  std::sort(faces.begin(), faces.end(),
+            [&topology](const TopoDS_Face& a, const TopoDS_Face& b) {
+              return topology.FaceId(a) < topology.FaceId(b);
+            });
+
+  std::map<Handle(Geom_Surface), size_t> surface2unique;
+  std::vector<Handle(Geom_Surface)> uniqueSurfaces;
+  std::vector<size_t> face2unique;
+  for (const TopoDS_Face& face : faces) {
     Handle(Geom_Surface) surface = BRep_Tool::Surface(face);
     assert(!surface.IsNull());
+    auto [itu, isNew] = surface2unique.emplace(surface, uniqueSurfaces.size());
+    if (isNew) uniqueSurfaces.push_back(surface);
+    myFace2index.emplace(face, myFaces.size());
+    myFaces.push_back(face);
+    mySurfaces.push_back(surface);
+    face2unique.push_back(itu->second);
+  }
 
-    auto boundedSurface = Handle(Geom_BoundedSurface)::DownCast(surface);
-    if (!boundedSurface) {
-      face2extendedSurface.insert(std::make_pair(face, surface));
-      continue;
-    }
-
-    // Расширяем ограниченную поверхность
-    // на половину ее длины влево и вправо, вверх и вниз.
-    Standard_Real u1, u2, v1, v2;
-    boundedSurface->Bounds(u1, u2, v1, v2);
-    Standard_Real extULength =
-        0.25 * (GetIsolineCurveLength(boundedSurface, Standard_True, u1) +
-                GetIsolineCurveLength(boundedSurface, Standard_True, u2));
-    Standard_Real extVLength =
-        0.25 * (GetIsolineCurveLength(boundedSurface, Standard_False, v1) +
-                GetIsolineCurveLength(boundedSurface, Standard_False, v2));
-    Standard_Integer cont = 2;
-    for (int i = 0; i < 4; ++i) {
-      Standard_Boolean inU = (i == 0 || i == 1);
-      Standard_Boolean after = (i == 1 || i == 3);
-      if (inU && boundedSurface->IsUPeriodic()) continue;
-      if (!inU && boundedSurface->IsVPeriodic()) continue;
-      Standard_Real extLength = inU ? extULength : extVLength;
-      GeomLib::ExtendSurfByLength(boundedSurface, extLength, cont, inU, after);
-    }
-
-    face2extendedSurface.insert(std::make_pair(face, boundedSurface));
+  std::vector<Handle(Geom_Surface)> extendedSurfaces(uniqueSurfaces.size());
+  std::vector<Standard_Real> extLengths(uniqueSurfaces.size());
+  auto extend = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      extendedSurfaces[i] = ExtendSurface(uniqueSurfaces[i], extLengths[i]);
+  };
+  if (myInParallel)
+    ParallelFor(uniqueSurfaces.size(), extend);
+  else
+    extend(0, uniqueSurfaces.size());
+  for (size_t i = 0; i < myFaces.size(); ++i) {
+    size_t unique = face2unique[i];
+    myExtendedSurfaces.push_back(extendedSurfaces[unique]);
+    myBoxes.push_back(ExtendedFaceBox(myFaces[i], extLengths[unique]));
   }
-}
-}  // namespace
 
-FaceFaceIntersections::FaceFaceIntersections(
-    const TopTools_MapOfShape& externalFaces) {
-  ExtendSurfacesOfExternalFaces(externalFaces, myFace2extendedSurface);
+  // Пустая коробка означает, что ее не удалось вычислить, и такая грань
+  // остается кандидатом для любой поверхности.
+  auto xMin = [this](size_t index) {
+    const Bnd_Box& box = myBoxes[index];
+    return box.IsVoid() ? -Precision::Infinite() : box.CornerMin().X();
+  };
+  mySortedFaces.resize(myFaces.size());
+  for (size_t i = 0; i < myFaces.size(); ++i) mySortedFaces[i] = i;
+  std::stable_sort(mySortedFaces.begin(), mySortedFaces.end(),
+                   [&xMin](size_t a, size_t b) { return xMin(a) < xMin(b); });
+  for (size_t index : mySortedFaces) mySortedXMins.push_back(xMin(index));
 }
 
-namespace {
-;
-void GetCommonEdges(const TopoDS_Face& f1, const TopoDS_Face& f2,
-                    std::list<TopoDS_Edge>& commonEdges) {
-  for (TopExp_Explorer it1(f1, TopAbs_EDGE); it1.More(); it1.Next()) {
-    const TopoDS_Shape& e1 = it1.Value();
-    for (TopExp_Explorer it2(f2, TopAbs_EDGE); it2.More(); it2.Next()) {
-      const TopoDS_Shape& e2 = it2.Value();
-      if (e1.IsSame(e2)) {
-        commonEdges.push_back(TopoDS::Edge(e1));
-        break;
-      }
-    }
+void FaceFaceIntersections::GetCandidates(
+    const Bnd_Box& box, std::vector<size_t>& candidates) const {
+  // Коробки, левая граница которых правее коробки `box`, с ней не
+  // пересекаются; остальные проверяются полностью.
+  Standard_Real xMax =
+      box.IsVoid() ? Precision::Infinite() : box.CornerMax().X();
+  auto last =
+      std::upper_bound(mySortedXMins.begin(), mySortedXMins.end(), xMax);
+  size_t nbSorted = last - mySortedXMins.begin();
+  candidates.clear();
+  for (size_t k = 0; k < nbSorted; ++k) {
+    size_t index = mySortedFaces[k];
+    const Bnd_Box& other = myBoxes[index];
+    if (box.IsVoid() || other.IsVoid() || !box.IsOut(other))
+      candidates.push_back(index);
   }
+  std::sort(candidates.begin(), candidates.end());
 }
-}  // namespace
 
 FaceFaceIntersections::FFResult FaceFaceIntersections::GetIntersections(
     const TopoDS_Face& fFirst) const {
   auto it = myFace2intersections.find(fFirst);
   if (it != myFace2intersections.end()) return FFResult(it->second);
 
-  Handle(Geom_Surface) surface1 = BRep_Tool::Surface(fFirst);
-  GeomAPI_IntSS intSS;
+  // Поиск ведется в увеличенной коробке грани, как и для граней множества.
+  Handle(Geom_Surface) surface1;
+  Bnd_Box box;
+  auto itIndex = myFace2index.find(fFirst);
+  if (itIndex != myFace2index.end()) {
+    surface1 = mySurfaces[itIndex->second];
+    box = myBoxes[itIndex->second];
+  } else {
+    surface1 = BRep_Tool::Surface(fFirst);
+    Standard_Real extLength;
+    ExtendSurface(surface1, extLength);
+    box = ExtendedFaceBox(fFirst, extLength);
+  }
+
+  std::vector<size_t> candidates;
+  this->GetCandidates(box, candidates);
+
+  // Пары поверхностей, пересечение которых еще не вычислялось.
+  std::vector<SurfacePair> pairs;
+  for (size_t index : candidates) {
+    if (myFaces[index] == fFirst) continue;
+    SurfacePair key(surface1, myExtendedSurfaces[index]);
+    if (mySurfaces2intersections.emplace(key, SurfaceIntersection()).second)
+      pairs.push_back(key);
+  }
+
+  std::vector<SurfaceIntersection> intersections(pairs.size());
+  auto intersect = [&](size_t begin, size_t end) {
+    GeomAPI_IntSS intSS;
+    for (size_t p = begin; p < end; ++p) {
+      SurfaceIntersection& intersection = intersections[p];
+      intSS.Perform(pairs[p].first, pairs[p].second, 1.0e-7);
+      intersection.isDone = intSS.IsDone();
+      if (!intersection.isDone) continue;
+      Standard_Integer nbLines = intSS.NbLines();
+      for (Standard_Integer l = 1; l <= nbLines; ++l)
+        intersection.lines.push_back(intSS.Line(l));
+    }
+  };
+  if (myInParallel)
+    ParallelFor(pairs.size(), intersect);
+  else
+    intersect(0, pairs.size());
+  for (size_t p = 0; p < pairs.size(); ++p)
+    mySurfaces2intersections[pairs[p]] = std::move(intersections[p]);
+
+  size_t firstId = myTopology.FaceId(fFirst);
+  std::vector<size_t> commonEdges;
   auto& results = myFace2intersections[fFirst];
-  for (const auto& v : myFace2extendedSurface) {
-    const TopoDS_Face& fSecond = v.first;
+  for (size_t index : candidates) {
+    const TopoDS_Face& fSecond = myFaces[index];
     if (fSecond == fFirst) continue;
 
-    Handle(Geom_Surface) surface2 = v.second;
-
-    intSS.Perform(surface1, surface2, 1.0e-7);
-    if (!intSS.IsDone()) continue;
-    Standard_Integer nbLines = intSS.NbLines();
-    for (Standard_Integer l = 1; l <= nbLines; ++l) {
-      Handle(Geom_Curve) line = intSS.Line(1);
+    const SurfaceIntersection& intersection = mySurfaces2intersections.at(
+        SurfacePair(surface1, myExtendedSurfaces[index]));
+    if (!intersection.isDone) continue;
+    for (const Handle(Geom_Curve) & line : intersection.lines)
       results.push_back(IntFF{fSecond, line});
-    }
-    if (nbLines == 0) {
-      std::list<TopoDS_Edge> commonEdges;
-      GetCommonEdges(fFirst, fSecond, commonEdges);
-      for (const auto& e : commonEdges) {
+    if (intersection.lines.empty() && firstId != ShapeTopology::NoId) {
+      myTopology.GetCommonEdges(firstId, myTopology.FaceId(fSecond),
+                                commonEdges);
+      for (size_t e : commonEdges) {
         Standard_Real u1, u2;
-        auto curve = BRep_Tool::Curve(e, u1, u2);
+        auto curve = BRep_Tool::Curve(myTopology.Edge(e), u1, u2);
         if (auto boundedCurve = Handle(Geom_BoundedCurve)::DownCast(curve)) {
           assert(false);
         }
@@ -154,14 +262,13 @@ FaceFaceIntersections::CFResult FaceFaceIntersections::GetIntersections(
   GeomAPI_IntCS intCS;
   Standard_Real u, v, t;
   auto& results = myCurve2intersections[curve];
-  for (const auto& fs : myFace2extendedSurface) {
-    Handle(Geom_Surface) surface = fs.second;
-    intCS.Perform(curve, surface);
+  for (size_t index = 0; index < myFaces.size(); ++index) {
+    intCS.Perform(curve, myExtendedSurfaces[index]);
     if (!intCS.IsDone()) continue;
     Standard_Integer nbPoints = intCS.NbPoints();
     for (Standard_Integer i = 1; i <= nbPoints; ++i) {
       intCS.Parameters(i, u, v, t);
-      results.push_back(IntCF{fs.first, t});
+      results.push_back(IntCF{myFaces[index], t});
     }
   }
   return CFResult(results);
@@ -4,7 +4,10 @@
 #include <list>
 #include <map>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "Bnd_Box.hxx"
 #include "Geom_Surface.hxx"
 #include "TopTools_MapOfShape.hxx"
 #include "TopoDS_Face.hxx"
@@ -15,10 +18,18 @@ class Geom_BoundedCurve;
 class Geom_Curve;
 class Geom_Surface;
 class Geom2d_BoundedCurve;
+class ShapeTopology;
 
 /**\class FaceFaceIntersections
 \brief Вспомогательное средство для вычисления пересечений расширенных граней
        друг с другом и кривой с расширенными гранями.
+
+Пересекаются только грани, габаритные коробки которых, увеличенные на длину
+расширения поверхности, перекрываются. Пересечения пар несущих поверхностей
+вычисляются параллельно и кешируются, так что грани с общей несущей
+поверхностью не пересекаются повторно. Результаты перечисляются в порядке
+граней фигуры и не зависят от числа потоков и от порядка граней в исходном
+множестве.
 */
 class FaceFaceIntersections {
  public:
@@ -52,8 +63,12 @@ class FaceFaceIntersections {
   };
 
  public:
-  //! Конструктор по множеству граней, которые будут участвовать в пересечениях.
-  FaceFaceIntersections(const TopTools_MapOfShape& externalFaces);
+  //! Конструктор по множеству граней, которые будут участвовать в пересечениях,
+  //! и отношениям смежности фигуры, которой они принадлежат. Если
+  //! `inParallel` не задан, все вычисления идут в вызывающем потоке: так
+  //! объект используют из задач, которые сами выполняются параллельно.
+  FaceFaceIntersections(const TopTools_MapOfShape& externalFaces,
+                        const ShapeTopology& topology, bool inParallel = true);
 
   //! Пересечения грани со множеством граней.
   FFResult GetIntersections(const TopoDS_Face&) const;
@@ -62,9 +77,35 @@ class FaceFaceIntersections {
   CFResult GetIntersections(const Handle(Geom_Curve) & curve) const;
 
  private:
-  //! Расширенные поверхности граней.
-  std::unordered_map<TopoDS_Face, Handle(Geom_Surface)>
-      myFace2extendedSurface;
+  typedef std::pair<Handle(Geom_Surface), Handle(Geom_Surface)> SurfacePair;
+
+  struct SurfaceIntersection {
+    Standard_Boolean isDone = Standard_False;
+    std::vector<Handle(Geom_Curve)> lines;
+  };
+
+  //! Номера граней, расширения которых могут пересекаться с поверхностью в
+  //! коробке `box`, по возрастанию.
+  void GetCandidates(const Bnd_Box& box, std::vector<size_t>& candidates) const;
+
+ private:
+  const ShapeTopology& myTopology;
+  bool myInParallel;
+
+  //! Грани в порядке фигуры, их несущие и расширенные поверхности, габаритные
+  //! коробки граней, увеличенные на длину расширения.
+  std::vector<TopoDS_Face> myFaces;
+  std::vector<Handle(Geom_Surface)> mySurfaces;
+  std::vector<Handle(Geom_Surface)> myExtendedSurfaces;
+  std::vector<Bnd_Box> myBoxes;
+  std::unordered_map<TopoDS_Face, size_t> myFace2index;
+
+  //! Номера граней по возрастанию левых границ коробок и сами границы.
+  std::vector<size_t> mySortedFaces;
+  std::vector<Standard_Real> mySortedXMins;
+
+  //! Кешированный результат пересечения несущей поверхности с расширенной.
+  mutable std::map<SurfacePair, SurfaceIntersection> mySurfaces2intersections;
 
   //! Кешированный результат пересечения граней с гранями.
   mutable std::unordered_map<TopoDS_Face, std::list<IntFF>>
@@ -3,12 +3,99 @@
 
 #include <Standard_TypeDef.hxx>
 #include <TopAbs_State.hxx>
+#include <memory>
+#include <span>
+#include <vector>
 
+#include "numgeom/meshparameters.h"
 #include "numgeom/occ_export.h"
 
 class AuxClassificateData2d;
+class CTriMesh;
+class gp_Pnt;
 class gp_Pnt2d;
 class TopoDS_Face;
+class TopoDS_Shape;
+
+/**\class FaceClassifier
+\brief Классификатор точек относительно параметрического пространства грани.
+
+Вспомогательные данные (квадродерево, размеченное по контурам грани) строятся
+один раз в конструкторе и больше не изменяются, поэтому методы классификации
+можно вызывать одновременно из нескольких потоков.
+*/
+class OCC_EXPORT FaceClassifier {
+ public:
+  typedef std::shared_ptr<const FaceClassifier> Ptr;
+
+ public:
+  explicit FaceClassifier(const TopoDS_Face& face,
+                          Standard_Real tolerance = 1.e-7);
+  ~FaceClassifier();
+
+  const TopoDS_Face& Face() const;
+
+  TopAbs_State Classify(const gp_Pnt2d& point) const;
+
+  //! Классифицирует точки в нескольких потоках. Точки группируются по
+  //! ячейкам квадродерева: ячейка, далекая от контуров, классифицируется
+  //! один раз для всех попавших в нее точек.
+  std::vector<TopAbs_State> Classify(std::span<const gp_Pnt2d> points) const;
+
+ private:
+  FaceClassifier(const FaceClassifier&) = delete;
+  FaceClassifier& operator=(const FaceClassifier&) = delete;
+
+ private:
+  std::unique_ptr<AuxClassificateData2d> myData;
+};
+
+/**\class SolidClassifier
+\brief Классификатор точек относительно твердого тела.
+
+В конструкторе строятся триангуляции граней тела (если их нет) и иерархия
+ограничивающих коробок треугольников. Триангуляции сохраняются в гранях самой
+переданной фигуры и остаются у нее после разрушения классификатора; чтобы не
+изменять фигуру, передайте ее копию `BRepBuilderAPI_Copy`.
+
+Точка, удаленная от триангуляции больше чем на удвоенный прогиб сетки и
+допуск, классифицируется по четности числа пересечений луча с треугольниками.
+Вблизи поверхности, а также если луч проходит через ребро или вершину
+треугольника, точка классифицируется точно с помощью
+`BRepClass3d_SolidClassifier`. Методы классификации можно вызывать
+одновременно из нескольких потоков.
+*/
+class OCC_EXPORT SolidClassifier {
+ public:
+  typedef std::shared_ptr<const SolidClassifier> Ptr;
+
+ public:
+  explicit SolidClassifier(const TopoDS_Shape& solid,
+                           Standard_Real tolerance = 1.e-7,
+                           const MeshParameters& params = MeshParameters());
+
+  //! Классификатор по уже построенной сетке `mesh`, извлеченной
+  //! `ConvertToTriMesh` из этой же фигуры; фигура повторно не триангулируется.
+  SolidClassifier(const TopoDS_Shape& solid, const CTriMesh& mesh,
+                  Standard_Real tolerance = 1.e-7);
+  ~SolidClassifier();
+
+  const TopoDS_Shape& Shape() const;
+
+  TopAbs_State Classify(const gp_Pnt& point) const;
+
+  //! Классифицирует точки в нескольких потоках; точный классификатор
+  //! создается не более одного раза на блок точек.
+  std::vector<TopAbs_State> Classify(std::span<const gp_Pnt> points) const;
+
+ private:
+  SolidClassifier(const SolidClassifier&) = delete;
+  SolidClassifier& operator=(const SolidClassifier&) = delete;
+
+ private:
+  struct Internal;
+  std::unique_ptr<Internal> myData;
+};
 
 /**\brief Классификация точки относительно параметрического пространства грани.
 \param face Топологическая грань, из которой извлекается двумерная область в
@@ -16,6 +103,10 @@ class TopoDS_Face;
 \param point Классифицируемая точка.
 \param aux Вспомогательный объект, ускоряющий вычисления при повторном вызове
            функции.
+
+Без `aux` функция хранит классификатор последней грани отдельно для каждого
+потока. Для многократной классификации точек одной грани предпочтительнее
+`FaceClassifier`.
 */
 OCC_EXPORT TopAbs_State
 Classificate(const TopoDS_Face& face, const gp_Pnt2d& point,
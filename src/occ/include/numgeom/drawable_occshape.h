@@ -1,31 +1,162 @@
 #ifndef NUMGEOM_OCC_OCCSHAPE_H
 #define NUMGEOM_OCC_OCCSHAPE_H
 
-#include <list>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
 
+#include "TopoDS_Face.hxx"
 #include "TopoDS_Shape.hxx"
 #include "gp_Trsf.hxx"
 
 #include "numgeom/drawable.h"
+#include "numgeom/meshparameters.h"
 #include "numgeom/trimesh.h"
 
-class Poly_Triangulation;
+class Application;
 
+/**\class Drawable2_OccShape
+\brief Отображаемое вхождение B-rep фигуры.
+
+Сетки граней хранятся в прототипе -- фигуре без положения, общем для всех
+вхождений одной фигуры (одного `TopoDS_TShape`). Вхождение хранит только свое
+положение и уровни детализации граней, поэтому память и время построения
+сеток сборки определяются числом уникальных деталей, а не вхождений.
+
+Сетки вхождения хранятся плоскими массивами: координаты и нормали вершин в
+системе сцены (`float`) и индексы треугольников (`uint32_t`), поэтому обход
+через итераторы и загрузка в рендерер сводятся к копированию. Массивы
+перестраиваются только при смене уровней детализации граней.
+
+Треугольники и вершины идут по граням подряд, и каждому треугольнику
+сопоставлен номер его грани (`GetTriangleGroups()`). Номер грани не зависит
+от уровня детализации, поэтому состояния граней (подсветка, выбор) хранятся
+отдельным массивом и при уточнении сеток не теряются.
+*/
 class Drawable2_OccShape : public Drawable2 {
  public:
-   Drawable2_OccShape(SceneObject*, const TopoDS_Shape&, const gp_Trsf&);
+   Drawable2_OccShape(SceneObject*, const TopoDS_Shape&, const gp_Trsf&,
+                      const MeshParameters& params = MeshParameters());
    virtual ~Drawable2_OccShape();
    virtual size_t GetVertsCount() const;
    virtual size_t GetCellsCount() const;
    virtual Iterator<glm::vec3> GetVertices() const;
    virtual Iterator<glm::u32vec3> GetTriangles() const;
    virtual Iterator<glm::vec3> GetNormals() const;
+   std::span<const glm::vec3> GetVertexArray() const override;
+   std::span<const glm::vec3> GetNormalArray() const override;
+   std::span<const glm::u32vec3> GetTriangleArray() const override;
+   std::span<const uint32_t> GetTriangleGroups() const override;
+
+   //! Начала вершин и треугольников граней в массивах; последний элемент --
+   //! общее число вершин (треугольников).
+   std::span<const size_t> GetFaceVertexOffsets() const;
+   std::span<const size_t> GetFaceTriangleOffsets() const;
+
+   glm::vec3 GetVertexColor(size_t vertex) const override;
+
+   //! Заполняет цветом грани сразу весь ее диапазон вершин.
+   float* CopyVertexColors(float* data) const override;
+
+   //! Состояние отображения грани.
+   enum class FaceState : uint8_t { Normal, Highlighted, Selected };
+
+   //! Число граней, имеющих сетку.
+   size_t GetFacesCount() const;
+
+   //! Грань фигуры с номером `index` из `GetTriangleGroups()`, с положением
+   //! и ориентацией фигуры, без преобразования вхождения.
+   TopoDS_Face GetFace(size_t index) const;
+
+   //! Меняет состояние грани. Сетки не перестраиваются: меняются только
+   //! цвета вершин грани, и рендерер обновляет один буфер цветов.
+   void SetFaceState(size_t index, FaceState state);
+   FaceState GetFaceState(size_t index) const;
+   std::span<const FaceState> GetFaceStates() const;
+
+   /**
+   \brief Включает уточнение сеток граней по виду камеры.
+
+   Сначала отображаются сетки, построенные с параметрами конструктора. Грань,
+   хордовая ошибка которой на экране больше `pixelError` пикселей,
+   перестраивается в фоне с вдвое, вчетверо и т.д. меньшим прогибом, но не
+   более `maxLevel` раз. Построенные уровни граней сохраняются и общие для
+   всех вхождений фигуры, поэтому при удалении камеры возврат к грубым
+   сеткам не требует вычислений.
+   */
+   void EnableViewRefinement(double pixelError = 1.0, int maxLevel = 6);
+
+   bool UpdateView(const Scene&) override;
+
+   //! Подбирает уровни граней для камеры в точке `eye`; `pixelScale` --
+   //! число пикселей в отрезке единичной длины на единичном расстоянии от
+   //! камеры. Возвращает `true`, если уточнение граней еще не закончено.
+   bool UpdateView(const glm::vec3& eye, float pixelScale);
+
+   /**
+   \brief Освобождает триангуляции граней, оставляя только плоские массивы.
+
+   Вхождение перестает ссылаться на прототип и больше не уточняет сетки.
+   Когда прототип не нужен ни одному вхождению, триангуляции удаляются и с
+   граней фигуры. Следует вызывать, если сетки вида не будут меняться, а
+   память под триангуляции в двойной точности важна.
+   */
+   void ReleaseTriangulations();
+
+ private:
+   struct Prototype;
+   struct RefinedFaces;
+
+   //! Прототип фигуры, общий для всех ее вхождений с теми же параметрами
+   //! построения сеток.
+   static std::shared_ptr<Prototype> GetPrototype(const TopoDS_Shape&,
+                                                  const MeshParameters&);
+
+   //! Собирает массивы сеток из текущих уровней граней.
+   void CollectTriangulations();
+
+   //! Цвет вершин грани с учетом ее состояния.
+   glm::vec3 GetFaceColor(size_t face) const;
 
  private:
    TopoDS_Shape shape_;
    gp_Trsf trsf_;
-   std::list<std::tuple<Handle(Poly_Triangulation),gp_Trsf,bool>> triangulations_;
-   size_t verts_num_;
-   size_t cells_num_;
+   gp_Trsf location_;          //!< Положение прототипа в сцене.
+   gp_Trsf inverse_location_;
+   bool reversed_;
+   std::shared_ptr<Prototype> prototype_;
+   std::vector<TopoDS_Face> faces_;   //!< Грани прототипа с сетками.
+   std::vector<int> levels_;   //!< Отображаемые уровни граней прототипа.
+   std::vector<glm::vec3> vertices_;
+   std::vector<glm::vec3> normals_;
+   std::vector<glm::u32vec3> triangles_;
+   std::vector<uint32_t> triangle_faces_;       //!< Грань каждого треугольника.
+   std::vector<size_t> face_vertex_offsets_;
+   std::vector<size_t> face_triangle_offsets_;
+   std::vector<FaceState> face_states_;
+   size_t nb_marked_faces_;   //!< Число граней не в состоянии `Normal`.
+   double pixel_error_;
+   int max_level_;
 };
+
+//! Грань, выбранная в точке экрана.
+struct OccPickedFace {
+  uint32_t drawable_id = 0;  //!< Ноль, если в точке нет объекта.
+  TopoDS_Face face;          //!< Пустая, если объект не B-rep фигура.
+  size_t face_index = 0;     //!< Номер грани в `GetTriangleGroups()`.
+};
+
+//! Выбирает объект в точке экрана и грань B-rep фигуры под курсором.
+OccPickedFace PickFace(const Application&, Scene*, int x, int y);
+
+/** \brief Делает выбранной грань `picked`, снимая выбор с остальных граней
+фигур сцены.
+
+Если в `picked` нет грани, выбор только снимается. Меняются лишь цвета
+вершин, так что рендерер обновит одни буферы цветов. Возвращает `true`, если
+состояние хотя бы одной грани изменилось.
+*/
+bool SelectPickedFace(Scene*, const OccPickedFace& picked);
+
 #endif // !NUMGEOM_OCC_OCCSHAPE_H
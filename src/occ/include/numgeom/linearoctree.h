@@ -0,0 +1,121 @@
+#ifndef numgeom_numgeom_linearoctree_h
+#define numgeom_numgeom_linearoctree_h
+
+#include <Bnd_Box.hxx>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "numgeom/occ_export.h"
+
+/**
+\brief Линейное октодерево: ячейки адресуются 64-битными ключами Мортона.
+
+Устроено так же, как `LinearQuadTree`: ключ ячейки -- код Мортона ее
+координат `(i, j, k)` на уровне, дополненный старшим единичным битом, который
+задает уровень. Трехмерный ключ вмещает по 21 биту на координату, см.
+`MaxLevel`.
+*/
+class OCC_EXPORT LinearOcTree {
+ public:
+  typedef std::shared_ptr<LinearOcTree> Ptr;
+  typedef std::shared_ptr<const LinearOcTree> CPtr;
+
+  typedef uint64_t Key;
+
+  //! Недействительный ключ: ячейки нет.
+  static constexpr Key NoKey = 0;
+
+  struct Internal;
+
+ public:
+  /** \brief Создать дерево с решёткой `in`x`jn`x`kn` ячеек нулевого уровня.
+
+    При неположительном размере решётки возвращается пустой указатель.
+    Если размер решётки по какому-либо направлению больше 2^21, ключи
+    нулевого уровня не помещаются в 64 бита: бросается Standard_OutOfRange.
+  */
+  static LinearOcTree::Ptr Create(const Bnd_Box&, Standard_Integer in = 1,
+                                  Standard_Integer jn = 1,
+                                  Standard_Integer kn = 1);
+
+ public:
+  ~LinearOcTree();
+
+  //! Количество уровней в дереве.
+  Standard_Integer Levels() const;
+
+  //! Наибольший уровень, ячейки которого представимы ключами.
+  Standard_Integer MaxLevel() const;
+
+  //! Количество терминальных ячеек.
+  size_t NbCells() const;
+
+  //! Габаритная коробка всех ячеек нулевого уровня.
+  void GetBox(Standard_Real& xMin, Standard_Real& yMin, Standard_Real& zMin,
+              Standard_Real& xMax, Standard_Real& yMax,
+              Standard_Real& zMax) const;
+
+  void CellsNumberOnLevel(Standard_Integer level, uint64_t& nbByI,
+                          uint64_t& nbByJ, uint64_t& nbByK) const;
+
+  //! Ключ ячейки с координатами `(i, j, k)` на уровне `level`.
+  Key GetKey(Standard_Integer level, uint32_t i, uint32_t j, uint32_t k) const;
+
+  Standard_Integer GetLevel(Key) const;
+
+  void GetCellCoords(Key, uint32_t& i, uint32_t& j, uint32_t& k) const;
+
+  //! Родительская ячейка или `NoKey` для ячейки нулевого уровня.
+  Key GetParent(Key) const;
+
+  //! Дочерняя ячейка: биты `childIndex` от младшего к старшему задают
+  //! смещения по `i`, `j` и `k`.
+  Key GetChild(Key, Standard_Integer childIndex) const;
+
+  //! Ячейка того же уровня, смещенная на `(di, dj, dk)`, или `NoKey`, если
+  //! она выходит за пределы сетки уровня. Существование ячейки не
+  //! проверяется.
+  Key GetNeighbour(Key, Standard_Integer di, Standard_Integer dj,
+                   Standard_Integer dk) const;
+
+  //! Ячейка существует в терминальном или нетерминальном виде?
+  Standard_Boolean IsExists(Key) const;
+
+  Standard_Boolean IsTerminal(Key) const;
+
+  //! Делит терминальную ячейку на восемь дочерних. Атрибут ячейки теряется.
+  void Split(Key);
+
+  //! Делит набор терминальных ячеек. Повторы ключей допускаются.
+  void Split(std::span<const Key>);
+
+  //! Терминальные ячейки в порядке обхода Z-кривой.
+  std::vector<Key> TerminalCells() const;
+
+  //! Терминальная ячейка, содержащая точку, или `NoKey` для точки вне
+  //! габаритной коробки.
+  Key GetCell(const gp_Pnt&) const;
+
+  void GetCellBox(Key, Standard_Real& xMin, Standard_Real& yMin,
+                  Standard_Real& zMin, Standard_Real& xMax, Standard_Real& yMax,
+                  Standard_Real& zMax) const;
+
+  gp_Pnt GetCenter(Key) const;
+
+  //! Атрибут терминальной ячейки; по умолчанию нулевой.
+  size_t GetAttr(Key) const;
+  void SetAttr(Key, size_t);
+
+ private:
+  LinearOcTree(const Bnd_Box&, Standard_Integer in, Standard_Integer jn,
+               Standard_Integer kn);
+  LinearOcTree(const LinearOcTree&) = delete;
+  LinearOcTree& operator=(const LinearOcTree&) = delete;
+
+ private:
+  Internal* pimpl;
+};
+
+#endif  // !numgeom_numgeom_linearoctree_h
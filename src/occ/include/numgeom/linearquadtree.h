@@ -0,0 +1,122 @@
+#ifndef numgeom_numgeom_linearquadtree_h
+#define numgeom_numgeom_linearquadtree_h
+
+#include <Bnd_Box2d.hxx>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "numgeom/occ_export.h"
+
+/**
+\brief Линейное квадродерево: ячейки адресуются 64-битными ключами Мортона.
+
+Ключ ячейки уровня `level` -- код Мортона ее координат `(i, j)` на этом уровне,
+дополненный старшим единичным битом. По положению этого бита определяется
+уровень, поэтому переход к родителю, дочерним и соседним ячейкам сводится к
+битовым операциям над ключом. Терминальные и нетерминальные ячейки хранятся
+в хеш-таблицах, так что деление ячейки и проверка ее существования выполняются
+за постоянное время, а поиск терминальной ячейки по точке -- двоичным поиском
+по уровням.
+
+Нулевой уровень, как и у `QuadTree`, составляет сетка `in` x `jn` ячеек.
+Координаты ячеек не ограничены 32-битными индексами уровня: глубина дерева
+ограничена только разрядностью ключа, см. `MaxLevel`.
+*/
+class OCC_EXPORT LinearQuadTree {
+ public:
+  typedef std::shared_ptr<LinearQuadTree> Ptr;
+  typedef std::shared_ptr<const LinearQuadTree> CPtr;
+
+  typedef uint64_t Key;
+
+  //! Недействительный ключ: ячейки нет.
+  static constexpr Key NoKey = 0;
+
+  struct Internal;
+
+ public:
+  /** \brief Создать дерево с решёткой `in`x`jn` ячеек нулевого уровня.
+
+    При неположительном размере решётки возвращается пустой указатель.
+    Если размер решётки по какому-либо направлению больше 2^31, ключи
+    нулевого уровня не помещаются в 64 бита: бросается Standard_OutOfRange.
+  */
+  static LinearQuadTree::Ptr Create(const Bnd_Box2d&, Standard_Integer in = 1,
+                                    Standard_Integer jn = 1);
+
+ public:
+  ~LinearQuadTree();
+
+  //! Количество уровней в дереве.
+  Standard_Integer Levels() const;
+
+  //! Наибольший уровень, ячейки которого представимы ключами.
+  Standard_Integer MaxLevel() const;
+
+  //! Количество терминальных ячеек.
+  size_t NbCells() const;
+
+  //! Габаритная коробка всех ячеек нулевого уровня.
+  void GetBox(Standard_Real& xMin, Standard_Real& yMin, Standard_Real& xMax,
+              Standard_Real& yMax) const;
+
+  void CellsNumberOnLevel(Standard_Integer level, uint64_t& nbByI,
+                          uint64_t& nbByJ) const;
+
+  //! Ключ ячейки с координатами `(i, j)` на уровне `level`.
+  Key GetKey(Standard_Integer level, uint32_t i, uint32_t j) const;
+
+  Standard_Integer GetLevel(Key) const;
+
+  void GetCellCoords(Key, uint32_t& i, uint32_t& j) const;
+
+  //! Родительская ячейка или `NoKey` для ячейки нулевого уровня.
+  Key GetParent(Key) const;
+
+  //! Дочерняя ячейка: младший бит `childIndex` задает смещение по `i`,
+  //! старший -- по `j`.
+  Key GetChild(Key, Standard_Integer childIndex) const;
+
+  //! Ячейка того же уровня, смещенная на `(di, dj)`, или `NoKey`, если она
+  //! выходит за пределы сетки уровня. Существование ячейки не проверяется.
+  Key GetNeighbour(Key, Standard_Integer di, Standard_Integer dj) const;
+
+  //! Ячейка существует в терминальном или нетерминальном виде?
+  Standard_Boolean IsExists(Key) const;
+
+  Standard_Boolean IsTerminal(Key) const;
+
+  //! Делит терминальную ячейку на четыре дочерних. Атрибут ячейки теряется.
+  void Split(Key);
+
+  //! Делит набор терминальных ячеек. Повторы ключей допускаются.
+  void Split(std::span<const Key>);
+
+  //! Терминальные ячейки в порядке обхода Z-кривой.
+  std::vector<Key> TerminalCells() const;
+
+  //! Терминальная ячейка, содержащая точку, или `NoKey` для точки вне
+  //! габаритной коробки.
+  Key GetCell(const gp_Pnt2d&) const;
+
+  void GetCellBox(Key, Standard_Real& xMin, Standard_Real& yMin,
+                  Standard_Real& xMax, Standard_Real& yMax) const;
+
+  gp_Pnt2d GetCenter(Key) const;
+
+  //! Атрибут терминальной ячейки; по умолчанию нулевой.
+  size_t GetAttr(Key) const;
+  void SetAttr(Key, size_t);
+
+ private:
+  LinearQuadTree(const Bnd_Box2d&, Standard_Integer in, Standard_Integer jn);
+  LinearQuadTree(const LinearQuadTree&) = delete;
+  LinearQuadTree& operator=(const LinearQuadTree&) = delete;
+
+ private:
+  Internal* pimpl;
+};
+
+#endif  // !numgeom_numgeom_linearquadtree_h
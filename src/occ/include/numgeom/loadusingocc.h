@@ -3,8 +3,10 @@
 
 #include <filesystem>
 
+#include "Message_ProgressRange.hxx"
 #include "Standard_Handle.hxx"
 
+#include "numgeom/loadasync.h"
 #include "numgeom/trimesh.h"
 
 class Poly_Triangulation;
@@ -12,15 +14,46 @@ class TDocStd_Document;
 
 TriMesh::Ptr LoadUsingOCC(const std::filesystem::path&);
 
-Handle(TDocStd_Document) LoadStepDocument(const std::filesystem::path&);
+//! Загрузчики документов передают ход преобразования в `progress` и
+//! возвращают пустой документ, если загрузка прервана через него.
+Handle(TDocStd_Document) LoadStepDocument(
+    const std::filesystem::path&,
+    const Message_ProgressRange& progress = Message_ProgressRange());
 
-Handle(TDocStd_Document) LoadIges(const std::filesystem::path&);
+Handle(TDocStd_Document) LoadIges(
+    const std::filesystem::path&,
+    const Message_ProgressRange& progress = Message_ProgressRange());
 
 #ifdef NUMGEOM_OCC_LOAD_VRML
-Handle(TDocStd_Document) LoadVrml(const std::filesystem::path&);
+Handle(TDocStd_Document) LoadVrml(
+    const std::filesystem::path&,
+    const Message_ProgressRange& progress = Message_ProgressRange());
 #endif
 
-Handle(TDocStd_Document) LoadGltf(const std::filesystem::path&);
+Handle(TDocStd_Document) LoadGltf(
+    const std::filesystem::path&,
+    const Message_ProgressRange& progress = Message_ProgressRange());
+
+//! Строит недостающие триангуляции граней документа так же, как
+//! `Drawable2_OccShape` (через `TriangulateShape`), сообщая в `progress`
+//! число обработанных граней. Возвращает `false`, если загрузка отменена.
+bool MeshDocument(const Handle(TDocStd_Document)&, LoadProgress& progress);
+
+/**
+\brief Загружает документ STEP, IGES, VRML или glTF и строит его сетку.
+
+Формат выбирается по расширению файла. Доля выполненного преобразования
+файла в документ пересчитывается в число разобранных байтов, после чего
+вызывается `MeshDocument`, чтобы отображение документа в потоке интерфейса
+не тратило время на построение сетки.
+*/
+Handle(TDocStd_Document) LoadDocument(const std::filesystem::path&,
+                                      LoadProgress& progress);
+
+//! Выполняет `LoadDocument` в отдельном потоке.
+AsyncLoad<Handle(TDocStd_Document)> LoadDocumentAsync(
+    const std::filesystem::path&,
+    LoadProgress::Callback callback = LoadProgress::Callback());
 
 Handle(Poly_Triangulation) LoadStl(const std::filesystem::path&);
 
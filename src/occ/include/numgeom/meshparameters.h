@@ -0,0 +1,25 @@
+#ifndef numgeom_numgeom_meshparameters_h
+#define numgeom_numgeom_meshparameters_h
+
+/**\struct MeshParameters
+\brief Параметры построения триангуляций граней B-rep фигур.
+
+Значения по умолчанию соответствуют прежнему вызову
+`BRepMesh_IncrementalMesh(face, 0.6)`.
+*/
+struct MeshParameters {
+  //! Наибольшее расстояние от треугольника до поверхности грани.
+  double linearDeflection = 0.6;
+
+  //! Наибольший угол (в радианах) между нормалями соседних узлов.
+  double angularDeflection = 0.5;
+
+  //! Задан ли `linearDeflection` относительно размера ребер.
+  bool relative = false;
+
+  //! Строить ли сетки в нескольких потоках. На результат не влияет: сетки
+  //! совпадают с построенными последовательно.
+  bool inParallel = true;
+};
+
+#endif  // !numgeom_numgeom_meshparameters_h
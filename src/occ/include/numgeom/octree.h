@@ -5,13 +5,19 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <span>
+#include <vector>
 
 #include "Bnd_Box.hxx"
 
 #include "numgeom/ijk.h"
 #include "numgeom/iterator.h"
+#include "numgeom/meshparameters.h"
 #include "numgeom/occ_export.h"
 
+class CTriMesh;
+class TopoDS_Shape;
+
 class OCC_EXPORT OcTree {
  public:
   typedef std::shared_ptr<OcTree> Ptr;
@@ -56,21 +62,77 @@ class OCC_EXPORT OcTree {
   struct Cell;
   struct Node;
 
+  //! Положение терминальной ячейки относительно поверхности; при адаптивном
+  //! построении дерева записывается в атрибут ячейки.
+  enum CellPosition { OuterCell = 0, InnerCell = 1, BoundaryCell = 2 };
+
+  //! Желаемый размер ячейки в точке.
+  typedef std::function<Standard_Real(const gp_Pnt&)> SizeField;
+
+  //! Порядковый номер отсутствующей ячейки.
+  static constexpr size_t NoOrdinal = static_cast<size_t>(-1);
+
+  //! Формат сериализации дерева.
+  enum class Format {
+    //! Компактный двоичный формат. Поток должен быть открыт в двоичном режиме.
+    Binary,
+    //! Текстовый формат JSON для отладки. Каналы атрибутов не сохраняются.
+    Json
+  };
+
  public:
+  //! Читает дерево в любом из форматов `Format`.
   static OcTree::Ptr Deserialize(std::istream&);
 
   static OcTree::Ptr Create(const Bnd_Box&, Standard_Integer in = 1,
                             Standard_Integer jn = 1, Standard_Integer kn = 1);
 
+  /**
+  \brief Строит дерево, измельченное вблизи поверхности замкнутой сетки.
+  \param maxLevel Наибольший уровень ячеек.
+  \param cellSize Ячейка, пересекающая треугольники сетки, делится, пока ее
+         наибольшая сторона больше `cellSize` в центре ячейки. Без функции
+         такие ячейки делятся до уровня `maxLevel`.
+
+  Ячейки нулевого уровня кубические и покрывают сетку с небольшим запасом.
+  Уровни делятся по очереди, ячейки уровня проверяются в нескольких потоках.
+  Затем дерево балансируется: уровни терминальных ячеек, соседних по грани,
+  ребру или вершине, отличаются не более чем на единицу. Атрибут
+  терминальной ячейки - значение `CellPosition`; положение ячеек, не
+  пересекающих сетку, определяется по четности пересечений луча из центра
+  ячейки с треугольниками. Для пустой сетки возвращает пустой указатель.
+  */
+  static OcTree::Ptr Create(const CTriMesh& mesh, Standard_Integer maxLevel,
+                            const SizeField& cellSize = SizeField());
+
+  //! Строит дерево по триангуляции граней тела так же, как по сетке, но
+  //! положение ячеек, не пересекающих поверхность, определяется
+  //! `SolidClassifier` по той же сетке. Как и классификатор, сохраняет
+  //! триангуляции в гранях `solid`.
+  static OcTree::Ptr Create(const TopoDS_Shape& solid,
+                            Standard_Integer maxLevel,
+                            const SizeField& cellSize = SizeField(),
+                            const MeshParameters& params = MeshParameters());
+
  public:
   ~OcTree();
 
   //! Количество уровней в дереве.
   Standard_Integer Levels() const;
 
-  //! Количество терминальных квадрантов.
+  //! Количество терминальных ячеек. Счетчики ячеек обновляются при делении,
+  //! так что этот и следующие методы не обходят дерево.
   Standard_Integer NbCells() const;
 
+  //! То же, что `NbCells()`.
+  size_t NbTerminalCells() const;
+
+  //! Количество терминальных ячеек уровня.
+  Standard_Integer NbTerminalCells(Standard_Integer level) const;
+
+  //! Количество нетерминальных ячеек уровня.
+  Standard_Integer NbNonTerminalCells(Standard_Integer level) const;
+
   //! Габаритная коробка всех ячеек нулевого уровня.
   void GetBox(Standard_Real& xMin, Standard_Real& yMin, Standard_Real& zMin,
               Standard_Real& xMax, Standard_Real& yMax,
@@ -86,12 +148,46 @@ class OCC_EXPORT OcTree {
   //! Итератор по терминальным ячейкам.
   Iterator<Cell> TerminalCells() const;
 
+  /**
+  \brief Терминальные ячейки в порядке `TerminalCells()` в виде массива.
+
+  Индекс ячейки в массиве - ее терминальный номер `GetTerminalOrdinal`.
+  Массив строится при первом обращении после деления ячеек и действителен
+  до следующего деления.
+  */
+  std::span<const Cell> TerminalCellsArray() const;
+
+  //! Номер ячейки в `TerminalCellsArray()` или `NoOrdinal`, если ячейка
+  //! нетерминальная или отсутствует.
+  size_t GetTerminalOrdinal(const Cell&) const;
+
   //! Итератор по терминальным ячейкам заданного уровня.
   Iterator<Cell> TerminalCellsOfLevel(Standard_Integer level) const;
 
   //! Итерирование по связанным (по ребру и вершине) ячейкам.
   Iterator<Cell> ConnectedCells(const Cell&) const;
 
+  /**
+  \brief Строит таблицу соседей терминальных ячеек.
+
+  Для каждой терминальной ячейки таблица хранит без повторов связанные с ней
+  по грани, ребру или вершине терминальные ячейки и типы связи
+  `GetConnectionType`. Строки расположены подряд в общем массиве по
+  порядковым номерам ячеек и заполняются в нескольких потоках. Деление ячеек
+  сбрасывает таблицу.
+  */
+  void BuildNeighbours();
+
+  //! Построена ли таблица соседей.
+  Standard_Boolean HasNeighbours() const;
+
+  //! Соседи терминальной ячейки из таблицы в порядке возрастания. Пустой
+  //! диапазон, если таблица не построена или ячейка нетерминальная.
+  std::span<const Cell> Neighbours(const Cell&) const;
+
+  //! Типы связи соседей `Neighbours(cell)` относительно ячейки `cell`.
+  std::span<const CellConnection> NeighbourConnections(const Cell&) const;
+
   void GetCellBox(const Cell& cell, Standard_Real& xMin, Standard_Real& yMin,
                   Standard_Real& zMin, Standard_Real& xMax, Standard_Real& yMax,
                   Standard_Real& zMax) const;
@@ -106,16 +202,58 @@ class OCC_EXPORT OcTree {
 
   Standard_Boolean Equals(OcTree::CPtr) const;
 
+  Standard_Boolean IsTerminal(const Cell&) const;
+
+  //! Дочерняя ячейка с номером от 0 до 7. Номера 0-3 перечисляют ячейки
+  //! нижнего по `k` слоя так же, как у квадродерева, 4-7 -- верхнего.
+  Cell GetChildCell(const Cell&, Standard_Integer childIndex) const;
+
   void Split(const Cell&);
 
   size_t GetAttr(const Cell&) const;
-  void SetAttr(const Cell&, size_t) const;
+  void SetAttr(const Cell&, size_t);
+
+  //! Порядковый номер ячейки или `NoOrdinal`, если ячейки нет в дереве.
+  //! Номер назначается ячейке при ее создании и не меняется при делении
+  //! ячеек, так что номера всех ячеек дерева занимают диапазон
+  //! [0, NbOrdinals()).
+  size_t GetOrdinal(const Cell&) const;
+
+  size_t NbOrdinals() const;
+
+  /**
+  \brief Добавляет канал атрибутов ячеек и возвращает его номер.
+
+  Канал хранит по значению типа `T` (`int`, `float` или `double`) для каждой
+  ячейки дерева в массиве по порядковым номерам ячеек. При делении ячеек
+  каналы дополняются значением `defaultValue`.
+  */
+  template <typename T>
+  size_t AddChannel(T defaultValue = T());
+
+  //! Значения канала по порядковым номерам ячеек. Пустой диапазон, если тип
+  //! `T` не совпадает с типом канала.
+  template <typename T>
+  std::span<T> GetChannel(size_t channel);
+  template <typename T>
+  std::span<const T> GetChannel(size_t channel) const;
+
+  template <typename T>
+  T GetValue(size_t channel, const Cell&) const;
+  template <typename T>
+  void SetValue(size_t channel, const Cell&, T value);
+
+  //! Значения канала для терминальных ячеек в порядке `TerminalCells()`.
+  template <typename T>
+  void GetValues(size_t channel, std::vector<T>& values) const;
+  template <typename T>
+  void SetValues(size_t channel, std::span<const T> values);
 
   Cell GetCell(const gp_Pnt&) const;
 
   Standard_Boolean Dump(const std::filesystem::path&) const;
 
-  void Serialize(std::ostream&) const;
+  void Serialize(std::ostream&, Format = Format::Binary) const;
 
  private:
   OcTree(const Bnd_Box&, Standard_Integer in, Standard_Integer jn,
@@ -180,16 +318,38 @@ struct OcTree::Node {
 
 /**
 \brief Поиск в октодереве ячеек (входящих в список отмеченных), которые
-       наиболее близко расположены к точке.
+       расположены не дальше заданного расстояния от точки.
 \param tree Октодерево.
 \param Q Искомая точка.
 \param isTaggedCell Функция, возвращающая признак отмеченности ячейки.
 \param maximumDistance Радиус, вокруг которого происходит поиск.
-\param nearestCells Ближайшие к точке терминальные отмеченные ячейки.
+\param nearestCells Терминальные отмеченные ячейки в порядке удаления от
+       точки.
 */
 void OCC_EXPORT SearchNearestCells(
     OcTree::CPtr tree, const gp_Pnt& Q,
     const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
         isTaggedCell,
     Standard_Real maximumDistance, std::list<OcTree::Cell>& nearestCells);
+
+/**
+\brief Поиск `k` ближайших к точке отмеченных ячеек октодерева.
+\param nearestCells Не более `k` терминальных отмеченных ячеек не дальше
+       `maximumDistance` в порядке удаления от точки.
+*/
+void OCC_EXPORT SearchKNearestCells(
+    OcTree::CPtr tree, const gp_Pnt& Q,
+    const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
+        isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<OcTree::Cell>& nearestCells);
+
+//! Поиск `k` ближайших отмеченных ячеек для набора точек в нескольких
+//! потоках. Функция `isTaggedCell` вызывается из разных потоков одновременно.
+void OCC_EXPORT SearchKNearestCells(
+    OcTree::CPtr tree, std::span<const gp_Pnt> points,
+    const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
+        isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<std::vector<OcTree::Cell>>& nearestCells);
 #endif  // !numgeom_numgeom_octree_h
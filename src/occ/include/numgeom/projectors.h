@@ -0,0 +1,114 @@
+#ifndef numgeom_numgeom_projectors_h
+#define numgeom_numgeom_projectors_h
+
+#include <Geom2d_Curve.hxx>
+#include <Geom_Curve.hxx>
+#include <Geom_Surface.hxx>
+#include <gp_Pnt.hxx>
+#include <gp_Pnt2d.hxx>
+#include <span>
+#include <vector>
+
+#include "numgeom/occ_export.h"
+
+/**
+\file
+\brief Проекторы точек на кривые и поверхности для многократного использования.
+
+В отличие от функций `Project(...)`, создающих алгоритм поиска экстремумов при
+каждом вызове, проектор инициализирует его один раз. Метод `Project(P, guess)`
+уточняет проекцию методом Ньютона от начального приближения `guess` и
+переходит к глобальному поиску, если локальный поиск не сошелся.
+
+Пакетный метод `Project(points)` обрабатывает точки в нескольких потоках, и
+каждый поток работает со своей копией проектора и геометрии. Проекция каждой
+точки начинается от решения для предыдущей точки того же потока; решение
+принимается, если его основание лежит внутри области параметров и оно не
+дальше ближайшей точки грубой выборки геометрии, иначе выполняется глобальный
+поиск. Принятое решение может уступить ближайшему не больше, чем на
+расстояние между точками выборки. Число точек, спроецированных локальным
+поиском, возвращается в `nbLocal`. Для бесконечной геометрии выборки нет, и
+все точки проецируются глобальным поиском. Точки, соседние в облаке, лучше
+передавать подряд.
+
+Если проекция не найдена, параметры равны `HUGE_VAL`. Одиночные методы
+изменяют состояние проектора, и один объект нельзя использовать одновременно
+из нескольких потоков.
+*/
+
+class OCC_EXPORT CurveProjector2d {
+ public:
+  explicit CurveProjector2d(const Handle(Geom2d_Curve) & curve);
+  ~CurveProjector2d();
+
+  const Handle(Geom2d_Curve) & Curve() const;
+
+  Standard_Real Project(const gp_Pnt2d& P);
+
+  Standard_Real Project(const gp_Pnt2d& P, Standard_Real guess);
+
+  std::vector<Standard_Real> Project(std::span<const gp_Pnt2d> points,
+                                     size_t* nbLocal = nullptr) const;
+
+ private:
+  CurveProjector2d(const CurveProjector2d&) = delete;
+  CurveProjector2d& operator=(const CurveProjector2d&) = delete;
+
+ public:
+  struct Internal;
+
+ private:
+  Internal* pimpl;
+};
+
+class OCC_EXPORT CurveProjector {
+ public:
+  explicit CurveProjector(const Handle(Geom_Curve) & curve);
+  ~CurveProjector();
+
+  const Handle(Geom_Curve) & Curve() const;
+
+  Standard_Real Project(const gp_Pnt& P);
+
+  Standard_Real Project(const gp_Pnt& P, Standard_Real guess);
+
+  std::vector<Standard_Real> Project(std::span<const gp_Pnt> points,
+                                     size_t* nbLocal = nullptr) const;
+
+ private:
+  CurveProjector(const CurveProjector&) = delete;
+  CurveProjector& operator=(const CurveProjector&) = delete;
+
+ public:
+  struct Internal;
+
+ private:
+  Internal* pimpl;
+};
+
+class OCC_EXPORT SurfaceProjector {
+ public:
+  explicit SurfaceProjector(const Handle(Geom_Surface) & surface);
+  ~SurfaceProjector();
+
+  const Handle(Geom_Surface) & Surface() const;
+
+  gp_Pnt2d Project(const gp_Pnt& P);
+
+  gp_Pnt2d Project(const gp_Pnt& P, const gp_Pnt2d& guess);
+
+  std::vector<gp_Pnt2d> Project(std::span<const gp_Pnt> points,
+                                size_t* nbLocal = nullptr) const;
+
+ private:
+  SurfaceProjector(const SurfaceProjector&) = delete;
+  SurfaceProjector& operator=(const SurfaceProjector&) = delete;
+
+ public:
+  struct Internal;
+
+ private:
+  Internal* pimpl;
+};
+
+#endif  // !numgeom_numgeom_projectors_h
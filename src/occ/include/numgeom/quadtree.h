@@ -6,6 +6,8 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <span>
+#include <vector>
 
 #include "numgeom/iterator.h"
 #include "numgeom/occ_export.h"
@@ -32,7 +34,19 @@ class OCC_EXPORT QuadTree {
   struct Cell;
   struct Node;
 
+  //! Порядковый номер отсутствующей ячейки.
+  static constexpr size_t NoOrdinal = static_cast<size_t>(-1);
+
+  //! Формат сериализации дерева.
+  enum class Format {
+    //! Компактный двоичный формат. Поток должен быть открыт в двоичном режиме.
+    Binary,
+    //! Текстовый формат JSON для отладки. Каналы атрибутов не сохраняются.
+    Json
+  };
+
  public:
+  //! Читает дерево в любом из форматов `Format`.
   static QuadTree::Ptr Deserialize(std::istream&);
 
   static QuadTree::Ptr Create(const Bnd_Box2d&, Standard_Integer in = 1,
@@ -44,9 +58,19 @@ class OCC_EXPORT QuadTree {
   //! Количество уровней в дереве.
   Standard_Integer Levels() const;
 
-  //! Количество терминальных квадрантов.
+  //! Количество терминальных ячеек. Счетчики ячеек обновляются при делении,
+  //! так что этот и следующие методы не обходят дерево.
   Standard_Integer NbCells() const;
 
+  //! То же, что `NbCells()`.
+  size_t NbTerminalCells() const;
+
+  //! Количество терминальных ячеек уровня.
+  Standard_Integer NbTerminalCells(Standard_Integer level) const;
+
+  //! Количество нетерминальных ячеек уровня.
+  Standard_Integer NbNonTerminalCells(Standard_Integer level) const;
+
   //! Габаритная коробка всех ячеек нулевого уровня.
   void GetBox(Standard_Real& xMin, Standard_Real& yMin, Standard_Real& xMax,
               Standard_Real& yMax) const;
@@ -63,12 +87,46 @@ class OCC_EXPORT QuadTree {
   //! Итератор по терминальным ячейкам.
   Iterator<Cell> TerminalCells() const;
 
+  /**
+  \brief Терминальные ячейки в порядке `TerminalCells()` в виде массива.
+
+  Индекс ячейки в массиве - ее терминальный номер `GetTerminalOrdinal`.
+  Массив строится при первом обращении после деления ячеек и действителен
+  до следующего деления.
+  */
+  std::span<const Cell> TerminalCellsArray() const;
+
+  //! Номер ячейки в `TerminalCellsArray()` или `NoOrdinal`, если ячейка
+  //! нетерминальная или отсутствует.
+  size_t GetTerminalOrdinal(const Cell&) const;
+
   //! Итератор по терминальным ячейкам заданного уровня.
   Iterator<Cell> TerminalCellsOfLevel(Standard_Integer level) const;
 
   //! Итерирование по связанным (по ребру и вершине) ячейкам.
   Iterator<Cell> ConnectedCells(const Cell&) const;
 
+  /**
+  \brief Строит таблицу соседей терминальных ячеек.
+
+  Для каждой терминальной ячейки таблица хранит без повторов связанные с ней
+  по стороне или вершине терминальные ячейки и типы связи
+  `GetConnectionType`. Строки расположены подряд в общем массиве по
+  порядковым номерам ячеек и заполняются в нескольких потоках. Деление ячеек
+  сбрасывает таблицу.
+  */
+  void BuildNeighbours();
+
+  //! Построена ли таблица соседей.
+  Standard_Boolean HasNeighbours() const;
+
+  //! Соседи терминальной ячейки из таблицы в порядке возрастания. Пустой
+  //! диапазон, если таблица не построена или ячейка нетерминальная.
+  std::span<const Cell> Neighbours(const Cell&) const;
+
+  //! Типы связи соседей `Neighbours(cell)` относительно ячейки `cell`.
+  std::span<const CellConnection> NeighbourConnections(const Cell&) const;
+
   void GetCellBox(const Cell& cell, Standard_Real& xMin, Standard_Real& yMin,
                   Standard_Real& xMax, Standard_Real& yMax) const;
 
@@ -82,16 +140,58 @@ class OCC_EXPORT QuadTree {
 
   Standard_Boolean Equals(QuadTree::CPtr) const;
 
+  Standard_Boolean IsTerminal(const Cell&) const;
+
+  //! Дочерняя ячейка с номером от 0 до 3; ячейки перечисляются против
+  //! часовой стрелки, начиная с левой нижней.
+  Cell GetChildCell(const Cell&, Standard_Integer childIndex) const;
+
   void Split(const Cell&);
 
   size_t GetAttr(const Cell&) const;
-  void SetAttr(const Cell&, size_t) const;
+  void SetAttr(const Cell&, size_t);
+
+  //! Порядковый номер ячейки или `NoOrdinal`, если ячейки нет в дереве.
+  //! Номер назначается ячейке при ее создании и не меняется при делении
+  //! ячеек, так что номера всех ячеек дерева занимают диапазон
+  //! [0, NbOrdinals()).
+  size_t GetOrdinal(const Cell&) const;
+
+  size_t NbOrdinals() const;
+
+  /**
+  \brief Добавляет канал атрибутов ячеек и возвращает его номер.
+
+  Канал хранит по значению типа `T` (`int`, `float` или `double`) для каждой
+  ячейки дерева в массиве по порядковым номерам ячеек. При делении ячеек
+  каналы дополняются значением `defaultValue`.
+  */
+  template <typename T>
+  size_t AddChannel(T defaultValue = T());
+
+  //! Значения канала по порядковым номерам ячеек. Пустой диапазон, если тип
+  //! `T` не совпадает с типом канала.
+  template <typename T>
+  std::span<T> GetChannel(size_t channel);
+  template <typename T>
+  std::span<const T> GetChannel(size_t channel) const;
+
+  template <typename T>
+  T GetValue(size_t channel, const Cell&) const;
+  template <typename T>
+  void SetValue(size_t channel, const Cell&, T value);
+
+  //! Значения канала для терминальных ячеек в порядке `TerminalCells()`.
+  template <typename T>
+  void GetValues(size_t channel, std::vector<T>& values) const;
+  template <typename T>
+  void SetValues(size_t channel, std::span<const T> values);
 
   Cell GetCell(const gp_Pnt2d&) const;
 
   Standard_Boolean Dump(const std::filesystem::path&) const;
 
-  void Serialize(std::ostream&) const;
+  void Serialize(std::ostream&, Format = Format::Binary) const;
 
  private:
   QuadTree(const Bnd_Box2d&, Standard_Integer in, Standard_Integer jn);
@@ -155,12 +255,13 @@ struct QuadTree::Node {
 
 /**
 \brief Поиск в квадродереве ячеек (входящих в список отмеченных), которые
-       наиболее близко расположены к точке.
+       расположены не дальше заданного расстояния от точки.
 \param qTree Квадродерево.
 \param Q Искомая точка.
 \param isTaggedCell Функция, возвращающая признак отмеченности ячейки.
 \param maximumDistance Радиус, вокруг которого происходит поиск.
-\param nearestCells Ближайшие к точке терминальные отмеченные ячейки.
+\param nearestCells Терминальные отмеченные ячейки в порядке удаления от
+       точки.
 */
 void OCC_EXPORT SearchNearestCells(
     QuadTree::CPtr qTree, const gp_Pnt2d& Q,
@@ -168,4 +269,28 @@ void OCC_EXPORT SearchNearestCells(
                                          const QuadTree::Cell&)>& isTaggedCell,
     Standard_Real maximumDistance, std::list<QuadTree::Cell>& nearestCells);
 
+/**
+\brief Поиск `k` ближайших к точке отмеченных ячеек квадродерева.
+
+Дерево обходится от корня в порядке удаления ячеек от точки, поэтому
+просматриваются только ячейки, которые ближе `k`-й найденной.
+\param nearestCells Не более `k` терминальных отмеченных ячеек не дальше
+       `maximumDistance` в порядке удаления от точки.
+*/
+void OCC_EXPORT SearchKNearestCells(
+    QuadTree::CPtr qTree, const gp_Pnt2d& Q,
+    const std::function<Standard_Boolean(QuadTree::CPtr,
+                                         const QuadTree::Cell&)>& isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<QuadTree::Cell>& nearestCells);
+
+//! Поиск `k` ближайших отмеченных ячеек для набора точек в нескольких
+//! потоках. Функция `isTaggedCell` вызывается из разных потоков одновременно.
+void OCC_EXPORT SearchKNearestCells(
+    QuadTree::CPtr qTree, std::span<const gp_Pnt2d> points,
+    const std::function<Standard_Boolean(QuadTree::CPtr,
+                                         const QuadTree::Cell&)>& isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<std::vector<QuadTree::Cell>>& nearestCells);
+
 #endif  // !numgeom_numgeom_quadtree_h
@@ -2,10 +2,24 @@
 #define numgeom_numgeom_algoremovefaces_h
 
 #include <TopTools_ListOfShape.hxx>
+#include <vector>
 
 class TopoDS_Shape;
 
 TopoDS_Shape RemoveFaces(const TopoDS_Shape& initShape,
                          const TopTools_ListOfShape& facesToRemove);
 
+/**
+\brief Удаляет грани, сообщая о блоках, которые не удалось обработать.
+
+Удаляемые грани делятся на блоки, связанные по ребрам, и блоки обрабатываются
+параллельно. Восстанавливающие грани блоков собираются в результат в порядке
+блоков, так что результат не зависит от числа потоков. Неудача одного блока не
+прерывает обработку остальных: его восстанавливающие грани в результат не
+попадают, а удаляемые грани блока добавляются в `failedBlocks`.
+*/
+TopoDS_Shape RemoveFaces(const TopoDS_Shape& initShape,
+                         const TopTools_ListOfShape& facesToRemove,
+                         std::vector<TopTools_ListOfShape>& failedBlocks);
+
 #endif  // !numgeom_numgeom_algoremovefaces_h
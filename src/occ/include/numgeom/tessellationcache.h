@@ -0,0 +1,74 @@
+#ifndef numgeom_numgeom_tessellationcache_h
+#define numgeom_numgeom_tessellationcache_h
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "numgeom/meshparameters.h"
+#include "numgeom/occ_export.h"
+
+class TopoDS_Shape;
+
+/**\class TessellationCache
+\brief Дисковый кэш триангуляций граней фигур.
+
+Триангуляции всех граней фигуры хранятся одним двоичным файлом, имя которого
+- ключ, вычисленный по содержимому фигуры и параметрам построения сетки.
+Файл сначала пишется во временный и затем переименовывается, поэтому кэш
+можно разделять между несколькими процессами: читатель видит либо старый,
+либо новый файл целиком. Если суммарный размер файлов превышает предел,
+удаляются файлы, к которым дольше всего не обращались (время обращения -
+время изменения файла, оно обновляется при каждом чтении).
+*/
+class OCC_EXPORT TessellationCache {
+ public:
+  typedef std::shared_ptr<TessellationCache> Ptr;
+
+ public:
+  //! Создает кэш в каталоге `directory` (создается при необходимости)
+  //! с пределом суммарного размера файлов `maxSize` байтов. Возвращает
+  //! пустой указатель, если каталог недоступен.
+  static Ptr Create(const std::filesystem::path& directory,
+                    uintmax_t maxSize = uintmax_t(1) << 30);
+
+  //! Кэш, используемый при построении триангуляций граней фигур; по
+  //! умолчанию не задан, и триангуляции строятся заново.
+  static Ptr Default();
+  static void SetDefault(Ptr cache);
+
+  //! Ключ фигуры: хэш ее описания в формате BRep (без учета положения),
+  //! параметров построения сетки и версии OCC.
+  static std::string ComputeKey(const TopoDS_Shape& shape,
+                                const MeshParameters& params);
+
+  const std::filesystem::path& Directory() const { return myDirectory; }
+
+  uintmax_t MaxSize() const { return myMaxSize; }
+
+  //! Присваивает граням фигуры триангуляции из кэша. Возвращает `false`,
+  //! если ключа нет в кэше или файл не соответствует фигуре.
+  bool Load(const std::string& key, const TopoDS_Shape& shape);
+
+  //! Сохраняет триангуляции граней фигуры под ключом `key`.
+  bool Store(const std::string& key, const TopoDS_Shape& shape);
+
+ private:
+  TessellationCache(const std::filesystem::path& directory, uintmax_t maxSize);
+
+  std::filesystem::path BlobPath(const std::string& key) const;
+
+  //! Удаляет давно не использованные файлы, пока их размер больше предела.
+  void Trim();
+
+ private:
+  std::filesystem::path myDirectory;
+  uintmax_t myMaxSize;
+  std::mutex myMutex;
+  // Оценка суммарного размера файлов, уточняется при каждом вызове `Trim`.
+  uintmax_t myCachedSize;
+  bool myCachedSizeKnown;
+};
+#endif  // !numgeom_numgeom_tessellationcache_h
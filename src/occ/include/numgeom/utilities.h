@@ -2,15 +2,18 @@
 #define numgeom_numgeom_utilities_h
 
 #include <filesystem>
+#include <vector>
 
 #include "Bnd_Box.hxx"
 #include "Bnd_Box2d.hxx"
 #include "Standard_Version.hxx"
 #include "TopoDS_Face.hxx"
 
+#include "numgeom/meshparameters.h"
 #include "numgeom/trimesh.h"
 
 class Geom_BoundedCurve;
+class LoadProgress;
 class Geom_Curve;
 class Geom_Surface;
 class Geom2d_BoundedCurve;
@@ -88,7 +91,34 @@ void GetMeshSideSizes(const Bnd_Box& box, Standard_Integer nbCells,
                       Standard_Integer& xN, Standard_Integer& yN,
                       Standard_Integer& zN);
 
-//! Извлекает из твердого тела треугольную сетку.
-TriMesh::Ptr ConvertToTriMesh(const TopoDS_Shape&);
+//! Собирает тела, оболочки и отдельные грани, составляющие фигуру.
+void ExtractTriangulableShapes(const TopoDS_Shape&,
+                               std::vector<TopoDS_Shape>& resultShapes);
+
+//! Строит триангуляции граней фигуры, если хотя бы у одной грани ее нет или
+//! она построена с прогибом больше `params.linearDeflection`. Сетки, заданные
+//! относительным прогибом, сравнить нельзя, и они строятся заново; сетки,
+//! подходящие параметрам, `BRepMesh_IncrementalMesh` оставляет. Если задан `TessellationCache::Default()`, триангуляции берутся из кэша,
+//! а новые сохраняются в нем.
+void TriangulateShape(const TopoDS_Shape&,
+                      const MeshParameters& params = MeshParameters());
+
+/**
+\brief Строит триангуляции граней нескольких фигур в нескольких потоках.
+
+Экземпляры фигуры с разными положениями обрабатываются один раз. Фигуры,
+имеющие общие ребра, обрабатываются в одном потоке по порядку, так как сетка
+ребра хранится в самом ребре; остальные группы фигур распределяются между
+потоками. Результат не зависит от числа потоков. В `progress` передается
+число обработанных граней; при отмене возвращается `false`.
+*/
+bool TriangulateShapes(const std::vector<TopoDS_Shape>&,
+                       const MeshParameters& params = MeshParameters(),
+                       LoadProgress* progress = nullptr);
+
+//! Извлекает из твердого тела треугольную сетку. Грани перечисляются в
+//! порядке обхода фигуры, так что результат не зависит от числа потоков.
+TriMesh::Ptr ConvertToTriMesh(const TopoDS_Shape&,
+                              const MeshParameters& params = MeshParameters());
 
 #endif  //! numgeom_numgeom_utilities_h
@@ -0,0 +1,283 @@
+#include "numgeom/linearoctree.h"
+
+#include <Standard_OutOfRange.hxx>
+#include <gp_Pnt.hxx>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "numgeom/mortoncode.h"
+
+struct LinearOcTree::Internal {
+  Bnd_Box boundBox;
+  Standard_Integer nbByI, nbByJ, nbByK;
+  //! Число бит координаты ячейки нулевого уровня.
+  Standard_Integer rootBits;
+  Standard_Integer levels;
+  //! Терминальные ячейки и их атрибуты.
+  std::unordered_map<Key, size_t> terminalCells;
+  //! Нетерминальные ячейки.
+  std::unordered_set<Key> nonTerminalCells;
+
+  //! Старший бит ключей уровня `level`.
+  Key LevelBit(Standard_Integer level) const {
+    return Key(1) << 3 * (rootBits + level);
+  }
+
+  Standard_Integer MaxLevel() const { return KeyBits - rootBits; }
+
+  //! Число бит координаты в ключе.
+  static constexpr Standard_Integer KeyBits = 21;
+
+  Standard_Integer GetLevel(Key key) const {
+    assert(key != NoKey);
+    return (std::bit_width(key) - 1) / 3 - rootBits;
+  }
+
+  void SplitTerminal(Key key);
+};
+
+void LinearOcTree::Internal::SplitTerminal(Key key) {
+  auto it = terminalCells.find(key);
+  assert(it != terminalCells.end());
+  if (it == terminalCells.end()) return;
+
+  Standard_Integer level = this->GetLevel(key);
+  assert(level < this->MaxLevel());
+  if (level >= this->MaxLevel()) return;
+
+  terminalCells.erase(it);
+  nonTerminalCells.insert(key);
+  for (Key childIndex = 0; childIndex < 8; ++childIndex)
+    terminalCells.emplace(key << 3 | childIndex, 0);
+  levels = std::max(levels, level + 2);
+}
+
+LinearOcTree::LinearOcTree(const Bnd_Box& boundBox, Standard_Integer in,
+                           Standard_Integer jn, Standard_Integer kn) {
+  pimpl = new Internal();
+  pimpl->boundBox = boundBox;
+  pimpl->nbByI = in;
+  pimpl->nbByJ = jn;
+  pimpl->nbByK = kn;
+  pimpl->rootBits =
+      std::bit_width(static_cast<uint32_t>(std::max({in, jn, kn}) - 1));
+  pimpl->levels = 1;
+  pimpl->terminalCells.reserve(static_cast<size_t>(in) * jn * kn);
+  for (Standard_Integer k = 0; k < kn; ++k) {
+    for (Standard_Integer j = 0; j < jn; ++j) {
+      for (Standard_Integer i = 0; i < in; ++i)
+        pimpl->terminalCells.emplace(this->GetKey(0, i, j, k), 0);
+    }
+  }
+}
+
+LinearOcTree::~LinearOcTree() { delete pimpl; }
+
+LinearOcTree::Ptr LinearOcTree::Create(const Bnd_Box& boundBox,
+                                       Standard_Integer in,
+                                       Standard_Integer jn,
+                                       Standard_Integer kn) {
+  if (in < 1 || jn < 1 || kn < 1) return LinearOcTree::Ptr();
+  // Иначе `MaxLevel` отрицателен, и ключи нулевого уровня не помещаются в
+  // 64 бита.
+  if (std::bit_width(static_cast<uint32_t>(std::max({in, jn, kn}) - 1)) >
+      Internal::KeyBits)
+    throw Standard_OutOfRange(
+        "LinearOcTree::Create: too many cells on the zero level");
+
+  return Ptr(new LinearOcTree(boundBox, in, jn, kn));
+}
+
+Standard_Integer LinearOcTree::Levels() const { return pimpl->levels; }
+
+Standard_Integer LinearOcTree::MaxLevel() const { return pimpl->MaxLevel(); }
+
+size_t LinearOcTree::NbCells() const { return pimpl->terminalCells.size(); }
+
+void LinearOcTree::GetBox(Standard_Real& xMin, Standard_Real& yMin,
+                          Standard_Real& zMin, Standard_Real& xMax,
+                          Standard_Real& yMax, Standard_Real& zMax) const {
+  pimpl->boundBox.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+}
+
+void LinearOcTree::CellsNumberOnLevel(Standard_Integer level, uint64_t& nbByI,
+                                      uint64_t& nbByJ, uint64_t& nbByK) const {
+  assert(level >= 0 && level <= pimpl->MaxLevel());
+  nbByI = static_cast<uint64_t>(pimpl->nbByI) << level;
+  nbByJ = static_cast<uint64_t>(pimpl->nbByJ) << level;
+  nbByK = static_cast<uint64_t>(pimpl->nbByK) << level;
+}
+
+LinearOcTree::Key LinearOcTree::GetKey(Standard_Integer level, uint32_t i,
+                                       uint32_t j, uint32_t k) const {
+  assert(level >= 0 && level <= pimpl->MaxLevel());
+  return pimpl->LevelBit(level) | MortonEncode3d(i, j, k);
+}
+
+Standard_Integer LinearOcTree::GetLevel(Key key) const {
+  return pimpl->GetLevel(key);
+}
+
+void LinearOcTree::GetCellCoords(Key key, uint32_t& i, uint32_t& j,
+                                 uint32_t& k) const {
+  Standard_Integer level = pimpl->GetLevel(key);
+  MortonDecode3d(key ^ pimpl->LevelBit(level), i, j, k);
+}
+
+LinearOcTree::Key LinearOcTree::GetParent(Key key) const {
+  if (pimpl->GetLevel(key) == 0) return NoKey;
+  return key >> 3;
+}
+
+LinearOcTree::Key LinearOcTree::GetChild(Key key,
+                                         Standard_Integer childIndex) const {
+  assert(childIndex >= 0 && childIndex < 8);
+  assert(pimpl->GetLevel(key) < pimpl->MaxLevel());
+  return key << 3 | static_cast<Key>(childIndex);
+}
+
+LinearOcTree::Key LinearOcTree::GetNeighbour(Key key, Standard_Integer di,
+                                             Standard_Integer dj,
+                                             Standard_Integer dk) const {
+  Standard_Integer level = pimpl->GetLevel(key);
+  uint64_t ni, nj, nk;
+  this->CellsNumberOnLevel(level, ni, nj, nk);
+  uint32_t i, j, k;
+  this->GetCellCoords(key, i, j, k);
+  int64_t ii = static_cast<int64_t>(i) + di;
+  int64_t jj = static_cast<int64_t>(j) + dj;
+  int64_t kk = static_cast<int64_t>(k) + dk;
+  if (ii < 0 || jj < 0 || kk < 0 || ii >= static_cast<int64_t>(ni) ||
+      jj >= static_cast<int64_t>(nj) || kk >= static_cast<int64_t>(nk))
+    return NoKey;
+  return this->GetKey(level, static_cast<uint32_t>(ii),
+                      static_cast<uint32_t>(jj), static_cast<uint32_t>(kk));
+}
+
+Standard_Boolean LinearOcTree::IsExists(Key key) const {
+  return pimpl->terminalCells.contains(key) ||
+         pimpl->nonTerminalCells.contains(key);
+}
+
+Standard_Boolean LinearOcTree::IsTerminal(Key key) const {
+  return pimpl->terminalCells.contains(key);
+}
+
+void LinearOcTree::Split(Key key) { pimpl->SplitTerminal(key); }
+
+void LinearOcTree::Split(std::span<const Key> keys) {
+  std::vector<Key> cells(keys.begin(), keys.end());
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+  pimpl->terminalCells.reserve(pimpl->terminalCells.size() + 7 * cells.size());
+  pimpl->nonTerminalCells.reserve(pimpl->nonTerminalCells.size() +
+                                  cells.size());
+  for (Key key : cells) pimpl->SplitTerminal(key);
+}
+
+std::vector<LinearOcTree::Key> LinearOcTree::TerminalCells() const {
+  std::vector<Key> cells;
+  cells.reserve(pimpl->terminalCells.size());
+  for (const auto& [key, attr] : pimpl->terminalCells) cells.push_back(key);
+
+  // Сдвиг ключей к общему уровню выравнивает их старшие биты, после чего
+  // порядок ключей совпадает с порядком обхода Z-кривой.
+  auto less = [this](Key a, Key b) {
+    Standard_Integer la = pimpl->GetLevel(a), lb = pimpl->GetLevel(b);
+    if (la < lb)
+      a <<= 3 * (lb - la);
+    else
+      b <<= 3 * (la - lb);
+    return a < b;
+  };
+  std::sort(cells.begin(), cells.end(), less);
+  return cells;
+}
+
+LinearOcTree::Key LinearOcTree::GetCell(const gp_Pnt& Q) const {
+  Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+  pimpl->boundBox.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+
+  Standard_Real xQ = Q.X(), yQ = Q.Y(), zQ = Q.Z();
+
+  // Точка расположена за пределами габаритной коробки дерева.
+  if (xQ < xMin || xQ > xMax || yQ < yMin || yQ > yMax || zQ < zMin ||
+      zQ > zMax)
+    return NoKey;
+
+  // Координаты точки на самом глубоком уровне дерева.
+  Standard_Integer deepest = pimpl->levels - 1;
+  uint64_t ni, nj, nk;
+  this->CellsNumberOnLevel(deepest, ni, nj, nk);
+  auto coord = [](Standard_Real t, uint64_t n) {
+    Standard_Real c = std::floor(t * static_cast<Standard_Real>(n));
+    if (!(c > 0.0)) return 0u;
+    return static_cast<uint32_t>(
+        std::min(c, static_cast<Standard_Real>(n - 1)));
+  };
+  uint32_t i = coord((xQ - xMin) / (xMax - xMin), ni);
+  uint32_t j = coord((yQ - yMin) / (yMax - yMin), nj);
+  uint32_t k = coord((zQ - zMin) / (zMax - zMin), nk);
+
+  // Предки терминальной ячейки нетерминальны, а потомков у нее нет, поэтому
+  // уровень терминальной ячейки находится двоичным поиском.
+  Standard_Integer lo = 0, hi = deepest;
+  while (lo <= hi) {
+    Standard_Integer level = (lo + hi) / 2;
+    Standard_Integer shift = deepest - level;
+    Key key = this->GetKey(level, i >> shift, j >> shift, k >> shift);
+    if (pimpl->terminalCells.contains(key)) return key;
+    if (pimpl->nonTerminalCells.contains(key))
+      lo = level + 1;
+    else
+      hi = level - 1;
+  }
+  assert(false);
+  return NoKey;
+}
+
+void LinearOcTree::GetCellBox(Key key, Standard_Real& xMin,
+                              Standard_Real& yMin, Standard_Real& zMin,
+                              Standard_Real& xMax, Standard_Real& yMax,
+                              Standard_Real& zMax) const {
+  uint64_t ni, nj, nk;
+  this->CellsNumberOnLevel(pimpl->GetLevel(key), ni, nj, nk);
+  uint32_t i, j, k;
+  this->GetCellCoords(key, i, j, k);
+  Standard_Real xMinBox, yMinBox, zMinBox, xMaxBox, yMaxBox, zMaxBox;
+  pimpl->boundBox.Get(xMinBox, yMinBox, zMinBox, xMaxBox, yMaxBox, zMaxBox);
+
+  Standard_Real xStep = (xMaxBox - xMinBox) / static_cast<Standard_Real>(ni);
+  Standard_Real yStep = (yMaxBox - yMinBox) / static_cast<Standard_Real>(nj);
+  Standard_Real zStep = (zMaxBox - zMinBox) / static_cast<Standard_Real>(nk);
+  xMin = xMinBox + xStep * i;
+  xMax = xMinBox + xStep * (i + 1.0);
+  yMin = yMinBox + yStep * j;
+  yMax = yMinBox + yStep * (j + 1.0);
+  zMin = zMinBox + zStep * k;
+  zMax = zMinBox + zStep * (k + 1.0);
+}
+
+gp_Pnt LinearOcTree::GetCenter(Key key) const {
+  Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+  this->GetCellBox(key, xMin, yMin, zMin, xMax, yMax, zMax);
+  return gp_Pnt(0.5 * (xMin + xMax), 0.5 * (yMin + yMax),
+                0.5 * (zMin + zMax));
+}
+
+size_t LinearOcTree::GetAttr(Key key) const {
+  auto it = pimpl->terminalCells.find(key);
+  if (it == pimpl->terminalCells.end()) return 0;
+  return it->second;
+}
+
+void LinearOcTree::SetAttr(Key key, size_t attr) {
+  auto it = pimpl->terminalCells.find(key);
+  assert(it != pimpl->terminalCells.end());
+  if (it != pimpl->terminalCells.end()) it->second = attr;
+}
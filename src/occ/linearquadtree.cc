@@ -0,0 +1,266 @@
+#include "numgeom/linearquadtree.h"
+
+#include <Standard_OutOfRange.hxx>
+#include <gp_Pnt2d.hxx>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "numgeom/mortoncode.h"
+
+struct LinearQuadTree::Internal {
+  Bnd_Box2d boundBox;
+  Standard_Integer nbByI, nbByJ;
+  //! Число бит координаты ячейки нулевого уровня.
+  Standard_Integer rootBits;
+  Standard_Integer levels;
+  //! Терминальные ячейки и их атрибуты.
+  std::unordered_map<Key, size_t> terminalCells;
+  //! Нетерминальные ячейки.
+  std::unordered_set<Key> nonTerminalCells;
+
+  //! Старший бит ключей уровня `level`.
+  Key LevelBit(Standard_Integer level) const {
+    return Key(1) << 2 * (rootBits + level);
+  }
+
+  Standard_Integer MaxLevel() const { return KeyBits - rootBits; }
+
+  //! Число бит координаты в ключе.
+  static constexpr Standard_Integer KeyBits = 31;
+
+  Standard_Integer GetLevel(Key key) const {
+    assert(key != NoKey);
+    return (std::bit_width(key) - 1) / 2 - rootBits;
+  }
+
+  void SplitTerminal(Key key);
+};
+
+void LinearQuadTree::Internal::SplitTerminal(Key key) {
+  auto it = terminalCells.find(key);
+  assert(it != terminalCells.end());
+  if (it == terminalCells.end()) return;
+
+  Standard_Integer level = this->GetLevel(key);
+  assert(level < this->MaxLevel());
+  if (level >= this->MaxLevel()) return;
+
+  terminalCells.erase(it);
+  nonTerminalCells.insert(key);
+  for (Key childIndex = 0; childIndex < 4; ++childIndex)
+    terminalCells.emplace(key << 2 | childIndex, 0);
+  levels = std::max(levels, level + 2);
+}
+
+LinearQuadTree::LinearQuadTree(const Bnd_Box2d& boundBox, Standard_Integer in,
+                               Standard_Integer jn) {
+  pimpl = new Internal();
+  pimpl->boundBox = boundBox;
+  pimpl->nbByI = in;
+  pimpl->nbByJ = jn;
+  pimpl->rootBits = std::bit_width(static_cast<uint32_t>(std::max(in, jn) - 1));
+  pimpl->levels = 1;
+  pimpl->terminalCells.reserve(static_cast<size_t>(in) * jn);
+  for (Standard_Integer j = 0; j < jn; ++j) {
+    for (Standard_Integer i = 0; i < in; ++i)
+      pimpl->terminalCells.emplace(this->GetKey(0, i, j), 0);
+  }
+}
+
+LinearQuadTree::~LinearQuadTree() { delete pimpl; }
+
+LinearQuadTree::Ptr LinearQuadTree::Create(const Bnd_Box2d& boundBox,
+                                           Standard_Integer in,
+                                           Standard_Integer jn) {
+  if (in < 1 || jn < 1) return LinearQuadTree::Ptr();
+  // Иначе `MaxLevel` отрицателен, и ключи нулевого уровня не помещаются в
+  // 64 бита.
+  if (std::bit_width(static_cast<uint32_t>(std::max(in, jn) - 1)) >
+      Internal::KeyBits)
+    throw Standard_OutOfRange(
+        "LinearQuadTree::Create: too many cells on the zero level");
+
+  return Ptr(new LinearQuadTree(boundBox, in, jn));
+}
+
+Standard_Integer LinearQuadTree::Levels() const { return pimpl->levels; }
+
+Standard_Integer LinearQuadTree::MaxLevel() const { return pimpl->MaxLevel(); }
+
+size_t LinearQuadTree::NbCells() const { return pimpl->terminalCells.size(); }
+
+void LinearQuadTree::GetBox(Standard_Real& xMin, Standard_Real& yMin,
+                            Standard_Real& xMax, Standard_Real& yMax) const {
+  pimpl->boundBox.Get(xMin, yMin, xMax, yMax);
+}
+
+void LinearQuadTree::CellsNumberOnLevel(Standard_Integer level,
+                                        uint64_t& nbByI,
+                                        uint64_t& nbByJ) const {
+  assert(level >= 0 && level <= pimpl->MaxLevel());
+  nbByI = static_cast<uint64_t>(pimpl->nbByI) << level;
+  nbByJ = static_cast<uint64_t>(pimpl->nbByJ) << level;
+}
+
+LinearQuadTree::Key LinearQuadTree::GetKey(Standard_Integer level, uint32_t i,
+                                           uint32_t j) const {
+  assert(level >= 0 && level <= pimpl->MaxLevel());
+  return pimpl->LevelBit(level) | MortonEncode2d(i, j);
+}
+
+Standard_Integer LinearQuadTree::GetLevel(Key key) const {
+  return pimpl->GetLevel(key);
+}
+
+void LinearQuadTree::GetCellCoords(Key key, uint32_t& i, uint32_t& j) const {
+  Standard_Integer level = pimpl->GetLevel(key);
+  MortonDecode2d(key ^ pimpl->LevelBit(level), i, j);
+}
+
+LinearQuadTree::Key LinearQuadTree::GetParent(Key key) const {
+  if (pimpl->GetLevel(key) == 0) return NoKey;
+  return key >> 2;
+}
+
+LinearQuadTree::Key LinearQuadTree::GetChild(
+    Key key, Standard_Integer childIndex) const {
+  assert(childIndex >= 0 && childIndex < 4);
+  assert(pimpl->GetLevel(key) < pimpl->MaxLevel());
+  return key << 2 | static_cast<Key>(childIndex);
+}
+
+LinearQuadTree::Key LinearQuadTree::GetNeighbour(Key key, Standard_Integer di,
+                                                 Standard_Integer dj) const {
+  Standard_Integer level = pimpl->GetLevel(key);
+  uint64_t ni, nj;
+  this->CellsNumberOnLevel(level, ni, nj);
+  uint32_t i, j;
+  this->GetCellCoords(key, i, j);
+  int64_t ii = static_cast<int64_t>(i) + di;
+  int64_t jj = static_cast<int64_t>(j) + dj;
+  if (ii < 0 || jj < 0 || ii >= static_cast<int64_t>(ni) ||
+      jj >= static_cast<int64_t>(nj))
+    return NoKey;
+  return this->GetKey(level, static_cast<uint32_t>(ii),
+                      static_cast<uint32_t>(jj));
+}
+
+Standard_Boolean LinearQuadTree::IsExists(Key key) const {
+  return pimpl->terminalCells.contains(key) ||
+         pimpl->nonTerminalCells.contains(key);
+}
+
+Standard_Boolean LinearQuadTree::IsTerminal(Key key) const {
+  return pimpl->terminalCells.contains(key);
+}
+
+void LinearQuadTree::Split(Key key) { pimpl->SplitTerminal(key); }
+
+void LinearQuadTree::Split(std::span<const Key> keys) {
+  std::vector<Key> cells(keys.begin(), keys.end());
+  std::sort(cells.begin(), cells.end());
+  cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+  pimpl->terminalCells.reserve(pimpl->terminalCells.size() + 3 * cells.size());
+  pimpl->nonTerminalCells.reserve(pimpl->nonTerminalCells.size() +
+                                  cells.size());
+  for (Key key : cells) pimpl->SplitTerminal(key);
+}
+
+std::vector<LinearQuadTree::Key> LinearQuadTree::TerminalCells() const {
+  std::vector<Key> cells;
+  cells.reserve(pimpl->terminalCells.size());
+  for (const auto& [key, attr] : pimpl->terminalCells) cells.push_back(key);
+
+  // Сдвиг ключей к общему уровню выравнивает их старшие биты, после чего
+  // порядок ключей совпадает с порядком обхода Z-кривой.
+  auto less = [this](Key a, Key b) {
+    Standard_Integer la = pimpl->GetLevel(a), lb = pimpl->GetLevel(b);
+    if (la < lb)
+      a <<= 2 * (lb - la);
+    else
+      b <<= 2 * (la - lb);
+    return a < b;
+  };
+  std::sort(cells.begin(), cells.end(), less);
+  return cells;
+}
+
+LinearQuadTree::Key LinearQuadTree::GetCell(const gp_Pnt2d& Q) const {
+  Standard_Real xMin, yMin, xMax, yMax;
+  pimpl->boundBox.Get(xMin, yMin, xMax, yMax);
+
+  Standard_Real xQ = Q.X(), yQ = Q.Y();
+
+  // Точка расположена за пределами габаритной коробки дерева.
+  if (xQ < xMin || xQ > xMax || yQ < yMin || yQ > yMax) return NoKey;
+
+  // Координаты точки на самом глубоком уровне дерева.
+  Standard_Integer deepest = pimpl->levels - 1;
+  uint64_t ni, nj;
+  this->CellsNumberOnLevel(deepest, ni, nj);
+  auto coord = [](Standard_Real t, uint64_t n) {
+    Standard_Real c = std::floor(t * static_cast<Standard_Real>(n));
+    if (!(c > 0.0)) return 0u;
+    return static_cast<uint32_t>(
+        std::min(c, static_cast<Standard_Real>(n - 1)));
+  };
+  uint32_t i = coord((xQ - xMin) / (xMax - xMin), ni);
+  uint32_t j = coord((yQ - yMin) / (yMax - yMin), nj);
+
+  // Предки терминальной ячейки нетерминальны, а потомков у нее нет, поэтому
+  // уровень терминальной ячейки находится двоичным поиском.
+  Standard_Integer lo = 0, hi = deepest;
+  while (lo <= hi) {
+    Standard_Integer level = (lo + hi) / 2;
+    Standard_Integer shift = deepest - level;
+    Key key = this->GetKey(level, i >> shift, j >> shift);
+    if (pimpl->terminalCells.contains(key)) return key;
+    if (pimpl->nonTerminalCells.contains(key))
+      lo = level + 1;
+    else
+      hi = level - 1;
+  }
+  assert(false);
+  return NoKey;
+}
+
+void LinearQuadTree::GetCellBox(Key key, Standard_Real& xMin,
+                                Standard_Real& yMin, Standard_Real& xMax,
+                                Standard_Real& yMax) const {
+  uint64_t ni, nj;
+  this->CellsNumberOnLevel(pimpl->GetLevel(key), ni, nj);
+  uint32_t i, j;
+  this->GetCellCoords(key, i, j);
+  Standard_Real xMinBox, yMinBox, xMaxBox, yMaxBox;
+  pimpl->boundBox.Get(xMinBox, yMinBox, xMaxBox, yMaxBox);
+
+  Standard_Real xStep = (xMaxBox - xMinBox) / static_cast<Standard_Real>(ni);
+  Standard_Real yStep = (yMaxBox - yMinBox) / static_cast<Standard_Real>(nj);
+  xMin = xMinBox + xStep * i;
+  xMax = xMinBox + xStep * (i + 1.0);
+  yMin = yMinBox + yStep * j;
+  yMax = yMinBox + yStep * (j + 1.0);
+}
+
+gp_Pnt2d LinearQuadTree::GetCenter(Key key) const {
+  Standard_Real xMin, yMin, xMax, yMax;
+  this->GetCellBox(key, xMin, yMin, xMax, yMax);
+  return gp_Pnt2d(0.5 * (xMin + xMax), 0.5 * (yMin + yMax));
+}
+
+size_t LinearQuadTree::GetAttr(Key key) const {
+  auto it = pimpl->terminalCells.find(key);
+  if (it == pimpl->terminalCells.end()) return 0;
+  return it->second;
+}
+
+void LinearQuadTree::SetAttr(Key key, size_t attr) {
+  auto it = pimpl->terminalCells.find(key);
+  assert(it != pimpl->terminalCells.end());
+  if (it != pimpl->terminalCells.end()) it->second = attr;
+}
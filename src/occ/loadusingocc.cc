@@ -4,25 +4,61 @@
 
 #include "BRepTools.hxx"
 #include "IGESCAFControl_Reader.hxx"
+#include "Message_ProgressIndicator.hxx"
+#include "Message_ProgressScope.hxx"
 #include "RWGltf_CafReader.hxx"
 #include "RWObj.hxx"
 #include "RWStl.hxx"
 #include "ShapeFix_Shape.hxx"
 #include "STEPCAFControl_Reader.hxx"
 #include "STEPControl_Reader.hxx"
+#include "TDF_LabelSequence.hxx"
 #include "XCAFApp_Application.hxx"
+#include "XCAFDoc_DocumentTool.hxx"
+#include "XCAFDoc_ShapeTool.hxx"
 #ifdef NUMGEOM_OCC_LOAD_VRML
 #  include "DEVRML_Provider.hxx"
 #endif
 
 #include "numgeom/utilities.h"
 
-TriMesh::Ptr LoadUsingOCC(const std::filesystem::path& filename) {
-  if (!std::filesystem::exists(filename)) return TriMesh::Ptr();
+namespace {
+;
 
+std::string LowerExtension(const std::filesystem::path& filename) {
   std::string ext = filename.extension().string();
   std::transform(ext.begin(), ext.end(), ext.begin(),
                  [](unsigned char c) { return std::tolower(c); });
+  return ext;
+}
+
+/**\class ProgressIndicator
+\brief Передает ход преобразования OCC в `LoadProgress`.
+
+Доля выполненной работы пересчитывается в число разобранных байтов файла,
+запрос отмены `LoadProgress` прерывает преобразование.
+*/
+class ProgressIndicator : public Message_ProgressIndicator {
+ public:
+  ProgressIndicator(LoadProgress& progress) : myProgress(progress) {}
+
+  Standard_Boolean UserBreak() override { return myProgress.IsCancelled(); }
+
+  void Show(const Message_ProgressScope&, const Standard_Boolean) override {
+    double position = std::clamp(GetPosition(), 0.0, 1.0);
+    myProgress.SetParsedBytes(
+        static_cast<size_t>(position * myProgress.TotalBytes()));
+  }
+
+ private:
+  LoadProgress& myProgress;
+};
+}  // namespace
+
+TriMesh::Ptr LoadUsingOCC(const std::filesystem::path& filename) {
+  if (!std::filesystem::exists(filename)) return TriMesh::Ptr();
+
+  std::string ext = LowerExtension(filename);
 
   TopoDS_Shape shape;
   if (ext == ".step" || ext == ".stp") {
@@ -47,7 +83,9 @@ TriMesh::Ptr LoadUsingOCC(const std::filesystem::path& filename) {
   return ConvertToTriMesh(shape);
 }
 
-Handle(TDocStd_Document) LoadStepDocument(const std::filesystem::path& filename) {
+Handle(TDocStd_Document) LoadStepDocument(
+    const std::filesystem::path& filename,
+    const Message_ProgressRange& progress) {
   Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
   Handle(TDocStd_Document) document;
   app->NewDocument("MDTV-XCAF", document);
@@ -64,7 +102,7 @@ Handle(TDocStd_Document) LoadStepDocument(const std::filesystem::path& filename)
     return Handle(TDocStd_Document)();
   }
 
-  if (!reader.Transfer(document)) {
+  if (!reader.Transfer(document, progress) || progress.UserBreak()) {
     return Handle(TDocStd_Document)();
   }
 
@@ -78,7 +116,8 @@ Handle(Poly_Triangulation) LoadStl(const std::filesystem::path& filename) {
   return tr;
 }
 
-Handle(TDocStd_Document) LoadIges(const std::filesystem::path& filename) {
+Handle(TDocStd_Document) LoadIges(const std::filesystem::path& filename,
+                                  const Message_ProgressRange& progress) {
   Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
   Handle(TDocStd_Document) document;
   app->NewDocument("MDTV-XCAF",document);
@@ -91,7 +130,7 @@ Handle(TDocStd_Document) LoadIges(const std::filesystem::path& filename) {
     return Handle(TDocStd_Document)();
   }
 
-  if (!reader.Transfer(document)) {
+  if (!reader.Transfer(document, progress) || progress.UserBreak()) {
     return Handle(TDocStd_Document)();
   }
 
@@ -105,12 +144,14 @@ Handle(Poly_Triangulation) LoadObj(const std::filesystem::path& filename) {
 }
 
 #ifdef NUMGEOM_OCC_LOAD_VRML
-Handle(TDocStd_Document) LoadVrml(const std::filesystem::path& filename) {
+Handle(TDocStd_Document) LoadVrml(const std::filesystem::path& filename,
+                                  const Message_ProgressRange& progress) {
   Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
   Handle(TDocStd_Document) document;
   app->NewDocument("MDTV-XCAF", document);
   DEVRML_Provider provider;
-  if (!provider.Read(filename.c_str(),document)) {
+  if (!provider.Read(filename.c_str(), document, progress) ||
+      progress.UserBreak()) {
     return Handle(TDocStd_Document)();
   }
   //Vrml_Provider provider;
@@ -121,16 +162,63 @@ Handle(TDocStd_Document) LoadVrml(const std::filesystem::path& filename) {
 }
 #endif
 
-Handle(TDocStd_Document) LoadGltf(const std::filesystem::path& filename) {
+Handle(TDocStd_Document) LoadGltf(const std::filesystem::path& filename,
+                                  const Message_ProgressRange& progress) {
   Handle(XCAFApp_Application) app = XCAFApp_Application::GetApplication();
   Handle(TDocStd_Document) document;
   app->NewDocument("MDTV-XCAF", document);
   RWGltf_CafReader reader;
   reader.SetDocument(document);
-  Message_ProgressRange msg;
   TCollection_AsciiString occ_filename(filename.c_str());
-  if (!reader.Perform(occ_filename,msg)) {
+  if (!reader.Perform(occ_filename, progress) || progress.UserBreak()) {
     return Handle(TDocStd_Document)();
   }
   return document;
 }
+
+bool MeshDocument(const Handle(TDocStd_Document)& document,
+                  LoadProgress& progress) {
+  std::vector<TopoDS_Shape> shapes;
+  TDF_LabelSequence free_shape_labels;
+  auto shape_tool = XCAFDoc_DocumentTool::ShapeTool(document->Main());
+  shape_tool->GetFreeShapes(free_shape_labels);
+  for (const TDF_Label& lbl : free_shape_labels)
+    ExtractTriangulableShapes(shape_tool->GetShape(lbl), shapes);
+  return TriangulateShapes(shapes, MeshParameters(), &progress);
+}
+
+Handle(TDocStd_Document) LoadDocument(const std::filesystem::path& filename,
+                                      LoadProgress& progress) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(filename, ec);
+  if (ec) return Handle(TDocStd_Document)();
+  progress.SetTotalBytes(static_cast<size_t>(size));
+
+  Handle(ProgressIndicator) indicator = new ProgressIndicator(progress);
+  std::string ext = LowerExtension(filename);
+  Handle(TDocStd_Document) document;
+  if (ext == ".step" || ext == ".stp")
+    document = LoadStepDocument(filename, indicator->Start());
+  else if (ext == ".iges" || ext == ".igs")
+    document = LoadIges(filename, indicator->Start());
+#ifdef NUMGEOM_OCC_LOAD_VRML
+  else if (ext == ".wrl" || ext == ".vrml")
+    document = LoadVrml(filename, indicator->Start());
+#endif
+  else if (ext == ".glb" || ext == ".gltf")
+    document = LoadGltf(filename, indicator->Start());
+  if (!document) return document;
+  progress.SetParsedBytes(progress.TotalBytes());
+
+  if (!MeshDocument(document, progress)) return Handle(TDocStd_Document)();
+  return document;
+}
+
+AsyncLoad<Handle(TDocStd_Document)> LoadDocumentAsync(
+    const std::filesystem::path& filename, LoadProgress::Callback callback) {
+  return LoadAsync<Handle(TDocStd_Document)>(
+      [filename](LoadProgress& progress) {
+        return LoadDocument(filename, progress);
+      },
+      std::move(callback));
+}
@@ -1,25 +1,88 @@
 ﻿#include "numgeom/octree.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <map>
-#include <set>
-#include <queue>
-#include <stack>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <variant>
 #include <vector>
 
 #include "nlohmann/json.hpp"
 using json = nlohmann::json;
 
+#include "binarystream.h"
 #include "iterator_ijk.h"
+#include "numgeom/classificate.h"
+#include "numgeom/parallelfor.h"
+#include "numgeom/trimesh.h"
+#include "numgeom/utilities.h"
+#include "trianglebvh.h"
+
+namespace {
+;
+//! Сигнатура и версия двоичного формата дерева.
+const char kBinaryMagic[4] = {'N', 'G', 'O', 'T'};
+const uint32_t kBinaryVersion = 1;
+
+static_assert(sizeof(size_t) == sizeof(uint64_t),
+              "атрибуты ячеек хранятся в двоичном формате как uint64_t");
+
+//! Наибольшее число ячеек нулевого уровня вдоль стороны дерева, строящегося
+//! по поверхности.
+const Standard_Integer kMaxRootCells = 16;
+}  // namespace
 
 struct OcTree::Internal {
   Bnd_Box boundBox;
   Standard_Integer nbByI, nbByJ, nbByK;
   //! Номера нетерминальных ячеек на уровне.
   std::vector<std::vector<uint32_t>> nonTerminalCells;
-  //! Атрибуты ячеек.
-  std::vector<std::map<Standard_Integer, size_t>> attrs;
+  //! Порядковые номера первых дочерних ячеек для нетерминальных ячеек уровня
+  //! в том же порядке, что и в `nonTerminalCells`. Дочерние ячейки получают
+  //! номера подряд в порядке `GetChildCell`.
+  std::vector<std::vector<uint32_t>> firstChildOrdinals;
+  //! Число пронумерованных ячеек.
+  size_t nbOrdinals = 0;
+  //! Атрибуты ячеек по порядковым номерам.
+  std::vector<size_t> attrs;
+
+  template <typename T>
+  struct TypedChannel {
+    std::vector<T> values;
+    T defaultValue;
+  };
+  typedef std::variant<TypedChannel<int>, TypedChannel<float>,
+                       TypedChannel<double>>
+      Channel;
+  //! Каналы атрибутов ячеек по порядковым номерам.
+  std::vector<Channel> channels;
+
+  //! Таблица соседей терминальных ячеек: строка ячейки с порядковым номером
+  //! `r` занимает диапазон [neighbourOffsets[r], neighbourOffsets[r + 1]).
+  //! Пустая, если таблица не построена.
+  std::vector<size_t> neighbourOffsets;
+  std::vector<Cell> neighbourCells;
+  std::vector<CellConnection> neighbourConnections;
+
+  //! Число терминальных ячеек.
+  size_t nbTerminalCells = 0;
+
+  //! Терминальные ячейки в порядке обхода `TerminalCells()`, их порядковые
+  //! номера и номера терминальных ячеек по порядковым номерам ячеек.
+  //! Строятся по запросу и сбрасываются при делении ячеек.
+  mutable std::vector<Cell> terminalCells;
+  mutable std::vector<size_t> terminalCellOrdinals;
+  mutable std::vector<size_t> terminalIndices;
+  mutable std::atomic<bool> hasTerminalIndex{false};
+  mutable std::mutex terminalIndexMutex;
 
   Standard_Integer Levels() const;
 
@@ -30,8 +93,61 @@ struct OcTree::Internal {
 
   Standard_Integer GetOrder(const Cell&) const;
 
+  //! Порядковый номер ячейки или `NoOrdinal`, если ячейки нет.
+  size_t GetOrdinal(const Cell&) const;
+
+  //! Нумерует ячейки заново, например, после загрузки дерева.
+  void NumberCells();
+
+  //! Дополняет атрибуты и каналы до числа пронумерованных ячеек.
+  void ResizeAttrs();
+
+  //! Сбрасывает таблицу соседей после изменения структуры дерева.
+  void ClearNeighbours();
+
+  //! Строит нумерацию терминальных ячеек, если она сброшена. Может
+  //! вызываться из нескольких потоков одновременно.
+  void UpdateTerminalIndex() const;
+
+  //! Перебирает все ячейки дерева вместе с их порядковыми номерами.
+  void ForEachCell(
+      const std::function<void(const Cell&, size_t ordinal)>& fn) const;
+
+  //! Порядковые номера ячеек в порядке обхода `ForEachCell`.
+  std::vector<size_t> TraversalOrder() const;
+
+  //! Записывает дерево в двоичном формате.
+  void SaveBinary(std::ostream&) const;
+
+  //! Читает дерево в двоичном формате; при ошибке возвращает пустой указатель.
+  static OcTree::Ptr LoadBinary(std::istream&);
+
+  template <typename T>
+  Standard_Boolean LoadChannel(std::istream&);
+
   Cell GetChildCell(const Cell& parentCell, Standard_Integer childIndex) const;
 
+  void GetCellBox(const Cell& cell, Standard_Real& xMin, Standard_Real& yMin,
+                  Standard_Real& zMin, Standard_Real& xMax, Standard_Real& yMax,
+                  Standard_Real& zMax) const;
+
+  //! Строит уровни дерева, деля ячейки, пересекающие треугольники, и
+  //! балансирует его. Дерево должно состоять из одного уровня.
+  void Refine(const TriangleBVH& bvh, Standard_Integer maxLevel,
+              const SizeField& cellSize);
+
+  //! Добавляет в `splits` ячейки, которые нужно разделить, чтобы уровни
+  //! соседних терминальных ячеек отличались не более чем на единицу.
+  void Balance(std::vector<std::vector<uint32_t>>& splits) const;
+
+  //! Записывает в атрибуты терминальных ячеек значения `CellPosition`.
+  //! Функция `classify` определяет состояния центров ячеек, не пересекающих
+  //! треугольники.
+  void MarkPositions(
+      const TriangleBVH& bvh,
+      const std::function<std::vector<TopAbs_State>(std::span<const gp_Pnt>)>&
+          classify);
+
   void GetCellsOfNextLevel(const Cell& parentCell,
                            std::array<Standard_Integer, 8>& cells) const;
 
@@ -84,6 +200,241 @@ Standard_Integer OcTree::Internal::GetOrder(const Cell& cell) const {
   return s_cellOrder[b3 ? 0 : 1][b2 ? 0 : 1][b1 ? 0 : 1];
 }
 
+size_t OcTree::Internal::GetOrdinal(const Cell& cell) const {
+  if (cell.level < 0 || cell.level >= this->Levels()) return NoOrdinal;
+  if (cell.index < 0 || cell.index >= this->GetNbCellsOnLevel(cell.level))
+    return NoOrdinal;
+  if (cell.level == 0) return cell.index;
+
+  Cell parentCell = this->GetParentCell(cell);
+  const auto& ntCells = nonTerminalCells[parentCell.level];
+  // Номер родителя неотрицателен: ячейка проверена выше.
+  const uint32_t parentIndex = static_cast<uint32_t>(parentCell.index);
+  auto it = std::lower_bound(ntCells.begin(), ntCells.end(), parentIndex);
+  if (it == ntCells.end() || *it != parentIndex) return NoOrdinal;
+  const auto& ordinals = firstChildOrdinals[parentCell.level];
+  return ordinals[it - ntCells.begin()] + this->GetOrder(cell);
+}
+
+void OcTree::Internal::NumberCells() {
+  nbOrdinals = this->GetNbCellsOnLevel(0);
+  firstChildOrdinals.resize(nonTerminalCells.size());
+  for (size_t level = 0; level < nonTerminalCells.size(); ++level) {
+    auto& ordinals = firstChildOrdinals[level];
+    ordinals.resize(nonTerminalCells[level].size());
+    for (uint32_t& ordinal : ordinals) {
+      ordinal = static_cast<uint32_t>(nbOrdinals);
+      nbOrdinals += 8;
+    }
+  }
+  nbTerminalCells = nbOrdinals;
+  for (const auto& ntCells : nonTerminalCells)
+    nbTerminalCells -= ntCells.size();
+  this->ClearNeighbours();
+  hasTerminalIndex = false;
+  this->ResizeAttrs();
+}
+
+void OcTree::Internal::ClearNeighbours() {
+  neighbourOffsets.clear();
+  neighbourCells.clear();
+  neighbourConnections.clear();
+}
+
+void OcTree::Internal::UpdateTerminalIndex() const {
+  if (hasTerminalIndex.load(std::memory_order_acquire)) return;
+  std::lock_guard<std::mutex> lock(terminalIndexMutex);
+  if (hasTerminalIndex.load(std::memory_order_relaxed)) return;
+
+  terminalCells.clear();
+  terminalCells.reserve(nbTerminalCells);
+  terminalCellOrdinals.clear();
+  terminalCellOrdinals.reserve(nbTerminalCells);
+  terminalIndices.assign(nbOrdinals, NoOrdinal);
+  // Обход заканчивается ячейкой нулевого уровня за последней.
+  Cell end(0, this->GetNbCellsOnLevel(0));
+  for (Cell cell = this->GetFirstTerminalCell(Cell(0, 0)); cell != end;
+       cell = this->Next(cell)) {
+    size_t ordinal = this->GetOrdinal(cell);
+    terminalIndices[ordinal] = terminalCells.size();
+    terminalCells.push_back(cell);
+    terminalCellOrdinals.push_back(ordinal);
+  }
+  hasTerminalIndex.store(true, std::memory_order_release);
+}
+
+void OcTree::Internal::ResizeAttrs() {
+  attrs.resize(nbOrdinals, 0);
+  for (Channel& channel : channels) {
+    std::visit(
+        [this](auto& typed) {
+          typed.values.resize(nbOrdinals, typed.defaultValue);
+        },
+        channel);
+  }
+}
+
+void OcTree::Internal::ForEachCell(
+    const std::function<void(const Cell&, size_t ordinal)>& fn) const {
+  Standard_Integer nc = this->GetNbCellsOnLevel(0);
+  for (Standard_Integer index = 0; index < nc; ++index)
+    fn(Cell(0, index), index);
+  for (size_t level = 0; level < nonTerminalCells.size(); ++level) {
+    const auto& ntCells = nonTerminalCells[level];
+    for (size_t r = 0; r < ntCells.size(); ++r) {
+      Cell parentCell(static_cast<Standard_Integer>(level), ntCells[r]);
+      for (Standard_Integer c = 0; c < 8; ++c)
+        fn(this->GetChildCell(parentCell, c), firstChildOrdinals[level][r] + c);
+    }
+  }
+}
+
+std::vector<size_t> OcTree::Internal::TraversalOrder() const {
+  std::vector<size_t> order;
+  order.reserve(nbOrdinals);
+  this->ForEachCell(
+      [&order](const Cell&, size_t ordinal) { order.push_back(ordinal); });
+  return order;
+}
+
+void OcTree::Internal::SaveBinary(std::ostream& stream) const {
+  WriteValue(stream, kBinaryMagic);
+  WriteValue(stream, kBinaryVersion);
+  Standard_Real box[6];
+  boundBox.Get(box[0], box[1], box[2], box[3], box[4], box[5]);
+  WriteValue(stream, box);
+  WriteValue(stream, static_cast<int32_t>(nbByI));
+  WriteValue(stream, static_cast<int32_t>(nbByJ));
+  WriteValue(stream, static_cast<int32_t>(nbByK));
+
+  WriteValue(stream, static_cast<uint32_t>(nonTerminalCells.size()));
+  for (const auto& ntCells : nonTerminalCells) {
+    WriteValue(stream, static_cast<uint64_t>(ntCells.size()));
+    WriteValues(stream, std::span<const uint32_t>(ntCells));
+  }
+
+  // Атрибуты пишутся в порядке обхода ячеек: после загрузки он совпадает с
+  // порядковыми номерами ячеек, и блоки читаются без перестановок.
+  std::vector<size_t> order = this->TraversalOrder();
+  WriteValue(stream, static_cast<uint64_t>(order.size()));
+  WriteValuesInOrder(stream, std::span<const size_t>(attrs), order);
+
+  // Тип канала записывается номером альтернативы в `Channel`.
+  WriteValue(stream, static_cast<uint32_t>(channels.size()));
+  for (const Channel& channel : channels) {
+    WriteValue(stream, static_cast<uint8_t>(channel.index()));
+    std::visit(
+        [&](const auto& typed) {
+          typedef std::decay_t<decltype(typed.defaultValue)> T;
+          WriteValue(stream, typed.defaultValue);
+          WriteValuesInOrder(stream, std::span<const T>(typed.values), order);
+        },
+        channel);
+  }
+}
+
+template <typename T>
+Standard_Boolean OcTree::Internal::LoadChannel(std::istream& stream) {
+  TypedChannel<T> channel;
+  if (!ReadValue(stream, channel.defaultValue)) return Standard_False;
+  if (!ReadValues(stream, nbOrdinals, channel.values)) return Standard_False;
+  channels.push_back(std::move(channel));
+  return Standard_True;
+}
+
+OcTree::Ptr OcTree::Internal::LoadBinary(std::istream& stream) {
+  char magic[4];
+  uint32_t version;
+  if (!ReadValue(stream, magic) || std::memcmp(magic, kBinaryMagic, 4) != 0 ||
+      !ReadValue(stream, version) || version != kBinaryVersion)
+    return OcTree::Ptr();
+
+  Standard_Real box[6];
+  int32_t in, jn, kn;
+  if (!ReadValue(stream, box) || !ReadValue(stream, in) ||
+      !ReadValue(stream, jn) || !ReadValue(stream, kn))
+    return OcTree::Ptr();
+
+  // Номера ячеек нулевого уровня должны помещаться в `Standard_Integer`, а
+  // их атрибуты записаны в потоке, поэтому число ячеек ограничено и его
+  // размером.
+  const uint64_t maxCells = std::numeric_limits<Standard_Integer>::max();
+  if (in < 1 || jn < 1 || kn < 1 ||
+      static_cast<uint64_t>(in) * jn > maxCells)
+    return OcTree::Ptr();
+  uint64_t nbCellsOnLevel = static_cast<uint64_t>(in) * jn * kn;
+  if (nbCellsOnLevel > maxCells ||
+      !HasValues<uint64_t>(stream, nbCellsOnLevel))
+    return OcTree::Ptr();
+
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(box[0], box[1], box[2]));
+  boundBox.Add(gp_Pnt(box[3], box[4], box[5]));
+  OcTree::Ptr tree = OcTree::Create(boundBox, in, jn, kn);
+  if (!tree) return tree;
+  Internal* data = tree->pimpl;
+
+  // Номера ячеек уровня должны возрастать, не выходить за пределы уровня и
+  // принадлежать дочерним ячейкам нетерминальных ячеек предыдущего уровня.
+  uint64_t nbOrdinals = nbCellsOnLevel;
+  uint32_t nbLevels;
+  if (!ReadValue(stream, nbLevels)) return OcTree::Ptr();
+  for (uint32_t level = 0; level < nbLevels; ++level) {
+    uint64_t count;
+    if (!ReadValue(stream, count) || count == 0 || count > nbCellsOnLevel)
+      return OcTree::Ptr();
+    auto& ntCells = data->nonTerminalCells.emplace_back();
+    if (!ReadValues(stream, count, ntCells)) return OcTree::Ptr();
+    for (size_t r = 0; r < ntCells.size(); ++r) {
+      if (ntCells[r] >= nbCellsOnLevel ||
+          (r > 0 && ntCells[r] <= ntCells[r - 1]))
+        return OcTree::Ptr();
+      if (level == 0) continue;
+      Cell parentCell =
+          data->GetParentCell(Cell(static_cast<Standard_Integer>(level),
+                                   static_cast<Standard_Integer>(ntCells[r])));
+      const auto& parents = data->nonTerminalCells[level - 1];
+      if (!std::binary_search(parents.begin(), parents.end(),
+                              static_cast<uint32_t>(parentCell.index)))
+        return OcTree::Ptr();
+    }
+    nbOrdinals += 8 * ntCells.size();
+    nbCellsOnLevel *= 8;
+    if (nbCellsOnLevel > maxCells) return OcTree::Ptr();
+  }
+
+  // Атрибуты читаются до нумерации ячеек, которая выделяет под них память.
+  uint64_t nbCells;
+  std::vector<size_t> attrs;
+  if (!ReadValue(stream, nbCells) || nbCells != nbOrdinals ||
+      !ReadValues(stream, nbCells, attrs))
+    return OcTree::Ptr();
+  data->NumberCells();
+  data->attrs = std::move(attrs);
+
+  uint32_t nbChannels;
+  if (!ReadValue(stream, nbChannels)) return OcTree::Ptr();
+  for (uint32_t channel = 0; channel < nbChannels; ++channel) {
+    uint8_t type;
+    if (!ReadValue(stream, type)) return OcTree::Ptr();
+    Standard_Boolean isRead = Standard_False;
+    switch (type) {
+      case 0:
+        isRead = data->LoadChannel<int>(stream);
+        break;
+      case 1:
+        isRead = data->LoadChannel<float>(stream);
+        break;
+      case 2:
+        isRead = data->LoadChannel<double>(stream);
+        break;
+    }
+    if (!isRead) return OcTree::Ptr();
+  }
+
+  return tree;
+}
+
 OcTree::Cell OcTree::Internal::GetChildCell(const Cell& parentCell,
                                             Standard_Integer childIndex) const {
   assert(childIndex >= 0 && childIndex < 8);
@@ -164,20 +515,21 @@ OcTree::Cell OcTree::Internal::GetParentCell(const Cell& cell) const {
 
 Standard_Boolean OcTree::Internal::IsExists(const Cell& cell) const {
   Standard_Integer nbLevels = this->Levels();
-  if (cell.level >= nbLevels) return Standard_False;
+  if (cell.level < 0 || cell.level >= nbLevels) return Standard_False;
 
   // Ячейка существует тогда, когда в подложке есть ячейка с таким номером и
   // ячейка входит в нулевой уровень или если нет, то ее родитель в списке
   // нетерминальных.
 
   Standard_Integer nc = this->GetNbCellsOnLevel(cell.level);
-  if (cell.index >= nc) return Standard_False;
+  if (cell.index < 0 || cell.index >= nc) return Standard_False;
 
   if (cell.level == 0) return Standard_True;
 
   Cell parentCell = this->GetParentCell(cell);
   const auto& ntCells = nonTerminalCells[parentCell.level];
-  return std::binary_search(ntCells.begin(), ntCells.end(), parentCell.index);
+  return std::binary_search(ntCells.begin(), ntCells.end(),
+                            static_cast<uint32_t>(parentCell.index));
 }
 
 OcTree::Cell OcTree::Internal::GetFirstTerminalCell(
@@ -305,7 +657,8 @@ OcTree::OcTree(const Bnd_Box& boundBox, Standard_Integer in,
   pimpl->nbByJ = jn;
   pimpl->nbByK = kn;
   pimpl->nonTerminalCells.reserve(32);
-  pimpl->attrs.reserve(32);
+  pimpl->firstChildOrdinals.reserve(32);
+  pimpl->NumberCells();
 }
 
 OcTree::~OcTree() { delete pimpl; }
@@ -318,55 +671,24 @@ void OcTree::GetBox(Standard_Real& xMin, Standard_Real& yMin,
   pimpl->boundBox.Get(xMin, yMin, zMin, xMax, yMax, zMax);
 }
 
-namespace {
-;
-Standard_Integer CellsCount(const OcTree::Internal* oTreeInternal,
-                            const OcTree::Cell& parentCell) {
-  typedef OcTree::Cell Cell;
-
-  Standard_Integer nbCells = 0;
-  std::stack<Cell> stack;
-  stack.push(parentCell);
-  while (!stack.empty()) {
-    Cell cell = stack.top();
-    stack.pop();
-
-    Standard_Boolean isTerminalCell = Standard_True;
-    if (cell.level < oTreeInternal->nonTerminalCells.size()) {
-      const auto& ntCells = oTreeInternal->nonTerminalCells[cell.level];
-      if (std::binary_search(ntCells.begin(), ntCells.end(), cell.index))
-        isTerminalCell = Standard_False;
-    }
+Standard_Integer OcTree::NbCells() const {
+  return static_cast<Standard_Integer>(pimpl->nbTerminalCells);
+}
 
-    if (isTerminalCell) {
-      ++nbCells;
-      continue;
-    }
+size_t OcTree::NbTerminalCells() const { return pimpl->nbTerminalCells; }
 
-    std::array<Standard_Integer, 8> nextCellsIndex;
-    oTreeInternal->GetCellsOfNextLevel(cell, nextCellsIndex);
-    stack.push(Cell{cell.level + 1, nextCellsIndex[0]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[1]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[2]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[3]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[4]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[5]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[6]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[7]});
-  }
-
-  return nbCells;
+Standard_Integer OcTree::NbTerminalCells(Standard_Integer level) const {
+  if (level < 0 || level >= pimpl->Levels()) return 0;
+  Standard_Integer nbCells =
+      level == 0 ? pimpl->GetNbCellsOnLevel(0)
+                 : 8 * static_cast<Standard_Integer>(
+                           pimpl->nonTerminalCells[level - 1].size());
+  return nbCells - this->NbNonTerminalCells(level);
 }
-}  // namespace
 
-Standard_Integer OcTree::NbCells() const {
-  Standard_Integer nbCells = 0;
-  Standard_Integer nbCellsOnLevel0 = pimpl->nbByI * pimpl->nbByJ * pimpl->nbByK;
-  for (Standard_Integer i = 0; i < nbCellsOnLevel0; ++i) {
-    Cell cell{0, i};
-    nbCells += CellsCount(pimpl, cell);
-  }
-  return nbCells;
+Standard_Integer OcTree::NbNonTerminalCells(Standard_Integer level) const {
+  if (level < 0 || level >= pimpl->nonTerminalCells.size()) return 0;
+  return static_cast<Standard_Integer>(pimpl->nonTerminalCells[level].size());
 }
 
 namespace {
@@ -417,6 +739,18 @@ Iterator<OcTree::Cell> OcTree::TerminalCells() const {
   return Iterator<Cell>(itImpl);
 }
 
+std::span<const OcTree::Cell> OcTree::TerminalCellsArray() const {
+  pimpl->UpdateTerminalIndex();
+  return pimpl->terminalCells;
+}
+
+size_t OcTree::GetTerminalOrdinal(const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (ordinal == NoOrdinal) return NoOrdinal;
+  pimpl->UpdateTerminalIndex();
+  return pimpl->terminalIndices[ordinal];
+}
+
 namespace {
 ;
 class IteratorImpl_OcTreeCellsOfLevel : public IteratorImpl<OcTree::Cell> {
@@ -672,14 +1006,108 @@ Iterator<OcTree::Cell> OcTree::ConnectedCells(const Cell& cell) const {
   return Iterator<Cell>(itImpl);
 }
 
+void OcTree::BuildNeighbours() {
+  std::vector<std::pair<Cell, size_t>> terminalCells;
+  pimpl->ForEachCell([this, &terminalCells](const Cell& cell, size_t ordinal) {
+    if (pimpl->IsTerminal(cell)) terminalCells.emplace_back(cell, ordinal);
+  });
+
+  // Строки блока ячеек собираются отдельно и затем копируются на свои места.
+  struct Block {
+    size_t begin;
+    std::vector<size_t> rowSizes;
+    std::vector<Cell> cells;
+  };
+  std::vector<Block> blocks;
+  std::mutex blocksMutex;
+  ParallelFor(
+      terminalCells.size(),
+      [&](size_t begin, size_t end) {
+        Block block{begin, {}, {}};
+        block.rowSizes.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+          size_t rowBegin = block.cells.size();
+          for (Cell other : this->ConnectedCells(terminalCells[i].first))
+            block.cells.push_back(other);
+          // Итератор пропускает только идущие подряд повторы.
+          auto row = block.cells.begin() + rowBegin;
+          std::sort(row, block.cells.end());
+          block.cells.erase(std::unique(row, block.cells.end()),
+                            block.cells.end());
+          block.rowSizes.push_back(block.cells.size() - rowBegin);
+        }
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        blocks.push_back(std::move(block));
+      },
+      256);
+
+  std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  offsets.assign(pimpl->nbOrdinals + 1, 0);
+  for (const Block& block : blocks) {
+    for (size_t r = 0; r < block.rowSizes.size(); ++r)
+      offsets[terminalCells[block.begin + r].second + 1] = block.rowSizes[r];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  std::vector<Cell>& cells = pimpl->neighbourCells;
+  std::vector<CellConnection>& connections = pimpl->neighbourConnections;
+  cells.resize(offsets.back());
+  connections.resize(offsets.back());
+  ParallelFor(
+      blocks.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+          const Block& block = blocks[b];
+          auto src = block.cells.begin();
+          for (size_t r = 0; r < block.rowSizes.size(); ++r) {
+            const auto& [cell, ordinal] = terminalCells[block.begin + r];
+            for (size_t k = offsets[ordinal]; k < offsets[ordinal + 1];
+                 ++k, ++src) {
+              cells[k] = *src;
+              connections[k] = this->GetConnectionType(cell, *src);
+            }
+          }
+        }
+      },
+      1);
+}
+
+Standard_Boolean OcTree::HasNeighbours() const {
+  return !pimpl->neighbourOffsets.empty();
+}
+
+std::span<const OcTree::Cell> OcTree::Neighbours(const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (!this->HasNeighbours() || ordinal == NoOrdinal) return {};
+  const std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  return std::span<const Cell>(pimpl->neighbourCells)
+      .subspan(offsets[ordinal], offsets[ordinal + 1] - offsets[ordinal]);
+}
+
+std::span<const OcTree::CellConnection> OcTree::NeighbourConnections(
+    const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (!this->HasNeighbours() || ordinal == NoOrdinal) return {};
+  const std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  return std::span<const CellConnection>(pimpl->neighbourConnections)
+      .subspan(offsets[ordinal], offsets[ordinal + 1] - offsets[ordinal]);
+}
+
 void OcTree::GetCellBox(const Cell& cell, Standard_Real& xMin,
                         Standard_Real& yMin, Standard_Real& zMin,
                         Standard_Real& xMax, Standard_Real& yMax,
                         Standard_Real& zMax) const {
+  pimpl->GetCellBox(cell, xMin, yMin, zMin, xMax, yMax, zMax);
+}
+
+void OcTree::Internal::GetCellBox(const Cell& cell, Standard_Real& xMin,
+                                  Standard_Real& yMin, Standard_Real& zMin,
+                                  Standard_Real& xMax, Standard_Real& yMax,
+                                  Standard_Real& zMax) const {
   Standard_Real xMinBox, yMinBox, zMinBox, xMaxBox, yMaxBox, zMaxBox;
-  Ijk n = pimpl->LevelSize(cell.level);
-  Ijk c = pimpl->GetCellCoords(cell);
-  pimpl->boundBox.Get(xMinBox, yMinBox, zMinBox, xMaxBox, yMaxBox, zMaxBox);
+  Ijk n = this->LevelSize(cell.level);
+  Ijk c = this->GetCellCoords(cell);
+  boundBox.Get(xMinBox, yMinBox, zMinBox, xMaxBox, yMaxBox, zMaxBox);
   xMin = xMinBox + (xMaxBox - xMinBox) / n.i * c.i;
   xMax = xMinBox + (xMaxBox - xMinBox) / n.i * (c.i + 1);
   yMin = yMinBox + (yMaxBox - yMinBox) / n.j * c.j;
@@ -732,6 +1160,15 @@ Ijk OcTree::CellsNumberOnLevel(Standard_Integer level) const {
   return pimpl->LevelSize(level);
 }
 
+Standard_Boolean OcTree::IsTerminal(const Cell& cell) const {
+  return pimpl->IsTerminal(cell);
+}
+
+OcTree::Cell OcTree::GetChildCell(const Cell& cell,
+                                  Standard_Integer childIndex) const {
+  return pimpl->GetChildCell(cell, childIndex);
+}
+
 void OcTree::Split(const Cell& cell) {
   size_t N = pimpl->nonTerminalCells.size();
   assert(cell.level <= N);
@@ -744,6 +1181,7 @@ void OcTree::Split(const Cell& cell) {
 
   if (cell.level == N) {
     pimpl->nonTerminalCells.push_back({});
+    pimpl->firstChildOrdinals.push_back({});
     auto& ntCells = pimpl->nonTerminalCells.back();
     Standard_Integer nc = pimpl->GetNbCellsOnLevel(cell.level);
     ntCells.reserve(std::min(32, nc));
@@ -751,7 +1189,19 @@ void OcTree::Split(const Cell& cell) {
 
   auto& ntCells = pimpl->nonTerminalCells[cell.level];
   auto it = std::lower_bound(ntCells.begin(), ntCells.end(), cell.index);
-  if (it == ntCells.end() || *it != cell.index) ntCells.insert(it, cell.index);
+  if (it != ntCells.end() && *it == cell.index) return;
+
+  // Дочерние ячейки получают номера в конце, так что номера имеющихся ячеек
+  // и их атрибуты сохраняются.
+  auto& ordinals = pimpl->firstChildOrdinals[cell.level];
+  ordinals.insert(ordinals.begin() + (it - ntCells.begin()),
+                  static_cast<uint32_t>(pimpl->nbOrdinals));
+  ntCells.insert(it, cell.index);
+  pimpl->nbOrdinals += 8;
+  pimpl->nbTerminalCells += 7;
+  pimpl->ResizeAttrs();
+  pimpl->ClearNeighbours();
+  pimpl->hasTerminalIndex = false;
 }
 
 Ijk OcTree::GetCellCoords(const Cell& cell) const {
@@ -784,22 +1234,100 @@ OcTree::Cell OcTree::GetCell(const gp_Pnt& Q) const {
 }
 
 size_t OcTree::GetAttr(const Cell& cell) const {
-  if (cell.level >= pimpl->attrs.size()) return 0;
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (ordinal == NoOrdinal) return 0;
+  return pimpl->attrs[ordinal];
+}
+
+void OcTree::SetAttr(const Cell& cell, size_t attr) {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal != NoOrdinal);
+  if (ordinal != NoOrdinal) pimpl->attrs[ordinal] = attr;
+}
 
-  const auto& map = pimpl->attrs[cell.level];
-  auto it = map.find(cell.index);
-  if (it == map.end()) return 0;
-  return it->second;
+size_t OcTree::GetOrdinal(const Cell& cell) const {
+  return pimpl->GetOrdinal(cell);
 }
 
-void OcTree::SetAttr(const Cell& cell, size_t attr) const {
-  assert(cell.level < this->Levels());
-  while (cell.level >= pimpl->attrs.size()) pimpl->attrs.push_back({});
+size_t OcTree::NbOrdinals() const { return pimpl->nbOrdinals; }
 
-  auto& map = pimpl->attrs[cell.level];
-  map[cell.index] = attr;
+template <typename T>
+size_t OcTree::AddChannel(T defaultValue) {
+  Internal::TypedChannel<T> channel;
+  channel.values.assign(pimpl->nbOrdinals, defaultValue);
+  channel.defaultValue = defaultValue;
+  pimpl->channels.push_back(std::move(channel));
+  return pimpl->channels.size() - 1;
 }
 
+template <typename T>
+std::span<T> OcTree::GetChannel(size_t channel) {
+  assert(channel < pimpl->channels.size());
+  if (channel >= pimpl->channels.size()) return {};
+  auto typed =
+      std::get_if<Internal::TypedChannel<T>>(&pimpl->channels[channel]);
+  if (!typed) return {};
+  return typed->values;
+}
+
+template <typename T>
+std::span<const T> OcTree::GetChannel(size_t channel) const {
+  return const_cast<OcTree*>(this)->GetChannel<T>(channel);
+}
+
+template <typename T>
+T OcTree::GetValue(size_t channel, const Cell& cell) const {
+  std::span<const T> values = this->GetChannel<T>(channel);
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal < values.size());
+  if (ordinal >= values.size()) return T();
+  return values[ordinal];
+}
+
+template <typename T>
+void OcTree::SetValue(size_t channel, const Cell& cell, T value) {
+  std::span<T> values = this->GetChannel<T>(channel);
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal < values.size());
+  if (ordinal < values.size()) values[ordinal] = value;
+}
+
+template <typename T>
+void OcTree::GetValues(size_t channel, std::vector<T>& values) const {
+  std::span<const T> data = this->GetChannel<T>(channel);
+  values.clear();
+  if (data.empty()) return;
+  pimpl->UpdateTerminalIndex();
+  values.reserve(pimpl->nbTerminalCells);
+  for (size_t ordinal : pimpl->terminalCellOrdinals)
+    values.push_back(data[ordinal]);
+}
+
+template <typename T>
+void OcTree::SetValues(size_t channel, std::span<const T> values) {
+  std::span<T> data = this->GetChannel<T>(channel);
+  if (data.empty()) return;
+  pimpl->UpdateTerminalIndex();
+  const std::vector<size_t>& ordinals = pimpl->terminalCellOrdinals;
+  assert(values.size() >= ordinals.size());
+  size_t n = std::min(values.size(), ordinals.size());
+  for (size_t i = 0; i < n; ++i) data[ordinals[i]] = values[i];
+}
+
+#define INSTANTIATE_CHANNEL(T)                                          \
+  template size_t OcTree::AddChannel<T>(T);                               \
+  template std::span<T> OcTree::GetChannel<T>(size_t);                   \
+  template std::span<const T> OcTree::GetChannel<T>(size_t) const;       \
+  template T OcTree::GetValue<T>(size_t, const Cell&) const;             \
+  template void OcTree::SetValue<T>(size_t, const Cell&, T);             \
+  template void OcTree::GetValues<T>(size_t, std::vector<T>&) const;     \
+  template void OcTree::SetValues<T>(size_t, std::span<const T>);
+
+INSTANTIATE_CHANNEL(int)
+INSTANTIATE_CHANNEL(float)
+INSTANTIATE_CHANNEL(double)
+#undef INSTANTIATE_CHANNEL
+
 Standard_Boolean OcTree::Equals(OcTree::CPtr other) const {
   std::array<Standard_Real, 6> bbCoords;
   pimpl->boundBox.Get(bbCoords[0], bbCoords[1], bbCoords[2], bbCoords[3],
@@ -825,7 +1353,12 @@ Standard_Boolean OcTree::Equals(OcTree::CPtr other) const {
   return Standard_True;
 }
 
-void OcTree::Serialize(std::ostream& stream) const {
+void OcTree::Serialize(std::ostream& stream, Format format) const {
+  if (format == Format::Binary) {
+    pimpl->SaveBinary(stream);
+    return;
+  }
+
   json data;
   Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
   pimpl->boundBox.Get(xMin, yMin, zMin, xMax, yMax, zMax);
@@ -833,12 +1366,23 @@ void OcTree::Serialize(std::ostream& stream) const {
   data["ZeroLevelCellsNumbers"] = {pimpl->nbByI, pimpl->nbByJ, pimpl->nbByK};
   data["NonTerminalCells"] = pimpl->nonTerminalCells;
 
-  if (!pimpl->attrs.empty()) data["Attrs"] = pimpl->attrs;
+  std::vector<std::map<Standard_Integer, size_t>> attrs;
+  pimpl->ForEachCell([&](const Cell& cell, size_t ordinal) {
+    size_t attr = pimpl->attrs[ordinal];
+    if (attr == 0) return;
+    if (attrs.size() <= cell.level) attrs.resize(cell.level + 1);
+    attrs[cell.level][cell.index] = attr;
+  });
+  if (!attrs.empty()) data["Attrs"] = attrs;
 
   stream << data << std::endl;
 }
 
 OcTree::Ptr OcTree::Deserialize(std::istream& stream) {
+  // Двоичный формат распознается по сигнатуре: текст JSON с буквы 'N'
+  // начинаться не может.
+  if (stream.peek() == kBinaryMagic[0]) return Internal::LoadBinary(stream);
+
   json data = json::parse(stream);
 
   Bnd_Box boundBox;
@@ -875,10 +1419,18 @@ OcTree::Ptr OcTree::Deserialize(std::istream& stream) {
         jNonTerminalCells.get<std::vector<std::vector<uint32_t>>>();
   }
 
+  oTree->pimpl->NumberCells();
+
   const json& jAttrs = data["Attrs"];
   if (!jAttrs.empty()) {
-    oTree->pimpl->attrs =
-        jAttrs.get<std::vector<std::map<Standard_Integer, size_t>>>();
+    auto attrs = jAttrs.get<std::vector<std::map<Standard_Integer, size_t>>>();
+    for (size_t level = 0; level < attrs.size(); ++level) {
+      for (const auto& [index, attr] : attrs[level]) {
+        Cell cell(static_cast<Standard_Integer>(level), index);
+        size_t ordinal = oTree->pimpl->GetOrdinal(cell);
+        if (ordinal != NoOrdinal) oTree->pimpl->attrs[ordinal] = attr;
+      }
+    }
   }
 
   return oTree;
@@ -891,6 +1443,237 @@ OcTree::Ptr OcTree::Create(const Bnd_Box& boundBox, Standard_Integer in,
   return Ptr(new OcTree(boundBox, in, jn, kn));
 }
 
+void OcTree::Internal::Refine(const TriangleBVH& bvh,
+                              Standard_Integer maxLevel,
+                              const SizeField& cellSize) {
+  // Номера ячеек уровня должны помещаться в `Standard_Integer`.
+  int64_t nbRootCells = this->GetNbCellsOnLevel(0);
+  while (maxLevel > 0 &&
+         (3 * maxLevel >= 31 || nbRootCells << 3 * maxLevel > INT_MAX))
+    --maxLevel;
+
+  std::vector<std::vector<uint32_t>> splits;
+  std::vector<uint32_t> cells(this->GetNbCellsOnLevel(0));
+  std::iota(cells.begin(), cells.end(), 0);
+  for (Standard_Integer level = 0; level < maxLevel && !cells.empty();
+       ++level) {
+    std::vector<char> isSplit(cells.size(), 0);
+    ParallelFor(
+        cells.size(),
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            Cell cell(level, static_cast<Standard_Integer>(cells[i]));
+            Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+            this->GetCellBox(cell, xMin, yMin, zMin, xMax, yMax, zMax);
+            if (!bvh.Intersects(glm::dvec3(xMin, yMin, zMin),
+                                glm::dvec3(xMax, yMax, zMax)))
+              continue;
+            if (cellSize) {
+              gp_Pnt center(0.5 * (xMin + xMax), 0.5 * (yMin + yMax),
+                            0.5 * (zMin + zMax));
+              Standard_Real size =
+                  std::max({xMax - xMin, yMax - yMin, zMax - zMin});
+              if (size <= cellSize(center)) continue;
+            }
+            isSplit[i] = 1;
+          }
+        },
+        64);
+
+    std::vector<uint32_t>& ntCells = splits.emplace_back();
+    for (size_t i = 0; i < cells.size(); ++i) {
+      if (isSplit[i]) ntCells.push_back(cells[i]);
+    }
+    std::sort(ntCells.begin(), ntCells.end());
+
+    cells.clear();
+    std::array<Standard_Integer, 8> children;
+    for (uint32_t index : ntCells) {
+      this->GetCellsOfNextLevel(Cell(level, index), children);
+      cells.insert(cells.end(), children.begin(), children.end());
+    }
+  }
+
+  this->Balance(splits);
+  while (!splits.empty() && splits.back().empty()) splits.pop_back();
+  nonTerminalCells = std::move(splits);
+  this->NumberCells();
+}
+
+void OcTree::Internal::Balance(
+    std::vector<std::vector<uint32_t>>& splits) const {
+  // Нетерминальная ячейка уровня `level` требует, чтобы существовали все ее
+  // соседи того же уровня, то есть чтобы их родители были нетерминальными.
+  // Уровни обходятся снизу вверх, так что добавленные ячейки сами
+  // учитываются на следующем шаге.
+  for (size_t level = splits.size(); level-- > 1;) {
+    const std::vector<uint32_t>& cells = splits[level];
+    Ijk n = this->LevelSize(static_cast<Standard_Integer>(level));
+    Ijk np = this->LevelSize(static_cast<Standard_Integer>(level) - 1);
+    std::vector<std::pair<size_t, std::vector<uint32_t>>> blocks;
+    std::mutex blocksMutex;
+    ParallelFor(
+        cells.size(),
+        [&](size_t begin, size_t end) {
+          std::vector<uint32_t> parents;
+          for (size_t r = begin; r < end; ++r) {
+            Ijk c = Ijk::Coords(static_cast<Standard_Integer>(cells[r]), n);
+            for (Standard_Integer dk = -1; dk <= 1; ++dk) {
+              for (Standard_Integer dj = -1; dj <= 1; ++dj) {
+                for (Standard_Integer di = -1; di <= 1; ++di) {
+                  Ijk nb(c.i + di, c.j + dj, c.k + dk);
+                  if (nb.i < 0 || nb.j < 0 || nb.k < 0 || nb.i >= n.i ||
+                      nb.j >= n.j || nb.k >= n.k)
+                    continue;
+                  parents.push_back(Ijk::Index(nb / 2, np));
+                }
+              }
+            }
+          }
+          std::lock_guard<std::mutex> lock(blocksMutex);
+          blocks.emplace_back(begin, std::move(parents));
+        },
+        1 << 10);
+
+    std::vector<uint32_t>& parentCells = splits[level - 1];
+    for (const auto& block : blocks)
+      parentCells.insert(parentCells.end(), block.second.begin(),
+                         block.second.end());
+    std::sort(parentCells.begin(), parentCells.end());
+    parentCells.erase(std::unique(parentCells.begin(), parentCells.end()),
+                      parentCells.end());
+  }
+}
+
+void OcTree::Internal::MarkPositions(
+    const TriangleBVH& bvh,
+    const std::function<std::vector<TopAbs_State>(std::span<const gp_Pnt>)>&
+        classify) {
+  std::vector<std::pair<Cell, size_t>> terminalCells;
+  this->ForEachCell([&](const Cell& cell, size_t ordinal) {
+    if (this->IsTerminal(cell)) terminalCells.emplace_back(cell, ordinal);
+  });
+
+  std::vector<char> isBoundary(terminalCells.size(), 0);
+  ParallelFor(
+      terminalCells.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+          this->GetCellBox(terminalCells[i].first, xMin, yMin, zMin, xMax,
+                           yMax, zMax);
+          isBoundary[i] = bvh.Intersects(glm::dvec3(xMin, yMin, zMin),
+                                         glm::dvec3(xMax, yMax, zMax));
+        }
+      },
+      64);
+
+  std::vector<size_t> innerCandidates;
+  std::vector<gp_Pnt> centers;
+  for (size_t i = 0; i < terminalCells.size(); ++i) {
+    size_t ordinal = terminalCells[i].second;
+    if (isBoundary[i]) {
+      attrs[ordinal] = BoundaryCell;
+      continue;
+    }
+    attrs[ordinal] = OuterCell;
+    Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+    this->GetCellBox(terminalCells[i].first, xMin, yMin, zMin, xMax, yMax,
+                     zMax);
+    innerCandidates.push_back(ordinal);
+    centers.emplace_back(0.5 * (xMin + xMax), 0.5 * (yMin + yMax),
+                         0.5 * (zMin + zMax));
+  }
+
+  std::vector<TopAbs_State> states = classify(centers);
+  for (size_t i = 0; i < innerCandidates.size(); ++i) {
+    if (states[i] == TopAbs_IN) attrs[innerCandidates[i]] = InnerCell;
+  }
+}
+
+namespace {
+;
+//! Дерево из кубических ячеек нулевого уровня, покрывающих сетку с запасом.
+OcTree::Ptr CreateRootGrid(const TriangleBVH& bvh) {
+  if (bvh.NbTriangles() == 0) return OcTree::Ptr();
+
+  glm::dvec3 min, max;
+  bvh.GetBox(min, max);
+  glm::dvec3 extent = max - min;
+  Standard_Real maxExtent = std::max({extent.x, extent.y, extent.z});
+  if (!(maxExtent > 0.0)) return OcTree::Ptr();
+
+  Standard_Real margin = 1.e-3 * maxExtent;
+  Standard_Real minExtent = std::min({extent.x, extent.y, extent.z});
+  Standard_Real h = std::max(maxExtent / kMaxRootCells, minExtent) + 2 * margin;
+  Standard_Integer n[3];
+  Bnd_Box box;
+  for (int i = 0; i < 3; ++i) {
+    n[i] = std::max(1, static_cast<Standard_Integer>(
+                           std::ceil((extent[i] + 2 * margin) / h)));
+    Standard_Real center = 0.5 * (min[i] + max[i]);
+    Standard_Real half = 0.5 * n[i] * h;
+    min[i] = center - half;
+    max[i] = center + half;
+  }
+  box.Update(min.x, min.y, min.z, max.x, max.y, max.z);
+  return OcTree::Create(box, n[0], n[1], n[2]);
+}
+}  // namespace
+
+OcTree::Ptr OcTree::Create(const CTriMesh& mesh, Standard_Integer maxLevel,
+                           const SizeField& cellSize) {
+  TriangleBVH bvh(mesh);
+  OcTree::Ptr tree = CreateRootGrid(bvh);
+  if (!tree || maxLevel < 0) return OcTree::Ptr();
+
+  tree->pimpl->Refine(bvh, maxLevel, cellSize);
+
+  // Луч из центра ячейки, не пересекающей сетку, не может пройти через ее
+  // ребро вблизи начала, а вырожденные пересечения вдали обходятся сменой
+  // направления: кроме трех основных перебираются запасные направления, так
+  // что ячейка не остается внешней лишь из-за неудачных лучей.
+  auto classify = [&bvh](std::span<const gp_Pnt> points) {
+    std::vector<TopAbs_State> states(points.size(), TopAbs_OUT);
+    ParallelFor(
+        points.size(),
+        [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            glm::dvec3 p(points[i].X(), points[i].Y(), points[i].Z());
+            bool isInside;
+            if (bvh.ClassifyByParity(p, isInside) && isInside)
+              states[i] = TopAbs_IN;
+          }
+        },
+        1 << 10);
+    return states;
+  };
+  tree->pimpl->MarkPositions(bvh, classify);
+  return tree;
+}
+
+OcTree::Ptr OcTree::Create(const TopoDS_Shape& solid,
+                           Standard_Integer maxLevel,
+                           const SizeField& cellSize,
+                           const MeshParameters& params) {
+  TriMesh::Ptr mesh = ConvertToTriMesh(solid, params);
+  if (!mesh) return OcTree::Ptr();
+
+  TriangleBVH bvh(*mesh);
+  OcTree::Ptr tree = CreateRootGrid(bvh);
+  if (!tree || maxLevel < 0) return OcTree::Ptr();
+
+  tree->pimpl->Refine(bvh, maxLevel, cellSize);
+
+  // Классификатор использует ту же сетку, так что тело триангулируется
+  // один раз.
+  SolidClassifier classifier(solid, *mesh);
+  tree->pimpl->MarkPositions(bvh, [&classifier](std::span<const gp_Pnt> pts) {
+    return classifier.Classify(pts);
+  });
+  return tree;
+}
+
 namespace {
 ;
 OcTree::Cell GetParentCell(OcTree::Internal* qTreeIntenal,
@@ -997,11 +1780,13 @@ void OcTree::GetMinMaxDistances(const gp_Pnt& q, const Cell& cell,
     return;
   }
 
-  Standard_Real dxMin = std::min(std::abs(xQ - xMin), std::abs(xQ - xMax));
+  // Вдоль оси, на проекцию ячейки на которую попадает точка, наименьшее
+  // расстояние нулевое.
+  Standard_Real dxMin = std::max({xMin - xQ, xQ - xMax, 0.0});
   Standard_Real dxMax = std::max(std::abs(xQ - xMin), std::abs(xQ - xMax));
-  Standard_Real dyMin = std::min(std::abs(yQ - yMin), std::abs(yQ - yMax));
+  Standard_Real dyMin = std::max({yMin - yQ, yQ - yMax, 0.0});
   Standard_Real dyMax = std::max(std::abs(yQ - yMin), std::abs(yQ - yMax));
-  Standard_Real dzMin = std::min(std::abs(zQ - zMin), std::abs(zQ - zMax));
+  Standard_Real dzMin = std::max({zMin - zQ, zQ - zMax, 0.0});
   Standard_Real dzMax = std::max(std::abs(zQ - zMin), std::abs(zQ - zMax));
 
   minDistance = std::sqrt(dxMin * dxMin + dyMin * dyMin + dzMin * dzMin);
@@ -1016,33 +1801,51 @@ gp_Pnt OcTree::GetCenter(const Cell& cell) const {
 
 namespace {
 ;
-
-struct CellWithDistances {
+//! Ячейка дерева и наименьшее расстояние от искомой точки до нее.
+struct CellDistance {
   OcTree::Cell cell;
-  Standard_Real mn;
-  Standard_Real mx;
-
-  CellWithDistances(OcTree::CPtr tree, const OcTree::Cell& c, const gp_Pnt& q)
-      : cell(c) {
-    tree->GetMinMaxDistances(q, cell, mn, mx);
-  }
+  Standard_Real distance;
 
-  Standard_Boolean operator<(const CellWithDistances& other) const {
-    assert(cell != other.cell);
-    return mn < other.mn;
+  //! Порядок для кучи `std::push_heap`: на вершине ближайшая ячейка.
+  Standard_Boolean operator<(const CellDistance& other) const {
+    if (distance != other.distance) return distance > other.distance;
+    return other.cell < cell;
   }
 };
 
-void PushNonVisitedCellsToQueue(OcTree::CPtr tree,
-                                const OcTree::Cell& startCell, const gp_Pnt& Q,
-                                std::set<OcTree::Cell>& visited,
-                                std::priority_queue<CellWithDistances>& queue) {
-  for (OcTree::Cell cell : tree->ConnectedCells(startCell)) {
-    if (!visited.insert(cell).second) continue;
-
-    gp_Pnt C = tree->GetCenter(cell);
-    Standard_Real d = C.Distance(Q);
-    queue.push(CellWithDistances(tree, cell, Q));
+//! Обход дерева в порядке удаления ячеек от точки `Q`, см. одноименную
+//! функцию квадродерева.
+void SearchBestFirst(
+    const OcTree::CPtr& tree, const gp_Pnt& Q,
+    const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
+        isTaggedCell,
+    size_t k, Standard_Real maximumDistance, std::vector<CellDistance>& heap,
+    std::vector<OcTree::Cell>& nearestCells) {
+  nearestCells.clear();
+  heap.clear();
+  if (!tree || k == 0) return;
+
+  auto push = [&](const OcTree::Cell& cell) {
+    Standard_Real dMin, dMax;
+    tree->GetMinMaxDistances(Q, cell, dMin, dMax);
+    if (dMin > maximumDistance) return;
+    heap.push_back({cell, dMin});
+    std::push_heap(heap.begin(), heap.end());
+  };
+
+  Ijk n = tree->CellsNumberOnLevel(0);
+  for (Standard_Integer index = 0; index < n.i * n.j * n.k; ++index)
+    push(OcTree::Cell(0, index));
+
+  while (!heap.empty() && nearestCells.size() < k) {
+    std::pop_heap(heap.begin(), heap.end());
+    OcTree::Cell cell = heap.back().cell;
+    heap.pop_back();
+    if (!tree->IsTerminal(cell)) {
+      for (Standard_Integer c = 0; c < 8; ++c)
+        push(tree->GetChildCell(cell, c));
+    } else if (isTaggedCell(tree, cell))
+      nearestCells.push_back(cell);
   }
 }
 }  // namespace
@@ -1052,38 +1855,35 @@ void SearchNearestCells(
     const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
         isTaggedCell,
     Standard_Real maximumDistance, std::list<OcTree::Cell>& nearestCells) {
-  nearestCells.clear();
-
-  if (!tree) return;
-
-  OcTree::Cell initCell = tree->GetCell(Q);
-  if (isTaggedCell(tree, initCell)) {
-    nearestCells.push_back(initCell);
-    return;
-  }
-
-  std::vector<CellWithDistances> result;
-  std::set<OcTree::Cell> visited;
-  std::priority_queue<CellWithDistances> queue;
-  visited.insert(initCell);
-  PushNonVisitedCellsToQueue(tree, initCell, Q, visited, queue);
-
-  while (!queue.empty()) {
-    CellWithDistances cwd = queue.top();
-    queue.pop();
-
-    OcTree::Cell cell = cwd.cell;
-
-    if (!isTaggedCell(tree, cell)) {
-      PushNonVisitedCellsToQueue(tree, cell, Q, visited, queue);
-      continue;
-    }
-
-    if (cwd.mn > maximumDistance) continue;
+  std::vector<CellDistance> heap;
+  std::vector<OcTree::Cell> cells;
+  SearchBestFirst(tree, Q, isTaggedCell, std::numeric_limits<size_t>::max(),
+                  maximumDistance, heap, cells);
+  nearestCells.assign(cells.begin(), cells.end());
+}
 
-    result.push_back(cwd);
-  }
+void SearchKNearestCells(
+    OcTree::CPtr tree, const gp_Pnt& Q,
+    const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
+        isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<OcTree::Cell>& nearestCells) {
+  std::vector<CellDistance> heap;
+  SearchBestFirst(tree, Q, isTaggedCell, k, maximumDistance, heap,
+                  nearestCells);
+}
 
-  std::sort(result.begin(), result.end());
-  for (const auto& r : result) nearestCells.push_back(r.cell);
+void SearchKNearestCells(
+    OcTree::CPtr tree, std::span<const gp_Pnt> points,
+    const std::function<Standard_Boolean(OcTree::CPtr, const OcTree::Cell&)>&
+        isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<std::vector<OcTree::Cell>>& nearestCells) {
+  nearestCells.resize(points.size());
+  ParallelFor(points.size(), [&](size_t iBegin, size_t iEnd) {
+    std::vector<CellDistance> heap;
+    for (size_t i = iBegin; i < iEnd; ++i)
+      SearchBestFirst(tree, points[i], isTaggedCell, k, maximumDistance, heap,
+                      nearestCells[i]);
+  });
 }
@@ -0,0 +1,366 @@
+#include "numgeom/projectors.h"
+
+#include <Extrema_ExtPC2d.hxx>
+#include <Extrema_GenLocateExtPS.hxx>
+#include <Extrema_LocateExtPC.hxx>
+#include <Extrema_LocateExtPC2d.hxx>
+#include <Extrema_POnCurv.hxx>
+#include <Extrema_POnCurv2d.hxx>
+#include <Extrema_POnSurf.hxx>
+#include <Geom2dAdaptor_Curve.hxx>
+#include <GeomAPI_ProjectPointOnCurve.hxx>
+#include <GeomAPI_ProjectPointOnSurf.hxx>
+#include <GeomAdaptor_Curve.hxx>
+#include <GeomAdaptor_Surface.hxx>
+#include <Precision.hxx>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+
+#include "numgeom/parallelfor.h"
+
+namespace {
+;
+
+//! Число точек грубой выборки кривой и поверхности (по каждому параметру).
+const int kNbCurveSamples = 64;
+const int kNbSurfaceSamples = 16;
+
+//! Лежит ли параметр строго внутри отрезка; периодический параметр границ
+//! не имеет.
+bool IsInside(Standard_Real t, Standard_Real t0, Standard_Real t1,
+              bool isPeriodic) {
+  return isPeriodic || (t > t0 + Precision::PConfusion() &&
+                        t < t1 - Precision::PConfusion());
+}
+
+//! Точки кривой с равным шагом по параметру; для бесконечной кривой выборка
+//! пуста.
+template <typename Curve, typename Point>
+void SampleCurve(const Curve& C, Standard_Real u0, Standard_Real u1,
+                 std::vector<Point>& samples) {
+  if (Precision::IsInfinite(u0) || Precision::IsInfinite(u1)) return;
+  for (int i = 0; i <= kNbCurveSamples; ++i)
+    samples.push_back(C->Value(u0 + (u1 - u0) * i / kNbCurveSamples));
+}
+
+//! Квадрат расстояния до ближайшей точки выборки или `HUGE_VAL`, если
+//! выборка пуста.
+template <typename Point>
+Standard_Real SquareDistanceToSamples(const std::vector<Point>& samples,
+                                      const Point& P) {
+  Standard_Real sqDist = HUGE_VAL;
+  for (const Point& S : samples)
+    sqDist = std::min(sqDist, P.SquareDistance(S));
+  return sqDist;
+}
+}  // namespace
+
+struct CurveProjector2d::Internal {
+  typedef gp_Pnt2d Point;
+  typedef Standard_Real Param;
+
+  Handle(Geom2d_Curve) curve;
+  Geom2dAdaptor_Curve adaptor;
+  Extrema_ExtPC2d extrema;
+  Extrema_LocateExtPC2d locator;
+  Standard_Real u0, u1;
+  std::vector<Point> samples;
+
+  explicit Internal(const Handle(Geom2d_Curve) & C)
+      : curve(C), adaptor(C) {
+    u0 = C->FirstParameter(), u1 = C->LastParameter();
+    extrema.Initialize(adaptor, u0, u1);
+    locator.Initialize(adaptor, u0, u1, Precision::PConfusion());
+    SampleCurve(C, u0, u1, samples);
+  }
+
+  bool IsInterior(Param u) const {
+    return IsInside(u, u0, u1, curve->IsPeriodic());
+  }
+
+  std::unique_ptr<Internal> Clone() const {
+    return std::make_unique<Internal>(
+        Handle(Geom2d_Curve)::DownCast(curve->Copy()));
+  }
+
+  static Param Undefined() { return HUGE_VAL; }
+
+  bool Global(const Point& P, Param& u, Standard_Real& sqDist) {
+    extrema.Perform(P);
+    if (!extrema.IsDone()) return false;
+    bool found = false;
+    for (Standard_Integer i = 1; i <= extrema.NbExt(); ++i) {
+      Standard_Real d = extrema.SquareDistance(i);
+      if (found && d >= sqDist) continue;
+      found = true;
+      sqDist = d;
+      u = extrema.Point(i).Parameter();
+    }
+    return found;
+  }
+
+  bool Local(const Point& P, Param guess, Param& u, Standard_Real& sqDist) {
+    locator.Perform(P, guess);
+    if (!locator.IsDone() || !locator.IsMin()) return false;
+    sqDist = locator.SquareDistance();
+    u = locator.Point().Parameter();
+    return true;
+  }
+};
+
+struct CurveProjector::Internal {
+  typedef gp_Pnt Point;
+  typedef Standard_Real Param;
+
+  Handle(Geom_Curve) curve;
+  GeomAPI_ProjectPointOnCurve projector;
+  GeomAdaptor_Curve adaptor;
+  Extrema_LocateExtPC locator;
+
+  Standard_Real u0, u1;
+  std::vector<Point> samples;
+
+  explicit Internal(const Handle(Geom_Curve) & C) : curve(C), adaptor(C) {
+    u0 = C->FirstParameter(), u1 = C->LastParameter();
+    projector.Init(C, u0, u1);
+    locator.Initialize(adaptor, u0, u1, Precision::PConfusion());
+    SampleCurve(C, u0, u1, samples);
+  }
+
+  bool IsInterior(Param u) const {
+    return IsInside(u, u0, u1, curve->IsPeriodic());
+  }
+
+  std::unique_ptr<Internal> Clone() const {
+    return std::make_unique<Internal>(
+        Handle(Geom_Curve)::DownCast(curve->Copy()));
+  }
+
+  static Param Undefined() { return HUGE_VAL; }
+
+  bool Global(const Point& P, Param& u, Standard_Real& sqDist) {
+    projector.Perform(P);
+    if (projector.NbPoints() == 0) return false;
+    u = projector.LowerDistanceParameter();
+    Standard_Real d = projector.LowerDistance();
+    sqDist = d * d;
+    return true;
+  }
+
+  bool Local(const Point& P, Param guess, Param& u, Standard_Real& sqDist) {
+    locator.Perform(P, guess);
+    if (!locator.IsDone() || !locator.IsMin()) return false;
+    sqDist = locator.SquareDistance();
+    u = locator.Point().Parameter();
+    return true;
+  }
+};
+
+struct SurfaceProjector::Internal {
+  typedef gp_Pnt Point;
+  typedef gp_Pnt2d Param;
+
+  Handle(Geom_Surface) surface;
+  GeomAPI_ProjectPointOnSurf projector;
+  GeomAdaptor_Surface adaptor;
+  Extrema_GenLocateExtPS locator;
+
+  Standard_Real u0, u1, v0, v1;
+  std::vector<Point> samples;
+
+  explicit Internal(const Handle(Geom_Surface) & S)
+      : surface(S), adaptor(S), locator(adaptor) {
+    S->Bounds(u0, u1, v0, v1);
+    projector.Init(S, u0, u1, v0, v1);
+    if (Precision::IsInfinite(u0) || Precision::IsInfinite(u1) ||
+        Precision::IsInfinite(v0) || Precision::IsInfinite(v1))
+      return;
+    for (int i = 0; i <= kNbSurfaceSamples; ++i) {
+      for (int j = 0; j <= kNbSurfaceSamples; ++j) {
+        samples.push_back(S->Value(u0 + (u1 - u0) * i / kNbSurfaceSamples,
+                                   v0 + (v1 - v0) * j / kNbSurfaceSamples));
+      }
+    }
+  }
+
+  bool IsInterior(const Param& uv) const {
+    return IsInside(uv.X(), u0, u1, surface->IsUPeriodic()) &&
+           IsInside(uv.Y(), v0, v1, surface->IsVPeriodic());
+  }
+
+  std::unique_ptr<Internal> Clone() const {
+    return std::make_unique<Internal>(
+        Handle(Geom_Surface)::DownCast(surface->Copy()));
+  }
+
+  static Param Undefined() { return gp_Pnt2d(HUGE_VAL, HUGE_VAL); }
+
+  bool Global(const Point& P, Param& uv, Standard_Real& sqDist) {
+    projector.Perform(P);
+    if (projector.NbPoints() == 0) return false;
+    Standard_Real u, v;
+    projector.LowerDistanceParameters(u, v);
+    uv.SetCoord(u, v);
+    Standard_Real d = projector.LowerDistance();
+    sqDist = d * d;
+    return true;
+  }
+
+  bool Local(const Point& P, const Param& guess, Param& uv,
+             Standard_Real& sqDist) {
+    // Критерий расстояния ищет минимум, а не произвольный экстремум.
+    locator.Perform(P, guess.X(), guess.Y(), Standard_True);
+    if (!locator.IsDone()) return false;
+    sqDist = locator.SquareDistance();
+    Standard_Real u, v;
+    locator.Point().Parameter(u, v);
+    uv.SetCoord(u, v);
+    return true;
+  }
+};
+
+namespace {
+;
+
+template <typename Internal>
+typename Internal::Param ProjectGlobal(Internal& projector,
+                                       const typename Internal::Point& P) {
+  typename Internal::Param param;
+  Standard_Real sqDist;
+  if (!projector.Global(P, param, sqDist)) return Internal::Undefined();
+  return param;
+}
+
+template <typename Internal>
+typename Internal::Param ProjectNear(Internal& projector,
+                                     const typename Internal::Point& P,
+                                     const typename Internal::Param& guess) {
+  typename Internal::Param param;
+  Standard_Real sqDist;
+  if (projector.Local(P, guess, param, sqDist)) return param;
+  return ProjectGlobal(projector, P);
+}
+
+//! Пакетная проекция с копией проектора на каждый блок точек. Решение для
+//! предыдущей точки блока служит начальным приближением для следующей.
+//!
+//! Локальный минимум принимается, если его основание лежит внутри области
+//! параметров (там минимум ортогонален геометрии, что и проверяет локальный
+//! поиск) и он не дальше ближайшей точки грубой выборки геометрии, то есть
+//! оценки сверху расстояния до ближайшей точки. Настоящий минимум эту
+//! проверку проходит всегда, а посторонний - только если он ближе всех точек
+//! выборки, т.е. почти так же близок, как ближайший.
+template <typename Internal>
+std::vector<typename Internal::Param> ProjectPoints(
+    const Internal& prototype, std::span<const typename Internal::Point> points,
+    size_t* nbLocal) {
+  typedef typename Internal::Point Point;
+  typedef typename Internal::Param Param;
+  std::vector<Param> params(points.size(), Internal::Undefined());
+  std::atomic<size_t> nbAccepted(0);
+  ParallelFor(
+      points.size(),
+      [&](size_t begin, size_t end) {
+        std::unique_ptr<Internal> projector = prototype.Clone();
+        bool hasPrev = false;
+        Param prevParam = Internal::Undefined();
+        size_t nbBlockAccepted = 0;
+        for (size_t i = begin; i < end; ++i) {
+          const Point& P = points[i];
+          Param param;
+          Standard_Real sqDist;
+          bool isDone = false;
+          if (hasPrev && !projector->samples.empty() &&
+              projector->Local(P, prevParam, param, sqDist) &&
+              projector->IsInterior(param)) {
+            Standard_Real bound =
+                SquareDistanceToSamples(projector->samples, P);
+            isDone = std::sqrt(sqDist) <=
+                     std::sqrt(bound) + Precision::Confusion();
+            if (isDone) ++nbBlockAccepted;
+          }
+          if (!isDone) isDone = projector->Global(P, param, sqDist);
+          hasPrev = isDone;
+          if (!isDone) continue;
+          params[i] = param;
+          prevParam = param;
+        }
+        nbAccepted += nbBlockAccepted;
+      },
+      256);
+  if (nbLocal) *nbLocal = nbAccepted;
+  return params;
+}
+}  // namespace
+
+CurveProjector2d::CurveProjector2d(const Handle(Geom2d_Curve) & curve) {
+  pimpl = new Internal(curve);
+}
+
+CurveProjector2d::~CurveProjector2d() { delete pimpl; }
+
+const Handle(Geom2d_Curve) & CurveProjector2d::Curve() const {
+  return pimpl->curve;
+}
+
+Standard_Real CurveProjector2d::Project(const gp_Pnt2d& P) {
+  return ProjectGlobal(*pimpl, P);
+}
+
+Standard_Real CurveProjector2d::Project(const gp_Pnt2d& P,
+                                        Standard_Real guess) {
+  return ProjectNear(*pimpl, P, guess);
+}
+
+std::vector<Standard_Real> CurveProjector2d::Project(
+    std::span<const gp_Pnt2d> points, size_t* nbLocal) const {
+  return ProjectPoints(*pimpl, points, nbLocal);
+}
+
+CurveProjector::CurveProjector(const Handle(Geom_Curve) & curve) {
+  pimpl = new Internal(curve);
+}
+
+CurveProjector::~CurveProjector() { delete pimpl; }
+
+const Handle(Geom_Curve) & CurveProjector::Curve() const {
+  return pimpl->curve;
+}
+
+Standard_Real CurveProjector::Project(const gp_Pnt& P) {
+  return ProjectGlobal(*pimpl, P);
+}
+
+Standard_Real CurveProjector::Project(const gp_Pnt& P, Standard_Real guess) {
+  return ProjectNear(*pimpl, P, guess);
+}
+
+std::vector<Standard_Real> CurveProjector::Project(
+    std::span<const gp_Pnt> points, size_t* nbLocal) const {
+  return ProjectPoints(*pimpl, points, nbLocal);
+}
+
+SurfaceProjector::SurfaceProjector(const Handle(Geom_Surface) & surface) {
+  pimpl = new Internal(surface);
+}
+
+SurfaceProjector::~SurfaceProjector() { delete pimpl; }
+
+const Handle(Geom_Surface) & SurfaceProjector::Surface() const {
+  return pimpl->surface;
+}
+
+gp_Pnt2d SurfaceProjector::Project(const gp_Pnt& P) {
+  return ProjectGlobal(*pimpl, P);
+}
+
+gp_Pnt2d SurfaceProjector::Project(const gp_Pnt& P, const gp_Pnt2d& guess) {
+  return ProjectNear(*pimpl, P, guess);
+}
+
+std::vector<gp_Pnt2d> SurfaceProjector::Project(
+    std::span<const gp_Pnt> points, size_t* nbLocal) const {
+  return ProjectPoints(*pimpl, points, nbLocal);
+}
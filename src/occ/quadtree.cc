@@ -1,23 +1,77 @@
 ﻿#include "numgeom/quadtree.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <limits>
 #include <map>
-#include <set>
-#include <queue>
-#include <stack>
+#include <mutex>
+#include <numeric>
+#include <span>
+#include <variant>
 #include <vector>
 
 #include "nlohmann/json.hpp"
 using json = nlohmann::json;
 
+#include "binarystream.h"
+#include "numgeom/parallelfor.h"
+
+namespace {
+;
+//! Сигнатура и версия двоичного формата дерева.
+const char kBinaryMagic[4] = {'N', 'G', 'Q', 'T'};
+const uint32_t kBinaryVersion = 1;
+
+static_assert(sizeof(size_t) == sizeof(uint64_t),
+              "атрибуты ячеек хранятся в двоичном формате как uint64_t");
+}  // namespace
+
 struct QuadTree::Internal {
   Bnd_Box2d boundBox;
   Standard_Integer nbByI, nbByJ;
   //! Номера нетерминальных ячеек на уровне.
   std::vector<std::vector<uint32_t>> nonTerminalCells;
-  //! Атрибуты ячеек.
-  std::vector<std::map<Standard_Integer, size_t>> attrs;
+  //! Порядковые номера первых дочерних ячеек для нетерминальных ячеек уровня
+  //! в том же порядке, что и в `nonTerminalCells`. Дочерние ячейки получают
+  //! номера подряд в порядке `GetChildCell`.
+  std::vector<std::vector<uint32_t>> firstChildOrdinals;
+  //! Число пронумерованных ячеек.
+  size_t nbOrdinals = 0;
+  //! Атрибуты ячеек по порядковым номерам.
+  std::vector<size_t> attrs;
+
+  template <typename T>
+  struct TypedChannel {
+    std::vector<T> values;
+    T defaultValue;
+  };
+  typedef std::variant<TypedChannel<int>, TypedChannel<float>,
+                       TypedChannel<double>>
+      Channel;
+  //! Каналы атрибутов ячеек по порядковым номерам.
+  std::vector<Channel> channels;
+
+  //! Таблица соседей терминальных ячеек: строка ячейки с порядковым номером
+  //! `r` занимает диапазон [neighbourOffsets[r], neighbourOffsets[r + 1]).
+  //! Пустая, если таблица не построена.
+  std::vector<size_t> neighbourOffsets;
+  std::vector<Cell> neighbourCells;
+  std::vector<CellConnection> neighbourConnections;
+
+  //! Число терминальных ячеек.
+  size_t nbTerminalCells = 0;
+
+  //! Терминальные ячейки в порядке обхода `TerminalCells()`, их порядковые
+  //! номера и номера терминальных ячеек по порядковым номерам ячеек.
+  //! Строятся по запросу и сбрасываются при делении ячеек.
+  mutable std::vector<Cell> terminalCells;
+  mutable std::vector<size_t> terminalCellOrdinals;
+  mutable std::vector<size_t> terminalIndices;
+  mutable std::atomic<bool> hasTerminalIndex{false};
+  mutable std::mutex terminalIndexMutex;
 
   Standard_Integer Levels() const;
 
@@ -28,6 +82,38 @@ struct QuadTree::Internal {
 
   Standard_Integer GetOrder(const Cell&) const;
 
+  //! Порядковый номер ячейки или `NoOrdinal`, если ячейки нет.
+  size_t GetOrdinal(const Cell&) const;
+
+  //! Нумерует ячейки заново, например, после загрузки дерева.
+  void NumberCells();
+
+  //! Дополняет атрибуты и каналы до числа пронумерованных ячеек.
+  void ResizeAttrs();
+
+  //! Сбрасывает таблицу соседей после изменения структуры дерева.
+  void ClearNeighbours();
+
+  //! Строит нумерацию терминальных ячеек, если она сброшена. Может
+  //! вызываться из нескольких потоков одновременно.
+  void UpdateTerminalIndex() const;
+
+  //! Перебирает все ячейки дерева вместе с их порядковыми номерами.
+  void ForEachCell(
+      const std::function<void(const Cell&, size_t ordinal)>& fn) const;
+
+  //! Порядковые номера ячеек в порядке обхода `ForEachCell`.
+  std::vector<size_t> TraversalOrder() const;
+
+  //! Записывает дерево в двоичном формате.
+  void SaveBinary(std::ostream&) const;
+
+  //! Читает дерево в двоичном формате; при ошибке возвращает пустой указатель.
+  static QuadTree::Ptr LoadBinary(std::istream&);
+
+  template <typename T>
+  Standard_Boolean LoadChannel(std::istream&);
+
   Cell GetChildCell(const Cell& parentCell, Standard_Integer childIndex) const;
 
   void GetCellsOfNextLevel(const Cell& parentCell,
@@ -86,6 +172,238 @@ Standard_Integer QuadTree::Internal::GetOrder(const Cell& cell) const {
   return 3;
 }
 
+size_t QuadTree::Internal::GetOrdinal(const Cell& cell) const {
+  if (cell.level < 0 || cell.level >= this->Levels()) return NoOrdinal;
+  if (cell.index < 0 || cell.index >= this->GetNbCellsOnLevel(cell.level))
+    return NoOrdinal;
+  if (cell.level == 0) return cell.index;
+
+  Cell parentCell = this->GetParentCell(cell);
+  const auto& ntCells = nonTerminalCells[parentCell.level];
+  // Номер родителя неотрицателен: ячейка проверена выше.
+  const uint32_t parentIndex = static_cast<uint32_t>(parentCell.index);
+  auto it = std::lower_bound(ntCells.begin(), ntCells.end(), parentIndex);
+  if (it == ntCells.end() || *it != parentIndex) return NoOrdinal;
+  const auto& ordinals = firstChildOrdinals[parentCell.level];
+  return ordinals[it - ntCells.begin()] + this->GetOrder(cell);
+}
+
+void QuadTree::Internal::NumberCells() {
+  nbOrdinals = this->GetNbCellsOnLevel(0);
+  firstChildOrdinals.resize(nonTerminalCells.size());
+  for (size_t level = 0; level < nonTerminalCells.size(); ++level) {
+    auto& ordinals = firstChildOrdinals[level];
+    ordinals.resize(nonTerminalCells[level].size());
+    for (uint32_t& ordinal : ordinals) {
+      ordinal = static_cast<uint32_t>(nbOrdinals);
+      nbOrdinals += 4;
+    }
+  }
+  nbTerminalCells = nbOrdinals;
+  for (const auto& ntCells : nonTerminalCells)
+    nbTerminalCells -= ntCells.size();
+  this->ClearNeighbours();
+  hasTerminalIndex = false;
+  this->ResizeAttrs();
+}
+
+void QuadTree::Internal::ClearNeighbours() {
+  neighbourOffsets.clear();
+  neighbourCells.clear();
+  neighbourConnections.clear();
+}
+
+void QuadTree::Internal::UpdateTerminalIndex() const {
+  if (hasTerminalIndex.load(std::memory_order_acquire)) return;
+  std::lock_guard<std::mutex> lock(terminalIndexMutex);
+  if (hasTerminalIndex.load(std::memory_order_relaxed)) return;
+
+  terminalCells.clear();
+  terminalCells.reserve(nbTerminalCells);
+  terminalCellOrdinals.clear();
+  terminalCellOrdinals.reserve(nbTerminalCells);
+  terminalIndices.assign(nbOrdinals, NoOrdinal);
+  // Обход заканчивается ячейкой нулевого уровня за последней.
+  Cell end(0, this->GetNbCellsOnLevel(0));
+  for (Cell cell = this->GetFirstTerminalCell(Cell(0, 0)); cell != end;
+       cell = this->Next(cell)) {
+    size_t ordinal = this->GetOrdinal(cell);
+    terminalIndices[ordinal] = terminalCells.size();
+    terminalCells.push_back(cell);
+    terminalCellOrdinals.push_back(ordinal);
+  }
+  hasTerminalIndex.store(true, std::memory_order_release);
+}
+
+void QuadTree::Internal::ResizeAttrs() {
+  attrs.resize(nbOrdinals, 0);
+  for (Channel& channel : channels) {
+    std::visit(
+        [this](auto& typed) {
+          typed.values.resize(nbOrdinals, typed.defaultValue);
+        },
+        channel);
+  }
+}
+
+void QuadTree::Internal::ForEachCell(
+    const std::function<void(const Cell&, size_t ordinal)>& fn) const {
+  Standard_Integer nc = this->GetNbCellsOnLevel(0);
+  for (Standard_Integer index = 0; index < nc; ++index)
+    fn(Cell(0, index), index);
+  for (size_t level = 0; level < nonTerminalCells.size(); ++level) {
+    const auto& ntCells = nonTerminalCells[level];
+    for (size_t r = 0; r < ntCells.size(); ++r) {
+      Cell parentCell(static_cast<Standard_Integer>(level), ntCells[r]);
+      for (Standard_Integer c = 0; c < 4; ++c)
+        fn(this->GetChildCell(parentCell, c), firstChildOrdinals[level][r] + c);
+    }
+  }
+}
+
+std::vector<size_t> QuadTree::Internal::TraversalOrder() const {
+  std::vector<size_t> order;
+  order.reserve(nbOrdinals);
+  this->ForEachCell(
+      [&order](const Cell&, size_t ordinal) { order.push_back(ordinal); });
+  return order;
+}
+
+void QuadTree::Internal::SaveBinary(std::ostream& stream) const {
+  WriteValue(stream, kBinaryMagic);
+  WriteValue(stream, kBinaryVersion);
+  Standard_Real box[4];
+  boundBox.Get(box[0], box[1], box[2], box[3]);
+  WriteValue(stream, box);
+  WriteValue(stream, static_cast<int32_t>(nbByI));
+  WriteValue(stream, static_cast<int32_t>(nbByJ));
+
+  WriteValue(stream, static_cast<uint32_t>(nonTerminalCells.size()));
+  for (const auto& ntCells : nonTerminalCells) {
+    WriteValue(stream, static_cast<uint64_t>(ntCells.size()));
+    WriteValues(stream, std::span<const uint32_t>(ntCells));
+  }
+
+  // Атрибуты пишутся в порядке обхода ячеек: после загрузки он совпадает с
+  // порядковыми номерами ячеек, и блоки читаются без перестановок.
+  std::vector<size_t> order = this->TraversalOrder();
+  WriteValue(stream, static_cast<uint64_t>(order.size()));
+  WriteValuesInOrder(stream, std::span<const size_t>(attrs), order);
+
+  // Тип канала записывается номером альтернативы в `Channel`.
+  WriteValue(stream, static_cast<uint32_t>(channels.size()));
+  for (const Channel& channel : channels) {
+    WriteValue(stream, static_cast<uint8_t>(channel.index()));
+    std::visit(
+        [&](const auto& typed) {
+          typedef std::decay_t<decltype(typed.defaultValue)> T;
+          WriteValue(stream, typed.defaultValue);
+          WriteValuesInOrder(stream, std::span<const T>(typed.values), order);
+        },
+        channel);
+  }
+}
+
+template <typename T>
+Standard_Boolean QuadTree::Internal::LoadChannel(std::istream& stream) {
+  TypedChannel<T> channel;
+  if (!ReadValue(stream, channel.defaultValue)) return Standard_False;
+  if (!ReadValues(stream, nbOrdinals, channel.values)) return Standard_False;
+  channels.push_back(std::move(channel));
+  return Standard_True;
+}
+
+QuadTree::Ptr QuadTree::Internal::LoadBinary(std::istream& stream) {
+  char magic[4];
+  uint32_t version;
+  if (!ReadValue(stream, magic) || std::memcmp(magic, kBinaryMagic, 4) != 0 ||
+      !ReadValue(stream, version) || version != kBinaryVersion)
+    return QuadTree::Ptr();
+
+  Standard_Real box[4];
+  int32_t in, jn;
+  if (!ReadValue(stream, box) || !ReadValue(stream, in) ||
+      !ReadValue(stream, jn))
+    return QuadTree::Ptr();
+
+  // Номера ячеек нулевого уровня должны помещаться в `Standard_Integer`, а
+  // их атрибуты записаны в потоке, поэтому число ячеек ограничено и его
+  // размером.
+  const uint64_t maxCells = std::numeric_limits<Standard_Integer>::max();
+  if (in < 1 || jn < 1) return QuadTree::Ptr();
+  uint64_t nbCellsOnLevel = static_cast<uint64_t>(in) * jn;
+  if (nbCellsOnLevel > maxCells ||
+      !HasValues<uint64_t>(stream, nbCellsOnLevel))
+    return QuadTree::Ptr();
+
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(box[0], box[1]));
+  boundBox.Add(gp_Pnt2d(box[2], box[3]));
+  QuadTree::Ptr tree = QuadTree::Create(boundBox, in, jn);
+  if (!tree) return tree;
+  Internal* data = tree->pimpl;
+
+  // Номера ячеек уровня должны возрастать, не выходить за пределы уровня и
+  // принадлежать дочерним ячейкам нетерминальных ячеек предыдущего уровня.
+  uint64_t nbOrdinals = nbCellsOnLevel;
+  uint32_t nbLevels;
+  if (!ReadValue(stream, nbLevels)) return QuadTree::Ptr();
+  for (uint32_t level = 0; level < nbLevels; ++level) {
+    uint64_t count;
+    if (!ReadValue(stream, count) || count == 0 || count > nbCellsOnLevel)
+      return QuadTree::Ptr();
+    auto& ntCells = data->nonTerminalCells.emplace_back();
+    if (!ReadValues(stream, count, ntCells)) return QuadTree::Ptr();
+    for (size_t r = 0; r < ntCells.size(); ++r) {
+      if (ntCells[r] >= nbCellsOnLevel ||
+          (r > 0 && ntCells[r] <= ntCells[r - 1]))
+        return QuadTree::Ptr();
+      if (level == 0) continue;
+      Cell parentCell =
+          data->GetParentCell(Cell(static_cast<Standard_Integer>(level),
+                                   static_cast<Standard_Integer>(ntCells[r])));
+      const auto& parents = data->nonTerminalCells[level - 1];
+      if (!std::binary_search(parents.begin(), parents.end(),
+                              static_cast<uint32_t>(parentCell.index)))
+        return QuadTree::Ptr();
+    }
+    nbOrdinals += 4 * ntCells.size();
+    nbCellsOnLevel *= 4;
+    if (nbCellsOnLevel > maxCells) return QuadTree::Ptr();
+  }
+
+  // Атрибуты читаются до нумерации ячеек, которая выделяет под них память.
+  uint64_t nbCells;
+  std::vector<size_t> attrs;
+  if (!ReadValue(stream, nbCells) || nbCells != nbOrdinals ||
+      !ReadValues(stream, nbCells, attrs))
+    return QuadTree::Ptr();
+  data->NumberCells();
+  data->attrs = std::move(attrs);
+
+  uint32_t nbChannels;
+  if (!ReadValue(stream, nbChannels)) return QuadTree::Ptr();
+  for (uint32_t channel = 0; channel < nbChannels; ++channel) {
+    uint8_t type;
+    if (!ReadValue(stream, type)) return QuadTree::Ptr();
+    Standard_Boolean isRead = Standard_False;
+    switch (type) {
+      case 0:
+        isRead = data->LoadChannel<int>(stream);
+        break;
+      case 1:
+        isRead = data->LoadChannel<float>(stream);
+        break;
+      case 2:
+        isRead = data->LoadChannel<double>(stream);
+        break;
+    }
+    if (!isRead) return QuadTree::Ptr();
+  }
+
+  return tree;
+}
+
 QuadTree::Cell QuadTree::Internal::GetChildCell(
     const Cell& parentCell, Standard_Integer childIndex) const {
   assert(childIndex >= 0 && childIndex < 4);
@@ -169,20 +487,21 @@ QuadTree::Cell QuadTree::Internal::GetParentCell(const Cell& cell) const {
 
 Standard_Boolean QuadTree::Internal::IsExists(const Cell& cell) const {
   Standard_Integer nbLevels = this->Levels();
-  if (cell.level >= nbLevels) return Standard_False;
+  if (cell.level < 0 || cell.level >= nbLevels) return Standard_False;
 
   // Ячейка существует тогда, когда в подложке есть ячейка с таким номером и
   // ячейка входит в нулевой уровень или если нет, то ее родитель в списке
   // нетерминальных.
 
   Standard_Integer nc = this->GetNbCellsOnLevel(cell.level);
-  if (cell.index >= nc) return Standard_False;
+  if (cell.index < 0 || cell.index >= nc) return Standard_False;
 
   if (cell.level == 0) return Standard_True;
 
   Cell parentCell = this->GetParentCell(cell);
   const auto& ntCells = nonTerminalCells[parentCell.level];
-  return std::binary_search(ntCells.begin(), ntCells.end(), parentCell.index);
+  return std::binary_search(ntCells.begin(), ntCells.end(),
+                            static_cast<uint32_t>(parentCell.index));
 }
 
 QuadTree::Cell QuadTree::Internal::GetFirstTerminalCell(
@@ -295,7 +614,8 @@ QuadTree::QuadTree(const Bnd_Box2d& boundBox, Standard_Integer in,
   pimpl->nbByI = in;
   pimpl->nbByJ = jn;
   pimpl->nonTerminalCells.reserve(16);
-  pimpl->attrs.reserve(16);
+  pimpl->firstChildOrdinals.reserve(16);
+  pimpl->NumberCells();
 }
 
 QuadTree::~QuadTree() { delete pimpl; }
@@ -307,51 +627,24 @@ void QuadTree::GetBox(Standard_Real& xMin, Standard_Real& yMin,
   pimpl->boundBox.Get(xMin, yMin, xMax, yMax);
 }
 
-namespace {
-;
-Standard_Integer CellsCount(const QuadTree::Internal* qTreeInternal,
-                            const QuadTree::Cell& parentCell) {
-  typedef QuadTree::Cell Cell;
-
-  Standard_Integer nbCells = 0;
-  std::stack<Cell> stack;
-  stack.push(parentCell);
-  while (!stack.empty()) {
-    Cell cell = stack.top();
-    stack.pop();
-
-    Standard_Boolean isTerminalCell = Standard_True;
-    if (cell.level < qTreeInternal->nonTerminalCells.size()) {
-      const auto& ntCells = qTreeInternal->nonTerminalCells[cell.level];
-      if (std::binary_search(ntCells.begin(), ntCells.end(), cell.index))
-        isTerminalCell = Standard_False;
-    }
-
-    if (isTerminalCell) {
-      ++nbCells;
-      continue;
-    }
+Standard_Integer QuadTree::NbCells() const {
+  return static_cast<Standard_Integer>(pimpl->nbTerminalCells);
+}
 
-    std::array<Standard_Integer, 4> nextCellsIndex;
-    qTreeInternal->GetCellsOfNextLevel(cell, nextCellsIndex);
-    stack.push(Cell{cell.level + 1, nextCellsIndex[0]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[1]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[2]});
-    stack.push(Cell{cell.level + 1, nextCellsIndex[3]});
-  }
+size_t QuadTree::NbTerminalCells() const { return pimpl->nbTerminalCells; }
 
-  return nbCells;
+Standard_Integer QuadTree::NbTerminalCells(Standard_Integer level) const {
+  if (level < 0 || level >= pimpl->Levels()) return 0;
+  Standard_Integer nbCells =
+      level == 0 ? pimpl->GetNbCellsOnLevel(0)
+                 : 4 * static_cast<Standard_Integer>(
+                           pimpl->nonTerminalCells[level - 1].size());
+  return nbCells - this->NbNonTerminalCells(level);
 }
-}  // namespace
 
-Standard_Integer QuadTree::NbCells() const {
-  Standard_Integer nbCells = 0;
-  Standard_Integer nbCellsOnLevel0 = pimpl->nbByI * pimpl->nbByJ;
-  for (Standard_Integer i = 0; i < nbCellsOnLevel0; ++i) {
-    Cell cell{0, i};
-    nbCells += CellsCount(pimpl, cell);
-  }
-  return nbCells;
+Standard_Integer QuadTree::NbNonTerminalCells(Standard_Integer level) const {
+  if (level < 0 || level >= pimpl->nonTerminalCells.size()) return 0;
+  return static_cast<Standard_Integer>(pimpl->nonTerminalCells[level].size());
 }
 
 namespace {
@@ -404,6 +697,18 @@ Iterator<QuadTree::Cell> QuadTree::TerminalCells() const {
   return Iterator<Cell>(itImpl);
 }
 
+std::span<const QuadTree::Cell> QuadTree::TerminalCellsArray() const {
+  pimpl->UpdateTerminalIndex();
+  return pimpl->terminalCells;
+}
+
+size_t QuadTree::GetTerminalOrdinal(const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (ordinal == NoOrdinal) return NoOrdinal;
+  pimpl->UpdateTerminalIndex();
+  return pimpl->terminalIndices[ordinal];
+}
+
 namespace {
 ;
 class IteratorImpl_QuadTreeCellsOfLevel : public IteratorImpl<QuadTree::Cell> {
@@ -722,6 +1027,93 @@ Iterator<QuadTree::Cell> QuadTree::ConnectedCells(const Cell& cell) const {
   return Iterator<Cell>(itImpl);
 }
 
+void QuadTree::BuildNeighbours() {
+  std::vector<std::pair<Cell, size_t>> terminalCells;
+  pimpl->ForEachCell([this, &terminalCells](const Cell& cell, size_t ordinal) {
+    if (pimpl->IsTerminal(cell)) terminalCells.emplace_back(cell, ordinal);
+  });
+
+  // Строки блока ячеек собираются отдельно и затем копируются на свои места.
+  struct Block {
+    size_t begin;
+    std::vector<size_t> rowSizes;
+    std::vector<Cell> cells;
+  };
+  std::vector<Block> blocks;
+  std::mutex blocksMutex;
+  ParallelFor(
+      terminalCells.size(),
+      [&](size_t begin, size_t end) {
+        Block block{begin, {}, {}};
+        block.rowSizes.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+          size_t rowBegin = block.cells.size();
+          for (Cell other : this->ConnectedCells(terminalCells[i].first))
+            block.cells.push_back(other);
+          // Итератор пропускает только идущие подряд повторы.
+          auto row = block.cells.begin() + rowBegin;
+          std::sort(row, block.cells.end());
+          block.cells.erase(std::unique(row, block.cells.end()),
+                            block.cells.end());
+          block.rowSizes.push_back(block.cells.size() - rowBegin);
+        }
+        std::lock_guard<std::mutex> lock(blocksMutex);
+        blocks.push_back(std::move(block));
+      },
+      256);
+
+  std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  offsets.assign(pimpl->nbOrdinals + 1, 0);
+  for (const Block& block : blocks) {
+    for (size_t r = 0; r < block.rowSizes.size(); ++r)
+      offsets[terminalCells[block.begin + r].second + 1] = block.rowSizes[r];
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  std::vector<Cell>& cells = pimpl->neighbourCells;
+  std::vector<CellConnection>& connections = pimpl->neighbourConnections;
+  cells.resize(offsets.back());
+  connections.resize(offsets.back());
+  ParallelFor(
+      blocks.size(),
+      [&](size_t begin, size_t end) {
+        for (size_t b = begin; b < end; ++b) {
+          const Block& block = blocks[b];
+          auto src = block.cells.begin();
+          for (size_t r = 0; r < block.rowSizes.size(); ++r) {
+            const auto& [cell, ordinal] = terminalCells[block.begin + r];
+            for (size_t k = offsets[ordinal]; k < offsets[ordinal + 1];
+                 ++k, ++src) {
+              cells[k] = *src;
+              connections[k] = this->GetConnectionType(cell, *src);
+            }
+          }
+        }
+      },
+      1);
+}
+
+Standard_Boolean QuadTree::HasNeighbours() const {
+  return !pimpl->neighbourOffsets.empty();
+}
+
+std::span<const QuadTree::Cell> QuadTree::Neighbours(const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (!this->HasNeighbours() || ordinal == NoOrdinal) return {};
+  const std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  return std::span<const Cell>(pimpl->neighbourCells)
+      .subspan(offsets[ordinal], offsets[ordinal + 1] - offsets[ordinal]);
+}
+
+std::span<const QuadTree::CellConnection> QuadTree::NeighbourConnections(
+    const Cell& cell) const {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (!this->HasNeighbours() || ordinal == NoOrdinal) return {};
+  const std::vector<size_t>& offsets = pimpl->neighbourOffsets;
+  return std::span<const CellConnection>(pimpl->neighbourConnections)
+      .subspan(offsets[ordinal], offsets[ordinal + 1] - offsets[ordinal]);
+}
+
 void QuadTree::GetCellBox(const Cell& cell, Standard_Real& xMin,
                           Standard_Real& yMin, Standard_Real& xMax,
                           Standard_Real& yMax) const {
@@ -778,6 +1170,15 @@ void QuadTree::CellsNumberOnLevel(Standard_Integer level,
   pimpl->LevelSize(level, nbByI, nbByJ);
 }
 
+Standard_Boolean QuadTree::IsTerminal(const Cell& cell) const {
+  return pimpl->IsTerminal(cell);
+}
+
+QuadTree::Cell QuadTree::GetChildCell(const Cell& cell,
+                                      Standard_Integer childIndex) const {
+  return pimpl->GetChildCell(cell, childIndex);
+}
+
 void QuadTree::Split(const Cell& cell) {
   size_t N = pimpl->nonTerminalCells.size();
   assert(cell.level <= N);
@@ -790,6 +1191,7 @@ void QuadTree::Split(const Cell& cell) {
 
   if (cell.level == N) {
     pimpl->nonTerminalCells.push_back({});
+    pimpl->firstChildOrdinals.push_back({});
     auto& ntCells = pimpl->nonTerminalCells.back();
     Standard_Integer nc = pimpl->GetNbCellsOnLevel(cell.level);
     ntCells.reserve(std::min(32, nc));
@@ -797,7 +1199,19 @@ void QuadTree::Split(const Cell& cell) {
 
   auto& ntCells = pimpl->nonTerminalCells[cell.level];
   auto it = std::lower_bound(ntCells.begin(), ntCells.end(), cell.index);
-  if (it == ntCells.end() || *it != cell.index) ntCells.insert(it, cell.index);
+  if (it != ntCells.end() && *it == cell.index) return;
+
+  // Дочерние ячейки получают номера в конце, так что номера имеющихся ячеек
+  // и их атрибуты сохраняются.
+  auto& ordinals = pimpl->firstChildOrdinals[cell.level];
+  ordinals.insert(ordinals.begin() + (it - ntCells.begin()),
+                  static_cast<uint32_t>(pimpl->nbOrdinals));
+  ntCells.insert(it, cell.index);
+  pimpl->nbOrdinals += 4;
+  pimpl->nbTerminalCells += 3;
+  pimpl->ResizeAttrs();
+  pimpl->ClearNeighbours();
+  pimpl->hasTerminalIndex = false;
 }
 
 void QuadTree::GetCellCoords(const Cell& cell, Standard_Integer& i,
@@ -830,22 +1244,100 @@ QuadTree::Cell QuadTree::GetCell(const gp_Pnt2d& Q) const {
 }
 
 size_t QuadTree::GetAttr(const Cell& cell) const {
-  if (cell.level >= pimpl->attrs.size()) return 0;
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  if (ordinal == NoOrdinal) return 0;
+  return pimpl->attrs[ordinal];
+}
+
+void QuadTree::SetAttr(const Cell& cell, size_t attr) {
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal != NoOrdinal);
+  if (ordinal != NoOrdinal) pimpl->attrs[ordinal] = attr;
+}
+
+size_t QuadTree::GetOrdinal(const Cell& cell) const {
+  return pimpl->GetOrdinal(cell);
+}
+
+size_t QuadTree::NbOrdinals() const { return pimpl->nbOrdinals; }
+
+template <typename T>
+size_t QuadTree::AddChannel(T defaultValue) {
+  Internal::TypedChannel<T> channel;
+  channel.values.assign(pimpl->nbOrdinals, defaultValue);
+  channel.defaultValue = defaultValue;
+  pimpl->channels.push_back(std::move(channel));
+  return pimpl->channels.size() - 1;
+}
 
-  const auto& map = pimpl->attrs[cell.level];
-  auto it = map.find(cell.index);
-  if (it == map.end()) return 0;
-  return it->second;
+template <typename T>
+std::span<T> QuadTree::GetChannel(size_t channel) {
+  assert(channel < pimpl->channels.size());
+  if (channel >= pimpl->channels.size()) return {};
+  auto typed =
+      std::get_if<Internal::TypedChannel<T>>(&pimpl->channels[channel]);
+  if (!typed) return {};
+  return typed->values;
 }
 
-void QuadTree::SetAttr(const Cell& cell, size_t attr) const {
-  assert(cell.level < this->Levels());
-  while (cell.level >= pimpl->attrs.size()) pimpl->attrs.push_back({});
+template <typename T>
+std::span<const T> QuadTree::GetChannel(size_t channel) const {
+  return const_cast<QuadTree*>(this)->GetChannel<T>(channel);
+}
 
-  auto& map = pimpl->attrs[cell.level];
-  map[cell.index] = attr;
+template <typename T>
+T QuadTree::GetValue(size_t channel, const Cell& cell) const {
+  std::span<const T> values = this->GetChannel<T>(channel);
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal < values.size());
+  if (ordinal >= values.size()) return T();
+  return values[ordinal];
 }
 
+template <typename T>
+void QuadTree::SetValue(size_t channel, const Cell& cell, T value) {
+  std::span<T> values = this->GetChannel<T>(channel);
+  size_t ordinal = pimpl->GetOrdinal(cell);
+  assert(ordinal < values.size());
+  if (ordinal < values.size()) values[ordinal] = value;
+}
+
+template <typename T>
+void QuadTree::GetValues(size_t channel, std::vector<T>& values) const {
+  std::span<const T> data = this->GetChannel<T>(channel);
+  values.clear();
+  if (data.empty()) return;
+  pimpl->UpdateTerminalIndex();
+  values.reserve(pimpl->nbTerminalCells);
+  for (size_t ordinal : pimpl->terminalCellOrdinals)
+    values.push_back(data[ordinal]);
+}
+
+template <typename T>
+void QuadTree::SetValues(size_t channel, std::span<const T> values) {
+  std::span<T> data = this->GetChannel<T>(channel);
+  if (data.empty()) return;
+  pimpl->UpdateTerminalIndex();
+  const std::vector<size_t>& ordinals = pimpl->terminalCellOrdinals;
+  assert(values.size() >= ordinals.size());
+  size_t n = std::min(values.size(), ordinals.size());
+  for (size_t i = 0; i < n; ++i) data[ordinals[i]] = values[i];
+}
+
+#define INSTANTIATE_CHANNEL(T)                                          \
+  template size_t QuadTree::AddChannel<T>(T);                               \
+  template std::span<T> QuadTree::GetChannel<T>(size_t);                   \
+  template std::span<const T> QuadTree::GetChannel<T>(size_t) const;       \
+  template T QuadTree::GetValue<T>(size_t, const Cell&) const;             \
+  template void QuadTree::SetValue<T>(size_t, const Cell&, T);             \
+  template void QuadTree::GetValues<T>(size_t, std::vector<T>&) const;     \
+  template void QuadTree::SetValues<T>(size_t, std::span<const T>);
+
+INSTANTIATE_CHANNEL(int)
+INSTANTIATE_CHANNEL(float)
+INSTANTIATE_CHANNEL(double)
+#undef INSTANTIATE_CHANNEL
+
 Standard_Boolean QuadTree::Equals(QuadTree::CPtr other) const {
   std::array<Standard_Real, 4> bbCoords;
   pimpl->boundBox.Get(bbCoords[0], bbCoords[1], bbCoords[2], bbCoords[3]);
@@ -869,7 +1361,12 @@ Standard_Boolean QuadTree::Equals(QuadTree::CPtr other) const {
   return Standard_True;
 }
 
-void QuadTree::Serialize(std::ostream& stream) const {
+void QuadTree::Serialize(std::ostream& stream, Format format) const {
+  if (format == Format::Binary) {
+    pimpl->SaveBinary(stream);
+    return;
+  }
+
   json data;
   Standard_Real xMin, yMin, xMax, yMax;
   pimpl->boundBox.Get(xMin, yMin, xMax, yMax);
@@ -877,12 +1374,23 @@ void QuadTree::Serialize(std::ostream& stream) const {
   data["ZeroLevelCellsNumbers"] = {pimpl->nbByI, pimpl->nbByJ};
   data["NonTerminalCells"] = pimpl->nonTerminalCells;
 
-  if (!pimpl->attrs.empty()) data["Attrs"] = pimpl->attrs;
+  std::vector<std::map<Standard_Integer, size_t>> attrs;
+  pimpl->ForEachCell([&](const Cell& cell, size_t ordinal) {
+    size_t attr = pimpl->attrs[ordinal];
+    if (attr == 0) return;
+    if (attrs.size() <= cell.level) attrs.resize(cell.level + 1);
+    attrs[cell.level][cell.index] = attr;
+  });
+  if (!attrs.empty()) data["Attrs"] = attrs;
 
   stream << data << std::endl;
 }
 
 QuadTree::Ptr QuadTree::Deserialize(std::istream& stream) {
+  // Двоичный формат распознается по сигнатуре: текст JSON с буквы 'N'
+  // начинаться не может.
+  if (stream.peek() == kBinaryMagic[0]) return Internal::LoadBinary(stream);
+
   json data = json::parse(stream);
 
   Bnd_Box2d boundBox;
@@ -916,10 +1424,18 @@ QuadTree::Ptr QuadTree::Deserialize(std::istream& stream) {
         jNonTerminalCells.get<std::vector<std::vector<uint32_t>>>();
   }
 
+  qTree->pimpl->NumberCells();
+
   const json& jAttrs = data["Attrs"];
   if (!jAttrs.empty()) {
-    qTree->pimpl->attrs =
-        jAttrs.get<std::vector<std::map<Standard_Integer, size_t>>>();
+    auto attrs = jAttrs.get<std::vector<std::map<Standard_Integer, size_t>>>();
+    for (size_t level = 0; level < attrs.size(); ++level) {
+      for (const auto& [index, attr] : attrs[level]) {
+        Cell cell(static_cast<Standard_Integer>(level), index);
+        size_t ordinal = qTree->pimpl->GetOrdinal(cell);
+        if (ordinal != NoOrdinal) qTree->pimpl->attrs[ordinal] = attr;
+      }
+    }
   }
 
   return qTree;
@@ -995,9 +1511,11 @@ void QuadTree::GetMinMaxDistances(const gp_Pnt2d& q, const Cell& cell,
     return;
   }
 
-  Standard_Real dxMin = std::min(std::abs(xQ - xMin), std::abs(xQ - xMax));
+  // Вдоль оси, на проекцию ячейки на которую попадает точка, наименьшее
+  // расстояние нулевое.
+  Standard_Real dxMin = std::max({xMin - xQ, xQ - xMax, 0.0});
   Standard_Real dxMax = std::max(std::abs(xQ - xMin), std::abs(xQ - xMax));
-  Standard_Real dyMin = std::min(std::abs(yQ - yMin), std::abs(yQ - yMax));
+  Standard_Real dyMin = std::max({yMin - yQ, yQ - yMax, 0.0});
   Standard_Real dyMax = std::max(std::abs(yQ - yMin), std::abs(yQ - yMax));
 
   minDistance = std::sqrt(dxMin * dxMin + dyMin * dyMin);
@@ -1012,35 +1530,61 @@ gp_Pnt2d QuadTree::GetCenter(const Cell& cell) const {
 
 namespace {
 ;
-
-struct CellWithDistances {
+//! Ячейка дерева и наименьшее расстояние от искомой точки до нее.
+struct CellDistance {
   QuadTree::Cell cell;
-  Standard_Real mn;
-  Standard_Real mx;
+  Standard_Real distance;
 
-  CellWithDistances(QuadTree::CPtr qTree, const QuadTree::Cell& c,
-                    const gp_Pnt2d& q)
-      : cell(c) {
-    qTree->GetMinMaxDistances(q, cell, mn, mx);
-  }
-
-  Standard_Boolean operator<(const CellWithDistances& other) const {
-    assert(cell != other.cell);
-    return mn < other.mn;
+  //! Порядок для кучи `std::push_heap`: на вершине ближайшая ячейка.
+  Standard_Boolean operator<(const CellDistance& other) const {
+    if (distance != other.distance) return distance > other.distance;
+    return other.cell < cell;
   }
 };
 
-void PushNonVisitedCellsToQueue(QuadTree::CPtr qTree,
-                                const QuadTree::Cell& startCell,
-                                const gp_Pnt2d& Q,
-                                std::set<QuadTree::Cell>& visited,
-                                std::priority_queue<CellWithDistances>& queue) {
-  for (QuadTree::Cell cell : qTree->ConnectedCells(startCell)) {
-    if (!visited.insert(cell).second) continue;
-
-    gp_Pnt2d C = qTree->GetCenter(cell);
-    Standard_Real d = C.Distance(Q);
-    queue.push(CellWithDistances(qTree, cell, Q));
+/**
+\brief Обход дерева в порядке удаления ячеек от точки `Q`.
+
+Обход начинается с ячеек нулевого уровня; извлеченная из кучи нетерминальная
+ячейка заменяется дочерними. Каждая ячейка попадает в кучу не более одного
+раза, поэтому учет посещенных ячеек не нужен. Отмеченные терминальные ячейки
+извлекаются из кучи в порядке удаления от точки, так что обход прекращается,
+как только найдено `k` ячеек. Ячейки дальше `maximumDistance` отсекаются
+вместе с поддеревьями.
+\param heap Рабочая память кучи, переиспользуемая между запросами.
+*/
+void SearchBestFirst(
+    const QuadTree::CPtr& qTree, const gp_Pnt2d& Q,
+    const std::function<Standard_Boolean(QuadTree::CPtr,
+                                         const QuadTree::Cell&)>& isTaggedCell,
+    size_t k, Standard_Real maximumDistance, std::vector<CellDistance>& heap,
+    std::vector<QuadTree::Cell>& nearestCells) {
+  nearestCells.clear();
+  heap.clear();
+  if (!qTree || k == 0) return;
+
+  auto push = [&](const QuadTree::Cell& cell) {
+    Standard_Real dMin, dMax;
+    qTree->GetMinMaxDistances(Q, cell, dMin, dMax);
+    if (dMin > maximumDistance) return;
+    heap.push_back({cell, dMin});
+    std::push_heap(heap.begin(), heap.end());
+  };
+
+  Standard_Integer ni, nj;
+  qTree->CellsNumberOnLevel(0, ni, nj);
+  for (Standard_Integer index = 0; index < ni * nj; ++index)
+    push(QuadTree::Cell(0, index));
+
+  while (!heap.empty() && nearestCells.size() < k) {
+    std::pop_heap(heap.begin(), heap.end());
+    QuadTree::Cell cell = heap.back().cell;
+    heap.pop_back();
+    if (!qTree->IsTerminal(cell)) {
+      for (Standard_Integer c = 0; c < 4; ++c)
+        push(qTree->GetChildCell(cell, c));
+    } else if (isTaggedCell(qTree, cell))
+      nearestCells.push_back(cell);
   }
 }
 }  // namespace
@@ -1050,38 +1594,35 @@ void SearchNearestCells(
     const std::function<Standard_Boolean(QuadTree::CPtr,
                                          const QuadTree::Cell&)>& isTaggedCell,
     Standard_Real maximumDistance, std::list<QuadTree::Cell>& nearestCells) {
-  nearestCells.clear();
-
-  if (!qTree) return;
-
-  QuadTree::Cell initCell = qTree->GetCell(Q);
-  if (isTaggedCell(qTree, initCell)) {
-    nearestCells.push_back(initCell);
-    return;
-  }
-
-  std::vector<CellWithDistances> result;
-  std::set<QuadTree::Cell> visited;
-  std::priority_queue<CellWithDistances> queue;
-  visited.insert(initCell);
-  PushNonVisitedCellsToQueue(qTree, initCell, Q, visited, queue);
-
-  while (!queue.empty()) {
-    CellWithDistances cwd = queue.top();
-    queue.pop();
-
-    QuadTree::Cell cell = cwd.cell;
-
-    if (!isTaggedCell(qTree, cell)) {
-      PushNonVisitedCellsToQueue(qTree, cell, Q, visited, queue);
-      continue;
-    }
-
-    if (cwd.mn > maximumDistance) continue;
+  std::vector<CellDistance> heap;
+  std::vector<QuadTree::Cell> cells;
+  SearchBestFirst(qTree, Q, isTaggedCell, std::numeric_limits<size_t>::max(),
+                  maximumDistance, heap, cells);
+  nearestCells.assign(cells.begin(), cells.end());
+}
 
-    result.push_back(cwd);
-  }
+void SearchKNearestCells(
+    QuadTree::CPtr qTree, const gp_Pnt2d& Q,
+    const std::function<Standard_Boolean(QuadTree::CPtr,
+                                         const QuadTree::Cell&)>& isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<QuadTree::Cell>& nearestCells) {
+  std::vector<CellDistance> heap;
+  SearchBestFirst(qTree, Q, isTaggedCell, k, maximumDistance, heap,
+                  nearestCells);
+}
 
-  std::sort(result.begin(), result.end());
-  for (const auto& r : result) nearestCells.push_back(r.cell);
+void SearchKNearestCells(
+    QuadTree::CPtr qTree, std::span<const gp_Pnt2d> points,
+    const std::function<Standard_Boolean(QuadTree::CPtr,
+                                         const QuadTree::Cell&)>& isTaggedCell,
+    size_t k, Standard_Real maximumDistance,
+    std::vector<std::vector<QuadTree::Cell>>& nearestCells) {
+  nearestCells.resize(points.size());
+  ParallelFor(points.size(), [&](size_t iBegin, size_t iEnd) {
+    std::vector<CellDistance> heap;
+    for (size_t i = iBegin; i < iEnd; ++i)
+      SearchBestFirst(qTree, points[i], isTaggedCell, k, maximumDistance, heap,
+                      nearestCells[i]);
+  });
 }
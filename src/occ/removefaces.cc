@@ -21,28 +21,34 @@
 #include <TopExp.hxx>
 #include <TopExp_Explorer.hxx>
 #include <TopTools_IndexedMapOfShape.hxx>
+#include <Standard_Failure.hxx>
 #include <TopTools_ListOfShape.hxx>
 #include <TopoDS_Edge.hxx>
 #include <TopoDS_Face.hxx>
 #include <TopoDS_Wire.hxx>
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <list>
 #include <map>
 #include <queue>
+#include <span>
 #include <stack>
+#include <vector>
 
 #include "ffextintersections.h"
 #include "intersections.h"
+#include "numgeom/parallelfor.h"
 #include "numgeom/utilities.h"
-
-#ifndef NDEBUG
-#define STATE_DIAGNOSTIC(cond) \
-  if (!(cond)) {               \
-    abort();                   \
+#include "shapetopology.h"
+
+// Нарушенное условие означает, что грани блока восстановить не удалось.
+// Исключение прерывает обработку только этого блока: он попадает в
+// `failedBlocks`, а его восстанавливающие грани в результат не включаются.
+#define STATE_DIAGNOSTIC(cond)                               \
+  if (!(cond)) {                                             \
+    throw Standard_Failure("RemoveFaces: violated " #cond);  \
   }
-#else
-#define STATE_DIAGNOSTIC(cond) ;
-#endif
 #undef STATE_DUMP
 
 namespace {
@@ -54,9 +60,7 @@ Standard_Boolean Dump(const std::string& fileName,
                       const TopTools_ListOfShape& contour);
 
 void ExtractBoundaryShapes(
-    const TopTools_ListOfShape& faces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& verex2edges,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
+    const TopTools_ListOfShape& faces, const ShapeTopology& topology,
     std::list<TopTools_ListOfShape>& boundaryEdges,
     TopTools_MapOfShape& externalFaces,
     TopTools_IndexedDataMapOfShapeListOfShape& bvertex2eedges);
@@ -64,8 +68,7 @@ void ExtractBoundaryShapes(
 TopTools_ListOfShape::iterator GetNextContourPiece(
     const TopTools_ListOfShape::iterator& itCurrent,
     const TopTools_ListOfShape::iterator& itEnd,
-    const TopTools_MapOfShape& externalFaces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
+    const TopTools_MapOfShape& externalFaces, const ShapeTopology& topology,
     TopoDS_Face& exf);
 
 std::pair<TopoDS_Vertex, TopoDS_Vertex> GetBoundaryVertices(
@@ -77,12 +80,6 @@ TopoDS_Vertex CreateVertex(const gp_Pnt&);
 TopoDS_Edge CreateEdge(Handle(Geom_Curve) curve, const TopoDS_Vertex& vBeg,
                        const TopoDS_Vertex& vEnd);
 
-void RemoveFaces(const TopoDS_Shape& initShape,
-                 const BOPTools_ConnexityBlock& cblock,
-                 const TopTools_IndexedDataMapOfShapeListOfShape& vertex2edges,
-                 const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
-                 TopTools_ListOfShape& visibleFaces);
-
 TopoDS_Shape CreateResult(const TopTools_ListOfShape& visibleFaces);
 
 TopoDS_Vertex GetBegVertex(const TopoDS_Edge& edge) {
@@ -92,35 +89,6 @@ TopoDS_Vertex GetBegVertex(const TopoDS_Edge& edge) {
 TopoDS_Vertex GetEndVertex(const TopoDS_Edge& edge) {
   return TopExp::LastVertex(edge, true);
 }
-}  // namespace
-
-TopoDS_Shape RemoveFaces(const TopoDS_Shape& initShape,
-                         const TopTools_ListOfShape& facesToRemove) {
-  if (initShape.IsNull()) return TopoDS_Shape();
-
-  TopTools_IndexedDataMapOfShapeListOfShape vertex2edges;
-  TopExp::MapShapesAndAncestors(initShape, TopAbs_VERTEX, TopAbs_EDGE,
-                                vertex2edges);
-
-  TopTools_IndexedDataMapOfShapeListOfShape edge2faces;
-  TopExp::MapShapesAndAncestors(initShape, TopAbs_EDGE, TopAbs_FACE,
-                                edge2faces);
-
-  // Разделение граней на сильно связанные компоненты.
-  BOPTools_ListOfConnexityBlock features;
-  BOPTools_AlgoTools::MakeConnexityBlocks(facesToRemove, TopAbs_EDGE,
-                                          TopAbs_FACE, features);
-
-  TopTools_ListOfShape visibleFaces;
-  for (const BOPTools_ConnexityBlock& cblock : features) {
-    RemoveFaces(initShape, cblock, vertex2edges, edge2faces, visibleFaces);
-  }
-
-  return CreateResult(visibleFaces);
-}
-
-namespace {
-;
 
 struct VisibleContour {
   /**\struct Piece
@@ -203,16 +171,24 @@ struct VisibleContour {
   }
 };
 
+//! Найденный контур восстанавливающей грани, по которому грань строится
+//! после анализа всех блоков.
+struct VisibleFaceDraft {
+  Handle(Geom_Surface) surface;
+  bool isClosedContour;
+  VisibleContour contour;
+  //! Ребра участка контура удаляемых граней.
+  TopTools_ListOfShape edges;
+};
+
 // Создаем восстанавливающую грань по найденному решению.
-TopoDS_Face CreateVisibleFace(const Handle(Geom_Surface) & sEx,
-                              bool isClosedContour,
-                              const VisibleContour& visibleContour,
-                              const TopTools_ListOfShape::iterator& itc,
-                              const TopTools_ListOfShape::iterator& itc2) {
+TopoDS_Face CreateVisibleFace(const VisibleFaceDraft& draft) {
+  const bool isClosedContour = draft.isClosedContour;
+  const VisibleContour& visibleContour = draft.contour;
   TopoDS_Wire innerWire;
   if (isClosedContour) {
     BRepLib_MakeWire wireMaker;
-    for (auto it = itc; it != itc2; ++it) wireMaker.Add(TopoDS::Edge(*it));
+    for (const TopoDS_Shape& e : draft.edges) wireMaker.Add(TopoDS::Edge(e));
     STATE_DIAGNOSTIC(wireMaker.Error() == BRepLib_WireDone);
     innerWire = wireMaker.Wire();
     innerWire.Reverse();
@@ -222,7 +198,7 @@ TopoDS_Face CreateVisibleFace(const Handle(Geom_Surface) & sEx,
   {
     BRepLib_MakeWire wireMaker;
     if (!isClosedContour) {
-      for (auto it = itc; it != itc2; ++it) wireMaker.Add(TopoDS::Edge(*it));
+      for (const TopoDS_Shape& e : draft.edges) wireMaker.Add(TopoDS::Edge(e));
     }
 
     TopoDS_Vertex vStart;
@@ -231,23 +207,13 @@ TopoDS_Face CreateVisibleFace(const Handle(Geom_Surface) & sEx,
       gp_Pnt pt = lastSolPiece.EndPoint();
       vStart = CreateVertex(pt);
     } else {
-      const TopoDS_Edge& e = TopoDS::Edge(*itc);
-      vStart = GetBegVertex(e);
+      vStart = GetBegVertex(TopoDS::Edge(draft.edges.First()));
     }
 
     TopoDS_Vertex vFinish = vStart;
     if (!isClosedContour) {
-      // Итератор itc2 указывает на следующую позицию, идущую за
-      // последним ребром. Итератор не поддерживает декремента, поэтому,
-      // чтобы найти последнее ребро, проходим от начала (itc) до конца.
-      TopoDS_Edge lastContourEdge;
-      STATE_DIAGNOSTIC(itc != itc2);
-      auto it = itc;
-      while (it != itc2) {
-        lastContourEdge = TopoDS::Edge(*it);
-        ++it;
-      }
-      vFinish = GetEndVertex(lastContourEdge);
+      STATE_DIAGNOSTIC(!draft.edges.IsEmpty());
+      vFinish = GetEndVertex(TopoDS::Edge(draft.edges.Last()));
     }
 
     TopoDS_Vertex vPred = vStart;
@@ -269,7 +235,7 @@ TopoDS_Face CreateVisibleFace(const Handle(Geom_Surface) & sEx,
     outerWire = wireMaker.Wire();
   }
 
-  BRepLib_MakeFace faceMaker(sEx, outerWire);
+  BRepLib_MakeFace faceMaker(draft.surface, outerWire);
   if (!innerWire.IsNull()) faceMaker.Add(innerWire);
   STATE_DIAGNOSTIC(faceMaker.Error() == BRepLib_FaceDone);
   return faceMaker.Face();
@@ -280,26 +246,23 @@ bool PointLieOnCurve(const gp_Pnt& P, const Handle(Geom_Curve) & C) {
   return P.SquareDistance(C->Value(t)) <= 1.e-7;
 }
 
-TopoDS_Face GetAdjFace(
-    const TopoDS_Face& face, const TopoDS_Edge& edge,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces) {
+TopoDS_Face GetAdjFace(const TopoDS_Face& face, const TopoDS_Edge& edge,
+                       const ShapeTopology& topology) {
   STATE_DIAGNOSTIC(!BRep_Tool::Degenerated(edge));
-  const TopTools_ListOfShape& faces = edge2faces.FindFromKey(edge);
-  STATE_DIAGNOSTIC(faces.Size() == 2);
-  const TopoDS_Shape& face1 = faces.First();
-  const TopoDS_Shape& face2 = faces.Last();
-  if (face1 == face) return TopoDS::Face(face2);
-  return TopoDS::Face(face1);
+  size_t adjFace =
+      topology.GetAdjFace(topology.FaceId(face), topology.EdgeId(edge));
+  STATE_DIAGNOSTIC(adjFace != ShapeTopology::NoId);
+  return topology.Face(adjFace);
 }
 
 TopoDS_Face GetNextExternalFace(
     const TopoDS_Face& fEx, const TopoDS_Vertex& vertex,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
+    const ShapeTopology& topology,
     const TopTools_IndexedDataMapOfShapeListOfShape& bvertex2eedges) {
   const auto& externalEdges = bvertex2eedges.FindFromKey(vertex);
   STATE_DIAGNOSTIC(externalEdges.Size() == 1);
   auto externalEdge = TopoDS::Edge(externalEdges.First());
-  return GetAdjFace(fEx, externalEdge, edge2faces);
+  return GetAdjFace(fEx, externalEdge, topology);
 }
 
 Standard_Boolean IsFaceInnerWire(const TopoDS_Face& F,
@@ -391,16 +354,17 @@ class SearchStack {
   std::stack<std::queue<ContourSeed>> stack;
 };
 
-//! Воспроизводим восстанавливающую грань.
-TopoDS_Face RecoverVisibleFace(
+//! Ищем контур восстанавливающей грани и добавляем его в `drafts`. Возвращает
+//! ложь, если контур найти не удалось.
+bool RecoverVisibleFace(
     const TopoDS_Shape& initShape, const TopoDS_Face& fEx,
     const TopTools_MapOfShape& externalFaces,
     const FaceFaceIntersections& ffIntersections,
     const TopTools_ListOfShape& contour,
     const TopTools_ListOfShape::iterator& itc,
-    const TopTools_ListOfShape::iterator& itc2,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& bvertex2eedges) {
+    const TopTools_ListOfShape::iterator& itc2, const ShapeTopology& topology,
+    const TopTools_IndexedDataMapOfShapeListOfShape& bvertex2eedges,
+    std::list<VisibleFaceDraft>& drafts) {
   Handle(Geom_Surface) sEx = BRep_Tool::Surface(fEx);
   bool isClosedContour = (itc == contour.begin() && itc2 == contour.end());
   TopoDS_Vertex vBeg, vEnd;
@@ -423,20 +387,20 @@ TopoDS_Face RecoverVisibleFace(
 
     if (sStack.IsStateEmpty()) {
       sStack.RemoveState();
-      return TopoDS_Face();
+      return false;
     }
   } else {
     const gp_Pnt& p = BRep_Tool::Pnt(vBeg);
     sStack.AddNextState();
     TopoDS_Face fexStart =
-        GetNextExternalFace(fEx, vBeg, edge2faces, bvertex2eedges);
+        GetNextExternalFace(fEx, vBeg, topology, bvertex2eedges);
     STATE_DIAGNOSTIC(!fexStart.IsNull() && fEx != fexStart);
     sStack.Append({ContourSeed{fexStart, p}});
   }
 
   TopoDS_Face fexFinish;
   if (!isClosedContour) {
-    fexFinish = GetNextExternalFace(fEx, vEnd, edge2faces, bvertex2eedges);
+    fexFinish = GetNextExternalFace(fEx, vEnd, topology, bvertex2eedges);
     STATE_DIAGNOSTIC(!fexFinish.IsNull() && fEx != fexFinish);
   }
 
@@ -537,57 +501,62 @@ TopoDS_Face RecoverVisibleFace(
     if (seed.F != fexFinish) exfsProcessed.Add(seed.F);
   }
 
-  if (solution.IsEmpty()) return TopoDS_Face();
+  if (solution.IsEmpty()) return false;
 
-  // Создаем восстанавливающую грань по найденному решению.
-  TopoDS_Face fSol =
-      CreateVisibleFace(sEx, isClosedContour, solution, itc, itc2);
-  return fSol;
+  TopTools_ListOfShape edges;
+  for (auto it = itc; it != itc2; ++it) edges.Append(*it);
+  drafts.push_back({sEx, isClosedContour, solution, edges});
+  return true;
 }
 
-void RemoveFaces(const TopoDS_Shape& initShape,
+//! Контуры восстанавливающих граней одного блока. Возвращает ложь, если хотя
+//! бы для одного участка контура грань построить не удалось. Пересечения
+//! граней вычисляются параллельно, только если задан `inParallel`. Блок
+//! только читает исходную фигуру.
+bool RemoveFaces(const TopoDS_Shape& initShape,
                  const BOPTools_ConnexityBlock& cblock,
-                 const TopTools_IndexedDataMapOfShapeListOfShape& vertex2edges,
-                 const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
-                 TopTools_ListOfShape& visibleFaces) {
+                 const ShapeTopology& topology, bool inParallel,
+                 std::list<VisibleFaceDraft>& drafts) {
   std::list<TopTools_ListOfShape> contours;
   TopTools_MapOfShape externalFaces;
   TopTools_IndexedDataMapOfShapeListOfShape bvertex2eedges;
-  ExtractBoundaryShapes(cblock.Shapes(), vertex2edges, edge2faces, contours,
-                        externalFaces, bvertex2eedges);
+  ExtractBoundaryShapes(cblock.Shapes(), topology, contours, externalFaces,
+                        bvertex2eedges);
 
-  FaceFaceIntersections ffIntersections(externalFaces);
+  FaceFaceIntersections ffIntersections(externalFaces, topology, inParallel);
 
   for (const auto& contour : contours) {
     auto itc = contour.begin();
     while (itc != contour.end()) {
       TopoDS_Face fEx;
       auto itc2 = GetNextContourPiece(itc, contour.end(), externalFaces,
-                                      edge2faces, fEx);
-      STATE_DIAGNOSTIC(!fEx.IsNull());
+                                      topology, fEx);
+      if (fEx.IsNull()) return false;
       STATE_DIAGNOSTIC(itc != itc2);
 
-      TopoDS_Face slf =
-          RecoverVisibleFace(initShape, fEx, externalFaces, ffIntersections,
-                             contour, itc, itc2, edge2faces, bvertex2eedges);
-      STATE_DIAGNOSTIC(!slf.IsNull());
-      visibleFaces.Append(slf);
+      if (!RecoverVisibleFace(initShape, fEx, externalFaces, ffIntersections,
+                              contour, itc, itc2, topology, bvertex2eedges,
+                              drafts))
+        return false;
       itc = itc2;
     }
   }
+  return true;
 }
 
-bool IsBoundary(const TopoDS_Edge& edge,
-                const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
-                const TopTools_ListOfShape& faces, TopoDS_Face& externalFace) {
-  const auto& adjFaces = edge2faces.FindFromKey(edge);
-  STATE_DIAGNOSTIC(adjFaces.Size() == 2);
-  const auto& firstFace = adjFaces.First();
-  const auto& secondFace = adjFaces.Last();
-  if (!faces.Contains(firstFace))
-    externalFace = TopoDS::Face(firstFace);
-  else if (!faces.Contains(secondFace))
-    externalFace = TopoDS::Face(secondFace);
+//! Ребро граничное, если одна из двух его граней не входит в `isInputFace`.
+bool IsBoundary(const TopoDS_Edge& edge, const ShapeTopology& topology,
+                const std::vector<bool>& isInputFace,
+                TopoDS_Face& externalFace) {
+  std::span<const size_t> adjFaces =
+      topology.EdgeFaces(topology.EdgeId(edge));
+  STATE_DIAGNOSTIC(adjFaces.size() == 2);
+  size_t firstFace = adjFaces.front();
+  size_t secondFace = adjFaces.back();
+  if (!isInputFace[firstFace])
+    externalFace = topology.Face(firstFace);
+  else if (!isInputFace[secondFace])
+    externalFace = topology.Face(secondFace);
   return !externalFace.IsNull();
 }
 
@@ -698,11 +667,18 @@ Standard_Boolean ComesFrom(const TopoDS_Edge& E, const TopoDS_Vertex& V) {
   return GetBegVertex(E).IsSame(V);
 }
 
-void GetAdjacentEntities(
-    const TopTools_ListOfShape& inputFaces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
-    TopTools_MapOfShape& boundaryEdges, TopTools_MapOfShape& internalEdges,
-    TopTools_MapOfShape& externalFaces) {
+void GetAdjacentEntities(const TopTools_ListOfShape& inputFaces,
+                         const ShapeTopology& topology,
+                         TopTools_MapOfShape& boundaryEdges,
+                         TopTools_MapOfShape& internalEdges,
+                         TopTools_MapOfShape& externalFaces) {
+  std::vector<bool> isInputFace(topology.NbFaces(), false);
+  for (const auto& face : inputFaces) {
+    size_t faceId = topology.FaceId(face);
+    STATE_DIAGNOSTIC(faceId != ShapeTopology::NoId);
+    isInputFace[faceId] = true;
+  }
+
   for (const auto& face : inputFaces) {
     for (TopExp_Explorer itw(face, TopAbs_WIRE); itw.More(); itw.Next()) {
       const TopoDS_Wire& wire = TopoDS::Wire(itw.Value());
@@ -711,7 +687,7 @@ void GetAdjacentEntities(
         if (BRep_Tool::Degenerated(edge)) continue;
 
         TopoDS_Face externalFace;
-        if (IsBoundary(edge, edge2faces, inputFaces, externalFace)) {
+        if (IsBoundary(edge, topology, isInputFace, externalFace)) {
           boundaryEdges.Add(edge);
           externalFaces.Add(externalFace);
         } else {
@@ -723,15 +699,13 @@ void GetAdjacentEntities(
 }
 
 void ExtractBoundaryShapes(
-    const TopTools_ListOfShape& inputFaces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& verex2edges,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
+    const TopTools_ListOfShape& inputFaces, const ShapeTopology& topology,
     std::list<TopTools_ListOfShape>& contours,
     TopTools_MapOfShape& externalFaces,
     TopTools_IndexedDataMapOfShapeListOfShape& bvertex2eedges) {
   // Вычисляем внешние и внутренние ребра связанных граней `inputFaces`.
   TopTools_MapOfShape boundaryEdges, internalEdges;
-  GetAdjacentEntities(inputFaces, edge2faces, boundaryEdges, internalEdges,
+  GetAdjacentEntities(inputFaces, topology, boundaryEdges, internalEdges,
                       externalFaces);
 
   // Вычисляем граничные и внешние ребра и грани.
@@ -776,7 +750,7 @@ void ExtractBoundaryShapes(
       TopoDS_Face nextFace = cFace;
       if (!boundaryEdges.Contains(nextEdge)) {
         do {
-          nextFace = GetAdjFace(nextFace, nextEdge, edge2faces);
+          nextFace = GetAdjFace(nextFace, nextEdge, topology);
           nextEdge = GetOutgoingEdge(nextFace, boundaryVertex);
         } while (!boundaryEdges.Contains(nextEdge));
       }
@@ -792,10 +766,10 @@ void ExtractBoundaryShapes(
       TopoDS_Vertex boundaryVertex = GetEndVertex(TopoDS::Edge(edge));
 
       // Для граничной вершины вычисляем внешние ребра.
-      const auto& edges = verex2edges.FindFromKey(boundaryVertex);
       TopTools_ListOfShape externalEdges;
-      for (auto it = edges.begin(); it != edges.end(); ++it) {
-        const TopoDS_Edge& e = TopoDS::Edge(*it);
+      for (size_t edgeId :
+           topology.VertexEdges(topology.VertexId(boundaryVertex))) {
+        const TopoDS_Edge& e = topology.Edge(edgeId);
 
         if (BRep_Tool::Degenerated(e)) continue;
 
@@ -835,18 +809,17 @@ void ExtractBoundaryShapes(
 TopTools_ListOfShape::iterator GetNextContourPiece(
     const TopTools_ListOfShape::iterator& itContourStart,
     const TopTools_ListOfShape::iterator& itContourEnd,
-    const TopTools_MapOfShape& externalFaces,
-    const TopTools_IndexedDataMapOfShapeListOfShape& edge2faces,
+    const TopTools_MapOfShape& externalFaces, const ShapeTopology& topology,
     TopoDS_Face& externalFace) {
   auto itContour = itContourStart;
   bool firstIteration = true;
   while (itContour != itContourEnd) {
     const auto& e = (*itContour);
-    const auto& faces = edge2faces.FindFromKey(e);
-    STATE_DIAGNOSTIC(faces.Size() == 2);
-    TopoDS_Face exf = TopoDS::Face(faces.First());
+    std::span<const size_t> faces = topology.EdgeFaces(topology.EdgeId(e));
+    STATE_DIAGNOSTIC(faces.size() == 2);
+    TopoDS_Face exf = topology.Face(faces.front());
     if (!externalFaces.Contains(exf)) {
-      exf = TopoDS::Face(faces.Last());
+      exf = topology.Face(faces.back());
       STATE_DIAGNOSTIC(externalFaces.Contains(exf));
     }
 
@@ -1126,3 +1099,70 @@ bool VisibleContour::Dump(const std::string& fileName) const {
   return true;
 }
 }  // namespace
+
+TopoDS_Shape RemoveFaces(const TopoDS_Shape& initShape,
+                         const TopTools_ListOfShape& facesToRemove) {
+  std::vector<TopTools_ListOfShape> failedBlocks;
+  return RemoveFaces(initShape, facesToRemove, failedBlocks);
+}
+
+TopoDS_Shape RemoveFaces(const TopoDS_Shape& initShape,
+                         const TopTools_ListOfShape& facesToRemove,
+                         std::vector<TopTools_ListOfShape>& failedBlocks) {
+  failedBlocks.clear();
+  if (initShape.IsNull()) return TopoDS_Shape();
+
+  // Отношения смежности строятся один раз для всей фигуры.
+  ShapeTopology topology(initShape);
+
+  // Разделение граней на сильно связанные компоненты.
+  BOPTools_ListOfConnexityBlock features;
+  BOPTools_AlgoTools::MakeConnexityBlocks(facesToRemove, TopAbs_EDGE,
+                                          TopAbs_FACE, features);
+
+  // Блоки независимы и разделяют лишь неизменяемую топологию, поэтому
+  // анализируются параллельно, каждый в свой список контуров. Блоки разного
+  // размера раздаются потокам по одному, по мере освобождения, и каждый
+  // строится последовательно; единственный блок сам вычисляет пересечения
+  // параллельно.
+  std::vector<const BOPTools_ConnexityBlock*> blocks;
+  for (const BOPTools_ConnexityBlock& cblock : features)
+    blocks.push_back(&cblock);
+  std::vector<std::list<VisibleFaceDraft>> blockDrafts(blocks.size());
+  std::vector<char> isDone(blocks.size(), 0);
+  const bool inParallel = blocks.size() == 1;
+  std::atomic<size_t> nextBlock(0);
+  ParallelFor(std::min(NbParallelThreads(), blocks.size()),
+              [&](size_t, size_t) {
+    for (size_t i = nextBlock++; i < blocks.size(); i = nextBlock++) {
+      try {
+        isDone[i] = RemoveFaces(initShape, *blocks[i], topology, inParallel,
+                                blockDrafts[i]);
+      } catch (const Standard_Failure&) {
+        isDone[i] = 0;
+      }
+    }
+  });
+
+  // Грани строятся последовательно, после анализа всех блоков: построение
+  // ребер дополняет общие вершины исходной фигуры, которые при анализе
+  // читаются другими блоками.
+  TopTools_ListOfShape visibleFaces;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    TopTools_ListOfShape faces;
+    if (isDone[i]) {
+      try {
+        for (const VisibleFaceDraft& draft : blockDrafts[i])
+          faces.Append(CreateVisibleFace(draft));
+      } catch (const Standard_Failure&) {
+        isDone[i] = 0;
+      }
+    }
+    if (isDone[i])
+      visibleFaces.Append(faces);
+    else
+      failedBlocks.push_back(blocks[i]->Shapes());
+  }
+
+  return CreateResult(visibleFaces);
+}
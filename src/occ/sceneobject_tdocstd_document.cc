@@ -7,6 +7,7 @@
 #include "XCAFDoc_ShapeTool.hxx"
 
 #include "numgeom/drawable_occshape.h"
+#include "numgeom/utilities.h"
 
 namespace {
 struct TerminalShape {
@@ -106,9 +107,17 @@ SceneObject_TDocStd_Document::SceneObject_TDocStd_Document(
     AnalyzeLabelRecursively(shape_tool, lbl, gp_Trsf(), triangulableShapes);
   }
 
+  // Сетки всех фигур строятся заранее в нескольких потоках, конструкторы
+  // отображаемых объектов их только собирают.
+  std::vector<TopoDS_Shape> shapes;
+  for (const auto& tShape : triangulableShapes)
+    shapes.push_back(tShape.shape);
+  TriangulateShapes(shapes);
+
   auto color_tool = XCAFDoc_DocumentTool::ColorTool(doc->Main());
   for (const auto& tShape : triangulableShapes) {
     auto d = this->AddDrawable<Drawable2_OccShape>(tShape.shape, tShape.trsf);
+    d->EnableViewRefinement();
     Quantity_Color clr;
     if (!color_tool->GetColor(tShape.shape,XCAFDoc_ColorSurf,clr))
       clr = Quantity_Color(0.647,0.647,0.647,Quantity_TOC_RGB);
@@ -0,0 +1,144 @@
+#include "shapetopology.h"
+
+#include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <algorithm>
+
+ShapeTopology::ShapeTopology(const TopoDS_Shape& shape) {
+  TopExp::MapShapes(shape, TopAbs_FACE, myFaces);
+  TopExp::MapShapes(shape, TopAbs_EDGE, myEdges);
+  TopExp::MapShapes(shape, TopAbs_VERTEX, myVertices);
+
+  size_t nbFaces = myFaces.Extent();
+  size_t nbEdges = myEdges.Extent();
+  size_t nbVertices = myVertices.Extent();
+
+  // Ребра граней в порядке обхода. Повторные вхождения ребра в грань, как у
+  // шовных ребер, сохраняются для отношения "ребро -> грани".
+  std::vector<size_t> faceEdges, faceOffsets(1, 0);
+  for (size_t f = 0; f < nbFaces; ++f) {
+    for (TopExp_Explorer it(myFaces(f + 1), TopAbs_EDGE); it.More(); it.Next())
+      faceEdges.push_back(myEdges.FindIndex(it.Current()) - 1);
+    faceOffsets.push_back(faceEdges.size());
+  }
+
+  std::vector<size_t> rowSizes(nbEdges, 0);
+  for (size_t e : faceEdges) ++rowSizes[e];
+  myEdge2faces.Initialize(rowSizes);
+  std::vector<size_t> cursors(nbEdges, 0);
+  for (size_t f = 0; f < nbFaces; ++f) {
+    for (size_t k = faceOffsets[f]; k < faceOffsets[f + 1]; ++k) {
+      size_t e = faceEdges[k];
+      myEdge2faces.Data()[myEdge2faces.Offsets()[e] + cursors[e]++] = f;
+    }
+  }
+
+  rowSizes.assign(nbFaces, 0);
+  std::vector<size_t> lastFace(nbEdges, NoId);
+  std::vector<size_t> uniqueEdges;
+  for (size_t f = 0; f < nbFaces; ++f) {
+    for (size_t k = faceOffsets[f]; k < faceOffsets[f + 1]; ++k) {
+      size_t e = faceEdges[k];
+      if (lastFace[e] == f) continue;
+      lastFace[e] = f;
+      uniqueEdges.push_back(e);
+      ++rowSizes[f];
+    }
+  }
+  myFace2edges.Initialize(rowSizes);
+  std::copy(uniqueEdges.begin(), uniqueEdges.end(), myFace2edges.Data());
+
+  // Вершины ребер без повторов: у замкнутого ребра обе вершины совпадают.
+  std::vector<size_t> edgeVertices, edgeOffsets(1, 0);
+  std::vector<size_t> lastEdge(nbVertices, NoId);
+  rowSizes.assign(nbVertices, 0);
+  for (size_t e = 0; e < nbEdges; ++e) {
+    for (TopExp_Explorer it(myEdges(e + 1), TopAbs_VERTEX); it.More();
+         it.Next()) {
+      size_t v = myVertices.FindIndex(it.Current()) - 1;
+      if (lastEdge[v] == e) continue;
+      lastEdge[v] = e;
+      edgeVertices.push_back(v);
+      ++rowSizes[v];
+    }
+    edgeOffsets.push_back(edgeVertices.size());
+  }
+  myVertex2edges.Initialize(rowSizes);
+  cursors.assign(nbVertices, 0);
+  for (size_t e = 0; e < nbEdges; ++e) {
+    for (size_t k = edgeOffsets[e]; k < edgeOffsets[e + 1]; ++k) {
+      size_t v = edgeVertices[k];
+      myVertex2edges.Data()[myVertex2edges.Offsets()[v] + cursors[v]++] = e;
+    }
+  }
+}
+
+size_t ShapeTopology::NbFaces() const { return myFaces.Extent(); }
+
+size_t ShapeTopology::NbEdges() const { return myEdges.Extent(); }
+
+size_t ShapeTopology::NbVertices() const { return myVertices.Extent(); }
+
+size_t ShapeTopology::FaceId(const TopoDS_Shape& face) const {
+  return myFaces.FindIndex(face) - 1;
+}
+
+size_t ShapeTopology::EdgeId(const TopoDS_Shape& edge) const {
+  return myEdges.FindIndex(edge) - 1;
+}
+
+size_t ShapeTopology::VertexId(const TopoDS_Shape& vertex) const {
+  return myVertices.FindIndex(vertex) - 1;
+}
+
+const TopoDS_Face& ShapeTopology::Face(size_t faceId) const {
+  return TopoDS::Face(myFaces(faceId + 1));
+}
+
+const TopoDS_Edge& ShapeTopology::Edge(size_t edgeId) const {
+  return TopoDS::Edge(myEdges(edgeId + 1));
+}
+
+const TopoDS_Vertex& ShapeTopology::Vertex(size_t vertexId) const {
+  return TopoDS::Vertex(myVertices(vertexId + 1));
+}
+
+namespace {
+;
+//! Строка массива; в отличие от `operator[]` допустима и для пустой
+//! последней строки.
+std::span<const size_t> Row(const StaticJaggedArray& array, size_t i) {
+  return {array.Data() + array.Offsets()[i], array.Size(i)};
+}
+}  // namespace
+
+std::span<const size_t> ShapeTopology::EdgeFaces(size_t edgeId) const {
+  return Row(myEdge2faces, edgeId);
+}
+
+std::span<const size_t> ShapeTopology::VertexEdges(size_t vertexId) const {
+  return Row(myVertex2edges, vertexId);
+}
+
+std::span<const size_t> ShapeTopology::FaceEdges(size_t faceId) const {
+  return Row(myFace2edges, faceId);
+}
+
+size_t ShapeTopology::GetAdjFace(size_t faceId, size_t edgeId) const {
+  std::span<const size_t> faces = this->EdgeFaces(edgeId);
+  if (faces.size() != 2) return NoId;
+  return faces[0] == faceId ? faces[1] : faces[0];
+}
+
+void ShapeTopology::GetCommonEdges(size_t faceId1, size_t faceId2,
+                                   std::vector<size_t>& edgeIds) const {
+  edgeIds.clear();
+  for (size_t e : this->FaceEdges(faceId1)) {
+    for (size_t f : this->EdgeFaces(e)) {
+      if (f != faceId2) continue;
+      edgeIds.push_back(e);
+      break;
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef numgeom_occ_shapetopology_h
+#define numgeom_occ_shapetopology_h
+
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <TopoDS_Edge.hxx>
+#include <TopoDS_Face.hxx>
+#include <TopoDS_Vertex.hxx>
+#include <span>
+#include <vector>
+
+#include "numgeom/staticjaggedarray.h"
+
+class TopoDS_Shape;
+
+/**\class ShapeTopology
+\brief Индексированные отношения смежности граней, ребер и вершин фигуры.
+
+Грани, ребра и вершины нумеруются с нуля в порядке `TopExp::MapShapes`.
+Отношения "ребро -> грани", "вершина -> ребра" и "грань -> ребра" строятся
+один раз и хранятся в виде плоских массивов номеров, так что запросы
+смежности не обходят фигуру и не сравнивают списки фигур. Грани ребра
+перечисляются в том же порядке и с той же кратностью, что и в
+`TopExp::MapShapesAndAncestors`; ребра грани и вершины -- без повторов.
+*/
+class ShapeTopology {
+ public:
+  //! Номер отсутствующего элемента.
+  static constexpr size_t NoId = static_cast<size_t>(-1);
+
+ public:
+  explicit ShapeTopology(const TopoDS_Shape&);
+
+  size_t NbFaces() const;
+  size_t NbEdges() const;
+  size_t NbVertices() const;
+
+  //! Номер элемента фигуры или `NoId`. Ориентация не учитывается.
+  size_t FaceId(const TopoDS_Shape&) const;
+  size_t EdgeId(const TopoDS_Shape&) const;
+  size_t VertexId(const TopoDS_Shape&) const;
+
+  const TopoDS_Face& Face(size_t faceId) const;
+  const TopoDS_Edge& Edge(size_t edgeId) const;
+  const TopoDS_Vertex& Vertex(size_t vertexId) const;
+
+  std::span<const size_t> EdgeFaces(size_t edgeId) const;
+  std::span<const size_t> VertexEdges(size_t vertexId) const;
+  std::span<const size_t> FaceEdges(size_t faceId) const;
+
+  //! Грань, смежная с `faceId` по ребру `edgeId`, или `NoId`, если ребро не
+  //! разделяет ровно две грани.
+  size_t GetAdjFace(size_t faceId, size_t edgeId) const;
+
+  //! Общие ребра двух граней в порядке обхода ребер первой грани.
+  void GetCommonEdges(size_t faceId1, size_t faceId2,
+                      std::vector<size_t>& edgeIds) const;
+
+ private:
+  ShapeTopology(const ShapeTopology&) = delete;
+  ShapeTopology& operator=(const ShapeTopology&) = delete;
+
+ private:
+  TopTools_IndexedMapOfShape myFaces;
+  TopTools_IndexedMapOfShape myEdges;
+  TopTools_IndexedMapOfShape myVertices;
+  StaticJaggedArray myEdge2faces;
+  StaticJaggedArray myVertex2edges;
+  StaticJaggedArray myFace2edges;
+};
+
+#endif  // !numgeom_occ_shapetopology_h
@@ -14,14 +14,15 @@ void Tesselate(const Handle(Geom_Curve) & C, Standard_Real uFirst,
   Standard_Real L = cl.Length();
   Standard_Integer N = std::floor(L + 0.5);
   N = std::max(N, 2);
+  std::vector<Standard_Real> abscissae(N - 2), params;
+  for (Standard_Integer i = 1; i < N - 1; ++i)
+    abscissae[i - 1] = L / (N - 1) * i;
+  cl.ParametersByAbscissae(abscissae, params);
   polyline.resize(N);
   polyline[0] = C->Value(uFirst);
   polyline[N - 1] = C->Value(uLast);
-  for (Standard_Integer i = 1; i < N - 1; ++i) {
-    Standard_Real l = L / (N - 1) * i;
-    Standard_Real u = cl.ParameterByAbscissa(uFirst, l);
-    polyline[i] = C->Value(u);
-  }
+  for (Standard_Integer i = 1; i < N - 1; ++i)
+    polyline[i] = C->Value(params[i - 1]);
 }
 
 void Tesselate(const Handle(Geom2d_Curve) & C, Standard_Real uFirst,
@@ -31,14 +32,15 @@ void Tesselate(const Handle(Geom2d_Curve) & C, Standard_Real uFirst,
   Standard_Real L = cl.Length();
   Standard_Integer N = std::floor(L + 0.5);
   N = std::max(N, 2);
+  std::vector<Standard_Real> abscissae(N - 2), params;
+  for (Standard_Integer i = 1; i < N - 1; ++i)
+    abscissae[i - 1] = L / (N - 1) * i;
+  cl.ParametersByAbscissae(abscissae, params);
   polyline.resize(N);
   polyline[0] = C->Value(uFirst);
   polyline[N - 1] = C->Value(uLast);
-  for (Standard_Integer i = 1; i < N - 1; ++i) {
-    Standard_Real l = L / (N - 1) * i;
-    Standard_Real u = cl.ParameterByAbscissa(uFirst, l);
-    polyline[i] = C->Value(u);
-  }
+  for (Standard_Integer i = 1; i < N - 1; ++i)
+    polyline[i] = C->Value(params[i - 1]);
 }
 
 void Tesselate(const TopoDS_Face& F, const TopoDS_Wire& W,
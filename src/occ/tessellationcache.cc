@@ -0,0 +1,363 @@
+#include "numgeom/tessellationcache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "BRep_Builder.hxx"
+#include "BRep_Tool.hxx"
+#include "BRepTools.hxx"
+#include "Poly_Triangulation.hxx"
+#include "Standard_Version.hxx"
+#include "TopExp_Explorer.hxx"
+#include "TopoDS.hxx"
+#include "TopoDS_Face.hxx"
+#include "TopoDS_Shape.hxx"
+
+namespace {
+;
+
+const char kMagic[4] = {'N', 'G', 'T', 'C'};
+const uint32_t kVersion = 1;
+const char* const kBlobExtension = ".tri";
+const char* const kTempExtension = ".tmp";
+
+std::mutex s_defaultMutex;
+TessellationCache::Ptr s_default;
+
+//! 128-битный хэш из двух независимых 64-битных.
+class Hash128 {
+ public:
+  void Add(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      myFnv ^= static_cast<unsigned char>(data[i]);
+      myFnv *= 0x100000001b3ull;
+      myMix = (myMix ^ static_cast<unsigned char>(data[i])) *
+              0xff51afd7ed558ccdull;
+      myMix ^= myMix >> 29;
+    }
+  }
+
+  std::string Hex() const {
+    char buf[33];
+    std::snprintf(buf, sizeof(buf), "%016llx%016llx",
+                  static_cast<unsigned long long>(myFnv),
+                  static_cast<unsigned long long>(myMix));
+    return buf;
+  }
+
+ private:
+  uint64_t myFnv = 0xcbf29ce484222325ull;
+  uint64_t myMix = 0x9e3779b97f4a7c15ull;
+};
+
+class BlobWriter {
+ public:
+  template <typename T>
+  void Put(const T& value) {
+    const char* p = reinterpret_cast<const char*>(&value);
+    myData.insert(myData.end(), p, p + sizeof(T));
+  }
+
+  const std::vector<char>& Data() const { return myData; }
+
+ private:
+  std::vector<char> myData;
+};
+
+class BlobReader {
+ public:
+  BlobReader(const std::vector<char>& data)
+      : myPtr(data.data()), myEnd(data.data() + data.size()) {}
+
+  template <typename T>
+  bool Get(T& value) {
+    if (static_cast<size_t>(myEnd - myPtr) < sizeof(T)) return false;
+    std::memcpy(&value, myPtr, sizeof(T));
+    myPtr += sizeof(T);
+    return true;
+  }
+
+  //! Проверяет, что в файле осталось не меньше `count` значений типа T.
+  template <typename T>
+  bool Has(size_t count) const {
+    return static_cast<size_t>(myEnd - myPtr) / sizeof(T) >= count;
+  }
+
+  bool AtEnd() const { return myPtr == myEnd; }
+
+ private:
+  const char* myPtr;
+  const char* myEnd;
+};
+
+void WriteTriangulation(const Handle(Poly_Triangulation) & tr,
+                        BlobWriter& writer) {
+  if (tr.IsNull()) {
+    writer.Put(uint32_t(0));
+    writer.Put(uint32_t(0));
+    writer.Put(uint8_t(0));
+    writer.Put(0.0);
+    return;
+  }
+
+  Standard_Integer nbNodes = tr->NbNodes();
+  Standard_Integer nbTriangles = tr->NbTriangles();
+  bool hasUV = tr->HasUVNodes();
+  writer.Put(static_cast<uint32_t>(nbNodes));
+  writer.Put(static_cast<uint32_t>(nbTriangles));
+  writer.Put(static_cast<uint8_t>(hasUV));
+  writer.Put(tr->Deflection());
+  for (Standard_Integer i = 1; i <= nbNodes; ++i) {
+    gp_Pnt p = tr->Node(i);
+    writer.Put(p.X());
+    writer.Put(p.Y());
+    writer.Put(p.Z());
+  }
+  if (hasUV) {
+    for (Standard_Integer i = 1; i <= nbNodes; ++i) {
+      gp_Pnt2d p = tr->UVNode(i);
+      writer.Put(p.X());
+      writer.Put(p.Y());
+    }
+  }
+  for (Standard_Integer i = 1; i <= nbTriangles; ++i) {
+    Standard_Integer n[3];
+    tr->Triangle(i).Get(n[0], n[1], n[2]);
+    for (Standard_Integer k : n) writer.Put(static_cast<int32_t>(k));
+  }
+}
+
+//! Читает триангуляцию грани; пустая триангуляция допустима и означает, что
+//! сетку грани построить не удалось.
+bool ReadTriangulation(BlobReader& reader, Handle(Poly_Triangulation) & tr) {
+  uint32_t nbNodes, nbTriangles;
+  uint8_t hasUV;
+  double deflection;
+  if (!reader.Get(nbNodes) || !reader.Get(nbTriangles) ||
+      !reader.Get(hasUV) || !reader.Get(deflection))
+    return false;
+  if (nbNodes == 0) return nbTriangles == 0;
+
+  size_t nbReals = size_t(nbNodes) * (hasUV ? 5 : 3);
+  if (!reader.Has<double>(nbReals)) return false;
+  tr = new Poly_Triangulation(nbNodes, nbTriangles, hasUV != 0);
+  for (uint32_t i = 1; i <= nbNodes; ++i) {
+    double c[3];
+    for (double& v : c) reader.Get(v);
+    tr->SetNode(i, gp_Pnt(c[0], c[1], c[2]));
+  }
+  if (hasUV) {
+    for (uint32_t i = 1; i <= nbNodes; ++i) {
+      double c[2];
+      for (double& v : c) reader.Get(v);
+      tr->SetUVNode(i, gp_Pnt2d(c[0], c[1]));
+    }
+  }
+
+  if (!reader.Has<int32_t>(size_t(nbTriangles) * 3)) return false;
+  for (uint32_t i = 1; i <= nbTriangles; ++i) {
+    int32_t n[3];
+    for (int32_t& k : n) {
+      reader.Get(k);
+      if (k < 1 || static_cast<uint32_t>(k) > nbNodes) return false;
+    }
+    tr->SetTriangle(i, Poly_Triangle(n[0], n[1], n[2]));
+  }
+  tr->Deflection(deflection);
+  return true;
+}
+
+//! Уникальное имя временного файла: несколько потоков и процессов могут
+//! одновременно писать файл с одним ключом.
+std::string UniqueSuffix() {
+  static const uint64_t s_processId = std::random_device()();
+  static std::atomic<uint64_t> s_counter(0);
+  std::ostringstream ss;
+  ss << std::hex << s_processId << '-' << s_counter++;
+  return ss.str();
+}
+}  // namespace
+
+TessellationCache::Ptr TessellationCache::Create(
+    const std::filesystem::path& directory, uintmax_t maxSize) {
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (!std::filesystem::is_directory(directory, ec)) return Ptr();
+  return Ptr(new TessellationCache(directory, maxSize));
+}
+
+TessellationCache::TessellationCache(const std::filesystem::path& directory,
+                                     uintmax_t maxSize)
+    : myDirectory(directory),
+      myMaxSize(maxSize),
+      myCachedSize(0),
+      myCachedSizeKnown(false) {}
+
+TessellationCache::Ptr TessellationCache::Default() {
+  std::lock_guard<std::mutex> lock(s_defaultMutex);
+  return s_default;
+}
+
+void TessellationCache::SetDefault(Ptr cache) {
+  std::lock_guard<std::mutex> lock(s_defaultMutex);
+  s_default = std::move(cache);
+}
+
+std::string TessellationCache::ComputeKey(const TopoDS_Shape& shape,
+                                          const MeshParameters& params) {
+  // Экземпляры одной фигуры с разными положениями имеют общие триангуляции.
+  std::ostringstream ss;
+  BRepTools::Write(shape.Located(TopLoc_Location()), ss);
+  std::string text = ss.str();
+
+  Hash128 hash;
+  hash.Add(text.data(), text.size());
+  // Флаг `inParallel` на сетку не влияет и в ключ не входит.
+  double values[3] = {params.linearDeflection, params.angularDeflection,
+                      params.relative ? 1.0 : 0.0};
+  hash.Add(reinterpret_cast<const char*>(values), sizeof(values));
+  int version = OCC_VERSION_HEX;
+  hash.Add(reinterpret_cast<const char*>(&version), sizeof(version));
+  return hash.Hex();
+}
+
+std::filesystem::path TessellationCache::BlobPath(
+    const std::string& key) const {
+  return myDirectory / (key + kBlobExtension);
+}
+
+bool TessellationCache::Load(const std::string& key,
+                             const TopoDS_Shape& shape) {
+  std::filesystem::path path = this->BlobPath(key);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+  file.close();
+
+  BlobReader reader(data);
+  char magic[4];
+  uint32_t version, nbFaces;
+  if (!reader.Get(magic) || std::memcmp(magic, kMagic, 4) != 0 ||
+      !reader.Get(version) || version != kVersion || !reader.Get(nbFaces))
+    return false;
+
+  std::vector<TopoDS_Face> faces;
+  for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next())
+    faces.push_back(TopoDS::Face(it.Value()));
+  if (faces.size() != nbFaces) return false;
+
+  // Триангуляции присваиваются граням только после проверки всего файла.
+  std::vector<Handle(Poly_Triangulation)> triangulations(nbFaces);
+  for (Handle(Poly_Triangulation) & tr : triangulations) {
+    if (!ReadTriangulation(reader, tr)) return false;
+  }
+  if (!reader.AtEnd()) return false;
+
+  BRep_Builder builder;
+  for (size_t i = 0; i < faces.size(); ++i) {
+    TopLoc_Location l;
+    if (!triangulations[i].IsNull() && !BRep_Tool::Triangulation(faces[i], l))
+      builder.UpdateFace(faces[i], triangulations[i]);
+  }
+
+  std::error_code ec;
+  std::filesystem::last_write_time(
+      path, std::filesystem::file_time_type::clock::now(), ec);
+  return true;
+}
+
+bool TessellationCache::Store(const std::string& key,
+                              const TopoDS_Shape& shape) {
+  BlobWriter writer;
+  writer.Put(kMagic);
+  writer.Put(kVersion);
+  std::vector<TopoDS_Face> faces;
+  for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next())
+    faces.push_back(TopoDS::Face(it.Value()));
+  writer.Put(static_cast<uint32_t>(faces.size()));
+  for (const TopoDS_Face& f : faces) {
+    TopLoc_Location l;
+    WriteTriangulation(BRep_Tool::Triangulation(f, l), writer);
+  }
+
+  std::filesystem::path path = this->BlobPath(key);
+  std::filesystem::path tempPath =
+      myDirectory / (key + "." + UniqueSuffix() + kTempExtension);
+  {
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    const std::vector<char>& data = writer.Data();
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      file.close();
+      std::error_code ec;
+      std::filesystem::remove(tempPath, ec);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tempPath, path, ec);
+  if (ec) {
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(myMutex);
+  myCachedSize += writer.Data().size();
+  if (!myCachedSizeKnown || myCachedSize > myMaxSize) this->Trim();
+  return true;
+}
+
+void TessellationCache::Trim() {
+  struct Entry {
+    std::filesystem::file_time_type time;
+    uintmax_t size;
+    std::filesystem::path path;
+  };
+
+  // Временные файлы процессов, завершившихся до переименования, удаляются
+  // через час после создания.
+  auto now = std::filesystem::file_time_type::clock::now();
+  std::vector<Entry> entries;
+  uintmax_t total = 0;
+  std::error_code ec;
+  for (const auto& it : std::filesystem::directory_iterator(myDirectory, ec)) {
+    if (!it.is_regular_file(ec)) continue;
+    std::filesystem::path path = it.path();
+    auto time = it.last_write_time(ec);
+    if (ec) continue;
+    if (path.extension() == kTempExtension) {
+      if (now - time > std::chrono::hours(1))
+        std::filesystem::remove(path, ec);
+      continue;
+    }
+    if (path.extension() != kBlobExtension) continue;
+    uintmax_t size = it.file_size(ec);
+    if (ec) continue;
+    entries.push_back({time, size, path});
+    total += size;
+  }
+
+  // Удаляем с запасом, чтобы не просматривать каталог при каждой записи.
+  if (total > myMaxSize) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    uintmax_t target = myMaxSize / 4 * 3;
+    for (const Entry& entry : entries) {
+      if (total <= target) break;
+      if (std::filesystem::remove(entry.path, ec)) total -= entry.size;
+    }
+  }
+  myCachedSize = total;
+  myCachedSizeKnown = true;
+}
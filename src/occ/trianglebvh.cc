@@ -0,0 +1,334 @@
+#include "trianglebvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "numgeom/trimesh.h"
+
+namespace {
+;
+
+//! Наибольшее число треугольников в листе.
+const size_t LeafSize = 4;
+
+//! Относительный допуск барицентрических координат, в пределах которого
+//! пересечение луча считается проходящим через ребро или вершину.
+const double BarycentricTolerance = 1.e-9;
+
+//! Число запасных направлений лучей для классификации по четности.
+const size_t NbSpareDirections = 32;
+
+//! Запасное направление луча номер `i` из `NbSpareDirections`. Направления
+//! лежат на спирали Фибоначчи и равномерно покрывают сферу.
+glm::dvec3 SpareDirection(size_t i) {
+  const double goldenAngle = 2.399963229728653;
+  double z = 1.0 - (2.0 * i + 1.0) / NbSpareDirections;
+  double r = std::sqrt(1.0 - z * z);
+  double phi = goldenAngle * i + 0.5;
+  return glm::dvec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+double SquareDistanceToBox(const glm::dvec3& p, const glm::dvec3& min,
+                           const glm::dvec3& max) {
+  double sqDist = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    double d = std::max({min[i] - p[i], 0.0, p[i] - max[i]});
+    sqDist += d * d;
+  }
+  return sqDist;
+}
+
+//! Квадрат расстояния от точки до треугольника (Ericson, "Real-Time
+//! Collision Detection", 5.1.5).
+double SquareDistanceToTriangle(const glm::dvec3& p, const glm::dvec3& a,
+                                const glm::dvec3& b, const glm::dvec3& c) {
+  glm::dvec3 ab = b - a, ac = c - a, ap = p - a;
+  double d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+  if (d1 <= 0.0 && d2 <= 0.0) return glm::dot(ap, ap);
+
+  glm::dvec3 bp = p - b;
+  double d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3) return glm::dot(bp, bp);
+
+  glm::dvec3 cp = p - c;
+  double d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6) return glm::dot(cp, cp);
+
+  glm::dvec3 q;
+  double vc = d1 * d4 - d3 * d2;
+  double vb = d5 * d2 - d1 * d6;
+  double va = d3 * d6 - d5 * d4;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+    q = a + ab * (d1 / (d1 - d3));
+  } else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+    q = a + ac * (d2 / (d2 - d6));
+  } else if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0) {
+    q = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  } else {
+    double denom = 1.0 / (va + vb + vc);
+    q = a + ab * (vb * denom) + ac * (vc * denom);
+  }
+  glm::dvec3 pq = p - q;
+  return glm::dot(pq, pq);
+}
+
+//! Пересекает ли луч коробку.
+bool RayHitsBox(const glm::dvec3& origin, const glm::dvec3& invDir,
+                const glm::dvec3& min, const glm::dvec3& max) {
+  double tMin = 0.0, tMax = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < 3; ++i) {
+    double t0 = (min[i] - origin[i]) * invDir[i];
+    double t1 = (max[i] - origin[i]) * invDir[i];
+    if (t0 > t1) std::swap(t0, t1);
+    // Для луча, параллельного граням коробки, `0 * inf` дает NaN, и
+    // сравнения с ним ложны: такая ось не ограничивает отрезок.
+    if (t0 > tMin) tMin = t0;
+    if (t1 < tMax) tMax = t1;
+    if (tMin > tMax) return false;
+  }
+  return true;
+}
+//! Пересекает ли треугольник коробку с центром в начале координат и
+//! полуразмерами `h`. Проверяются разделяющие оси: нормали граней коробки,
+//! нормаль треугольника и произведения ребер (Akenine-Möller).
+bool TriangleHitsBox(const glm::dvec3& h, const glm::dvec3 v[3]) {
+  for (int i = 0; i < 3; ++i) {
+    double vMin = std::min({v[0][i], v[1][i], v[2][i]});
+    double vMax = std::max({v[0][i], v[1][i], v[2][i]});
+    if (vMin > h[i] || vMax < -h[i]) return false;
+  }
+
+  auto separates = [&](const glm::dvec3& axis) {
+    double p0 = glm::dot(axis, v[0]);
+    double p1 = glm::dot(axis, v[1]);
+    double p2 = glm::dot(axis, v[2]);
+    double r = h.x * std::abs(axis.x) + h.y * std::abs(axis.y) +
+               h.z * std::abs(axis.z);
+    return std::min({p0, p1, p2}) > r || std::max({p0, p1, p2}) < -r;
+  };
+
+  glm::dvec3 e[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+  if (separates(glm::cross(e[0], e[1]))) return false;
+  for (int i = 0; i < 3; ++i) {
+    glm::dvec3 unit(0.0);
+    unit[i] = 1.0;
+    for (int j = 0; j < 3; ++j) {
+      if (separates(glm::cross(unit, e[j]))) return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TriangleBVH::TriangleBVH(const CTriMesh& mesh) {
+  size_t nbTriangles = mesh.NbCells();
+  std::vector<glm::dvec3> centers(nbTriangles), mins(nbTriangles),
+      maxs(nbTriangles);
+  for (size_t i = 0; i < nbTriangles; ++i) {
+    const CTriMesh::Cell& cell = mesh.GetCell(i);
+    const glm::dvec3& a = mesh.GetNode(cell.na);
+    const glm::dvec3& b = mesh.GetNode(cell.nb);
+    const glm::dvec3& c = mesh.GetNode(cell.nc);
+    mins[i] = glm::min(a, glm::min(b, c));
+    maxs[i] = glm::max(a, glm::max(b, c));
+    centers[i] = (mins[i] + maxs[i]) * 0.5;
+  }
+
+  std::vector<uint32_t> order(nbTriangles);
+  std::iota(order.begin(), order.end(), 0);
+  if (nbTriangles != 0) {
+    myNodes.reserve(2 * (nbTriangles / LeafSize) + 1);
+    this->Build(order, centers, mins, maxs, 0, nbTriangles);
+  }
+
+  myVertices.reserve(3 * nbTriangles);
+  for (uint32_t i : order) {
+    const CTriMesh::Cell& cell = mesh.GetCell(i);
+    myVertices.push_back(mesh.GetNode(cell.na));
+    myVertices.push_back(mesh.GetNode(cell.nb));
+    myVertices.push_back(mesh.GetNode(cell.nc));
+  }
+}
+
+uint32_t TriangleBVH::Build(std::vector<uint32_t>& order,
+                            const std::vector<glm::dvec3>& centers,
+                            const std::vector<glm::dvec3>& mins,
+                            const std::vector<glm::dvec3>& maxs, size_t begin,
+                            size_t end) {
+  uint32_t index = static_cast<uint32_t>(myNodes.size());
+  myNodes.emplace_back();
+
+  glm::dvec3 min = mins[order[begin]], max = maxs[order[begin]];
+  glm::dvec3 cMin = centers[order[begin]], cMax = cMin;
+  for (size_t i = begin + 1; i < end; ++i) {
+    min = glm::min(min, mins[order[i]]);
+    max = glm::max(max, maxs[order[i]]);
+    cMin = glm::min(cMin, centers[order[i]]);
+    cMax = glm::max(cMax, centers[order[i]]);
+  }
+  myNodes[index].min = min;
+  myNodes[index].max = max;
+
+  glm::dvec3 extent = cMax - cMin;
+  int axis = 0;
+  if (extent[1] > extent[axis]) axis = 1;
+  if (extent[2] > extent[axis]) axis = 2;
+  if (end - begin <= LeafSize || extent[axis] == 0.0) {
+    myNodes[index].first = static_cast<uint32_t>(begin);
+    myNodes[index].count = static_cast<uint32_t>(end - begin);
+    return index;
+  }
+
+  size_t mid = (begin + end) / 2;
+  std::nth_element(order.begin() + begin, order.begin() + mid,
+                   order.begin() + end, [&](uint32_t a, uint32_t b) {
+                     return centers[a][axis] < centers[b][axis];
+                   });
+  this->Build(order, centers, mins, maxs, begin, mid);
+  uint32_t right = this->Build(order, centers, mins, maxs, mid, end);
+  myNodes[index].first = right;
+  myNodes[index].count = 0;
+  return index;
+}
+
+void TriangleBVH::GetBox(glm::dvec3& min, glm::dvec3& max) const {
+  if (myNodes.empty()) {
+    min = glm::dvec3(std::numeric_limits<double>::max());
+    max = glm::dvec3(-std::numeric_limits<double>::max());
+    return;
+  }
+  min = myNodes.front().min;
+  max = myNodes.front().max;
+}
+
+bool TriangleBVH::IsCloser(const glm::dvec3& point, double distance) const {
+  if (myNodes.empty()) return false;
+
+  double sqDistance = distance * distance;
+  std::vector<uint32_t> stack(1, 0);
+  while (!stack.empty()) {
+    uint32_t index = stack.back();
+    const Node& node = myNodes[index];
+    stack.pop_back();
+    if (SquareDistanceToBox(point, node.min, node.max) > sqDistance) continue;
+
+    if (node.count == 0) {
+      stack.push_back(node.first);
+      stack.push_back(index + 1);
+      continue;
+    }
+
+    for (uint32_t t = node.first; t < node.first + node.count; ++t) {
+      const glm::dvec3* v = &myVertices[3 * size_t(t)];
+      if (SquareDistanceToTriangle(point, v[0], v[1], v[2]) <= sqDistance)
+        return true;
+    }
+  }
+  return false;
+}
+
+bool TriangleBVH::CountCrossings(const glm::dvec3& origin,
+                                 const glm::dvec3& dir,
+                                 size_t& nbCrossings) const {
+  nbCrossings = 0;
+  if (myNodes.empty()) return true;
+
+  glm::dvec3 invDir(1.0 / dir.x, 1.0 / dir.y, 1.0 / dir.z);
+  std::vector<uint32_t> stack(1, 0);
+  while (!stack.empty()) {
+    uint32_t index = stack.back();
+    const Node& node = myNodes[index];
+    stack.pop_back();
+    if (!RayHitsBox(origin, invDir, node.min, node.max)) continue;
+
+    if (node.count == 0) {
+      stack.push_back(node.first);
+      stack.push_back(index + 1);
+      continue;
+    }
+
+    // Пересечение луча с треугольником (Möller, Trumbore).
+    for (uint32_t t = node.first; t < node.first + node.count; ++t) {
+      const glm::dvec3* v = &myVertices[3 * size_t(t)];
+      glm::dvec3 e1 = v[1] - v[0], e2 = v[2] - v[0];
+      glm::dvec3 pvec = glm::cross(dir, e2);
+      double det = glm::dot(e1, pvec);
+      // Луч, параллельный плоскости треугольника, касается лишь его ребер,
+      // а они принадлежат и соседним треугольникам, где касание
+      // обнаруживается как пересечение вблизи ребра.
+      if (std::abs(det) <= 1.e-12 * glm::length(e1) * glm::length(e2))
+        continue;
+
+      double invDet = 1.0 / det;
+      glm::dvec3 tvec = origin - v[0];
+      double u = glm::dot(tvec, pvec) * invDet;
+      if (u < -BarycentricTolerance || u > 1.0 + BarycentricTolerance)
+        continue;
+      glm::dvec3 qvec = glm::cross(tvec, e1);
+      double w = glm::dot(dir, qvec) * invDet;
+      if (w < -BarycentricTolerance || u + w > 1.0 + BarycentricTolerance)
+        continue;
+      if (glm::dot(e2, qvec) * invDet <= 0.0) continue;
+
+      if (u < BarycentricTolerance || w < BarycentricTolerance ||
+          u + w > 1.0 - BarycentricTolerance)
+        return false;
+      ++nbCrossings;
+    }
+  }
+  return true;
+}
+
+bool TriangleBVH::ClassifyByParity(const glm::dvec3& point,
+                                   bool& isInside) const {
+  // Направления лучей не параллельны осям, так что лучи редко проходят вдоль
+  // ребер сеток плоских граней, ориентированных по осям.
+  static const glm::dvec3 s_directions[] = {
+      glm::normalize(glm::dvec3(1.0, 0.5772156649, 0.3141592654)),
+      glm::normalize(glm::dvec3(-0.2718281828, 1.0, 0.4142135624)),
+      glm::normalize(glm::dvec3(0.1732050808, -0.6180339887, 1.0))};
+
+  size_t nbCrossings;
+  for (const glm::dvec3& dir : s_directions) {
+    if (!this->CountCrossings(point, dir, nbCrossings)) continue;
+    isInside = nbCrossings % 2 == 1;
+    return true;
+  }
+  for (size_t i = 0; i < NbSpareDirections; ++i) {
+    if (!this->CountCrossings(point, SpareDirection(i), nbCrossings)) continue;
+    isInside = nbCrossings % 2 == 1;
+    return true;
+  }
+  return false;
+}
+
+bool TriangleBVH::Intersects(const glm::dvec3& min,
+                             const glm::dvec3& max) const {
+  if (myNodes.empty()) return false;
+
+  glm::dvec3 center = (min + max) * 0.5, half = (max - min) * 0.5;
+  std::vector<uint32_t> stack(1, 0);
+  while (!stack.empty()) {
+    uint32_t index = stack.back();
+    const Node& node = myNodes[index];
+    stack.pop_back();
+    if (node.min.x > max.x || node.max.x < min.x || node.min.y > max.y ||
+        node.max.y < min.y || node.min.z > max.z || node.max.z < min.z)
+      continue;
+
+    if (node.count == 0) {
+      stack.push_back(node.first);
+      stack.push_back(index + 1);
+      continue;
+    }
+
+    for (uint32_t t = node.first; t < node.first + node.count; ++t) {
+      const glm::dvec3* v = &myVertices[3 * size_t(t)];
+      glm::dvec3 local[3] = {v[0] - center, v[1] - center, v[2] - center};
+      if (TriangleHitsBox(half, local)) return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,79 @@
+#ifndef numgeom_occ_trianglebvh_h
+#define numgeom_occ_trianglebvh_h
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class CTriMesh;
+
+/**\class TriangleBVH
+\brief Иерархия ограничивающих коробок треугольников сетки.
+
+Треугольники делятся пополам по медиане центров вдоль самой длинной стороны
+коробки, пока в листе их не останется несколько. Узлы и вершины треугольников
+хранятся плоскими массивами в порядке обхода дерева. После построения
+иерархия не изменяется, и запросы можно выполнять одновременно из нескольких
+потоков.
+*/
+class TriangleBVH {
+ public:
+  explicit TriangleBVH(const CTriMesh& mesh);
+
+  size_t NbTriangles() const { return myVertices.size() / 3; }
+
+  //! Коробка всех треугольников; для пустой сетки `min > max`.
+  void GetBox(glm::dvec3& min, glm::dvec3& max) const;
+
+  //! Есть ли треугольник, расстояние от которого до точки не больше
+  //! `distance`.
+  bool IsCloser(const glm::dvec3& point, double distance) const;
+
+  /**
+  \brief Считает пересечения луча с треугольниками.
+  \param dir Единичное направление луча.
+  \return Ложь, если луч проходит вблизи ребра или вершины треугольника, и
+          число пересечений не определено.
+  */
+  bool CountCrossings(const glm::dvec3& origin, const glm::dvec3& dir,
+                      size_t& nbCrossings) const;
+
+  /**
+  \brief Определяет по четности числа пересечений луча с замкнутой сеткой,
+         лежит ли точка внутри нее.
+
+  Лучи выпускаются по нескольким направлениям, не параллельным осям, пока
+  один из них не даст определенного числа пересечений. Если все они
+  вырождены, перебираются направления, равномерно распределенные по сфере.
+  \return Ложь, если все лучи проходят вблизи ребер или вершин; для точки,
+          удаленной от сетки, это практически невозможно.
+  */
+  bool ClassifyByParity(const glm::dvec3& point, bool& isInside) const;
+
+  //! Пересекает ли какой-либо треугольник замкнутую коробку.
+  bool Intersects(const glm::dvec3& min, const glm::dvec3& max) const;
+
+ private:
+  struct Node {
+    glm::dvec3 min, max;
+    //! Для листа - первый треугольник, для внутреннего узла - номер правого
+    //! потомка; левый потомок следует сразу за узлом.
+    uint32_t first;
+    //! Число треугольников листа; ноль у внутреннего узла.
+    uint32_t count;
+  };
+
+  uint32_t Build(std::vector<uint32_t>& order,
+                 const std::vector<glm::dvec3>& centers,
+                 const std::vector<glm::dvec3>& mins,
+                 const std::vector<glm::dvec3>& maxs, size_t begin,
+                 size_t end);
+
+ private:
+  std::vector<Node> myNodes;
+  //! По три вершины на треугольник в порядке листьев.
+  std::vector<glm::dvec3> myVertices;
+};
+
+#endif  // !numgeom_occ_trianglebvh_h
@@ -1,6 +1,8 @@
 #include "numgeom/utilities.h"
 
-#include <unordered_map>
+#include <atomic>
+#include <numeric>
+#include <queue>
 
 #include <BRepBndLib.hxx>
 #include <BRepClass_FaceClassifier.hxx>
@@ -22,7 +24,10 @@
 #include <STEPControl_Writer.hxx>
 #include <ShapeFix_Shape.hxx>
 #include <TopExp.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopTools_DataMapOfShapeInteger.hxx>
 #include <TopTools_IndexedDataMapOfShapeListOfShape.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
 #include <TopoDS.hxx>
 #include <TopoDS_Edge.hxx>
 #include <TopoDS_Face.hxx>
@@ -30,6 +35,10 @@
 #include <TopoDS_Shell.hxx>
 #include <TopoDS_Solid.hxx>
 
+#include "numgeom/loadasync.h"
+#include "numgeom/parallelfor.h"
+#include "numgeom/tessellationcache.h"
+
 Bnd_Box2d ComputePCurvesBox(const TopoDS_Face& F) {
   static const Standard_Real tol = Precision::Confusion();
 
@@ -150,8 +159,6 @@ Standard_Real Project(const gp_Pnt& P, const Handle(Geom_Curve) & C) {
   return project.LowerDistanceParameter();
 }
 
-namespace {
-;
 void ExtractTriangulableShapes(const TopoDS_Shape& initShape,
                                std::vector<TopoDS_Shape>& resultShapes) {
   if (initShape.IsNull()) return;
@@ -183,64 +190,194 @@ void ExtractTriangulableShapes(const TopoDS_Shape& initShape,
     }
   }
 }
-}  // namespace
 
-TriMesh::Ptr ConvertToTriMesh(const TopoDS_Shape& initShape) {
-  std::unordered_map<TopoDS_Face,
-                     std::pair<Handle(Poly_Triangulation), TopLoc_Location> >
-      face2triangulation;
+namespace {
+;
 
-  std::vector<TopoDS_Shape> triangulableShapes;
-  ExtractTriangulableShapes(initShape, triangulableShapes);
+//! Есть ли у всех граней сетки, прогиб которых не больше требуемого.
+bool IsTriangulated(const TopoDS_Shape& shape, const MeshParameters& params) {
+  if (params.relative) return false;
+  for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next()) {
+    TopLoc_Location l;
+    const Handle(Poly_Triangulation)& tr =
+        BRep_Tool::Triangulation(TopoDS::Face(it.Value()), l);
+    if (tr.IsNull() ||
+        tr->Deflection() > params.linearDeflection * (1.0 + 1.0e-7))
+      return false;
+  }
+  return true;
+}
+
+Standard_Integer NbFaces(const TopoDS_Shape& shape) {
+  TopTools_IndexedMapOfShape faces;
+  TopExp::MapShapes(shape, TopAbs_FACE, faces);
+  return faces.Extent();
+}
 
-  for (const TopoDS_Shape& shape : triangulableShapes) {
-    for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next()) {
-      const TopoDS_Face& f = TopoDS::Face(it.Value());
-      TopLoc_Location l;
-      Handle(Poly_Triangulation) tr = BRep_Tool::Triangulation(f, l);
-      if (!tr) {
-        BRepMesh_IncrementalMesh(f, 0.6f);
-        tr = BRep_Tool::Triangulation(f, l);
+//! Разбивает фигуры на группы, связанные общими ребрами. Группы и фигуры в
+//! них упорядочены по возрастанию номеров.
+std::vector<std::vector<Standard_Integer>> GroupByCommonEdges(
+    const TopTools_IndexedMapOfShape& shapes) {
+  Standard_Integer nbShapes = shapes.Extent();
+  std::vector<Standard_Integer> parent(nbShapes + 1);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&parent](Standard_Integer i) {
+    while (parent[i] != i) i = parent[i] = parent[parent[i]];
+    return i;
+  };
+
+  TopTools_DataMapOfShapeInteger edge2shape;
+  for (Standard_Integer i = 1; i <= nbShapes; ++i) {
+    for (TopExp_Explorer it(shapes(i), TopAbs_EDGE); it.More(); it.Next()) {
+      TopoDS_Shape edge = it.Current().Located(TopLoc_Location());
+      if (const Standard_Integer* j = edge2shape.Seek(edge)) {
+        Standard_Integer a = find(i), b = find(*j);
+        parent[std::max(a, b)] = std::min(a, b);
+      } else {
+        edge2shape.Bind(edge, i);
       }
-      face2triangulation.insert(std::make_pair(f, std::make_pair(tr, l)));
     }
   }
 
-  size_t nbNodes = 0, nbCells = 0;
-  for (const auto& v : face2triangulation) {
-    nbNodes += v.second.first->NbNodes();
-    nbCells += v.second.first->NbTriangles();
+  std::vector<std::vector<Standard_Integer>> groups;
+  std::vector<Standard_Integer> root2group(nbShapes + 1, -1);
+  for (Standard_Integer i = 1; i <= nbShapes; ++i) {
+    Standard_Integer root = find(i);
+    if (root2group[root] < 0) {
+      root2group[root] = static_cast<Standard_Integer>(groups.size());
+      groups.emplace_back();
+    }
+    groups[root2group[root]].push_back(i);
+  }
+  return groups;
+}
+}  // namespace
+
+void TriangulateShape(const TopoDS_Shape& shape, const MeshParameters& params) {
+  if (IsTriangulated(shape, params)) return;
+
+  TessellationCache::Ptr cache = TessellationCache::Default();
+  std::string key;
+  if (cache) {
+    key = TessellationCache::ComputeKey(shape, params);
+    if (cache->Load(key, shape)) return;
+  }
+
+  // Внутри фигуры грани распределяются между потоками средствами OCC:
+  // ребра дискретизируются заранее, так что сетки граней независимы.
+  BRepMesh_IncrementalMesh(shape, params.linearDeflection, params.relative,
+                           params.angularDeflection, params.inParallel);
+
+  if (cache) cache->Store(key, shape);
+}
+
+bool TriangulateShapes(const std::vector<TopoDS_Shape>& initShapes,
+                       const MeshParameters& params, LoadProgress* progress) {
+  TopTools_IndexedMapOfShape shapes;
+  for (const TopoDS_Shape& shape : initShapes) {
+    TopoDS_Shape prototype = shape.Located(TopLoc_Location());
+    if (!IsTriangulated(prototype, params)) shapes.Add(prototype);
+  }
+
+  std::vector<Standard_Integer> nbFaces(shapes.Extent() + 1, 0);
+  for (Standard_Integer i = 1; i <= shapes.Extent(); ++i)
+    nbFaces[i] = NbFaces(shapes(i));
+  if (progress) {
+    progress->SetTotalFaces(
+        std::accumulate(nbFaces.begin(), nbFaces.end(), size_t(0)));
   }
 
-  TriMesh::Ptr mesh = TriMesh::Create(nbNodes, nbCells);
-  Standard_Integer nodeIndex = 0, cellIndex = 0, nodeOffset = 0;
-  for (const auto& v : face2triangulation) {
-    Handle(Poly_Triangulation) triangulation = v.second.first;
-    const TopLoc_Location& location = v.second.second;
-    const gp_Trsf& tr = location.Transformation();
-    Standard_Integer nbNodes = triangulation->NbNodes();
-    for (Standard_Integer i = 1; i <= nbNodes; ++i) {
-      gp_Pnt pt = triangulation->Node(i);
-      pt.Transform(tr);
-      mesh->GetNode(nodeIndex++) = TriMesh::NodeType(pt.X(), pt.Y(), pt.Z());
+  std::vector<std::vector<Standard_Integer>> groups =
+      GroupByCommonEdges(shapes);
+  if (groups.size() <= 1 || !params.inParallel) {
+    for (const std::vector<Standard_Integer>& group : groups) {
+      for (Standard_Integer i : group) {
+        if (progress && progress->IsCancelled()) return false;
+        TriangulateShape(shapes(i), params);
+        if (progress) progress->AddMeshedFaces(nbFaces[i]);
+      }
     }
+    return !(progress && progress->IsCancelled());
+  }
 
-    bool normalConsistent = (v.first.Orientation() == TopAbs_FORWARD);
-    Standard_Integer nbCells = triangulation->NbTriangles();
-    for (Standard_Integer i = 1; i <= nbCells; ++i) {
-      const Poly_Triangle& cell = triangulation->Triangle(i);
-      Standard_Integer na, nb, nc;
-      cell.Get(na, nb, nc);
-      if (!normalConsistent) std::swap(nb, nc);
-      mesh->GetCell(cellIndex++) =
-          TriMesh::Cell{static_cast<TriMesh::IndexType>(na + nodeOffset - 1),
-                        static_cast<TriMesh::IndexType>(nb + nodeOffset - 1),
-                        static_cast<TriMesh::IndexType>(nc + nodeOffset - 1)};
+  // Группы разного размера раздаются потокам по одной, по мере
+  // освобождения; каждая группа строится последовательно.
+  MeshParameters groupParams = params;
+  groupParams.inParallel = false;
+  std::atomic<size_t> nextGroup(0);
+  ParallelFor(NbParallelThreads(), [&](size_t, size_t) {
+    for (size_t g = nextGroup++; g < groups.size(); g = nextGroup++) {
+      for (Standard_Integer i : groups[g]) {
+        if (progress && progress->IsCancelled()) return;
+        TriangulateShape(shapes(i), groupParams);
+        if (progress) progress->AddMeshedFaces(nbFaces[i]);
+      }
     }
+  });
+  return !(progress && progress->IsCancelled());
+}
 
-    nodeOffset += nbNodes;
+TriMesh::Ptr ConvertToTriMesh(const TopoDS_Shape& initShape,
+                              const MeshParameters& params) {
+  std::vector<TopoDS_Shape> triangulableShapes;
+  ExtractTriangulableShapes(initShape, triangulableShapes);
+  TriangulateShapes(triangulableShapes, params);
+
+  // Грани нумеруются в порядке обхода, повторные вхождения пропускаются.
+  TopTools_IndexedMapOfShape faces;
+  for (const TopoDS_Shape& shape : triangulableShapes)
+    TopExp::MapShapes(shape, TopAbs_FACE, faces);
+
+  Standard_Integer nbFaces = faces.Extent();
+  std::vector<Handle(Poly_Triangulation)> triangulations(nbFaces);
+  std::vector<TopLoc_Location> locations(nbFaces);
+  std::vector<size_t> nodeOffsets(nbFaces + 1, 0);
+  std::vector<size_t> cellOffsets(nbFaces + 1, 0);
+  for (Standard_Integer i = 0; i < nbFaces; ++i) {
+    const TopoDS_Face& f = TopoDS::Face(faces(i + 1));
+    triangulations[i] = BRep_Tool::Triangulation(f, locations[i]);
+    size_t nbNodes = 0, nbCells = 0;
+    if (!triangulations[i].IsNull()) {
+      nbNodes = triangulations[i]->NbNodes();
+      nbCells = triangulations[i]->NbTriangles();
+    }
+    nodeOffsets[i + 1] = nodeOffsets[i] + nbNodes;
+    cellOffsets[i + 1] = cellOffsets[i] + nbCells;
   }
 
+  TriMesh::Ptr mesh = TriMesh::Create(nodeOffsets.back(), cellOffsets.back());
+  ParallelFor(nbFaces, [&](size_t begin, size_t end) {
+    for (size_t iFace = begin; iFace < end; ++iFace) {
+      const Handle(Poly_Triangulation)& triangulation = triangulations[iFace];
+      if (triangulation.IsNull()) continue;
+      const gp_Trsf& tr = locations[iFace].Transformation();
+      size_t nodeIndex = nodeOffsets[iFace];
+      Standard_Integer nbNodes = triangulation->NbNodes();
+      for (Standard_Integer i = 1; i <= nbNodes; ++i) {
+        gp_Pnt pt = triangulation->Node(i);
+        pt.Transform(tr);
+        mesh->GetNode(nodeIndex++) =
+            TriMesh::NodeType(pt.X(), pt.Y(), pt.Z());
+      }
+
+      const TopoDS_Shape& f = faces(static_cast<Standard_Integer>(iFace) + 1);
+      bool normalConsistent = (f.Orientation() == TopAbs_FORWARD);
+      size_t nodeOffset = nodeOffsets[iFace];
+      size_t cellIndex = cellOffsets[iFace];
+      Standard_Integer nbCells = triangulation->NbTriangles();
+      for (Standard_Integer i = 1; i <= nbCells; ++i) {
+        const Poly_Triangle& cell = triangulation->Triangle(i);
+        Standard_Integer na, nb, nc;
+        cell.Get(na, nb, nc);
+        if (!normalConsistent) std::swap(nb, nc);
+        mesh->GetCell(cellIndex++) =
+            TriMesh::Cell{static_cast<TriMesh::IndexType>(na + nodeOffset - 1),
+                          static_cast<TriMesh::IndexType>(nb + nodeOffset - 1),
+                          static_cast<TriMesh::IndexType>(nc + nodeOffset - 1)};
+      }
+    }
+  });
+
   return mesh;
 }
 
@@ -1,8 +1,11 @@
-﻿#include "BRepClass_FaceClassifier.hxx"
+﻿#include "BRepClass3d_SolidClassifier.hxx"
+#include "BRepClass_FaceClassifier.hxx"
+#include "Bnd_Box.hxx"
 #include "Bnd_Box2d.hxx"
 #include "TopExp_Explorer.hxx"
 #include "TopoDS.hxx"
 #include "TopoDS_Face.hxx"
+#include "gp_Pnt.hxx"
 #include "gp_Pnt2d.hxx"
 #include "gtest/gtest.h"
 #include "numgeom/classificate.h"
@@ -36,3 +39,61 @@ TEST(Classificate, Face) {
     aux = nullptr;
   }
 }
+
+TEST(Classificate, FaceClassifierBatch) {
+  TopoDS_Shape model = LoadFromFile(TestData("rounded-cube.step"));
+  ASSERT_FALSE(model.IsNull());
+  for (TopExp_Explorer it(model, TopAbs_FACE); it.More(); it.Next()) {
+    TopoDS_Face face = TopoDS::Face(it.Current());
+    FaceClassifier classifier(face);
+    Bnd_Box2d pCurvesBox = ComputePCurvesBox(face);
+    Standard_Integer iN, jN;
+    GetMeshSideSizes(pCurvesBox, 1000, iN, jN);
+    Standard_Real xMin, yMin, xMax, yMax;
+    pCurvesBox.Get(xMin, yMin, xMax, yMax);
+    std::vector<gp_Pnt2d> points;
+    for (Standard_Integer j = 0; j <= jN; ++j) {
+      Standard_Real y = yMin + (yMax - yMin) / jN * j;
+      for (Standard_Integer i = 0; i <= iN; ++i)
+        points.emplace_back(xMin + (xMax - xMin) / iN * i, y);
+    }
+    std::vector<TopAbs_State> states = classifier.Classify(points);
+    ASSERT_EQ(states.size(), points.size());
+    for (size_t k = 0; k < points.size(); ++k) {
+      ASSERT_EQ(states[k], classifier.Classify(points[k]));
+      ASSERT_EQ(states[k], Classificate(face, points[k]));
+    }
+  }
+}
+
+TEST(Classificate, SolidClassifierBatch) {
+  TopoDS_Shape model = LoadFromFile(TestData("rounded-cube.step"));
+  ASSERT_FALSE(model.IsNull());
+  SolidClassifier classifier(model);
+
+  // Сетка точек немного больше габаритов тела, так что в нее попадают
+  // внешние, внутренние и близкие к поверхности точки.
+  Bnd_Box box = ComputeBoundBox(model);
+  box.Enlarge(0.1 * std::sqrt(box.SquareExtent()));
+  Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+  box.Get(xMin, yMin, zMin, xMax, yMax, zMax);
+  const int n = 30;
+  std::vector<gp_Pnt> points;
+  for (int k = 0; k <= n; ++k) {
+    for (int j = 0; j <= n; ++j) {
+      for (int i = 0; i <= n; ++i)
+        points.emplace_back(xMin + (xMax - xMin) / n * i,
+                            yMin + (yMax - yMin) / n * j,
+                            zMin + (zMax - zMin) / n * k);
+    }
+  }
+
+  std::vector<TopAbs_State> states = classifier.Classify(points);
+  ASSERT_EQ(states.size(), points.size());
+  BRepClass3d_SolidClassifier exact(model);
+  for (size_t i = 0; i < points.size(); ++i) {
+    exact.Perform(points[i], 1.e-7);
+    ASSERT_EQ(states[i], exact.State());
+    ASSERT_EQ(states[i], classifier.Classify(points[i]));
+  }
+}
@@ -3,6 +3,8 @@
 #include "numgeom/drawable_sphere.h"
 #include "numgeom/scene.h"
 #include "numgeom/sceneobject.h"
+#include "numgeom/sceneobject_mesh.h"
+#include "numgeom/trimesh.h"
 
 template<typename DrawableType>
 class SceneObject_WithDrawable : public SceneObject {
@@ -62,3 +64,36 @@ TEST(Drawable, DrawableSphereGetTriangles) {
     ASSERT_LT(tr.z, d2->GetCellsCount());
   }
 }
+
+TEST(Drawable, PointFieldColors) {
+  std::vector<TriMesh::NodeType> nodes = {
+      {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}};
+  std::vector<TriMesh::Cell> cells = {TriMesh::Cell(0, 1, 2)};
+  TriMesh::Ptr mesh = TriMesh::Create(std::move(nodes), std::move(cells));
+  MeshField::Ptr field =
+      MeshField::Create("pressure", MeshField::ValueType::Float, 1, 3);
+  for (size_t i = 0; i < 3; ++i) field->SetValue(i, 0, 2.0 * i);
+  ASSERT_TRUE(mesh->AddPointField(field));
+
+  Scene scene("scene");
+  SceneObject* o = scene.AddObject<SceneObject_Mesh>(mesh);
+  Drawable2* d = Drawable2::Cast(*o->Drawables());
+  ASSERT_TRUE(d != nullptr);
+  EXPECT_EQ(d->GetColorField(), "pressure");
+  EXPECT_EQ(d->GetPointField("pressure"), field);
+
+  // Наименьшее значение - синий цвет, наибольшее - красный.
+  std::vector<float> colors(9);
+  EXPECT_EQ(d->CopyVertexColors(colors.data()), colors.data() + 9);
+  EXPECT_EQ(glm::vec3(colors[0], colors[1], colors[2]),
+            glm::vec3(0.0f, 0.0f, 1.0f));
+  EXPECT_EQ(glm::vec3(colors[3], colors[4], colors[5]),
+            glm::vec3(0.5f, 0.0f, 0.5f));
+  EXPECT_EQ(glm::vec3(colors[6], colors[7], colors[8]),
+            glm::vec3(1.0f, 0.0f, 0.0f));
+
+  // Без массива вершины окрашены цветом объекта.
+  d->SetColorField("");
+  d->CopyVertexColors(colors.data());
+  EXPECT_EQ(glm::vec3(colors[3], colors[4], colors[5]), d->GetColor());
+}
@@ -0,0 +1,276 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gp_Trsf.hxx"
+#include "gp_Vec.hxx"
+#include "gtest/gtest.h"
+
+#include "numgeom/drawable_occshape.h"
+#include "numgeom/scene.h"
+#include "numgeom/sceneobject.h"
+#include "numgeom/utilities.h"
+
+#include "utilities.h"
+
+namespace {
+;
+
+class SceneObject_OccShape : public SceneObject {
+ public:
+  SceneObject_OccShape(Scene* scene, const TopoDS_Shape& shape,
+                       const gp_Trsf& trsf = gp_Trsf(),
+                       const MeshParameters& params = MeshParameters())
+      : SceneObject(scene) {
+    drawable = this->AddDrawable<Drawable2_OccShape>(shape, trsf, params);
+  }
+
+  Drawable2_OccShape* drawable;
+};
+
+//! Повторяет обновление вида, пока уточнение сеток не закончится.
+void RefineForView(Drawable2_OccShape* d, const glm::vec3& eye,
+                   float pixelScale) {
+  for (int i = 0; i < 10000 && d->UpdateView(eye, pixelScale); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+}  // namespace
+
+TEST(Drawable2_OccShape, ViewRefinement) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  Scene scene("scene");
+  auto o = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape));
+  Drawable2_OccShape* d = o->drawable;
+  const size_t nbCoarseCells = d->GetCellsCount();
+  ASSERT_GT(nbCoarseCells, 0);
+
+  d->EnableViewRefinement(1.0, 3);
+
+  // Издалека грубые сетки достаточны.
+  const glm::vec3 farEye(1.0e6f, 0.0f, 0.0f);
+  EXPECT_FALSE(d->UpdateView(farEye, 1000.0f));
+  EXPECT_EQ(d->GetCellsCount(), nbCoarseCells);
+
+  // Вблизи сетки уточняются в фоне.
+  const glm::vec3 nearEye(0.0f, 0.0f, 0.0f);
+  RefineForView(d, nearEye, 1000.0f);
+  EXPECT_FALSE(d->UpdateView(nearEye, 1000.0f));
+  const size_t nbFineCells = d->GetCellsCount();
+  EXPECT_GT(nbFineCells, nbCoarseCells);
+  size_t nbTriangles = 0;
+  for (glm::u32vec3 tr : d->GetTriangles()) {
+    ASSERT_LT(tr.x, d->GetVertsCount());
+    ++nbTriangles;
+  }
+  EXPECT_EQ(nbTriangles, nbFineCells);
+
+  // Возврат к построенным уровням не запускает построение.
+  EXPECT_FALSE(d->UpdateView(farEye, 1000.0f));
+  EXPECT_EQ(d->GetCellsCount(), nbCoarseCells);
+  EXPECT_FALSE(d->UpdateView(nearEye, 1000.0f));
+  EXPECT_EQ(d->GetCellsCount(), nbFineCells);
+}
+
+TEST(Drawable2_OccShape, PrototypesPerParameters) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  MeshParameters coarse, fine;
+  coarse.linearDeflection = 1.0;
+  fine.linearDeflection = 0.05;
+  Scene scene("scene");
+  // Подробная сетка, построенная первой, не должна достаться грубому
+  // прототипу, и наоборот.
+  auto a = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape, gp_Trsf(), fine));
+  auto b = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape, gp_Trsf(), coarse));
+  auto c = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape, gp_Trsf(), fine));
+  EXPECT_GT(a->drawable->GetCellsCount(), b->drawable->GetCellsCount());
+  EXPECT_EQ(a->drawable->GetCellsCount(), c->drawable->GetCellsCount());
+}
+
+TEST(Drawable2_OccShape, InstancesShareRefinement) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  gp_Trsf shift;
+  shift.SetTranslation(gp_Vec(100.0, 0.0, 0.0));
+  Scene scene("scene");
+  auto a = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape));
+  auto b = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape.Moved(shift)));
+  a->drawable->EnableViewRefinement(1.0, 3);
+  b->drawable->EnableViewRefinement(1.0, 3);
+
+  const glm::vec3 eye(0.0f, 0.0f, 0.0f);
+  RefineForView(a->drawable, eye, 1000.0f);
+  ASSERT_GT(a->drawable->GetCellsCount(), b->drawable->GetCellsCount());
+
+  // Второе вхождение видно с той же точки в своей системе координат: все
+  // нужные уровни уже построены для первого.
+  const glm::vec3 shiftedEye(100.0f, 0.0f, 0.0f);
+  EXPECT_FALSE(b->drawable->UpdateView(shiftedEye, 1000.0f));
+  EXPECT_EQ(b->drawable->GetCellsCount(), a->drawable->GetCellsCount());
+
+  glm::vec3 pa = *a->drawable->GetVertices();
+  glm::vec3 pb = *b->drawable->GetVertices();
+  EXPECT_NEAR(pb.x - pa.x, 100.0f, 1.0e-3f);
+  EXPECT_NEAR(pb.y, pa.y, 1.0e-3f);
+  EXPECT_NEAR(pb.z, pa.z, 1.0e-3f);
+}
+
+TEST(Drawable2_OccShape, FaceStates) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  Scene scene("scene");
+  auto o = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape));
+  Drawable2_OccShape* d = o->drawable;
+  const size_t nbFaces = d->GetFacesCount();
+  ASSERT_GT(nbFaces, 1);
+
+  // Треугольники идут по граням подряд.
+  std::span<const uint32_t> groups = d->GetTriangleGroups();
+  ASSERT_EQ(groups.size(), d->GetCellsCount());
+  for (size_t i = 0; i < groups.size(); ++i) {
+    ASSERT_LT(groups[i], nbFaces);
+    if (i > 0) ASSERT_LE(groups[i - 1], groups[i]);
+  }
+  for (size_t f = 0; f < nbFaces; ++f)
+    EXPECT_FALSE(d->GetFace(f).IsNull());
+
+  // Вершины выделенной грани -- вершины ее треугольников.
+  const uint32_t face = groups.back();
+  std::vector<bool> isFaceVertex(d->GetVertsCount(), false);
+  size_t t = 0;
+  for (glm::u32vec3 tr : d->GetTriangles()) {
+    if (groups[t++] != face) continue;
+    isFaceVertex[tr.x] = isFaceVertex[tr.y] = isFaceVertex[tr.z] = true;
+  }
+
+  const glm::vec3 color = d->GetColor();
+  d->SetFaceState(face, Drawable2_OccShape::FaceState::Selected);
+  EXPECT_EQ(d->GetFaceState(face), Drawable2_OccShape::FaceState::Selected);
+  EXPECT_EQ(d->GetCellsCount(), groups.size());
+  size_t nbChanged = 0;
+  for (size_t v = 0; v < d->GetVertsCount(); ++v) {
+    bool changed = d->GetVertexColor(v) != color;
+    if (changed) ++nbChanged;
+    if (!isFaceVertex[v]) EXPECT_FALSE(changed);
+  }
+  EXPECT_GT(nbChanged, 0);
+
+  // Меняются только цвета: объект не становится измененным целиком, а
+  // цвета, скопированные по граням, совпадают с цветами вершин.
+  d->Sync();
+  d->SetFaceState(face, Drawable2_OccShape::FaceState::Highlighted);
+  EXPECT_TRUE(d->IsColorsDirty());
+  EXPECT_EQ(d->GetState(), TrackedObject::State::Clean);
+  std::vector<float> colors(3 * d->GetVertsCount() + 1, -1.0f);
+  EXPECT_EQ(d->CopyVertexColors(colors.data()), &colors.back());
+  for (size_t v = 0; v < d->GetVertsCount(); ++v) {
+    glm::vec3 c = d->GetVertexColor(v);
+    ASSERT_EQ(colors[3 * v], c.x);
+    ASSERT_EQ(colors[3 * v + 1], c.y);
+    ASSERT_EQ(colors[3 * v + 2], c.z);
+  }
+  d->Sync();
+  EXPECT_FALSE(d->IsColorsDirty());
+
+  d->SetFaceState(face, Drawable2_OccShape::FaceState::Normal);
+  for (size_t v = 0; v < d->GetVertsCount(); ++v)
+    ASSERT_EQ(d->GetVertexColor(v), color);
+}
+
+//! Выбор грани щелчком: выбор переходит с грани на грань, подсветка не
+//! сбрасывается, а обновляются только цвета.
+TEST(Drawable2_OccShape, SelectPickedFace) {
+  using FaceState = Drawable2_OccShape::FaceState;
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  Scene scene("scene");
+  auto o = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape));
+  Drawable2_OccShape* d = o->drawable;
+  ASSERT_GT(d->GetFacesCount(), 2);
+  d->SetFaceState(2, FaceState::Highlighted);
+  d->Sync();
+
+  OccPickedFace picked;
+  picked.drawable_id = d->GetId();
+  picked.face_index = 0;
+  picked.face = d->GetFace(0);
+  EXPECT_TRUE(SelectPickedFace(&scene, picked));
+  EXPECT_EQ(d->GetFaceState(0), FaceState::Selected);
+  EXPECT_EQ(d->GetFaceState(2), FaceState::Highlighted);
+  EXPECT_TRUE(d->IsColorsDirty());
+  EXPECT_EQ(d->GetState(), TrackedObject::State::Clean);
+  d->Sync();
+  EXPECT_FALSE(SelectPickedFace(&scene, picked));
+
+  picked.face_index = 1;
+  picked.face = d->GetFace(1);
+  EXPECT_TRUE(SelectPickedFace(&scene, picked));
+  EXPECT_EQ(d->GetFaceState(0), FaceState::Normal);
+  EXPECT_EQ(d->GetFaceState(1), FaceState::Selected);
+
+  // Щелчок мимо фигур снимает выбор.
+  EXPECT_TRUE(SelectPickedFace(&scene, OccPickedFace()));
+  EXPECT_EQ(d->GetFaceState(1), FaceState::Normal);
+  EXPECT_EQ(d->GetFaceState(2), FaceState::Highlighted);
+  EXPECT_EQ(d->GetState(), TrackedObject::State::Clean);
+}
+
+TEST(Drawable2_OccShape, FlatArrays) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+  Scene scene("scene");
+  auto o = static_cast<SceneObject_OccShape*>(
+      scene.AddObject<SceneObject_OccShape>(shape));
+  Drawable2_OccShape* d = o->drawable;
+  std::span<const glm::vec3> vertices = d->GetVertexArray();
+  std::span<const glm::vec3> normals = d->GetNormalArray();
+  std::span<const glm::u32vec3> triangles = d->GetTriangleArray();
+  ASSERT_EQ(vertices.size(), d->GetVertsCount());
+  ASSERT_EQ(normals.size(), d->GetVertsCount());
+  ASSERT_EQ(triangles.size(), d->GetCellsCount());
+
+  // Итераторы обходят те же массивы.
+  size_t i = 0;
+  for (glm::vec3 p : d->GetVertices()) ASSERT_EQ(p, vertices[i++]);
+  i = 0;
+  for (glm::vec3 n : d->GetNormals()) ASSERT_EQ(n, normals[i++]);
+  i = 0;
+  for (glm::u32vec3 t : d->GetTriangles()) ASSERT_EQ(t, triangles[i++]);
+
+  // Треугольники грани ссылаются только на вершины своей грани.
+  std::span<const size_t> vertexOffsets = d->GetFaceVertexOffsets();
+  std::span<const size_t> triangleOffsets = d->GetFaceTriangleOffsets();
+  ASSERT_EQ(vertexOffsets.size(), d->GetFacesCount() + 1);
+  ASSERT_EQ(triangleOffsets.size(), d->GetFacesCount() + 1);
+  EXPECT_EQ(vertexOffsets.back(), d->GetVertsCount());
+  EXPECT_EQ(triangleOffsets.back(), d->GetCellsCount());
+  std::span<const uint32_t> groups = d->GetTriangleGroups();
+  for (size_t f = 0; f < d->GetFacesCount(); ++f) {
+    for (size_t t = triangleOffsets[f]; t < triangleOffsets[f + 1]; ++t) {
+      ASSERT_EQ(groups[t], f);
+      for (int k = 0; k < 3; ++k) {
+        ASSERT_GE(triangles[t][k], vertexOffsets[f]);
+        ASSERT_LT(triangles[t][k], vertexOffsets[f + 1]);
+      }
+    }
+  }
+
+  // Без триангуляций массивы сохраняются, но сетки не уточняются.
+  const std::vector<glm::vec3> copy(vertices.begin(), vertices.end());
+  d->EnableViewRefinement(1.0, 3);
+  d->ReleaseTriangulations();
+  EXPECT_FALSE(d->UpdateView(glm::vec3(0.0f), 1000.0f));
+  ASSERT_EQ(d->GetVertsCount(), copy.size());
+  for (size_t v = 0; v < copy.size(); ++v)
+    ASSERT_EQ(d->GetVertexArray()[v], copy[v]);
+  EXPECT_FALSE(d->GetFace(0).IsNull());
+}
@@ -0,0 +1,85 @@
+#include <Standard_OutOfRange.hxx>
+
+#include "gtest/gtest.h"
+#include "numgeom/linearoctree.h"
+
+namespace {
+;
+LinearOcTree::Ptr CreateExample() {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(3, 2, 1));
+
+  LinearOcTree::Ptr tree = LinearOcTree::Create(boundBox, 3, 2, 1);
+  std::vector<LinearOcTree::Key> cells = {tree->GetKey(0, 1, 0, 0),
+                                          tree->GetKey(0, 2, 0, 0),
+                                          tree->GetKey(0, 0, 1, 0)};
+  tree->Split(cells);
+  tree->Split(tree->GetKey(1, 2, 0, 0));
+  tree->Split(tree->GetKey(1, 3, 0, 0));
+  tree->Split(tree->GetKey(1, 3, 1, 0));
+  tree->Split(tree->GetKey(1, 4, 1, 0));
+  return tree;
+}
+}  // namespace
+
+//! Повторяет тест `OcTree.Example`.
+TEST(LinearOcTree, Example) {
+  LinearOcTree::Ptr tree = CreateExample();
+  ASSERT_EQ(tree->NbCells(), 55);
+  ASSERT_EQ(tree->Levels(), 3);
+}
+
+TEST(LinearOcTree, KeyArithmetic) {
+  LinearOcTree::Ptr tree = CreateExample();
+  LinearOcTree::Key key = tree->GetKey(1, 4, 1, 0);
+  ASSERT_EQ(tree->GetLevel(key), 1);
+  ASSERT_EQ(tree->GetParent(key), tree->GetKey(0, 2, 0, 0));
+  ASSERT_EQ(tree->GetChild(key, 7), tree->GetKey(2, 9, 3, 1));
+  for (Standard_Integer c = 0; c < 8; ++c)
+    ASSERT_EQ(tree->GetParent(tree->GetChild(key, c)), key);
+
+  ASSERT_EQ(tree->GetNeighbour(key, 1, -1, 1), tree->GetKey(1, 5, 0, 1));
+  ASSERT_EQ(tree->GetNeighbour(key, 0, 0, 2), LinearOcTree::NoKey);
+}
+
+TEST(LinearOcTree, GetCell) {
+  LinearOcTree::Ptr tree = CreateExample();
+  std::vector<LinearOcTree::Key> cells = tree->TerminalCells();
+  ASSERT_EQ(cells.size(), tree->NbCells());
+  for (LinearOcTree::Key key : cells)
+    ASSERT_EQ(tree->GetCell(tree->GetCenter(key)), key);
+  ASSERT_EQ(tree->GetCell(gp_Pnt(1, 1, 2)), LinearOcTree::NoKey);
+}
+
+//! Ячейки глубоких уровней, число которых по оси превышает 2^10.
+TEST(LinearOcTree, DeepLevels) {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(1, 1, 1));
+  LinearOcTree::Ptr tree = LinearOcTree::Create(boundBox);
+  ASSERT_EQ(tree->MaxLevel(), 21);
+
+  LinearOcTree::Key key = tree->GetKey(0, 0, 0, 0);
+  for (Standard_Integer level = 0; level < tree->MaxLevel(); ++level) {
+    tree->Split(key);
+    key = tree->GetChild(key, 7);
+  }
+  ASSERT_EQ(tree->NbCells(), 1 + 7 * 21);
+
+  uint32_t i, j, k;
+  tree->GetCellCoords(key, i, j, k);
+  ASSERT_EQ(i, (uint32_t(1) << 21) - 1);
+  ASSERT_EQ(tree->GetCell(gp_Pnt(1, 1, 1)), key);
+}
+
+//! Недопустимые размеры решётки нулевого уровня.
+TEST(LinearOcTree, InvalidGrid) {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(1, 1, 1));
+  ASSERT_FALSE(LinearOcTree::Create(boundBox, 0, 1, 1));
+  ASSERT_FALSE(LinearOcTree::Create(boundBox, 1, -1, 1));
+  ASSERT_THROW(LinearOcTree::Create(boundBox, 1, 1, (1 << 21) + 1),
+               Standard_OutOfRange);
+}
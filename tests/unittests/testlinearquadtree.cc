@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+#include "numgeom/linearquadtree.h"
+
+namespace {
+;
+LinearQuadTree::Ptr CreateExample() {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(3, 2));
+
+  LinearQuadTree::Ptr tree = LinearQuadTree::Create(boundBox, 3, 2);
+  std::vector<LinearQuadTree::Key> cells = {
+      tree->GetKey(0, 1, 0), tree->GetKey(0, 2, 0), tree->GetKey(0, 0, 1)};
+  tree->Split(cells);
+  tree->Split(tree->GetKey(1, 2, 0));
+  tree->Split(tree->GetKey(1, 3, 0));
+  tree->Split(tree->GetKey(1, 3, 1));
+  tree->Split(tree->GetKey(1, 4, 1));
+  return tree;
+}
+}  // namespace
+
+//! Повторяет тест `QuadTree.Example`.
+TEST(LinearQuadTree, Example) {
+  LinearQuadTree::Ptr tree = CreateExample();
+  ASSERT_EQ(tree->NbCells(), 27);
+  ASSERT_EQ(tree->Levels(), 3);
+}
+
+TEST(LinearQuadTree, KeyArithmetic) {
+  LinearQuadTree::Ptr tree = CreateExample();
+  LinearQuadTree::Key key = tree->GetKey(1, 4, 1);
+  ASSERT_EQ(tree->GetLevel(key), 1);
+  ASSERT_EQ(tree->GetParent(key), tree->GetKey(0, 2, 0));
+  ASSERT_EQ(tree->GetParent(tree->GetKey(0, 2, 0)), LinearQuadTree::NoKey);
+  ASSERT_EQ(tree->GetChild(key, 3), tree->GetKey(2, 9, 3));
+  for (Standard_Integer c = 0; c < 4; ++c)
+    ASSERT_EQ(tree->GetParent(tree->GetChild(key, c)), key);
+
+  ASSERT_EQ(tree->GetNeighbour(key, 1, -1), tree->GetKey(1, 5, 0));
+  ASSERT_EQ(tree->GetNeighbour(key, 2, 0), LinearQuadTree::NoKey);
+  ASSERT_EQ(tree->GetNeighbour(key, 0, -2), LinearQuadTree::NoKey);
+
+  ASSERT_FALSE(tree->IsTerminal(key));
+  ASSERT_TRUE(tree->IsExists(key));
+  ASSERT_TRUE(tree->IsTerminal(tree->GetChild(key, 0)));
+  ASSERT_FALSE(tree->IsExists(tree->GetKey(2, 0, 0)));
+}
+
+TEST(LinearQuadTree, GetCell) {
+  LinearQuadTree::Ptr tree = CreateExample();
+  std::vector<LinearQuadTree::Key> cells = tree->TerminalCells();
+  ASSERT_EQ(cells.size(), tree->NbCells());
+  for (LinearQuadTree::Key key : cells) {
+    ASSERT_TRUE(tree->IsTerminal(key));
+    ASSERT_EQ(tree->GetCell(tree->GetCenter(key)), key);
+  }
+  ASSERT_NE(tree->GetCell(gp_Pnt2d(3, 2)), LinearQuadTree::NoKey);
+  ASSERT_EQ(tree->GetCell(gp_Pnt2d(3.5, 1)), LinearQuadTree::NoKey);
+}
+
+//! Ячейки глубоких уровней, число которых по оси превышает 2^31.
+TEST(LinearQuadTree, DeepLevels) {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(1, 1));
+  LinearQuadTree::Ptr tree = LinearQuadTree::Create(boundBox);
+  ASSERT_EQ(tree->MaxLevel(), 31);
+
+  // Делим ячейки, примыкающие к правому верхнему углу.
+  LinearQuadTree::Key key = tree->GetKey(0, 0, 0);
+  for (Standard_Integer level = 0; level < tree->MaxLevel(); ++level) {
+    tree->Split(key);
+    key = tree->GetChild(key, 3);
+  }
+  ASSERT_EQ(tree->Levels(), 32);
+  ASSERT_EQ(tree->NbCells(), 1 + 3 * 31);
+
+  uint64_t ni, nj;
+  tree->CellsNumberOnLevel(31, ni, nj);
+  ASSERT_EQ(ni, uint64_t(1) << 31);
+  uint32_t i, j;
+  tree->GetCellCoords(key, i, j);
+  ASSERT_EQ(i, (uint32_t(1) << 31) - 1);
+  ASSERT_EQ(j, i);
+  ASSERT_EQ(tree->GetCell(gp_Pnt2d(1, 1)), key);
+  ASSERT_EQ(tree->GetCell(gp_Pnt2d(0.25, 0.25)), tree->GetKey(1, 0, 0));
+}
+
+//! Недопустимые размеры решётки нулевого уровня.
+TEST(LinearQuadTree, InvalidGrid) {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(1, 1));
+  ASSERT_FALSE(LinearQuadTree::Create(boundBox, 0, 1));
+  ASSERT_FALSE(LinearQuadTree::Create(boundBox, 1, -1));
+}
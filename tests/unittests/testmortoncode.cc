@@ -0,0 +1,34 @@
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include "numgeom/mortoncode.h"
+
+TEST(MortonCode, InterleavesBits) {
+  ASSERT_EQ(MortonEncode2d(0b11, 0b00), 0b0101u);
+  ASSERT_EQ(MortonEncode2d(0b00, 0b11), 0b1010u);
+  ASSERT_EQ(MortonEncode3d(1, 0, 0), 0b001u);
+  ASSERT_EQ(MortonEncode3d(0, 1, 0), 0b010u);
+  ASSERT_EQ(MortonEncode3d(0, 0, 1), 0b100u);
+  ASSERT_EQ(MortonEncode3d(0b10, 0b10, 0b10), 0b111000u);
+}
+
+TEST(MortonCode, DecodeIsInverse) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<uint32_t> any;
+  std::uniform_int_distribution<uint32_t> bits21(0, (1u << 21) - 1);
+  for (int n = 0; n < 1000; ++n) {
+    uint32_t i = any(gen), j = any(gen);
+    uint32_t ii, jj;
+    MortonDecode2d(MortonEncode2d(i, j), ii, jj);
+    ASSERT_EQ(i, ii);
+    ASSERT_EQ(j, jj);
+
+    uint32_t a = bits21(gen), b = bits21(gen), c = bits21(gen);
+    uint32_t aa, bb, cc;
+    MortonDecode3d(MortonEncode3d(a, b, c), aa, bb, cc);
+    ASSERT_EQ(a, aa);
+    ASSERT_EQ(b, bb);
+    ASSERT_EQ(c, cc);
+  }
+}
@@ -1,5 +1,13 @@
 #include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+
+#include "numgeom/classificate.h"
 #include "numgeom/octree.h"
+#include "numgeom/utilities_occ.h"
 #include "utilities.h"
 
 namespace {
@@ -28,6 +36,43 @@ TEST(OcTree, Example) {
   ASSERT_EQ(oTree->NbCells(), 55);
 }
 
+TEST(OcTree, CellCounts) {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(3, 2, 1));
+
+  OcTree::Ptr oTree = OcTree::Create(boundBox, 3, 2, 1);
+  ASSERT_EQ(oTree->TerminalCellsArray().size(), 6);
+  oTree->Split(OcTree::Cell(0, 1));
+  oTree->Split(OcTree::Cell(0, 2));
+  oTree->Split(OcTree::Cell(0, 3));
+  oTree->Split(OcTree::Cell(1, 2));
+  oTree->Split(OcTree::Cell(1, 3));
+  oTree->Split(OcTree::Cell(1, 9));
+  oTree->Split(OcTree::Cell(1, 10));
+
+  ASSERT_EQ(oTree->NbTerminalCells(), 55);
+  ASSERT_EQ(oTree->NbTerminalCells(0), 3);
+  ASSERT_EQ(oTree->NbTerminalCells(1), 20);
+  ASSERT_EQ(oTree->NbTerminalCells(2), 32);
+  ASSERT_EQ(oTree->NbTerminalCells(3), 0);
+  ASSERT_EQ(oTree->NbNonTerminalCells(0), 3);
+  ASSERT_EQ(oTree->NbNonTerminalCells(1), 4);
+  ASSERT_EQ(oTree->NbNonTerminalCells(2), 0);
+
+  // Массив терминальных ячеек совпадает с обходом `TerminalCells()`.
+  std::span<const OcTree::Cell> cells = oTree->TerminalCellsArray();
+  ASSERT_EQ(cells.size(), oTree->NbTerminalCells());
+  size_t n = 0;
+  for (OcTree::Cell cell : oTree->TerminalCells()) {
+    ASSERT_EQ(cells[n], cell);
+    ASSERT_EQ(oTree->GetTerminalOrdinal(cell), n);
+    ++n;
+  }
+  ASSERT_EQ(n, cells.size());
+  ASSERT_EQ(oTree->GetTerminalOrdinal(OcTree::Cell(0, 1)), OcTree::NoOrdinal);
+}
+
 TEST(OcTree, CreateOcTree0) {
   Bnd_Box boundBox;
   boundBox.Add(gp_Pnt(0, 0, 0));
@@ -69,19 +114,82 @@ TEST(OcTree, SaveLoad) {
 
   std::string fileName = GetTestName();
   {
-    std::ofstream file(fileName);
+    std::ofstream file(fileName, std::ios::binary);
     tree->Serialize(file);
   }
 
   OcTree::CPtr qTreeCopy;
   {
-    std::ifstream file(fileName);
+    std::ifstream file(fileName, std::ios::binary);
     qTreeCopy = OcTree::Deserialize(file);
   }
   ASSERT_TRUE(qTreeCopy != OcTree::Ptr());
   ASSERT_TRUE(tree->Equals(qTreeCopy));
 }
 
+//! Дерево с атрибутами и каналами переживает запись в обоих форматах, а
+//! оборванный двоичный поток не читается.
+TEST(OcTree, SaveLoadBinary) {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(3, 2, 1));
+  OcTree::Ptr tree = OcTree::Create(boundBox, 3, 2, 1);
+  tree->Split(OcTree::Cell(0, 4));
+  tree->Split(OcTree::Cell(0, 1));
+  tree->Split(OcTree::Cell(1, 2));
+  tree->SetAttr(OcTree::Cell(2, 4), 5);
+  tree->SetAttr(OcTree::Cell(0, 5), 3);
+  size_t channel = tree->AddChannel<double>(-1.0);
+  tree->SetValue(channel, OcTree::Cell(1, 14), 2.5);
+
+  std::stringstream binary;
+  tree->Serialize(binary);
+  OcTree::Ptr treeCopy = OcTree::Deserialize(binary);
+  ASSERT_TRUE(treeCopy != OcTree::Ptr());
+  ASSERT_TRUE(tree->Equals(treeCopy));
+  for (OcTree::Cell cell : tree->TerminalCells()) {
+    ASSERT_EQ(treeCopy->GetAttr(cell), tree->GetAttr(cell));
+    ASSERT_EQ(treeCopy->GetValue<double>(channel, cell),
+              tree->GetValue<double>(channel, cell));
+  }
+
+  std::stringstream text;
+  tree->Serialize(text, OcTree::Format::Json);
+  treeCopy = OcTree::Deserialize(text);
+  ASSERT_TRUE(treeCopy != OcTree::Ptr());
+  ASSERT_TRUE(tree->Equals(treeCopy));
+  ASSERT_EQ(treeCopy->GetAttr(OcTree::Cell(2, 4)), 5);
+
+  std::string data = binary.str();
+  std::stringstream truncated(data.substr(0, data.size() - 1));
+  ASSERT_TRUE(OcTree::Deserialize(truncated) == OcTree::Ptr());
+
+  // Число ячеек в заголовке не подкреплено данными потока, и память под
+  // ячейки не выделяется.
+  std::string huge = data;
+  int32_t nbCells = 1000;
+  std::memcpy(&huge[56], &nbCells, sizeof(nbCells));
+  std::memcpy(&huge[60], &nbCells, sizeof(nbCells));
+  std::memcpy(&huge[64], &nbCells, sizeof(nbCells));
+  std::stringstream corrupted(huge);
+  ASSERT_TRUE(OcTree::Deserialize(corrupted) == OcTree::Ptr());
+
+  // Без позиционирования размер потока неизвестен; значения читаются
+  // блоками, и недостаток данных обнаруживается без выделения памяти под
+  // заявленное число ячеек.
+  NonSeekableBuf pipeBuf(data);
+  std::istream pipe(&pipeBuf);
+  treeCopy = OcTree::Deserialize(pipe);
+  ASSERT_TRUE(treeCopy != OcTree::Ptr());
+  ASSERT_TRUE(tree->Equals(treeCopy));
+  NonSeekableBuf truncatedPipeBuf(data.substr(0, data.size() - 1));
+  std::istream truncatedPipe(&truncatedPipeBuf);
+  ASSERT_TRUE(OcTree::Deserialize(truncatedPipe) == OcTree::Ptr());
+  NonSeekableBuf corruptedPipeBuf(huge);
+  std::istream corruptedPipe(&corruptedPipeBuf);
+  ASSERT_TRUE(OcTree::Deserialize(corruptedPipe) == OcTree::Ptr());
+}
+
 TEST(OcTree, IterateConnectedCells) {
   auto fileName = TestData("octree-0.json");
   std::ifstream file(fileName);
@@ -101,6 +209,33 @@ TEST(OcTree, IterateConnectedCells) {
   }
 }
 
+TEST(OcTree, NeighbourTable) {
+  auto fileName = TestData("octree-0.json");
+  std::ifstream file(fileName);
+  OcTree::Ptr tree = OcTree::Deserialize(file);
+  ASSERT_TRUE(tree != nullptr);
+  ASSERT_FALSE(tree->HasNeighbours());
+
+  tree->BuildNeighbours();
+  ASSERT_TRUE(tree->HasNeighbours());
+  for (auto aCell : tree->TerminalCells()) {
+    std::set<OcTree::Cell> expected;
+    for (auto bCell : tree->ConnectedCells(aCell)) expected.insert(bCell);
+    auto neighbours = tree->Neighbours(aCell);
+    auto connections = tree->NeighbourConnections(aCell);
+    ASSERT_EQ(std::vector<OcTree::Cell>(neighbours.begin(), neighbours.end()),
+              std::vector<OcTree::Cell>(expected.begin(), expected.end()));
+    ASSERT_EQ(connections.size(), neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); ++i)
+      ASSERT_EQ(connections[i],
+                tree->GetConnectionType(aCell, neighbours[i]));
+  }
+
+  // Деление ячейки сбрасывает таблицу.
+  tree->Split(*tree->TerminalCells().begin());
+  ASSERT_FALSE(tree->HasNeighbours());
+}
+
 namespace {
 ;
 //! ����� ��������� ����������� ���������� �� ���������� �����.
@@ -130,7 +265,7 @@ TEST(OcTree, SearchNearestCells) {
     return cell.level == tree->Levels() - 1;
   };
 
-  OcTree::Ptr tree = LoadOcTree(TestData("OcTree-0.json"));
+  OcTree::Ptr tree = LoadOcTree(TestData("octree-0.json"));
   ASSERT_TRUE(tree != OcTree::Ptr());
 
   for (OcTree::Cell cell : tree->TerminalCells()) {
@@ -157,3 +292,118 @@ TEST(OcTree, SearchNearestCells) {
     ASSERT_EQ(nearestDistance, dMin);
   }
 }
+
+//! Сравниваем расстояния до `k` ближайших ячеек с найденными перебором.
+TEST(OcTree, SearchKNearestCells) {
+  auto IsTaggedCell = [](OcTree::CPtr tree, const OcTree::Cell& cell) {
+    return cell.level == tree->Levels() - 1;
+  };
+
+  OcTree::Ptr tree = LoadOcTree(TestData("octree-0.json"));
+  ASSERT_TRUE(tree != OcTree::Ptr());
+
+  std::vector<gp_Pnt> points;
+  for (OcTree::Cell cell : tree->TerminalCells()) {
+    Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+    tree->GetCellBox(cell, xMin, yMin, zMin, xMax, yMax, zMax);
+    points.push_back(gp_Pnt(0.7 * xMin + 0.3 * xMax, 0.2 * yMin + 0.8 * yMax,
+                            0.4 * zMin + 0.6 * zMax));
+  }
+
+  const size_t k = 5;
+  std::vector<std::vector<OcTree::Cell>> batch;
+  SearchKNearestCells(tree, points, IsTaggedCell, k,
+                      std::numeric_limits<double>::max(), batch);
+  ASSERT_EQ(batch.size(), points.size());
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    std::vector<Standard_Real> distances;
+    for (OcTree::Cell cell : tree->TerminalCells()) {
+      if (!IsTaggedCell(tree, cell)) continue;
+      Standard_Real dMin, dMax;
+      tree->GetMinMaxDistances(points[i], cell, dMin, dMax);
+      distances.push_back(dMin);
+    }
+    std::sort(distances.begin(), distances.end());
+
+    std::vector<OcTree::Cell> nearestCells;
+    SearchKNearestCells(tree, points[i], IsTaggedCell, k,
+                        std::numeric_limits<double>::max(), nearestCells);
+    ASSERT_EQ(nearestCells, batch[i]);
+    ASSERT_EQ(nearestCells.size(), std::min(k, distances.size()));
+    for (size_t n = 0; n < nearestCells.size(); ++n) {
+      ASSERT_TRUE(IsTaggedCell(tree, nearestCells[n]));
+      Standard_Real dMin, dMax;
+      tree->GetMinMaxDistances(points[i], nearestCells[n], dMin, dMax);
+      ASSERT_EQ(dMin, distances[n]);
+    }
+  }
+}
+
+TEST(OcTree, AttrChannels) {
+  Bnd_Box boundBox;
+  boundBox.Add(gp_Pnt(0, 0, 0));
+  boundBox.Add(gp_Pnt(3, 2, 1));
+  OcTree::Ptr tree = OcTree::Create(boundBox, 3, 2, 1);
+
+  size_t distance = tree->AddChannel<float>(-1.0f);
+  size_t material = tree->AddChannel<int>();
+  ASSERT_TRUE(tree->GetChannel<double>(distance).empty());
+
+  tree->SetValue(distance, OcTree::Cell(0, 0), 0.5f);
+  tree->SetValue(material, OcTree::Cell(0, 4), 7);
+
+  // Деление ячеек не меняет номера и атрибуты имеющихся ячеек.
+  size_t ordinal = tree->GetOrdinal(OcTree::Cell(0, 4));
+  tree->Split(OcTree::Cell(0, 1));
+  tree->Split(OcTree::Cell(1, 2));
+  ASSERT_EQ(tree->NbOrdinals(), 6 + 2 * 8);
+  ASSERT_EQ(tree->GetOrdinal(OcTree::Cell(0, 4)), ordinal);
+  ASSERT_EQ(tree->GetValue<float>(distance, OcTree::Cell(0, 0)), 0.5f);
+  ASSERT_EQ(tree->GetValue<int>(material, OcTree::Cell(0, 4)), 7);
+  ASSERT_EQ(tree->GetValue<float>(distance, OcTree::Cell(2, 4)), -1.0f);
+
+  std::vector<float> values(tree->NbCells());
+  for (size_t i = 0; i < values.size(); ++i) values[i] = 0.25f * i;
+  tree->SetValues<float>(distance, values);
+  std::vector<float> result;
+  tree->GetValues(distance, result);
+  ASSERT_EQ(result, values);
+}
+
+TEST(OcTree, CreateAroundSolid) {
+  TopoDS_Shape model = LoadFromFile(TestData("rounded-cube.step"));
+  ASSERT_FALSE(model.IsNull());
+  OcTree::Ptr tree = OcTree::Create(model, 4);
+  ASSERT_TRUE(tree != nullptr);
+  ASSERT_EQ(tree->Levels(), 5);
+
+  SolidClassifier classifier(model);
+  size_t nbCells[3] = {0, 0, 0};
+  for (OcTree::Cell cell : tree->TerminalCells()) {
+    size_t position = tree->GetAttr(cell);
+    ASSERT_LE(position, size_t(OcTree::BoundaryCell));
+    ++nbCells[position];
+    // Пересекающие поверхность ячейки разделены до последнего уровня.
+    if (position == OcTree::BoundaryCell)
+      ASSERT_EQ(cell.level, tree->Levels() - 1);
+    else
+      ASSERT_EQ(position == OcTree::InnerCell,
+                classifier.Classify(tree->GetCenter(cell)) == TopAbs_IN);
+
+    // Дерево сбалансировано.
+    for (OcTree::Cell other : tree->ConnectedCells(cell))
+      ASSERT_LE(std::abs(other.level - cell.level), 1);
+  }
+  ASSERT_GT(nbCells[OcTree::InnerCell], 0);
+  ASSERT_GT(nbCells[OcTree::BoundaryCell], 0);
+
+  // Размер ячеек ограничивает измельчение.
+  Standard_Real xMin, yMin, zMin, xMax, yMax, zMax;
+  tree->GetBox(xMin, yMin, zMin, xMax, yMax, zMax);
+  Standard_Real size = 0.2 * (xMax - xMin);
+  OcTree::Ptr coarseTree =
+      OcTree::Create(model, 4, [size](const gp_Pnt&) { return size; });
+  ASSERT_TRUE(coarseTree != nullptr);
+  ASSERT_LT(coarseTree->Levels(), tree->Levels());
+}
@@ -0,0 +1,130 @@
+#include <Geom2d_Circle.hxx>
+#include <Geom_Circle.hxx>
+#include <Geom_Ellipse.hxx>
+#include <Geom_RectangularTrimmedSurface.hxx>
+#include <Geom_SphericalSurface.hxx>
+#include <Geom_SurfaceOfLinearExtrusion.hxx>
+#include <gp_Ax2.hxx>
+#include <gp_Ax22d.hxx>
+#include <gp_Ax3.hxx>
+#include <gp_Dir.hxx>
+#include <cmath>
+
+#include "gtest/gtest.h"
+#include "numgeom/projectors.h"
+
+TEST(Projectors, Curve2d) {
+  Handle(Geom2d_Circle) circle = new Geom2d_Circle(gp_Ax22d(), 2.0);
+  CurveProjector2d projector(circle);
+  std::vector<gp_Pnt2d> points;
+  for (int i = 0; i < 1000; ++i) {
+    Standard_Real t = 0.006 * i;
+    points.push_back(gp_Pnt2d(3.0 * std::cos(t), 3.0 * std::sin(t)));
+  }
+  size_t nbLocal = 0;
+  std::vector<Standard_Real> params = projector.Project(points, &nbLocal);
+  ASSERT_EQ(params.size(), points.size());
+  // Глобальный поиск нужен только первой точке каждого блока.
+  EXPECT_GT(nbLocal, points.size() / 2);
+  for (size_t i = 0; i < points.size(); ++i) {
+    EXPECT_NEAR(params[i], 0.006 * i, 1.e-7);
+    EXPECT_NEAR(projector.Project(points[i]), params[i], 1.e-7);
+  }
+}
+
+TEST(Projectors, Curve) {
+  Handle(Geom_Circle) circle = new Geom_Circle(gp_Ax2(), 2.0);
+  CurveProjector projector(circle);
+  std::vector<gp_Pnt> points;
+  for (int i = 0; i < 1000; ++i) {
+    Standard_Real t = 0.006 * i;
+    points.push_back(gp_Pnt(3.0 * std::cos(t), 3.0 * std::sin(t), 1.0));
+  }
+  size_t nbLocal = 0;
+  std::vector<Standard_Real> params = projector.Project(points, &nbLocal);
+  ASSERT_EQ(params.size(), points.size());
+  EXPECT_GT(nbLocal, points.size() / 2);
+  for (size_t i = 0; i < points.size(); ++i)
+    EXPECT_NEAR(params[i], 0.006 * i, 1.e-7);
+
+  // Начальное приближение у другого конца окружности не мешает найти
+  // ближайшую точку.
+  EXPECT_NEAR(projector.Project(points[10], 3.0), 0.06, 1.e-7);
+}
+
+TEST(Projectors, Surface) {
+  Handle(Geom_SphericalSurface) sphere =
+      new Geom_SphericalSurface(gp_Ax3(), 1.0);
+  SurfaceProjector projector(sphere);
+  std::vector<gp_Pnt> points;
+  for (int j = 0; j < 20; ++j) {
+    for (int i = 0; i < 50; ++i) {
+      gp_Pnt p = sphere->Value(0.1 * i + 0.05, 0.07 * j - 0.7);
+      points.push_back(gp_Pnt(2.0 * p.X(), 2.0 * p.Y(), 2.0 * p.Z()));
+    }
+  }
+  size_t nbLocal = 0;
+  std::vector<gp_Pnt2d> params = projector.Project(points, &nbLocal);
+  ASSERT_EQ(params.size(), points.size());
+  EXPECT_GT(nbLocal, points.size() / 2);
+  for (size_t i = 0; i < points.size(); ++i) {
+    gp_Pnt q = sphere->Value(params[i].X(), params[i].Y());
+    EXPECT_NEAR(q.Distance(points[i]), 1.0, 1.e-7);
+    gp_Pnt2d uv = projector.Project(points[i]);
+    EXPECT_LT(sphere->Value(uv.X(), uv.Y()).Distance(q), 1.e-7);
+  }
+}
+
+namespace {
+;
+
+//! Точки на малой оси эллипса с полуосями 3 и 1, от одной вершины к другой.
+//! Обе вершины малой оси - локальные минимумы расстояния, и ближайшей
+//! становится то одна, то другая.
+std::vector<gp_Pnt> MinorAxisPoints(Standard_Real z) {
+  std::vector<gp_Pnt> points;
+  for (int i = 0; i < 1000; ++i)
+    points.push_back(gp_Pnt(0.0, 0.4995 - 0.001 * i, z));
+  return points;
+}
+}  // namespace
+
+TEST(Projectors, CurveSeveralMinima) {
+  Handle(Geom_Ellipse) ellipse = new Geom_Ellipse(gp_Ax2(), 3.0, 1.0);
+  CurveProjector projector(ellipse);
+  std::vector<gp_Pnt> points = MinorAxisPoints(0.0);
+  size_t nbLocal = 0;
+  std::vector<Standard_Real> params = projector.Project(points, &nbLocal);
+  ASSERT_EQ(params.size(), points.size());
+  // Локальный поиск работает по обе стороны от центра, но не переносит
+  // решение через него.
+  EXPECT_GT(nbLocal, points.size() / 2);
+  for (size_t i = 0; i < points.size(); ++i) {
+    Standard_Real t = projector.Project(points[i]);
+    EXPECT_NEAR(ellipse->Value(params[i]).Distance(points[i]),
+                ellipse->Value(t).Distance(points[i]), 1.e-7);
+    EXPECT_NEAR(ellipse->Value(params[i]).Y(), points[i].Y() > 0 ? 1.0 : -1.0,
+                1.e-7);
+  }
+}
+
+TEST(Projectors, SurfaceSeveralMinima) {
+  Handle(Geom_Ellipse) ellipse = new Geom_Ellipse(gp_Ax2(), 3.0, 1.0);
+  Handle(Geom_SurfaceOfLinearExtrusion) extrusion =
+      new Geom_SurfaceOfLinearExtrusion(ellipse, gp_Dir(0.0, 0.0, 1.0));
+  Handle(Geom_RectangularTrimmedSurface) cylinder =
+      new Geom_RectangularTrimmedSurface(extrusion, 0.0, 1.0, Standard_False);
+  SurfaceProjector projector(cylinder);
+  std::vector<gp_Pnt> points = MinorAxisPoints(0.5);
+  size_t nbLocal = 0;
+  std::vector<gp_Pnt2d> params = projector.Project(points, &nbLocal);
+  ASSERT_EQ(params.size(), points.size());
+  EXPECT_GT(nbLocal, points.size() / 2);
+  for (size_t i = 0; i < points.size(); ++i) {
+    gp_Pnt q = cylinder->Value(params[i].X(), params[i].Y());
+    gp_Pnt2d uv = projector.Project(points[i]);
+    EXPECT_NEAR(q.Distance(points[i]),
+                cylinder->Value(uv.X(), uv.Y()).Distance(points[i]), 1.e-7);
+    EXPECT_NEAR(q.Y(), points[i].Y() > 0 ? 1.0 : -1.0, 1.e-7);
+  }
+}
@@ -1,4 +1,9 @@
 ﻿#include "gtest/gtest.h"
+
+#include <cstring>
+#include <set>
+#include <sstream>
+
 #include "numgeom/quadtree.h"
 #include "utilities.h"
 
@@ -28,6 +33,44 @@ TEST(QuadTree, Example) {
   ASSERT_EQ(qTree->NbCells(), 27);
 }
 
+TEST(QuadTree, CellCounts) {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(3, 2));
+
+  QuadTree::Ptr qTree = QuadTree::Create(boundBox, 3, 2);
+  ASSERT_EQ(qTree->TerminalCellsArray().size(), 6);
+  qTree->Split(QuadTree::Cell(0, 1));
+  qTree->Split(QuadTree::Cell(0, 2));
+  qTree->Split(QuadTree::Cell(0, 3));
+  qTree->Split(QuadTree::Cell(1, 2));
+  qTree->Split(QuadTree::Cell(1, 3));
+  qTree->Split(QuadTree::Cell(1, 9));
+  qTree->Split(QuadTree::Cell(1, 10));
+
+  ASSERT_EQ(qTree->NbTerminalCells(), 27);
+  ASSERT_EQ(qTree->NbTerminalCells(0), 3);
+  ASSERT_EQ(qTree->NbTerminalCells(1), 8);
+  ASSERT_EQ(qTree->NbTerminalCells(2), 16);
+  ASSERT_EQ(qTree->NbTerminalCells(3), 0);
+  ASSERT_EQ(qTree->NbNonTerminalCells(0), 3);
+  ASSERT_EQ(qTree->NbNonTerminalCells(1), 4);
+  ASSERT_EQ(qTree->NbNonTerminalCells(2), 0);
+
+  // Массив терминальных ячеек совпадает с обходом `TerminalCells()`.
+  std::span<const QuadTree::Cell> cells = qTree->TerminalCellsArray();
+  ASSERT_EQ(cells.size(), qTree->NbTerminalCells());
+  size_t n = 0;
+  for (QuadTree::Cell cell : qTree->TerminalCells()) {
+    ASSERT_EQ(cells[n], cell);
+    ASSERT_EQ(qTree->GetTerminalOrdinal(cell), n);
+    ++n;
+  }
+  ASSERT_EQ(n, cells.size());
+  ASSERT_EQ(qTree->GetTerminalOrdinal(QuadTree::Cell(0, 1)),
+            QuadTree::NoOrdinal);
+}
+
 TEST(QuadTest, CreateQuadTree0) {
   Bnd_Box2d boundBox;
   boundBox.Add(gp_Pnt2d(0.0, 0.0));
@@ -69,19 +112,81 @@ TEST(QuadTree, SaveLoad) {
 
   std::string fileName = GetTestName();
   {
-    std::ofstream file(fileName);
+    std::ofstream file(fileName, std::ios::binary);
     qTree->Serialize(file);
   }
 
   QuadTree::CPtr qTreeCopy;
   {
-    std::ifstream file(fileName);
+    std::ifstream file(fileName, std::ios::binary);
     qTreeCopy = QuadTree::Deserialize(file);
   }
   ASSERT_TRUE(qTreeCopy != QuadTree::Ptr());
   ASSERT_TRUE(qTree->Equals(qTreeCopy));
 }
 
+//! Дерево с атрибутами и каналами переживает запись в обоих форматах, а
+//! оборванный двоичный поток не читается.
+TEST(QuadTree, SaveLoadBinary) {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(3, 2));
+  QuadTree::Ptr qTree = QuadTree::Create(boundBox, 3, 2);
+  qTree->Split(QuadTree::Cell(0, 4));
+  qTree->Split(QuadTree::Cell(0, 1));
+  qTree->Split(QuadTree::Cell(1, 2));
+  qTree->SetAttr(QuadTree::Cell(2, 4), 5);
+  qTree->SetAttr(QuadTree::Cell(0, 5), 3);
+  size_t channel = qTree->AddChannel<float>(-1.0f);
+  qTree->SetValue(channel, QuadTree::Cell(1, 14), 2.5f);
+
+  std::stringstream binary;
+  qTree->Serialize(binary);
+  QuadTree::Ptr qTreeCopy = QuadTree::Deserialize(binary);
+  ASSERT_TRUE(qTreeCopy != QuadTree::Ptr());
+  ASSERT_TRUE(qTree->Equals(qTreeCopy));
+  for (QuadTree::Cell cell : qTree->TerminalCells()) {
+    ASSERT_EQ(qTreeCopy->GetAttr(cell), qTree->GetAttr(cell));
+    ASSERT_EQ(qTreeCopy->GetValue<float>(channel, cell),
+              qTree->GetValue<float>(channel, cell));
+  }
+
+  std::stringstream text;
+  qTree->Serialize(text, QuadTree::Format::Json);
+  qTreeCopy = QuadTree::Deserialize(text);
+  ASSERT_TRUE(qTreeCopy != QuadTree::Ptr());
+  ASSERT_TRUE(qTree->Equals(qTreeCopy));
+  ASSERT_EQ(qTreeCopy->GetAttr(QuadTree::Cell(2, 4)), 5);
+
+  std::string data = binary.str();
+  std::stringstream truncated(data.substr(0, data.size() - 1));
+  ASSERT_TRUE(QuadTree::Deserialize(truncated) == QuadTree::Ptr());
+
+  // Число ячеек в заголовке не подкреплено данными потока, и память под
+  // ячейки не выделяется.
+  std::string huge = data;
+  int32_t nbCells = 1000;
+  std::memcpy(&huge[40], &nbCells, sizeof(nbCells));
+  std::memcpy(&huge[44], &nbCells, sizeof(nbCells));
+  std::stringstream corrupted(huge);
+  ASSERT_TRUE(QuadTree::Deserialize(corrupted) == QuadTree::Ptr());
+
+  // Без позиционирования размер потока неизвестен; значения читаются
+  // блоками, и недостаток данных обнаруживается без выделения памяти под
+  // заявленное число ячеек.
+  NonSeekableBuf pipeBuf(data);
+  std::istream pipe(&pipeBuf);
+  qTreeCopy = QuadTree::Deserialize(pipe);
+  ASSERT_TRUE(qTreeCopy != QuadTree::Ptr());
+  ASSERT_TRUE(qTree->Equals(qTreeCopy));
+  NonSeekableBuf truncatedPipeBuf(data.substr(0, data.size() - 1));
+  std::istream truncatedPipe(&truncatedPipeBuf);
+  ASSERT_TRUE(QuadTree::Deserialize(truncatedPipe) == QuadTree::Ptr());
+  NonSeekableBuf corruptedPipeBuf(huge);
+  std::istream corruptedPipe(&corruptedPipeBuf);
+  ASSERT_TRUE(QuadTree::Deserialize(corruptedPipe) == QuadTree::Ptr());
+}
+
 TEST(QuadTree, IterateConnectedCells) {
   auto fileName = TestData("quadtree-0.json");
   std::ifstream file(fileName);
@@ -101,6 +206,33 @@ TEST(QuadTree, IterateConnectedCells) {
   }
 }
 
+TEST(QuadTree, NeighbourTable) {
+  auto fileName = TestData("quadtree-0.json");
+  std::ifstream file(fileName);
+  QuadTree::Ptr qTree = QuadTree::Deserialize(file);
+  ASSERT_TRUE(qTree != nullptr);
+  ASSERT_FALSE(qTree->HasNeighbours());
+
+  qTree->BuildNeighbours();
+  ASSERT_TRUE(qTree->HasNeighbours());
+  for (auto aCell : qTree->TerminalCells()) {
+    std::set<QuadTree::Cell> expected;
+    for (auto bCell : qTree->ConnectedCells(aCell)) expected.insert(bCell);
+    auto neighbours = qTree->Neighbours(aCell);
+    auto connections = qTree->NeighbourConnections(aCell);
+    ASSERT_EQ(std::vector<QuadTree::Cell>(neighbours.begin(), neighbours.end()),
+              std::vector<QuadTree::Cell>(expected.begin(), expected.end()));
+    ASSERT_EQ(connections.size(), neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); ++i)
+      ASSERT_EQ(connections[i],
+                qTree->GetConnectionType(aCell, neighbours[i]));
+  }
+
+  // Деление ячейки сбрасывает таблицу.
+  qTree->Split(*qTree->TerminalCells().begin());
+  ASSERT_FALSE(qTree->HasNeighbours());
+}
+
 namespace {
 ;
 //! Поиск перебором наименьшего расстояния до отмеченных ячеек.
@@ -157,3 +289,93 @@ TEST(QuadTree, SearchNearestCells) {
     ASSERT_EQ(nearestDistance, dMin);
   }
 }
+
+//! Сравниваем расстояния до `k` ближайших ячеек с найденными перебором.
+TEST(QuadTree, SearchKNearestCells) {
+  auto IsTaggedCell = [](QuadTree::CPtr qTree, const QuadTree::Cell& cell) {
+    return cell.level == qTree->Levels() - 1;
+  };
+
+  QuadTree::Ptr qTree = LoadQuadTree(TestData("quadtree-0.json"));
+  ASSERT_TRUE(qTree != QuadTree::Ptr());
+
+  std::vector<gp_Pnt2d> points;
+  for (QuadTree::Cell cell : qTree->TerminalCells()) {
+    Standard_Real xMin, yMin, xMax, yMax;
+    qTree->GetCellBox(cell, xMin, yMin, xMax, yMax);
+    points.push_back(
+        gp_Pnt2d(0.7 * xMin + 0.3 * xMax, 0.2 * yMin + 0.8 * yMax));
+  }
+
+  const size_t k = 5;
+  std::vector<std::vector<QuadTree::Cell>> batch;
+  SearchKNearestCells(qTree, points, IsTaggedCell, k,
+                      std::numeric_limits<double>::max(), batch);
+  ASSERT_EQ(batch.size(), points.size());
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    std::vector<Standard_Real> distances;
+    for (QuadTree::Cell cell : qTree->TerminalCells()) {
+      if (!IsTaggedCell(qTree, cell)) continue;
+      Standard_Real dMin, dMax;
+      qTree->GetMinMaxDistances(points[i], cell, dMin, dMax);
+      distances.push_back(dMin);
+    }
+    std::sort(distances.begin(), distances.end());
+
+    std::vector<QuadTree::Cell> nearestCells;
+    SearchKNearestCells(qTree, points[i], IsTaggedCell, k,
+                        std::numeric_limits<double>::max(), nearestCells);
+    ASSERT_EQ(nearestCells, batch[i]);
+    ASSERT_EQ(nearestCells.size(), std::min(k, distances.size()));
+    for (size_t n = 0; n < nearestCells.size(); ++n) {
+      ASSERT_TRUE(IsTaggedCell(qTree, nearestCells[n]));
+      Standard_Real dMin, dMax;
+      qTree->GetMinMaxDistances(points[i], nearestCells[n], dMin, dMax);
+      ASSERT_EQ(dMin, distances[n]);
+    }
+  }
+}
+
+TEST(QuadTree, AttrChannels) {
+  Bnd_Box2d boundBox;
+  boundBox.Add(gp_Pnt2d(0, 0));
+  boundBox.Add(gp_Pnt2d(3, 2));
+  QuadTree::Ptr qTree = QuadTree::Create(boundBox, 3, 2);
+
+  size_t distance = qTree->AddChannel<double>(-1.0);
+  size_t material = qTree->AddChannel<int>();
+  ASSERT_TRUE(qTree->GetChannel<float>(distance).empty());
+
+  qTree->SetValue(distance, QuadTree::Cell(0, 0), 0.5);
+  qTree->SetValue(material, QuadTree::Cell(0, 4), 7);
+  qTree->SetAttr(QuadTree::Cell(0, 5), 42);
+
+  // Деление ячеек не меняет номера и атрибуты имеющихся ячеек.
+  size_t ordinal = qTree->GetOrdinal(QuadTree::Cell(0, 4));
+  qTree->Split(QuadTree::Cell(0, 1));
+  qTree->Split(QuadTree::Cell(1, 2));
+  ASSERT_EQ(qTree->NbOrdinals(), 6 + 2 * 4);
+  ASSERT_EQ(qTree->GetOrdinal(QuadTree::Cell(0, 4)), ordinal);
+  ASSERT_EQ(qTree->GetValue<double>(distance, QuadTree::Cell(0, 0)), 0.5);
+  ASSERT_EQ(qTree->GetValue<int>(material, QuadTree::Cell(0, 4)), 7);
+  ASSERT_EQ(qTree->GetAttr(QuadTree::Cell(0, 5)), 42);
+  ASSERT_EQ(qTree->GetValue<double>(distance, QuadTree::Cell(2, 4)), -1.0);
+  ASSERT_EQ(qTree->GetOrdinal(QuadTree::Cell(2, 0)), QuadTree::NoOrdinal);
+
+  std::vector<size_t> ordinals;
+  for (QuadTree::Cell cell : qTree->TerminalCells())
+    ordinals.push_back(qTree->GetOrdinal(cell));
+  ASSERT_EQ(ordinals.size(), qTree->NbCells());
+  std::sort(ordinals.begin(), ordinals.end());
+  ASSERT_TRUE(std::adjacent_find(ordinals.begin(), ordinals.end()) ==
+              ordinals.end());
+  ASSERT_LT(ordinals.back(), qTree->NbOrdinals());
+
+  std::vector<double> values(qTree->NbCells());
+  for (size_t i = 0; i < values.size(); ++i) values[i] = 0.25 * i;
+  qTree->SetValues<double>(distance, values);
+  std::vector<double> result;
+  qTree->GetValues(distance, result);
+  ASSERT_EQ(result, values);
+}
@@ -1,6 +1,9 @@
+#include <BRepBndLib.hxx>
 #include <BRep_Tool.hxx>
+#include <Bnd_Box.hxx>
 #include <Geom_Plane.hxx>
 #include <TopExp.hxx>
+#include <TopTools_MapOfShape.hxx>
 #include <TopoDS.hxx>
 #include <filesystem>
 
@@ -58,3 +61,112 @@ TEST_P(RemoveFacesTest, FromStep) {
     ASSERT_TRUE(WriteToStep(result, outFilename));
   }
 }
+
+TEST_P(RemoveFacesTest, FailedBlocks) {
+  const auto& param = this->GetParam();
+
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(param.ModelPath(), shape));
+
+  TopTools_ListOfShape facesToRemove;
+  {
+    TopTools_IndexedMapOfShape allFaces;
+    TopExp::MapShapes(shape, TopAbs_FACE, allFaces);
+    for (auto id : param.facesIds) facesToRemove.Append(allFaces.FindKey(id));
+  }
+
+  std::vector<TopTools_ListOfShape> failedBlocks;
+  TopoDS_Shape result = RemoveFaces(shape, facesToRemove, failedBlocks);
+  ASSERT_TRUE(!result.IsNull());
+  EXPECT_TRUE(failedBlocks.empty());
+
+  // Порядок восстанавливающих граней не зависит от параллельной обработки.
+  TopoDS_Shape result2 = RemoveFaces(shape, facesToRemove);
+  TopTools_IndexedMapOfShape faces, faces2;
+  TopExp::MapShapes(result, TopAbs_FACE, faces);
+  TopExp::MapShapes(result2, TopAbs_FACE, faces2);
+  ASSERT_EQ(faces.Extent(), faces2.Extent());
+  for (Standard_Integer i = 1; i <= faces.Extent(); ++i) {
+    Handle(Geom_Surface) S = BRep_Tool::Surface(TopoDS::Face(faces(i)));
+    Handle(Geom_Surface) S2 = BRep_Tool::Surface(TopoDS::Face(faces2(i)));
+    EXPECT_EQ(S->DynamicType(), S2->DynamicType());
+  }
+}
+
+TEST_P(RemoveFacesTest, IndependentOfHashOrder) {
+  const auto& param = this->GetParam();
+
+  // Две копии модели имеют разные адреса фигур, а значит и разный порядок
+  // граней в хеш-таблицах.
+  TopoDS_Shape results[2];
+  for (TopoDS_Shape& result : results) {
+    TopoDS_Shape shape;
+    ASSERT_TRUE(ReadFromFile(param.ModelPath(), shape));
+    TopTools_IndexedMapOfShape allFaces;
+    TopExp::MapShapes(shape, TopAbs_FACE, allFaces);
+    TopTools_ListOfShape facesToRemove;
+    for (auto id : param.facesIds) facesToRemove.Append(allFaces.FindKey(id));
+    result = RemoveFaces(shape, facesToRemove);
+    ASSERT_FALSE(result.IsNull());
+  }
+
+  TopTools_IndexedMapOfShape faces, faces2;
+  TopExp::MapShapes(results[0], TopAbs_FACE, faces);
+  TopExp::MapShapes(results[1], TopAbs_FACE, faces2);
+  ASSERT_EQ(faces.Extent(), faces2.Extent());
+  for (Standard_Integer i = 1; i <= faces.Extent(); ++i) {
+    Bnd_Box box, box2;
+    BRepBndLib::Add(faces(i), box);
+    BRepBndLib::Add(faces2(i), box2);
+    EXPECT_LT(box.CornerMin().Distance(box2.CornerMin()), 1.0e-6);
+    EXPECT_LT(box.CornerMax().Distance(box2.CornerMax()), 1.0e-6);
+  }
+}
+
+TEST(RemoveFaces, OneBlockFails) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("one-side-rounded-cube.step"), shape));
+
+  TopTools_IndexedMapOfShape allFaces;
+  TopExp::MapShapes(shape, TopAbs_FACE, allFaces);
+  TopTools_ListOfShape roundedFaces;
+  TopTools_MapOfShape roundedVertices;
+  for (int id : {3, 7, 9, 10}) {
+    roundedFaces.Append(allFaces.FindKey(id));
+    TopExp::MapShapes(allFaces.FindKey(id), TopAbs_VERTEX, roundedVertices);
+  }
+
+  // Грань куба напротив скругленной: продолжения ее соседей параллельны и
+  // не замыкают восстанавливающую грань, поэтому ее блок не удаляется.
+  TopoDS_Shape opposite;
+  for (Standard_Integer i = 1; i <= allFaces.Extent() && opposite.IsNull();
+       ++i) {
+    const TopoDS_Face& face = TopoDS::Face(allFaces(i));
+    if (!BRep_Tool::Surface(face)->IsKind(STANDARD_TYPE(Geom_Plane)))
+      continue;
+    TopTools_IndexedMapOfShape vertices;
+    TopExp::MapShapes(face, TopAbs_VERTEX, vertices);
+    bool isolated = true;
+    for (Standard_Integer j = 1; j <= vertices.Extent(); ++j)
+      isolated = isolated && !roundedVertices.Contains(vertices(j));
+    if (isolated) opposite = face;
+  }
+  ASSERT_FALSE(opposite.IsNull());
+
+  TopTools_ListOfShape facesToRemove = roundedFaces;
+  facesToRemove.Append(opposite);
+  std::vector<TopTools_ListOfShape> failedBlocks;
+  TopoDS_Shape result = RemoveFaces(shape, facesToRemove, failedBlocks);
+  ASSERT_FALSE(result.IsNull());
+  ASSERT_EQ(failedBlocks.size(), 1);
+  ASSERT_EQ(failedBlocks[0].Extent(), 1);
+  EXPECT_TRUE(failedBlocks[0].First().IsSame(opposite));
+
+  // Скругления удалены так же, как без неудачного блока.
+  TopoDS_Shape expected = RemoveFaces(shape, roundedFaces);
+  TopTools_IndexedMapOfShape faces, expectedFaces;
+  TopExp::MapShapes(result, TopAbs_FACE, faces);
+  TopExp::MapShapes(expected, TopAbs_FACE, expectedFaces);
+  EXPECT_GT(faces.Extent(), 0);
+  EXPECT_EQ(faces.Extent(), expectedFaces.Extent());
+}
@@ -0,0 +1,20 @@
+#include "Geom_Circle.hxx"
+#include "gp_Ax2.hxx"
+#include "gtest/gtest.h"
+#include "numgeom/tesselate.h"
+
+TEST(Tesselate, CircleIsUniform) {
+  // У окружности метрика постоянна, поэтому узлы должны лежать на равных
+  // расстояниях друг от друга.
+  Handle(Geom_Circle) circle = new Geom_Circle(gp_Ax2(), 10.0);
+  std::vector<gp_Pnt> polyline;
+  Tesselate(circle, 0.0, M_PI, polyline);
+  ASSERT_GT(polyline.size(), 3);
+  EXPECT_LT(polyline.front().Distance(circle->Value(0.0)), 1.e-9);
+  EXPECT_LT(polyline.back().Distance(circle->Value(M_PI)), 1.e-9);
+  const double chord = polyline[0].Distance(polyline[1]);
+  for (size_t i = 1; i < polyline.size(); ++i) {
+    EXPECT_NEAR(polyline[i - 1].Distance(polyline[i]), chord, 1.e-2 * chord);
+    EXPECT_NEAR(polyline[i].Distance(gp_Pnt()), 10.0, 1.e-9);
+  }
+}
@@ -0,0 +1,77 @@
+#include "BRep_Tool.hxx"
+#include "BRepPrimAPI_MakeBox.hxx"
+#include "BRepTools.hxx"
+#include "TopExp_Explorer.hxx"
+#include "TopoDS.hxx"
+#include "TopoDS_Face.hxx"
+#include "gtest/gtest.h"
+#include "numgeom/tessellationcache.h"
+#include "numgeom/utilities.h"
+#include "utilities.h"
+
+namespace {
+;
+
+size_t CountTriangles(const TopoDS_Shape& shape) {
+  size_t nbTriangles = 0;
+  for (TopExp_Explorer it(shape, TopAbs_FACE); it.More(); it.Next()) {
+    TopLoc_Location l;
+    auto tr = BRep_Tool::Triangulation(TopoDS::Face(it.Value()), l);
+    if (tr) nbTriangles += tr->NbTriangles();
+  }
+  return nbTriangles;
+}
+}  // namespace
+
+TEST(TessellationCache, StoreAndLoad) {
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / GetTestName();
+  std::filesystem::remove_all(dir);
+  TessellationCache::Ptr cache = TessellationCache::Create(dir);
+  ASSERT_TRUE(cache);
+  TessellationCache::SetDefault(cache);
+
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("rounded-cube.step"), shape));
+  // Ключ вычисляется до построения сетки, как в `TriangulateShape`.
+  std::string key = TessellationCache::ComputeKey(shape, MeshParameters());
+  TriangulateShape(shape);
+  size_t nbTriangles = CountTriangles(shape);
+  ASSERT_GT(nbTriangles, 0);
+  ASSERT_TRUE(std::filesystem::exists(dir / (key + ".tri")));
+
+  // Та же фигура, прочитанная заново, получает сетку из кэша.
+  TopoDS_Shape copy;
+  ASSERT_TRUE(ReadFromFile(TestData("rounded-cube.step"), copy));
+  ASSERT_EQ(CountTriangles(copy), 0);
+  ASSERT_EQ(TessellationCache::ComputeKey(copy, MeshParameters()), key);
+  ASSERT_TRUE(cache->Load(key, copy));
+  ASSERT_EQ(CountTriangles(copy), nbTriangles);
+
+  // Другой прогиб - другой ключ.
+  MeshParameters fine;
+  fine.linearDeflection = 0.1;
+  ASSERT_NE(TessellationCache::ComputeKey(copy, MeshParameters()),
+            TessellationCache::ComputeKey(copy, fine));
+
+  TessellationCache::SetDefault(TessellationCache::Ptr());
+  std::filesystem::remove_all(dir);
+}
+
+TEST(TessellationCache, SizeLimit) {
+  std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / GetTestName();
+  std::filesystem::remove_all(dir);
+  TessellationCache::Ptr cache = TessellationCache::Create(dir, 1);
+  ASSERT_TRUE(cache);
+
+  TopoDS_Shape box = BRepPrimAPI_MakeBox(1.0, 2.0, 3.0).Shape();
+  std::string key = TessellationCache::ComputeKey(box, MeshParameters());
+  TriangulateShape(box);
+  ASSERT_TRUE(cache->Store(key, box));
+  // Файл больше предела и сразу вытесняется.
+  ASSERT_FALSE(std::filesystem::exists(dir / (key + ".tri")));
+  ASSERT_FALSE(cache->Load(key, box));
+
+  std::filesystem::remove_all(dir);
+}
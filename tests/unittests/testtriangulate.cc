@@ -0,0 +1,33 @@
+#include "BRepTools.hxx"
+#include "gtest/gtest.h"
+#include "numgeom/utilities.h"
+#include "utilities.h"
+
+TEST(Triangulate, ParallelEqualsSerial) {
+  TopoDS_Shape shape;
+  ASSERT_TRUE(ReadFromFile(TestData("handle.step"), shape));
+
+  MeshParameters params;
+  params.linearDeflection = 0.1;
+  params.angularDeflection = 0.3;
+  params.inParallel = false;
+  TriMesh::Ptr serial = ConvertToTriMesh(shape, params);
+  ASSERT_TRUE(serial);
+  ASSERT_GT(serial->NbCells(), 0);
+
+  BRepTools::Clean(shape);
+  params.inParallel = true;
+  TriMesh::Ptr parallel = ConvertToTriMesh(shape, params);
+  ASSERT_TRUE(parallel);
+  ASSERT_EQ(parallel->NbNodes(), serial->NbNodes());
+  ASSERT_EQ(parallel->NbCells(), serial->NbCells());
+  for (size_t i = 0; i < serial->NbNodes(); ++i)
+    ASSERT_EQ(parallel->GetNode(i), serial->GetNode(i));
+  for (size_t i = 0; i < serial->NbCells(); ++i) {
+    const TriMesh::Cell& a = serial->GetCell(i);
+    const TriMesh::Cell& b = parallel->GetCell(i);
+    ASSERT_EQ(a.na, b.na);
+    ASSERT_EQ(a.nb, b.nb);
+    ASSERT_EQ(a.nc, b.nc);
+  }
+}
@@ -1,8 +1,13 @@
 #include <format>
+#include <fstream>
+#include <iterator>
+#include <thread>
 
 #include "gtest/gtest.h"
 
 #include "numgeom/loadfromvtk.h"
+#include "numgeom/loadtrimesh.h"
+#include "numgeom/parallelfor.h"
 #include "numgeom/trimeshconnectivity.h"
 #include "numgeom/writetovtk.h"
 
@@ -71,3 +76,328 @@ TEST(TriMesh, LoadAndWrite) {
   ASSERT_EQ(mesh->NbCells(), mesh_next->NbCells());
   ASSERT_LT(Deviation(mesh,mesh_next), 1.e-6);
 }
+
+TEST(TriMesh, LoadFields) {
+  TriMesh::Ptr mesh = LoadTriMeshFromVtk(TestData("polydata-fields.vtk"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  ASSERT_EQ(mesh->NbNodes(), 6);
+  ASSERT_EQ(mesh->NbCells(), 2);
+
+  ASSERT_EQ(mesh->PointFields().size(), 2);
+  MeshField::Ptr pressure = mesh->FindPointField("pressure");
+  ASSERT_TRUE(pressure != MeshField::Ptr());
+  ASSERT_EQ(pressure->Type(), MeshField::ValueType::Double);
+  ASSERT_EQ(pressure->NbComponents(), 1);
+  ASSERT_DOUBLE_EQ(pressure->Values<double>()[5], 5.5);
+
+  MeshField::Ptr velocity = mesh->FindPointField("velocity");
+  ASSERT_TRUE(velocity != MeshField::Ptr());
+  ASSERT_EQ(velocity->Type(), MeshField::ValueType::Float);
+  ASSERT_EQ(velocity->NbComponents(), 3);
+  ASSERT_FLOAT_EQ(velocity->Values<float>()[3 * 4 + 1], 1.0f);
+
+  // Атрибуты четырехугольника отброшены вместе с ним.
+  MeshField::Ptr material = mesh->FindCellField("material_id");
+  ASSERT_TRUE(material != MeshField::Ptr());
+  ASSERT_EQ(material->Type(), MeshField::ValueType::Int);
+  ASSERT_EQ(material->NbTuples(), 2);
+  ASSERT_EQ(material->Values<int32_t>()[0], 7);
+  ASSERT_EQ(material->Values<int32_t>()[1], 9);
+}
+
+TEST(TriMesh, WriteFields) {
+  TriMesh::Ptr mesh = LoadTriMeshFromVtk(TestData("polydata-fields.vtk"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  std::filesystem::path out_filename = GetTestName() + ".vtk";
+  ASSERT_TRUE(WriteToUnstructuredVtk(mesh, out_filename));
+  TriMesh::Ptr mesh_next = LoadTriMeshFromVtk(out_filename);
+  ASSERT_TRUE(mesh_next != TriMesh::Ptr());
+  ASSERT_EQ(mesh_next->PointFields().size(), mesh->PointFields().size());
+  ASSERT_EQ(mesh_next->CellFields().size(), mesh->CellFields().size());
+
+  MeshField::Ptr velocity = mesh_next->FindPointField("velocity");
+  ASSERT_TRUE(velocity != MeshField::Ptr());
+  ASSERT_EQ(velocity->NbComponents(), 3);
+  for (size_t i = 0; i < mesh->NbNodes(); ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      ASSERT_EQ(velocity->GetValue(i, j),
+                mesh->FindPointField("velocity")->GetValue(i, j));
+    }
+  }
+  ASSERT_EQ(mesh_next->FindCellField("material_id")->GetValue(1, 0), 9);
+
+  std::ifstream file(out_filename);
+  std::string text((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  ASSERT_NE(text.find("VECTORS velocity float\n"), std::string::npos);
+  ASSERT_EQ(text.find("SCALARS velocity"), std::string::npos);
+  ASSERT_NE(text.find("SCALARS pressure double 1\n"), std::string::npos);
+}
+
+TEST(TriMesh, LoadFieldNamedInt) {
+  // Тип int распознается только на месте типа и остается допустимым именем.
+  std::filesystem::path filename = GetTestName() + ".vtk";
+  std::ofstream(filename) << "# vtk DataFile Version 3.0\n"
+                             "title\n"
+                             "ASCII\n"
+                             "DATASET POLYDATA\n"
+                             "POINTS 3 float\n"
+                             "0 0 0 1 0 0 0 1 0\n"
+                             "POLYGONS 1 4\n"
+                             "3 0 1 2\n"
+                             "POINT_DATA 3\n"
+                             "SCALARS int int 1\n"
+                             "LOOKUP_TABLE int\n"
+                             "1 2 3\n";
+  TriMesh::Ptr mesh = LoadTriMeshFromVtk(filename);
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  MeshField::Ptr field = mesh->FindPointField("int");
+  ASSERT_TRUE(field != MeshField::Ptr());
+  ASSERT_EQ(field->Type(), MeshField::ValueType::Int);
+  ASSERT_EQ(field->GetValue(2, 0), 3);
+}
+
+TEST(TriMesh, CreateByMove) {
+  std::vector<TriMesh::NodeType> nodes = {
+      {0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}};
+  std::vector<TriMesh::Cell> cells = {TriMesh::Cell(0, 1, 2)};
+  const TriMesh::NodeType* nodesData = nodes.data();
+  TriMesh::Ptr mesh = TriMesh::Create(std::move(nodes), std::move(cells));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  ASSERT_EQ(mesh->NbNodes(), 3);
+  ASSERT_EQ(mesh->NbCells(), 1);
+  ASSERT_EQ(&mesh->GetNode(0), nodesData);
+}
+
+namespace {
+;
+
+class CountingConsumer : public TriMeshConsumer {
+ public:
+  bool AddNodes(const CTriMesh::NodeType* nodes, size_t count) override {
+    maxChunk = std::max(maxChunk, count);
+    for (size_t i = 0; i < count; ++i) lastNode = nodes[i];
+    nbNodes += count;
+    return true;
+  }
+
+  bool AddCells(const CTriMesh::Cell* cells, size_t count) override {
+    maxChunk = std::max(maxChunk, count);
+    nbCells += count;
+    return true;
+  }
+
+  size_t nbNodes = 0;
+  size_t nbCells = 0;
+  size_t maxChunk = 0;
+  CTriMesh::NodeType lastNode;
+};
+
+//! Отказывается принять вторую порцию.
+class RejectingConsumer : public TriMeshConsumer {
+ public:
+  void ReserveCells(size_t nbCells) override { cellsReserved = true; }
+
+  bool AddNodes(const CTriMesh::NodeType* nodes, size_t count) override {
+    return ++nbCalls != 2;
+  }
+
+  bool AddCells(const CTriMesh::Cell* cells, size_t count) override {
+    return ++nbCalls != 2;
+  }
+
+  size_t nbCalls = 0;
+  bool cellsReserved = false;
+};
+}  // namespace
+
+TEST(TriMesh, LoadFromVtkByChunks) {
+  TriMesh::Ptr mesh = LoadTriMeshFromVtk(TestData("k.vtk"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+
+  CountingConsumer consumer;
+  ASSERT_TRUE(LoadTriMeshFromVtk(TestData("k.vtk"), consumer, 16));
+  ASSERT_EQ(consumer.nbNodes, mesh->NbNodes());
+  ASSERT_EQ(consumer.nbCells, mesh->NbCells());
+  ASSERT_LE(consumer.maxChunk, 16);
+  ASSERT_EQ(consumer.lastNode, mesh->GetNode(mesh->NbNodes() - 1));
+}
+
+TEST(TriMesh, LoadFromVtkRejected) {
+  RejectingConsumer consumer;
+  ASSERT_FALSE(LoadTriMeshFromVtk(TestData("k.vtk"), consumer, 16));
+  // Разбор остановлен на отвергнутой порции узлов и до треугольников не
+  // дошел.
+  ASSERT_EQ(consumer.nbCalls, 2);
+  ASSERT_FALSE(consumer.cellsReserved);
+
+  ASSERT_TRUE(LoadTriMeshFromVtk(TestData("polydata-cube.vtk")) !=
+              TriMesh::Ptr());
+}
+
+TEST(TriMesh, LoadFromVtkAfterError) {
+  TriMesh::Ptr mesh = LoadTriMeshFromVtk(TestData("polydata-cube.vtk"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+
+  // Файл обрывается в заголовке, и сканер остается в условии заголовка;
+  // прерванный разбор оставляет в буфере сканера непрочитанные данные.
+  std::filesystem::path broken = GetTestName() + ".vtk";
+  std::ofstream(broken) << "# vtk DataFile Version 3.0\ntitle";
+  ASSERT_TRUE(LoadTriMeshFromVtk(broken) == TriMesh::Ptr());
+  LoadProgress progress;
+  progress.Cancel();
+  ASSERT_TRUE(LoadTriMeshFromVtk(TestData("k.vtk"), &progress) ==
+              TriMesh::Ptr());
+
+  TriMesh::Ptr next = LoadTriMeshFromVtk(TestData("polydata-cube.vtk"));
+  ASSERT_TRUE(next != TriMesh::Ptr());
+  ASSERT_EQ(next->NbNodes(), mesh->NbNodes());
+  ASSERT_EQ(next->NbCells(), mesh->NbCells());
+}
+
+TEST(TriMesh, LoadFromStl) {
+  for (const char* fileName : {"tetra-ascii.stl", "tetra-binary.stl"}) {
+    TriMesh::Ptr mesh = LoadTriMeshFromStl(TestData(fileName));
+    ASSERT_TRUE(mesh != TriMesh::Ptr());
+    // Вершины соседних фасет слиты.
+    ASSERT_EQ(mesh->NbNodes(), 4);
+    ASSERT_EQ(mesh->NbCells(), 4);
+    ASSERT_EQ(mesh->Connectivity()->NbNodes(), 4);
+    for (size_t i = 0; i < mesh->NbNodes(); ++i)
+      ASSERT_FALSE(mesh->Connectivity()->IsBoundaryNode(i));
+  }
+}
+
+namespace {
+;
+
+std::string ReadBytes(const std::filesystem::path& fileName) {
+  std::ifstream file(fileName, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), {});
+}
+
+void WriteBytes(const std::filesystem::path& fileName,
+                const std::string& bytes) {
+  std::ofstream(fileName, std::ios::binary) << bytes;
+}
+}  // namespace
+
+TEST(TriMesh, LoadFromStlWithTrailingBytes) {
+  std::filesystem::path fileName = GetTestName() + ".stl";
+  WriteBytes(fileName, ReadBytes(TestData("tetra-binary.stl")) + "padding");
+  TriMesh::Ptr mesh = LoadTriMeshFromStl(fileName);
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  ASSERT_EQ(mesh->NbCells(), 4);
+}
+
+TEST(TriMesh, LoadFromObj) {
+  TriMesh::Ptr mesh = LoadTriMesh(TestData("tetra.obj"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  ASSERT_EQ(mesh->NbNodes(), 4);
+  ASSERT_EQ(mesh->NbCells(), 4);
+  const TriMesh::Cell& cell = mesh->GetCell(2);
+  ASSERT_EQ(cell.na, 0);
+  ASSERT_EQ(cell.nb, 3);
+  ASSERT_EQ(cell.nc, 2);
+}
+
+TEST(TriMesh, LoadFromPly) {
+  TriMesh::Ptr mesh = LoadTriMesh(TestData("pyramid.ply"));
+  ASSERT_TRUE(mesh != TriMesh::Ptr());
+  ASSERT_EQ(mesh->NbNodes(), 5);
+  // Четырехугольное основание разбито на два треугольника.
+  ASSERT_EQ(mesh->NbCells(), 4);
+  ASSERT_EQ(mesh->GetNode(4), glm::dvec3(0.5, 0.5, 1.0));
+  const TriMesh::Cell& cell = mesh->GetCell(1);
+  ASSERT_EQ(cell.na, 0);
+  ASSERT_EQ(cell.nb, 2);
+  ASSERT_EQ(cell.nc, 1);
+}
+
+TEST(TriMesh, LoadFromPlyNegativeIndex) {
+  std::string bytes = ReadBytes(TestData("pyramid.ply"));
+  // Первый индекс первой грани: за заголовком идут 5 вершин по 13 байт,
+  // а в записи грани - флаги и число индексов.
+  size_t offset = bytes.find("end_header\n") + 11 + 5 * 13 + 2;
+  bytes.replace(offset, 4, "\xff\xff\xff\xff");
+  std::filesystem::path fileName = GetTestName() + ".ply";
+  WriteBytes(fileName, bytes);
+  ASSERT_TRUE(LoadTriMesh(fileName) == TriMesh::Ptr());
+}
+
+TEST(TriMesh, LoadFromPlyHugeFaceCount) {
+  std::string bytes = ReadBytes(TestData("pyramid.ply"));
+  size_t offset = bytes.find("element face ");
+  ASSERT_NE(offset, std::string::npos);
+  offset += 13;
+  bytes.replace(offset, bytes.find('\n', offset) - offset,
+                "4000000000000000000");
+  std::filesystem::path fileName = GetTestName() + ".ply";
+  WriteBytes(fileName, bytes);
+  ASSERT_TRUE(LoadTriMesh(fileName) == TriMesh::Ptr());
+}
+
+TEST(TriMesh, LoadAsync) {
+  for (const char* fileName :
+       {"tetra-binary.stl", "tetra.obj", "pyramid.ply", "polydata-cube.vtk"}) {
+    AsyncLoad<TriMesh::Ptr> load = LoadTriMeshAsync(TestData(fileName));
+    ASSERT_TRUE(load.IsValid());
+    TriMesh::Ptr mesh = load.Get();
+    ASSERT_TRUE(mesh != TriMesh::Ptr());
+    ASSERT_FALSE(load.IsValid());
+    ASSERT_NE(load.Progress().TotalBytes(), 0);
+    ASSERT_EQ(load.Progress().ParsedBytes(), load.Progress().TotalBytes());
+    ASSERT_EQ(load.Progress().Fraction(), 1.0);
+  }
+}
+
+TEST(TriMesh, LoadAsyncEmpty) {
+  AsyncLoad<int> load;
+  ASSERT_FALSE(load.IsValid());
+  ASSERT_EQ(load.Progress().ParsedBytes(), 0);
+  ASSERT_EQ(load.Progress().Fraction(), 0.0);
+}
+
+TEST(TriMesh, LoadProgressCallbackFromWorkers) {
+  // Рабочие потоки сообщают ход одновременно, а вызовы функции обратного
+  // вызова не пересекаются.
+  std::atomic<int> nbInside(0);
+  bool overlapped = false;
+  size_t nbCalls = 0;
+  LoadProgress progress([&](const LoadProgress&) {
+    if (nbInside++ != 0) overlapped = true;
+    ++nbCalls;
+    std::this_thread::yield();
+    --nbInside;
+  });
+  const size_t n = 1000 * NbParallelThreads();
+  ParallelFor(n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) progress.AddParsedBytes(1);
+  });
+  ASSERT_FALSE(overlapped);
+  ASSERT_EQ(nbCalls, n);
+  ASSERT_EQ(progress.ParsedBytes(), n);
+}
+
+TEST(TriMesh, LoadAbandoned) {
+  // Загрузчик завершится только после того, как от него откажутся:
+  // если бы присваивание дожидалось загрузчика, тест бы завис.
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  AsyncLoad<int> load = LoadAsync<int>([released](LoadProgress& progress) {
+    released.wait();
+    return progress.IsCancelled() ? 0 : 1;
+  });
+  load = LoadAsync<int>([](LoadProgress&) { return 2; });
+  release.set_value();
+  ASSERT_EQ(load.Get(), 2);
+}
+
+TEST(TriMesh, LoadCancelled) {
+  for (const char* fileName : {"tetra-ascii.stl", "tetra-binary.stl",
+                               "tetra.obj", "pyramid.ply", "k.vtk"}) {
+    LoadProgress progress;
+    progress.Cancel();
+    ASSERT_TRUE(LoadTriMesh(TestData(fileName), &progress) == TriMesh::Ptr());
+  }
+}
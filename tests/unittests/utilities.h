@@ -2,9 +2,26 @@
 #define NUMGEOM_UNITTESTS_UTILITIES_H
 
 #include <filesystem>
+#include <sstream>
+#include <string>
 
 std::string GetTestName();
 
 std::filesystem::path TestData(const std::string& fileName);
 
+//! Буфер чтения строки, не поддерживающий позиционирование, как у канала.
+class NonSeekableBuf : public std::stringbuf {
+ public:
+  explicit NonSeekableBuf(const std::string& data)
+      : std::stringbuf(data, std::ios::in) {}
+
+ protected:
+  pos_type seekoff(off_type, std::ios::seekdir, std::ios::openmode) override {
+    return pos_type(off_type(-1));
+  }
+  pos_type seekpos(pos_type, std::ios::openmode) override {
+    return pos_type(off_type(-1));
+  }
+};
+
 #endif  // !NUMGEOM_UNITTESTS_UTILITIES_H